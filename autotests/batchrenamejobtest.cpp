@@ -94,6 +94,13 @@ private Q_SLOTS:
                                                              << 4
                                                              << QChar('#')
                                                              << QStringList{"##file#4.h", "##file#5.h", "##file#6.c"};
+
+        // The second item takes the name freed by the first one
+        QTest::newRow("chained-names") << (QStringList{"2.txt", "other.txt"})
+                                       << "#"
+                                       << 1
+                                       << QChar('#')
+                                       << QStringList{"1.txt", "2.txt"};
         /* clang-format on */
     }
 
@@ -117,6 +124,24 @@ private Q_SLOTS:
         QVERIFY(checkFileExistence(newFilenames));
     }
 
+    void batchRenameJobConflictTest()
+    {
+        const QStringList oldFilenames{"first.log", "second.log", "third.log"};
+        createTestFiles(oldFilenames);
+        // The new name of the item in the middle of the batch is taken
+        createTestFiles({"conflict-2.log"});
+        KIO::BatchRenameJob *job = KIO::batchRename(createUrlList(oldFilenames), "conflict-#", 1, QChar('#'));
+        job->setUiDelegate(nullptr);
+        QSignalSpy spy(job, &KIO::BatchRenameJob::fileRenamed);
+        QVERIFY(!job->exec());
+        // The other items were renamed, the conflicting one was left to CopyJob, which can't ask without a UI
+        QCOMPARE(job->error(), KIO::ERR_FILE_ALREADY_EXIST);
+        QCOMPARE(spy.count(), 2);
+        QVERIFY(checkFileExistence({"conflict-1.log", "second.log", "conflict-2.log", "conflict-3.log"}));
+        QVERIFY(!checkFileExistence({"first.log"}));
+        QVERIFY(!checkFileExistence({"third.log"}));
+    }
+
 private:
     QString m_homeDir;
 };
@@ -0,0 +1,33 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <KIO/ThumbnailCreator>
+#include <KPluginFactory>
+
+#include <QImage>
+
+// A thumbnail plugin for previewjobtest, used if the thumbnail worker is installed
+class FakeThumbnail : public KIO::ThumbnailCreator
+{
+    Q_OBJECT
+public:
+    FakeThumbnail(QObject *parent, const QVariantList &args)
+        : KIO::ThumbnailCreator(parent, args)
+    {
+    }
+
+    KIO::ThumbnailResult create(const KIO::ThumbnailRequest &request) override
+    {
+        QImage image(request.targetSize(), QImage::Format_ARGB32);
+        image.fill(Qt::red);
+        return KIO::ThumbnailResult::pass(image);
+    }
+};
+
+K_PLUGIN_CLASS_WITH_JSON(FakeThumbnail, "fakethumbnail.json")
+
+#include "fakethumbnail.moc"
@@ -0,0 +1,189 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QFile>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KIO/FileJob>
+#include <KIO/FileJobDevice>
+
+class FileJobDeviceTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    static bool openDevice(KIO::FileJobDevice &device, QIODevice::OpenMode mode)
+    {
+        return device.waitForOpened() && device.open(mode);
+    }
+
+    // Reads never block, wait for the data like QFile-based code would expect
+    static QByteArray readFully(KIO::FileJobDevice &device, qint64 size)
+    {
+        QByteArray result = device.read(size);
+        while (result.size() < size && device.waitForReadyRead(30000)) {
+            result += device.read(size - result.size());
+        }
+        return result;
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+
+        QVERIFY(m_tempDir.isValid());
+        m_data.reserve(3 * 1024 * 1024);
+        for (int i = 0; m_data.size() < 3 * 1024 * 1024; ++i) {
+            m_data += QByteArray::number(i) + ' ';
+        }
+        m_filePath = m_tempDir.filePath(QStringLiteral("testfile"));
+        QFile file(m_filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(m_data), m_data.size());
+    }
+
+    void shouldReadSequentially()
+    {
+        KIO::FileJobDevice device(KIO::open(QUrl::fromLocalFile(m_filePath), QIODevice::ReadOnly));
+        QVERIFY2(openDevice(device, QIODevice::ReadOnly), qPrintable(device.errorString()));
+        QCOMPARE(device.size(), m_data.size());
+
+        // Small reads, served from the read-ahead buffer
+        QByteArray result;
+        while (!device.atEnd()) {
+            const QByteArray chunk = readFully(device, 1000);
+            QVERIFY2(!chunk.isEmpty(), qPrintable(device.errorString()));
+            result += chunk;
+        }
+        QCOMPARE(result.size(), m_data.size());
+        QVERIFY(result == m_data);
+        device.close();
+        QVERIFY(!device.isOpen());
+    }
+
+    void shouldReadAfterSeek()
+    {
+        KIO::FileJobDevice device(KIO::open(QUrl::fromLocalFile(m_filePath), QIODevice::ReadOnly));
+        QVERIFY2(openDevice(device, QIODevice::ReadOnly), qPrintable(device.errorString()));
+
+        QCOMPARE(readFully(device, 10), m_data.left(10));
+        QVERIFY(device.seek(2000000));
+        QCOMPARE(readFully(device, 100), m_data.mid(2000000, 100));
+        QVERIFY(device.seek(5));
+        QCOMPARE(readFully(device, 20), m_data.mid(5, 20));
+        QCOMPARE(device.pos(), 25);
+    }
+
+    void shouldWriteBehind()
+    {
+        const QString path = m_tempDir.filePath(QStringLiteral("written"));
+        {
+            KIO::FileJobDevice device(KIO::open(QUrl::fromLocalFile(path), QIODevice::WriteOnly));
+            QVERIFY2(openDevice(device, QIODevice::WriteOnly), qPrintable(device.errorString()));
+            for (int i = 0; i < m_data.size(); i += 1000) {
+                QCOMPARE(device.write(m_data.mid(i, 1000)), std::min<qint64>(1000, m_data.size() - i));
+            }
+            QCOMPARE(device.size(), m_data.size());
+            device.close();
+            QVERIFY2(device.waitForClosed(), qPrintable(device.errorString()));
+        }
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll() == m_data);
+    }
+
+    void shouldReadBackWrites()
+    {
+        const QString path = m_tempDir.filePath(QStringLiteral("readwrite"));
+        QFile::remove(path);
+        QVERIFY(QFile::copy(m_filePath, path));
+        QByteArray expected = m_data;
+        {
+            KIO::FileJobDevice device(KIO::open(QUrl::fromLocalFile(path), QIODevice::ReadWrite));
+            QVERIFY2(openDevice(device, QIODevice::ReadWrite), qPrintable(device.errorString()));
+
+            QCOMPARE(readFully(device, 10), m_data.left(10));
+            // A small write, kept in the write-behind buffer
+            QCOMPARE(device.write("HELLO"), 5);
+            expected.replace(10, 5, "HELLO");
+            // The read must come after the write, at the position after it
+            QCOMPARE(readFully(device, 10), m_data.mid(15, 10));
+            QCOMPARE(device.pos(), 25);
+
+            QVERIFY(device.seek(10));
+            QCOMPARE(readFully(device, 5), QByteArray("HELLO"));
+
+            // Again after a seek, then further away
+            QVERIFY(device.seek(1000));
+            QCOMPARE(device.write("WORLD"), 5);
+            expected.replace(1000, 5, "WORLD");
+            QCOMPARE(readFully(device, 5), m_data.mid(1005, 5));
+            QVERIFY(device.seek(995));
+            QCOMPARE(readFully(device, 15), expected.mid(995, 15));
+            device.close();
+            QVERIFY2(device.waitForClosed(), qPrintable(device.errorString()));
+        }
+
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.readAll() == expected);
+    }
+
+    void shouldFailOnMissingFile()
+    {
+        KIO::FileJob *job = KIO::open(QUrl::fromLocalFile(m_tempDir.filePath(QStringLiteral("missing"))), QIODevice::ReadOnly);
+        job->setUiDelegate(nullptr);
+        KIO::FileJobDevice device(job);
+        QVERIFY(!device.waitForOpened());
+        QVERIFY(!device.open(QIODevice::ReadOnly));
+        QVERIFY(!device.errorString().isEmpty());
+    }
+
+    void shouldAssembleSplitReplies()
+    {
+        KIO::FileJobDevice device(KIO::open(QUrl::fromLocalFile(m_filePath), QIODevice::ReadOnly));
+        QVERIFY2(openDevice(device, QIODevice::ReadOnly), qPrintable(device.errorString()));
+        // Nothing arrived yet, the device asks the job for the data
+        QVERIFY(device.read(10).isEmpty());
+        // Some workers answer a read in several parts
+        KIO::FileJob *job = device.job();
+        Q_EMIT job->data(job, m_data.left(4));
+        Q_EMIT job->data(job, m_data.mid(4, 6));
+        QCOMPARE(device.read(10), m_data.left(10));
+        QCOMPARE(device.pos(), 10);
+    }
+
+    void shouldCloseWhenDestroyed()
+    {
+        const QString path = m_tempDir.filePath(QStringLiteral("destroyed"));
+        QPointer<KIO::FileJob> job = KIO::open(QUrl::fromLocalFile(path), QIODevice::WriteOnly);
+        {
+            KIO::FileJobDevice device(job);
+            QVERIFY2(openDevice(device, QIODevice::WriteOnly), qPrintable(device.errorString()));
+            QCOMPARE(device.write(m_data.left(100)), 100);
+        }
+        // The job writes the data and closes the file on its own
+        QTRY_VERIFY(!job);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), m_data.left(100));
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    QString m_filePath;
+    QByteArray m_data;
+};
+
+QTEST_MAIN(FileJobDeviceTest)
+
+#include "filejobdevicetest.moc"
@@ -0,0 +1,57 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "globmatcher_p.h"
+
+#include <QRegularExpression>
+#include <QTest>
+
+#include <algorithm>
+
+using namespace KIO;
+
+class GlobMatcherTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMatches_data()
+    {
+        QTest::addColumn<QStringList>("patterns");
+
+        QTest::addRow("extensions") << QStringList{"*.png", "*.JPG", "*.jpeg", "*.tar.gz"};
+        QTest::addRow("prefix_suffix_name") << QStringList{"README*", "*rc", "Makefile"};
+        QTest::addRow("slashes") << QStringList{"*/foo", "image/*", "*.d/conf"};
+        QTest::addRow("regex_fallback") << QStringList{"*.[ch]", "file?.txt", "*a*b*"};
+        QTest::addRow("all") << QStringList{"*"};
+        QTest::addRow("none") << QStringList{};
+    }
+
+    void testMatches()
+    {
+        QFETCH(QStringList, patterns);
+
+        // Must give the same results as the wildcard regular expressions
+        const GlobMatcher matcher(patterns);
+        const QStringList names{"image.png", "IMAGE.PNG", "photo.jpg", "photo.jpeg.bak", "archive.tar.gz", "archive.gz", ".png", "png",
+                                "README", "README.md", "readme.txt", "kdeglobalsrc", "rc", "Makefile", "makefile", "Makefile.am",
+                                "main.c", "main.h", "main.cpp", "file1.txt", "file12.txt", "cab", "bac", "",
+                                "x/foo", "/foo", "x/y/foo", "xfoo", "image/png", "image/", "image/svg/xml", "dir/image.png",
+                                "a.d/conf", "a/b.d/conf", "dir/kdeglobalsrc", "src/README"};
+        for (const QString &name : names) {
+            const bool expected = std::any_of(patterns.cbegin(), patterns.cend(), [&name](const QString &pattern) {
+                const QRegularExpression regex(QRegularExpression::wildcardToRegularExpression(pattern), QRegularExpression::CaseInsensitiveOption);
+                return regex.match(name).hasMatch();
+            });
+            QVERIFY2(matcher.matches(name) == expected, qPrintable(name));
+        }
+    }
+};
+
+QTEST_MAIN(GlobMatcherTest)
+
+#include "globmatchertest.moc"
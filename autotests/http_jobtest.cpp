@@ -5,12 +5,20 @@
     SPDX-License-Identifier: LGPL-2.0-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 
+#include <KConfig>
+#include <KConfigGroup>
+#include <QPointer>
 #include <QSignalSpy>
 #include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTest>
 
 #include "httpserver_p.h"
+#include <kio/filecopyjob.h>
 #include <kio/storedtransferjob.h>
+#include <kprotocolmanager.h>
+#include <filecopyjob_p.h>
+#include <kprotocolmanager_p.h>
 
 class HTTPJobTest : public QObject
 {
@@ -21,8 +29,24 @@ private Q_SLOTS:
     void testBasicGet();
     void testErrorPage();
     void testMimeTypeDetermination();
+    void testFileCopy();
+    void testFileCopyError();
+    void testSegmentedFileCopy_data();
+    void testSegmentedFileCopy();
+    void testSegmentedFileCopyWithoutRanges();
+    void testJobsWaitingForProxies();
 };
 
+static QByteArray createSegmentedTestData()
+{
+    QByteArray data;
+    data.reserve(2 * 1024 * 1024);
+    for (int i = 0; data.size() < 2 * 1024 * 1024; ++i) {
+        data += QByteArray::number(i) + '\n';
+    }
+    return data;
+}
+
 void HTTPJobTest::initTestCase()
 {
     QStandardPaths::setTestModeEnabled(true);
@@ -76,6 +100,148 @@ void HTTPJobTest::testErrorPage()
     QCOMPARE(mimeTypeFoundSpy.at(0).at(1).toString(), QStringLiteral("text/html"));
 }
 
+void HTTPJobTest::testFileCopy()
+{
+    // http can't copy to a local file, so the data goes from the http worker to the file worker
+    static const char response[] = "Hello world";
+    HttpServerThread server(response, HttpServerThread::Public);
+    QTemporaryDir tempDir;
+    const QString destPath = tempDir.filePath(QStringLiteral("copied"));
+    KIO::FileCopyJob *job = KIO::file_copy(QUrl(server.endPoint()), QUrl::fromLocalFile(destPath), -1, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+    // The data went through the data pipe; had it come through the application, the job would have failed
+    const QString dataPipe = KIO::_fileCopyJobDataPipe(job);
+    QVERIFY(dataPipe.startsWith(QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)));
+
+    QFile file(destPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(QString::fromLatin1(file.readAll()), QString::fromLatin1(response));
+
+    // Each copy gets its own pipe
+    const QString destPath2 = tempDir.filePath(QStringLiteral("copied2"));
+    job = KIO::file_copy(QUrl(server.endPoint()), QUrl::fromLocalFile(destPath2), -1, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+    QVERIFY(!KIO::_fileCopyJobDataPipe(job).isEmpty());
+    QVERIFY(KIO::_fileCopyJobDataPipe(job) != dataPipe);
+}
+
+void HTTPJobTest::testFileCopyError()
+{
+    static const char response[] = "<html>File not found</html>";
+    HttpServerThread server(response, HttpServerThread::Error404);
+    QTemporaryDir tempDir;
+    const QString destPath = tempDir.filePath(QStringLiteral("copied"));
+    KIO::FileCopyJob *job = KIO::file_copy(QUrl(server.endPoint()), QUrl::fromLocalFile(destPath), -1, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QVERIFY(!job->exec());
+    QVERIFY(!KIO::_fileCopyJobDataPipe(job).isEmpty());
+    QCOMPARE(job->error(), int(KIO::ERR_DOES_NOT_EXIST));
+    QVERIFY(!QFile::exists(destPath));
+}
+
+void HTTPJobTest::testSegmentedFileCopy_data()
+{
+    QTest::addColumn<bool>("knownSize");
+
+    QTest::newRow("size_from_response") << false;
+    QTest::newRow("known_size") << true;
+}
+
+void HTTPJobTest::testSegmentedFileCopy()
+{
+    QFETCH(bool, knownSize);
+
+    const QByteArray response = createSegmentedTestData();
+    HttpServerThread server(response, HttpServerThread::Ranges);
+    server.setResponseDelay(50);
+    QTemporaryDir tempDir;
+    const QString destPath = tempDir.filePath(QStringLiteral("copied"));
+    KIO::FileCopyJob *job = KIO::file_copy(QUrl(server.endPoint()), QUrl::fromLocalFile(destPath), -1, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    job->setSegmentCount(4);
+    if (knownSize) {
+        job->setSourceSize(response.size());
+    }
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+
+    // The other segments were requested with ranges
+    QVERIFY(server.rangeRequestCount() >= 3);
+    QVERIFY(!QFile::exists(destPath + QLatin1String(".part")));
+    QFile file(destPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.size(), qint64(response.size()));
+    QVERIFY(file.readAll() == response);
+}
+
+void HTTPJobTest::testSegmentedFileCopyWithoutRanges()
+{
+    // The server ignores "Range" headers, the file is downloaded over a single connection
+    const QByteArray response = createSegmentedTestData();
+    HttpServerThread server(response, HttpServerThread::Public);
+    server.setResponseDelay(50);
+    QTemporaryDir tempDir;
+    const QString destPath = tempDir.filePath(QStringLiteral("copied"));
+    KIO::FileCopyJob *job = KIO::file_copy(QUrl(server.endPoint()), QUrl::fromLocalFile(destPath), -1, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    job->setSegmentCount(4);
+    job->setSourceSize(response.size());
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+
+    QFile file(destPath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.size(), qint64(response.size()));
+    QVERIFY(file.readAll() == response);
+}
+
+void HTTPJobTest::testJobsWaitingForProxies()
+{
+    KConfig config(QStringLiteral("kioslaverc"), KConfig::NoGlobals);
+    KConfigGroup cfg(&config, "Proxy Settings");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::ManualProxy));
+    // Nothing listens there, a job going through the proxy fails
+    cfg.writeEntry("httpProxy", QStringLiteral("http://127.0.0.1:1"));
+    cfg.writeEntry("NoProxyFor", QStringLiteral("127.0.0.0/8,::1/128"));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+
+    static const char response[] = "Hello world";
+    HttpServerThread server(response, HttpServerThread::Public);
+    QUrl url(server.endPoint());
+    url.setHost(QStringLiteral("localhost"));
+    // The scheduler has to look up the host before it knows that the proxy isn't used
+    QString protocol;
+    QStringList proxyList;
+    QVERIFY(!KProtocolManagerPrivate::cachedWorkerProtocol(url, protocol, proxyList));
+
+    // The jobs wait for a single lookup, a job killed meanwhile is forgotten
+    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QPointer<KIO::StoredTransferJob> killedJob = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    killedJob->setUiDelegate(nullptr);
+    KIO::StoredTransferJob *otherJob = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    otherJob->setUiDelegate(nullptr);
+    QSignalSpy resultSpy(job, &KJob::result);
+    QSignalSpy otherResultSpy(otherJob, &KJob::result);
+    QVERIFY(killedJob->kill());
+
+    QTRY_COMPARE(resultSpy.count(), 1);
+    QCOMPARE(job->error(), 0);
+    QCOMPARE(QString::fromLatin1(job->data()), QString::fromLatin1(response));
+    QTRY_COMPARE(otherResultSpy.count(), 1);
+    QCOMPARE(otherJob->error(), 0);
+    QCOMPARE(QString::fromLatin1(otherJob->data()), QString::fromLatin1(response));
+    QTRY_VERIFY(!killedJob);
+
+    // restore
+    cfg.deleteEntry("httpProxy");
+    cfg.deleteEntry("NoProxyFor");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::NoProxy));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+}
+
 void HTTPJobTest::testMimeTypeDetermination()
 {
     static const char response[] = "<html>Some HTML page here</html>";
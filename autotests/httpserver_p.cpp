@@ -79,27 +79,49 @@ static void parseAuthLine(const QString &str, Method *method, QString *headerVal
     }
 }
 
-QByteArray HttpServerThread::makeHttpResponse(const QByteArray &responseData) const
+QByteArray HttpServerThread::makeHttpResponse(const QByteArray &responseData, const QByteArray &range) const
 {
+    QByteArray data = responseData;
+    QByteArray contentRange;
+    if (range.startsWith("bytes=")) {
+        // Only single ranges, "bytes=start-end" or "bytes=start-"
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        const qsizetype start = bounds.at(0).toLongLong();
+        qsizetype end = data.size() - 1;
+        if (bounds.size() > 1 && !bounds.at(1).isEmpty()) {
+            end = qMin<qsizetype>(end, bounds.at(1).toLongLong());
+        }
+        contentRange = "bytes " + QByteArray::number(start) + '-' + QByteArray::number(end) + '/' + QByteArray::number(data.size());
+        data = data.mid(start, end - start + 1);
+    }
+
     QByteArray httpResponse;
     if (m_features & Error404) {
         httpResponse += "HTTP/1.1 404 Not Found\r\n";
+    } else if (!contentRange.isEmpty()) {
+        httpResponse += "HTTP/1.1 206 Partial Content\r\n";
     } else {
         httpResponse += "HTTP/1.1 200 OK\r\n";
     }
     if (!m_contentType.isEmpty()) {
         httpResponse += "Content-Type: " + m_contentType + "\r\n";
     }
+    if (m_features & Ranges) {
+        httpResponse += "Accept-Ranges: bytes\r\n";
+    }
+    if (!contentRange.isEmpty()) {
+        httpResponse += "Content-Range: " + contentRange + "\r\n";
+    }
     httpResponse += "Mozilla/5.0 (X11; Linux x86_64) KHTML/5.20.0 (like Gecko) Konqueror/5.20\r\n";
     httpResponse += "Content-Length: ";
-    httpResponse += QByteArray::number(responseData.size());
+    httpResponse += QByteArray::number(data.size());
     httpResponse += "\r\n";
 
     // We don't support multiple connections so let's ask the client
     // to close the connection every time.
     httpResponse += "Connection: close\r\n";
     httpResponse += "\r\n";
-    httpResponse += responseData;
+    httpResponse += data;
     return httpResponse;
 }
 
@@ -231,8 +253,22 @@ void HttpServerThread::run()
             }
         }
 
+        lock.relock();
+        const int responseDelay = m_responseDelay;
+        QByteArray range;
+        if ((m_features & Ranges) && !(m_features & Error404)) {
+            range = m_headers.value("Range");
+            if (!range.isEmpty()) {
+                ++m_rangeRequestCount;
+            }
+        }
+        lock.unlock();
+        if (responseDelay > 0) {
+            msleep(responseDelay);
+        }
+
         // send response
-        const QByteArray response = makeHttpResponse(m_dataToSend);
+        const QByteArray response = makeHttpResponse(m_dataToSend, range);
         if (doDebug) {
             qDebug() << "HttpServerThread: writing" << response;
         }
@@ -28,7 +28,8 @@ public:
         Ssl = 1, // HTTPS
         BasicAuth = 2, // Requires authentication
         Error404 = 4, // Return "404 not found"
-                      // bitfield, next item is 8
+        Ranges = 8, // Honour "Range" headers with "206 Partial Content"
+                    // bitfield, next item is 16
     };
     Q_DECLARE_FLAGS(Features, Feature)
 
@@ -63,6 +64,20 @@ public:
         m_features = features;
     }
 
+    // Waits before each response, to simulate a slow network
+    void setResponseDelay(int msecs)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_responseDelay = msecs;
+    }
+
+    // The number of requests with a "Range" header, when using the Ranges feature
+    int rangeRequestCount() const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_rangeRequestCount;
+    }
+
     void disableSsl();
     inline int serverPort() const
     {
@@ -103,7 +118,7 @@ protected:
     /* \reimp */ void run() override;
 
 private:
-    QByteArray makeHttpResponse(const QByteArray &responseData) const;
+    QByteArray makeHttpResponse(const QByteArray &responseData, const QByteArray &range) const;
 
 private:
     QByteArray m_partialRequest;
@@ -111,11 +126,13 @@ private:
     QByteArray m_dataToSend;
     QByteArray m_contentType;
 
-    mutable QMutex m_mutex; // protects the 4 vars below
+    mutable QMutex m_mutex; // protects the 6 vars below
     QByteArray m_receivedData;
     QByteArray m_receivedHeaders;
     QMap<QByteArray, QByteArray> m_headers;
     int m_port;
+    int m_responseDelay = 0;
+    int m_rangeRequestCount = 0;
 
     Features m_features;
     BlockingHttpServer *m_server;
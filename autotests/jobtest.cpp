@@ -15,6 +15,7 @@
 #include <kio/deletejob.h>
 #include <kio/directorysizejob.h>
 #include <kio/statjob.h>
+#include <kio/transferjobdevice.h>
 #include <kmountpoint.h>
 #include <kprotocolinfo.h>
 
@@ -172,6 +173,76 @@ void JobTest::storedGet()
     QVERIFY(!spyPercent.isEmpty());
 }
 
+static QByteArray createBigTestFile(const QString &path)
+{
+    QByteArray content;
+    content.reserve(1024 * 1024);
+    for (int i = 0; content.size() < 1024 * 1024; ++i) {
+        content += QByteArray::number(i) + '\n';
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+        qFatal("Couldn't write %s", qPrintable(path));
+    }
+    return content;
+}
+
+void JobTest::getFlowControlled()
+{
+    const QString filePath = homeTmpDir() + "bigFileFromHome";
+    const QByteArray content = createBigTestFile(filePath);
+    const qint64 window = 64 * 1024;
+
+    KIO::TransferJob *job = KIO::get(QUrl::fromLocalFile(filePath), KIO::NoReload, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    job->setFlowControlWindow(window);
+    job->setManualDataAcknowledgementEnabled(true);
+    QByteArray received;
+    connect(job, &KIO::TransferJob::data, this, [&received](KIO::Job *, const QByteArray &data) {
+        received += data;
+    });
+    QSignalSpy spyResult(job, &KJob::result);
+
+    // Without acknowledgement, the worker stops after sending the window (plus at most one block)
+    QTRY_VERIFY(!received.isEmpty());
+    QTest::qWait(200);
+    QVERIFY(spyResult.isEmpty());
+    QVERIFY2(received.size() < 2 * window, QByteArray::number(received.size()).constData());
+
+    // Acknowledging the data lets it send the rest
+    connect(job, &KIO::TransferJob::data, job, [job](KIO::Job *, const QByteArray &data) {
+        job->acknowledgeData(data.size());
+    });
+    job->acknowledgeData(received.size());
+    QTRY_COMPARE(spyResult.count(), 1);
+    QCOMPARE(spyResult.at(0).at(0).value<KJob *>()->error(), 0);
+    QCOMPARE(received.size(), content.size());
+    QVERIFY(received == content);
+}
+
+void JobTest::transferJobDevice()
+{
+    const QString filePath = homeTmpDir() + "bigFileFromHome";
+    const QByteArray content = createBigTestFile(filePath);
+    const qint64 bufferSize = 64 * 1024;
+
+    KIO::TransferJobDevice device(KIO::get(QUrl::fromLocalFile(filePath), KIO::NoReload, KIO::HideProgressInfo), bufferSize);
+    device.job()->setUiDelegate(nullptr);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QVERIFY(device.isSequential());
+
+    QByteArray received;
+    while (device.waitForReadyRead(5000)) {
+        QVERIFY(device.bytesAvailable() < 2 * bufferSize);
+        received += device.read(1000); // the device keeps the rest
+    }
+    QVERIFY(device.isFinished());
+    QVERIFY(device.atEnd());
+    QCOMPARE(device.job()->error(), 0);
+    QCOMPARE(received.size(), content.size());
+    QVERIFY(received == content);
+}
+
 void JobTest::slotGetResult(KJob *job)
 {
     m_result = job->error();
@@ -1418,6 +1489,35 @@ void JobTest::multipleListRecursive()
     QCOMPARE(joinedNames.toLatin1(), ref_names);
 }
 
+void JobTest::listRecursiveWithoutHidden()
+{
+    QTemporaryDir dir(homeTmpDir() + "ListRecursiveHiddenTest");
+    QVERIFY(dir.isValid());
+    const QString src = dir.path();
+    QVERIFY(QDir(src).mkpath("dir/subdir"));
+    QVERIFY(QDir(src).mkpath(".hiddenDir/subdir"));
+    createTestFile(src + "/dir/subdir/file");
+    createTestFile(src + "/dir/.hiddenFile");
+    createTestFile(src + "/.hiddenDir/file");
+
+    m_names.clear();
+    KIO::ListJob *job = KIO::listRecursive(QUrl::fromLocalFile(src), KIO::HideProgressInfo, false /*includeHidden*/);
+    job->setUiDelegate(nullptr);
+    connect(job, &KIO::ListJob::entries, this, &JobTest::slotEntries);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+    m_names.sort();
+    QCOMPARE(m_names, QStringList({"dir", "dir/subdir", "dir/subdir/file"}));
+
+    m_names.clear();
+    job = KIO::listRecursive(QUrl::fromLocalFile(src), KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    connect(job, &KIO::ListJob::entries, this, &JobTest::slotEntries);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+    m_names.sort();
+    QCOMPARE(m_names,
+             QStringList({".", "..", ".hiddenDir", ".hiddenDir/file", ".hiddenDir/subdir", "dir", "dir/.hiddenFile", "dir/subdir", "dir/subdir/file"}));
+}
+
 void JobTest::listFile()
 {
     const QString filePath = homeTmpDir() + "fileFromHome";
@@ -1506,6 +1606,29 @@ void JobTest::directorySizeError()
     qApp->sendPostedEvents(nullptr, QEvent::DeferredDelete);
 }
 
+void JobTest::directorySizeHardlinks()
+{
+#ifdef Q_OS_WIN
+    QSKIP("Test skipped on Windows");
+#else
+    const QString dir = homeTmpDir() + "dirWithHardlinks";
+    QVERIFY(QDir().mkpath(dir));
+    const QString file = dir + "/fileFromHome";
+    createTestFile(file);
+    QCOMPARE(::link(QFile::encodeName(file).constData(), QFile::encodeName(dir + "/hardlink").constData()), 0);
+
+    KIO::DirectorySizeJob *job = KIO::directorySize(QUrl::fromLocalFile(dir));
+    job->setUiDelegate(nullptr);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+    QCOMPARE(job->totalFiles(), 1ULL); // the hardlink is only counted once
+    QCOMPARE(job->totalSubdirs(), 0ULL);
+    QVERIFY(job->totalSize() >= QFileInfo(file).size());
+
+    QVERIFY(QDir(dir).removeRecursively());
+    qApp->sendPostedEvents(nullptr, QEvent::DeferredDelete);
+#endif
+}
+
 void JobTest::slotEntries(KIO::Job *, const KIO::UDSEntryList &lst)
 {
     for (KIO::UDSEntryList::ConstIterator it = lst.begin(); it != lst.end(); ++it) {
@@ -2064,6 +2187,57 @@ void JobTest::chmodSticky()
     QCOMPARE(QString::number(newItem.permissions(), 8), QString::number(newPerm, 8));
     QVERIFY(QDir().rmdir(dirPath));
 }
+
+void JobTest::chmodRecursive()
+{
+    const QString dirPath = homeTmpDir() + "dirForChmodRecursive";
+    QDir(dirPath).removeRecursively();
+    QVERIFY(QDir().mkpath(dirPath + "/subdir"));
+    const QString filePath = dirPath + "/subdir/file";
+    const QString exePath = dirPath + "/exe";
+    createTestFile(filePath);
+    createTestFile(exePath);
+    QCOMPARE(::chmod(QFile::encodeName(filePath).constData(), 0644), 0);
+    QCOMPARE(::chmod(QFile::encodeName(exePath).constData(), 0744), 0);
+    QVERIFY(QFile::link(filePath, dirPath + "/link"));
+
+    KFileItemList items({KFileItem(QUrl::fromLocalFile(dirPath))});
+    KIO::Job *job = KIO::chmod(items, 0750, 0077, QString(), QString(), true, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+
+    auto permissions = [](const QString &path) {
+        return QString::number(KFileItem(QUrl::fromLocalFile(path)).permissions(), 8);
+    };
+    QCOMPARE(permissions(dirPath), QStringLiteral("750"));
+    QCOMPARE(permissions(dirPath + "/subdir"), QStringLiteral("750"));
+    // +X emulation: files without any x bit don't get one
+    QCOMPARE(permissions(filePath), QStringLiteral("640"));
+    QCOMPARE(permissions(exePath), QStringLiteral("750"));
+    QVERIFY(QDir(dirPath).removeRecursively());
+}
+
+void JobTest::chmodRecursiveNestedItems()
+{
+    // A directory and one of its subdirectories: the subdirectory has to be changed
+    // before its parent loses the x bit, like when ChmodJob listed the directories
+    const QString dirPath = homeTmpDir() + "dirForChmodRecursiveNested";
+    QDir(dirPath).removeRecursively();
+    const QString subdirPath = dirPath + "/subdir";
+    QVERIFY(QDir().mkpath(subdirPath));
+    createTestFile(subdirPath + "/file");
+
+    KFileItemList items({KFileItem(QUrl::fromLocalFile(dirPath)), KFileItem(QUrl::fromLocalFile(subdirPath))});
+    KIO::Job *job = KIO::chmod(items, 0, 0100, QString(), QString(), true, KIO::HideProgressInfo);
+    job->setUiDelegate(nullptr);
+    QVERIFY2(job->exec(), qPrintable(job->errorString()));
+
+    QCOMPARE(KFileItem(QUrl::fromLocalFile(dirPath)).permissions() & 0100, 0);
+    QCOMPARE(::chmod(QFile::encodeName(dirPath).constData(), 0700), 0);
+    QCOMPARE(KFileItem(QUrl::fromLocalFile(subdirPath)).permissions() & 0100, 0);
+    QCOMPARE(::chmod(QFile::encodeName(subdirPath).constData(), 0700), 0);
+    QVERIFY(QDir(dirPath).removeRecursively());
+}
 #endif
 
 void JobTest::chmodFileError()
@@ -36,6 +36,8 @@ private Q_SLOTS:
 
     // Local tests (kio_file only)
     void storedGet();
+    void getFlowControlled();
+    void transferJobDevice();
     void put();
     void putPermissionKept();
     void storedPut();
@@ -61,12 +63,14 @@ private Q_SLOTS:
     void suspendCopy();
     void listRecursive();
     void multipleListRecursive();
+    void listRecursiveWithoutHidden();
     void listFile();
     void killJob();
     void killJobBeforeStart();
     void deleteJobBeforeStart();
     void directorySize();
     void directorySizeError();
+    void directorySizeHardlinks();
     void moveFileToSamePartition();
     void moveDirectoryToSamePartition();
     void moveDirectoryIntoItself();
@@ -98,6 +102,8 @@ private Q_SLOTS:
     void chmodFile();
 #ifdef Q_OS_UNIX
     void chmodSticky();
+    void chmodRecursive();
+    void chmodRecursiveNestedItems();
 #endif
     void chmodFileError();
     void mimeType();
@@ -0,0 +1,99 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QTest>
+
+#include <KFileItem>
+#include <kio/udsentry.h>
+
+#include "dirlistingchanges_p.h"
+
+#include <qplatformdefs.h>
+
+#include <algorithm>
+#include <set>
+
+/*
+   Measures how KCoreDirLister matches a new listing of an already listed directory
+   with its items (KIO::compareDirListing(), used by updateDirectory()), on prepared
+   lists: with no file, 1% of the files or all of them changed between two listings.
+   The listing and the creation of the items of the changed files aren't measured.
+   The directories with one million files are only used when KIO_BENCHMARK_LARGE is set.
+*/
+class KCoreDirListerUpdateBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void compareDirListing_data();
+    void compareDirListing();
+};
+
+static KIO::UDSEntry fileEntry(int index, long long size)
+{
+    KIO::UDSEntry entry;
+    entry.reserve(5);
+    entry.fastInsert(KIO::UDSEntry::UDS_NAME, QStringLiteral("file%1.txt").arg(index));
+    entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    entry.fastInsert(KIO::UDSEntry::UDS_ACCESS, 0644);
+    entry.fastInsert(KIO::UDSEntry::UDS_SIZE, size);
+    entry.fastInsert(KIO::UDSEntry::UDS_MODIFICATION_TIME, 1700000000 + index);
+    return entry;
+}
+
+void KCoreDirListerUpdateBenchmark::compareDirListing_data()
+{
+    QTest::addColumn<int>("fileCount");
+    QTest::addColumn<int>("changedPercent");
+
+    QList<int> fileCounts{10000, 100000};
+    if (qEnvironmentVariableIsSet("KIO_BENCHMARK_LARGE")) {
+        fileCounts.append(1000000);
+    }
+    for (int fileCount : std::as_const(fileCounts)) {
+        for (int changedPercent : {0, 1, 100}) {
+            QTest::addRow("%d files, %d%% changed", fileCount, changedPercent) << fileCount << changedPercent;
+        }
+    }
+}
+
+void KCoreDirListerUpdateBenchmark::compareDirListing()
+{
+    QFETCH(int, fileCount);
+    QFETCH(int, changedPercent);
+
+    const QUrl dirUrl = QUrl::fromLocalFile(QStringLiteral("/benchmark"));
+    QList<KFileItem> items;
+    items.reserve(fileCount);
+    KIO::UDSEntryList entries;
+    entries.reserve(fileCount + 1);
+    KIO::UDSEntry dotEntry;
+    dotEntry.fastInsert(KIO::UDSEntry::UDS_NAME, QStringLiteral("."));
+    dotEntry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+    entries.append(dotEntry);
+    // The worker lists in its own order, the items are sorted by URL
+    const int changedCount = fileCount * changedPercent / 100;
+    for (int i = fileCount - 1; i >= 0; --i) {
+        items.append(KFileItem(fileEntry(i, 0), dirUrl, true, true));
+        entries.append(fileEntry(i, i < changedCount ? 1 : 0));
+    }
+    std::sort(items.begin(), items.end());
+
+    const std::set<KFileItem> pendingUpdates;
+    KIO::DirListingChanges changes;
+    QBENCHMARK {
+        changes = KIO::compareDirListing(items, entries, pendingUpdates);
+    }
+    QCOMPARE(changes.dotEntry, 0);
+    QCOMPARE(qsizetype(changes.changedItems.size()), qsizetype(changedCount));
+    QVERIFY(changes.newEntries.empty());
+    QVERIFY(changes.deletedItems.empty());
+}
+
+QTEST_GUILESS_MAIN(KCoreDirListerUpdateBenchmark)
+
+#include "kcoredirlister_update_benchmark.moc"
@@ -204,6 +204,12 @@ void KDirListerTest::testOpenUrlFromCache()
     disconnect(&m_dirLister, nullptr, this, nullptr);
 }
 
+// Whether KDirWatch reports the files created in the listed directories, see KCoreDirListerCache::DirItem::startWatching()
+static bool watchesFiles()
+{
+    return KDirWatch::self()->internalMethod() == KDirWatch::INotify;
+}
+
 // This test assumes testOpenUrl was run before. So m_dirLister is holding the items already.
 // This test creates 1 file in the temporary directory
 void KDirListerTest::testNewItem()
@@ -218,9 +224,16 @@ void KDirListerTest::testNewItem()
     createSimpleFile(path + fileName);
 
     QTRY_COMPARE(m_items.count(), 5);
-    QCOMPARE(m_dirLister.spyStarted.count(), 1); // Updates call started
-    QCOMPARE(m_dirLister.spyCompleted.count(), 1); // and completed
-    QCOMPARE(m_dirLister.spyCompletedQUrl.count(), 1);
+    if (watchesFiles()) {
+        // fast path: the new file is stat'ed alone, no directory listing needed
+        QCOMPARE(m_dirLister.spyStarted.count(), 0);
+        QCOMPARE(m_dirLister.spyCompleted.count(), 0);
+        QCOMPARE(m_dirLister.spyCompletedQUrl.count(), 0);
+    } else {
+        QCOMPARE(m_dirLister.spyStarted.count(), 1); // Updates call started
+        QCOMPARE(m_dirLister.spyCompleted.count(), 1); // and completed
+        QCOMPARE(m_dirLister.spyCompletedQUrl.count(), 1);
+    }
     QCOMPARE(m_dirLister.spyCanceled.count(), 0);
     QCOMPARE(m_dirLister.spyCanceledQUrl.count(), 0);
     QCOMPARE(m_dirLister.spyClear.count(), 0);
@@ -258,8 +271,14 @@ void KDirListerTest::testNewItems()
 
     QTRY_COMPARE(m_items.count(), 105);
 
-    QVERIFY(m_dirLister.spyStarted.count() > 0 && m_dirLister.spyStarted.count() < 3); // Updates call started, probably twice
-    QVERIFY(m_dirLister.spyCompleted.count() > 0 && m_dirLister.spyCompleted.count() < 3); // and completed, probably twice
+    if (watchesFiles()) {
+        // fast path: the new files are stat'ed one by one, no directory listing needed
+        QCOMPARE(m_dirLister.spyStarted.count(), 0);
+        QCOMPARE(m_dirLister.spyCompleted.count(), 0);
+    } else {
+        QVERIFY(m_dirLister.spyStarted.count() > 0 && m_dirLister.spyStarted.count() < 3); // Updates call started, probably twice
+        QVERIFY(m_dirLister.spyCompleted.count() > 0 && m_dirLister.spyCompleted.count() < 3); // and completed, probably twice
+    }
     QVERIFY(m_dirLister.spyCompletedQUrl.count() < 3);
     QCOMPARE(m_dirLister.spyCanceled.count(), 0);
     QCOMPARE(m_dirLister.spyCanceledQUrl.count(), 0);
@@ -307,9 +326,16 @@ void KDirListerTest::testNewItemByCopy()
     // Give time for KDirWatch/KDirNotify to notify us
     QTRY_COMPARE(m_items.count(), origItemCount + 1);
 
-    QCOMPARE(m_dirLister.spyStarted.count(), 1); // Updates call started
-    QCOMPARE(m_dirLister.spyCompleted.count(), 1); // and completed
-    QCOMPARE(m_dirLister.spyCompletedQUrl.count(), 1);
+    if (watchesFiles()) {
+        // KDirWatch doesn't trigger a listing anymore, only KDirNotify's FilesAdded might
+        QVERIFY(m_dirLister.spyStarted.count() <= 1);
+        QCOMPARE(m_dirLister.spyCompleted.count(), m_dirLister.spyStarted.count());
+        QCOMPARE(m_dirLister.spyCompletedQUrl.count(), m_dirLister.spyStarted.count());
+    } else {
+        QCOMPARE(m_dirLister.spyStarted.count(), 1); // Updates call started
+        QCOMPARE(m_dirLister.spyCompleted.count(), 1); // and completed
+        QCOMPARE(m_dirLister.spyCompletedQUrl.count(), 1);
+    }
     QCOMPARE(m_dirLister.spyCanceled.count(), 0);
     QCOMPARE(m_dirLister.spyCanceledQUrl.count(), 0);
     QCOMPARE(m_dirLister.spyClear.count(), 0);
@@ -0,0 +1,105 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KDirLister>
+#include <KDirModel>
+#include <KDirSortFilterProxyModel>
+#include <KFileItem>
+#include <kio/udsentry.h>
+
+#include <qplatformdefs.h>
+
+#include <algorithm>
+#include <memory>
+
+/*
+   Measures how fast KDirModel takes in a large listing, as KDirLister emits it:
+   in batches of 1000 items (what a worker sends at once), followed by listingDirCompleted.
+   The listing with one million items is only used when KIO_BENCHMARK_LARGE is set.
+*/
+class KDirModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void insertItems_data();
+    void insertItems();
+};
+
+static constexpr int s_batchSize = 1000;
+
+void KDirModelBenchmark::insertItems_data()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::addColumn<bool>("withProxy");
+
+    QList<int> itemCounts{10000, 100000};
+    if (qEnvironmentVariableIsSet("KIO_BENCHMARK_LARGE")) {
+        itemCounts.append(1000000);
+    }
+    for (int itemCount : std::as_const(itemCounts)) {
+        QTest::addRow("%d items", itemCount) << itemCount << false;
+        QTest::addRow("%d items, sorted", itemCount) << itemCount << true;
+    }
+}
+
+void KDirModelBenchmark::insertItems()
+{
+    QFETCH(int, itemCount);
+    QFETCH(bool, withProxy);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QUrl dirUrl = QUrl::fromLocalFile(tempDir.path());
+
+    KDirModel model;
+    KDirLister *lister = model.dirLister();
+    lister->setAutoUpdate(false);
+    QSignalSpy spyCompleted(lister, qOverload<>(&KCoreDirLister::completed));
+    model.openUrl(dirUrl);
+    QVERIFY(spyCompleted.wait());
+
+    std::unique_ptr<KDirSortFilterProxyModel> proxy;
+    if (withProxy) {
+        proxy = std::make_unique<KDirSortFilterProxyModel>();
+        proxy->setSourceModel(&model);
+        proxy->sort(0);
+    }
+
+    QList<KFileItemList> batches;
+    for (int i = 0; i < itemCount; i += s_batchSize) {
+        KFileItemList batch;
+        batch.reserve(s_batchSize);
+        for (int j = i; j < std::min(i + s_batchSize, itemCount); ++j) {
+            KIO::UDSEntry entry;
+            entry.reserve(4);
+            entry.fastInsert(KIO::UDSEntry::UDS_NAME, QStringLiteral("file%1.txt").arg(j));
+            entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+            entry.fastInsert(KIO::UDSEntry::UDS_SIZE, j);
+            entry.fastInsert(KIO::UDSEntry::UDS_MODIFICATION_TIME, 1700000000 + j);
+            batch.append(KFileItem(entry, dirUrl, true /*delayedMimeTypes*/, true /*urlIsDirectory*/));
+        }
+        batches.append(batch);
+    }
+
+    QBENCHMARK {
+        Q_EMIT lister->clear();
+        for (const KFileItemList &batch : std::as_const(batches)) {
+            Q_EMIT lister->itemsAdded(dirUrl, batch);
+        }
+        Q_EMIT lister->listingDirCompleted(dirUrl);
+        QCOMPARE(model.rowCount(), itemCount);
+    }
+}
+
+QTEST_MAIN(KDirModelBenchmark)
+
+#include "kdirmodel_benchmark.moc"
@@ -5,6 +5,7 @@
     SPDX-License-Identifier: LGPL-2.0-or-later
 */
 
+#include <algorithm>
 #include <array>
 
 #include "jobuidelegatefactory.h"
@@ -20,6 +21,7 @@
 
 #include <QDebug>
 #include <QMimeData>
+#include <QSet>
 #include <QSignalSpy>
 #include <QUrl>
 
@@ -387,6 +389,26 @@ void KDirModelTest::testData()
     QCOMPARE(m_dirModel->data(m_fileInSubdirIndex.parent(), KDirModel::ChildCountRole).toInt(), 1);
 }
 
+void KDirModelTest::testChildCountRole()
+{
+    // subdir/hasChildren isn't listed, its entries are counted in a thread
+    QModelIndex hasChildrenIndex;
+    for (int row = 0; row < m_dirModel->rowCount(m_dirIndex); ++row) {
+        const QModelIndex idx = m_dirModel->index(row, 0, m_dirIndex);
+        if (m_dirModel->itemForIndex(idx).name() == QLatin1String("hasChildren")) {
+            hasChildrenIndex = idx;
+        }
+    }
+    QVERIFY(hasChildrenIndex.isValid());
+
+    QSignalSpy spyDataChanged(m_dirModel, &QAbstractItemModel::dataChanged);
+    QCOMPARE(m_dirModel->data(hasChildrenIndex, KDirModel::ChildCountRole).toInt(), (int)KDirModel::ChildCountUnknown);
+    QTRY_COMPARE(m_dirModel->data(hasChildrenIndex, KDirModel::ChildCountRole).toInt(), 5);
+    QVERIFY(std::any_of(spyDataChanged.cbegin(), spyDataChanged.cend(), [&](const QList<QVariant> &args) {
+        return args.at(0).toModelIndex() == hasChildrenIndex;
+    }));
+}
+
 void KDirModelTest::testIcon()
 {
     /**
@@ -1463,6 +1485,132 @@ void KDirModelTest::testInvalidUrl()
     // currently ends up in KCoreDirLister::handleError. TODO: add error signal to KDirModel
 }
 
+void KDirModelTest::testBatchedInsertion()
+{
+    // Enough files for the worker to send several batches of entries
+    QTemporaryDir tempDir(homeTmpDir());
+    const QString path = tempDir.path() + '/';
+    const int fileCount = 3000;
+    for (int i = 0; i < fileCount; ++i) {
+        createTestFile(path + QStringLiteral("file_%1").arg(i));
+    }
+    createTestDirectory(path + "subdir", NoSymlink);
+    createTestFile(path + "subdir/file_0"); // same name as at the top level
+
+    KDirModel dirModel;
+    KDirLister *dirLister = dirModel.dirLister();
+    dirLister->setAutoErrorHandlingEnabled(false);
+    QSignalSpy spyRowsInserted(&dirModel, &QAbstractItemModel::rowsInserted);
+    // The rows pending insertion are inserted before the listing is reported as completed
+    int rowCountWhenCompleted = -1;
+    connect(dirLister, qOverload<>(&KCoreDirLister::completed), this, [&]() {
+        rowCountWhenCompleted = dirModel.rowCount();
+    });
+    dirModel.openUrl(QUrl::fromLocalFile(path));
+    QTRY_COMPARE_WITH_TIMEOUT(rowCountWhenCompleted, fileCount + 1, 10000);
+    QCOMPARE(dirModel.rowCount(), fileCount + 1);
+
+    // Each batch is appended after the previous one, at the top level
+    QVERIFY(spyRowsInserted.count() >= 1);
+    int expectedFirst = 0;
+    for (const QList<QVariant> &args : std::as_const(spyRowsInserted)) {
+        QVERIFY(!args[0].value<QModelIndex>().isValid());
+        QCOMPARE(args[1].toInt(), expectedFirst);
+        QVERIFY(args[2].toInt() >= args[1].toInt());
+        expectedFirst = args[2].toInt() + 1;
+    }
+    QCOMPARE(expectedFirst, fileCount + 1);
+
+    // No item was inserted twice, and each one can be found
+    QSet<QString> names;
+    for (int row = 0; row < dirModel.rowCount(); ++row) {
+        const QModelIndex index = dirModel.index(row, 0);
+        const KFileItem item = dirModel.itemForIndex(index);
+        QVERIFY(!names.contains(item.name()));
+        names.insert(item.name());
+        QCOMPARE(dirModel.indexForUrl(item.url()), index);
+    }
+
+    // The items of a subdirectory go under it
+    const QModelIndex subdirIndex = dirModel.indexForUrl(QUrl::fromLocalFile(path + "subdir"));
+    QVERIFY(subdirIndex.isValid());
+    spyRowsInserted.clear();
+    QSignalSpy spyDirCompleted(dirLister, qOverload<const QUrl &>(&KCoreDirLister::completed));
+    dirModel.fetchMore(subdirIndex);
+    QVERIFY(spyDirCompleted.wait());
+    QCOMPARE(dirModel.rowCount(subdirIndex), 2);
+    QVERIFY(!spyRowsInserted.isEmpty());
+    for (const QList<QVariant> &args : std::as_const(spyRowsInserted)) {
+        QCOMPARE(args[0].value<QModelIndex>(), subdirIndex);
+    }
+    const QModelIndex subdirFileIndex = dirModel.indexForUrl(QUrl::fromLocalFile(path + "subdir/file_0"));
+    QVERIFY(subdirFileIndex.isValid());
+    QCOMPARE(subdirFileIndex.parent(), subdirIndex);
+    const QModelIndex topLevelFileIndex = dirModel.indexForUrl(QUrl::fromLocalFile(path + "file_0"));
+    QVERIFY(topLevelFileIndex.isValid());
+    QVERIFY(!topLevelFileIndex.parent().isValid());
+    QCOMPARE(dirModel.rowCount(), fileCount + 1);
+}
+
+void KDirModelTest::testLookupAfterRenameAndDelete()
+{
+    QTemporaryDir tempDir(homeTmpDir());
+    const QString path = tempDir.path() + '/';
+    createTestFile(path + "a");
+    createTestFile(path + "b");
+    createTestFile(path + "c");
+    createTestFile(path + "d");
+
+    KDirModel dirModel;
+    dirModel.dirLister()->setAutoErrorHandlingEnabled(false);
+    QSignalSpy spyCompleted(dirModel.dirLister(), qOverload<>(&KCoreDirLister::completed));
+    dirModel.openUrl(QUrl::fromLocalFile(path));
+    QVERIFY(spyCompleted.wait());
+    QCOMPARE(dirModel.rowCount(), 4);
+    auto urlOf = [&path](const char *name) {
+        return QUrl::fromLocalFile(path + QLatin1String(name));
+    };
+    auto nameAt = [&dirModel](const QModelIndex &index) {
+        return dirModel.itemForIndex(index).name();
+    };
+
+    // Renamed: found under the new name only
+    const int rowOfA = dirModel.indexForUrl(urlOf("a")).row();
+    QSignalSpy spyDataChanged(&dirModel, &QAbstractItemModel::dataChanged);
+    KIO::SimpleJob *job = KIO::rename(urlOf("a"), urlOf("a2"), KIO::HideProgressInfo);
+    QVERIFY(job->exec());
+    QTRY_VERIFY(!spyDataChanged.isEmpty());
+    QVERIFY(!dirModel.indexForUrl(urlOf("a")).isValid());
+    QCOMPARE(dirModel.indexForUrl(urlOf("a2")).row(), rowOfA);
+    QCOMPARE(nameAt(dirModel.indexForUrl(urlOf("a2"))), QStringLiteral("a2"));
+
+    // The old name can be used again
+    createTestFile(path + "a");
+    QTRY_COMPARE(dirModel.rowCount(), 5);
+    QCOMPARE(nameAt(dirModel.indexForUrl(urlOf("a"))), QStringLiteral("a"));
+    QCOMPARE(nameAt(dirModel.indexForUrl(urlOf("a2"))), QStringLiteral("a2"));
+
+    // Renamed over another file: that one is gone
+    job = KIO::rename(urlOf("c"), urlOf("d"), KIO::HideProgressInfo | KIO::Overwrite);
+    QVERIFY(job->exec());
+    QTRY_COMPARE(dirModel.rowCount(), 4);
+    QTRY_VERIFY(!dirModel.indexForUrl(urlOf("c")).isValid());
+    QCOMPARE(nameAt(dirModel.indexForUrl(urlOf("d"))), QStringLiteral("d"));
+
+    // Deleted: the rows after it moved, and are still found
+    KIO::DeleteJob *delJob = KIO::del(urlOf("b"), KIO::HideProgressInfo);
+    QVERIFY(delJob->exec());
+    QTRY_COMPARE(dirModel.rowCount(), 3);
+    QVERIFY(!dirModel.indexForUrl(urlOf("b")).isValid());
+    const QStringList names{QStringLiteral("a"), QStringLiteral("a2"), QStringLiteral("d")};
+    for (const QString &name : names) {
+        const QModelIndex index = dirModel.indexForUrl(QUrl::fromLocalFile(path + name));
+        QVERIFY2(index.isValid(), qPrintable(name));
+        QCOMPARE(nameAt(index), name);
+        QCOMPARE(dirModel.index(index.row(), 0), index);
+    }
+}
+
 void KDirModelTest::testDeleteFile()
 {
     fillModel(true);
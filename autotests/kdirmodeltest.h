@@ -30,6 +30,7 @@ private Q_SLOTS:
     void testItemForIndex();
     void testIndexForItem();
     void testData();
+    void testChildCountRole();
 
     /**
      * Test if the icon is valid if "Icon" is specified in the desktop file, and can fall back to "unknown"
@@ -65,6 +66,8 @@ private Q_SLOTS:
     void testHasChildren_data();
     void testHasChildren();
     void testInvalidUrl();
+    void testBatchedInsertion();
+    void testLookupAfterRenameAndDelete();
 
     // These tests must be done last
     void testDeleteFile();
@@ -0,0 +1,112 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <KDirLister>
+#include <KDirModel>
+#include <KDirSortFilterProxyModel>
+
+#include <QCollator>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+
+class KDirSortFilterProxyModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testNaturalSorting_data();
+    void testNaturalSorting();
+};
+
+void KDirSortFilterProxyModelTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    // The C locale has no natural sorting
+    QLocale::setDefault(QLocale(QLocale::English, QLocale::UnitedStates));
+}
+
+void KDirSortFilterProxyModelTest::testNaturalSorting_data()
+{
+    QTest::addColumn<QStringList>("fileNames");
+
+    QTest::newRow("few") << QStringList{QStringLiteral("file10.txt"),
+                                        QStringLiteral("file2.txt"),
+                                        QStringLiteral("File3.txt"),
+                                        QStringLiteral("file1.txt"),
+                                        QStringLiteral("FILE1.txt"),
+                                        QStringLiteral("a b"),
+                                        QStringLiteral("ab"),
+                                        QStringLiteral("Äb"),
+                                        QStringLiteral("z")};
+
+    // Enough files for the collation keys to be computed in parallel
+    QStringList many;
+    QRandomGenerator random(42);
+    for (int i = 0; i < 5000; ++i) {
+        many.append(QStringLiteral("%1file%2-%3").arg(i % 2 ? QStringLiteral("F") : QStringLiteral("f")).arg(random.bounded(1000)).arg(i));
+    }
+    QTest::newRow("many") << many;
+}
+
+void KDirSortFilterProxyModelTest::testNaturalSorting()
+{
+    QFETCH(QStringList, fileNames);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    QVERIFY(QDir(tempDir.path()).mkdir(QStringLiteral("subdir9")));
+    QVERIFY(QDir(tempDir.path()).mkdir(QStringLiteral("subdir10")));
+    for (const QString &fileName : std::as_const(fileNames)) {
+        QFile file(tempDir.filePath(fileName));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    KDirModel model;
+    KDirSortFilterProxyModel proxy;
+    proxy.setSourceModel(&model);
+    QSignalSpy spyCompleted(model.dirLister(), qOverload<>(&KCoreDirLister::completed));
+    model.dirLister()->openUrl(QUrl::fromLocalFile(tempDir.path()));
+    QVERIFY(spyCompleted.wait());
+
+    // What QCollator::compare gives, folders first
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    auto lessThan = [&collator](const QString &left, const QString &right) {
+        const int result = collator.compare(left, right);
+        return result != 0 ? result < 0 : QString::compare(left, right, Qt::CaseSensitive) < 0;
+    };
+    std::sort(fileNames.begin(), fileNames.end(), lessThan);
+    QStringList expected{QStringLiteral("subdir9"), QStringLiteral("subdir10")};
+    expected += fileNames;
+
+    auto proxyOrder = [&proxy]() {
+        QStringList names;
+        for (int row = 0; row < proxy.rowCount(); ++row) {
+            names.append(proxy.index(row, KDirModel::Name).data().toString());
+        }
+        return names;
+    };
+    QCOMPARE(proxyOrder(), expected);
+
+    // Sorting again gives the same result
+    proxy.sort(KDirModel::Name, Qt::DescendingOrder);
+    proxy.sort(KDirModel::Name, Qt::AscendingOrder);
+    QCOMPARE(proxyOrder(), expected);
+}
+
+QTEST_MAIN(KDirSortFilterProxyModelTest)
+
+#include "kdirsortfilterproxymodeltest.moc"
@@ -10,6 +10,7 @@
 #include <kfileitem.h>
 #include <kfileitemlistproperties.h>
 
+#include "filesystemtypecache_p.h"
 #include "kiotesthelper.h"
 #include <KConfigGroup>
 #include <KDesktopFile>
@@ -19,6 +20,7 @@
 
 #include <KProtocolInfo>
 #include <QMimeDatabase>
+#include <qplatformdefs.h>
 
 QTEST_MAIN(KFileItemTest)
 
@@ -522,6 +524,28 @@ void KFileItemTest::testDotDirectory()
     }
 }
 
+void KFileItemTest::testFileSystemTypeCache()
+{
+    QTemporaryDir tempDir;
+    const KFileSystemType::Type type = KFileSystemType::fileSystemType(tempDir.path());
+
+    // The type is looked up once per device
+    KIO::FileSystemTypeCache *cache = KIO::FileSystemTypeCache::instance();
+    cache->clear();
+    const qint64 deviceId = 123456789;
+    QCOMPARE(cache->fileSystemType(deviceId, tempDir.path()), type);
+    QCOMPARE(cache->fileSystemType(deviceId, QStringLiteral("/does/not/exist")), type);
+
+    KIO::UDSEntry entry;
+    entry.fastInsert(KIO::UDSEntry::UDS_NAME, QStringLiteral("afile"));
+    entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    entry.fastInsert(KIO::UDSEntry::UDS_ACCESS, 0644);
+    entry.fastInsert(KIO::UDSEntry::UDS_DEVICE_ID, deviceId);
+    const KFileItem fileItem(entry, QUrl::fromLocalFile(tempDir.path()), false, true);
+    QCOMPARE(fileItem.isSlow(), KIO::FileSystemTypeCache::isSlow(type));
+    cache->clear();
+}
+
 void KFileItemTest::testDecodeFileName_data()
 {
     QTest::addColumn<QString>("filename");
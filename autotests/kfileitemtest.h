@@ -30,6 +30,7 @@ private Q_SLOTS:
     void testRename();
     void testRefresh();
     void testDotDirectory();
+    void testFileSystemTypeCache();
     void testMimetypeForRemoteFolder();
     void testMimetypeForRemoteFolderWithFileType();
     void testCurrentMimetypeForRemoteFolder();
@@ -7,6 +7,7 @@
 #include "kmountpointtest.h"
 
 #include "kmountpoint.h"
+#include "kmountpoint_p.h"
 #include <QDebug>
 #include <QTest>
 #include <qplatformdefs.h>
@@ -79,6 +80,27 @@ void KMountPointTest::testCurrentMountPoints()
 #endif
 }
 
+void KMountPointTest::testFindByPathInCurrentMountPoints()
+{
+    const KMountPoint::List mountPoints = KMountPoint::currentMountPoints();
+    if (mountPoints.isEmpty()) { // can happen in chroot jails
+        QSKIP("mtab is empty");
+    }
+
+    // A modified copy doesn't use the lookup of the current mount points
+    KMountPoint::List copy = mountPoints;
+    copy.append(KMountPoint::Ptr());
+    copy.removeLast();
+    QVERIFY(copy.constData() != mountPoints.constData());
+
+    const QStringList paths{QStringLiteral("/"), QStringLiteral("/home"), QDir::homePath(), QDir::tempPath(), QStringLiteral("/proc/self")};
+    for (const QString &path : paths) {
+        const KMountPoint::Ptr found = mountPoints.findByPath(path);
+        const KMountPoint::Ptr expected = copy.findByPath(path);
+        QCOMPARE(found.data(), expected.data());
+    }
+}
+
 void KMountPointTest::testCurrentMountPointOptions()
 {
     const KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::NeedRealDeviceName | KMountPoint::NeedMountOptions);
@@ -174,4 +196,57 @@ void KMountPointTest::testPossibleMountPoints()
 #endif
 }
 
+void KMountPointTest::testDiffMountPoints()
+{
+    const KMountPoint::List mountPoints = KMountPoint::currentMountPoints();
+    if (mountPoints.size() < 2) { // can happen in chroot jails
+        QSKIP("mtab has less than two mount points");
+    }
+
+    KMountPoint::List added;
+    KMountPoint::List removed;
+    auto diff = [&](const KMountPoint::List &oldMountPoints, const KMountPoint::List &newMountPoints) {
+        added.clear();
+        removed.clear();
+        KIO::diffMountPoints(oldMountPoints, newMountPoints, added, removed);
+    };
+
+    diff(mountPoints, mountPoints);
+    QVERIFY(added.isEmpty());
+    QVERIFY(removed.isEmpty());
+
+    // The order doesn't matter
+    KMountPoint::List reversed = mountPoints;
+    std::reverse(reversed.begin(), reversed.end());
+    diff(mountPoints, reversed);
+    QVERIFY(added.isEmpty());
+    QVERIFY(removed.isEmpty());
+
+    // Unmounted, then mounted again
+    KMountPoint::List withoutLast = mountPoints;
+    const KMountPoint::Ptr last = withoutLast.takeLast();
+    diff(mountPoints, withoutLast);
+    QVERIFY(added.isEmpty());
+    QCOMPARE(removed.size(), 1);
+    QCOMPARE(removed.first().data(), last.data());
+    diff(withoutLast, mountPoints);
+    QCOMPARE(added.size(), 1);
+    QCOMPARE(added.first().data(), last.data());
+    QVERIFY(removed.isEmpty());
+
+    // Both at once
+    KMountPoint::List withoutFirst = mountPoints;
+    const KMountPoint::Ptr first = withoutFirst.takeFirst();
+    diff(withoutFirst, withoutLast);
+    QCOMPARE(added.size(), 1);
+    QCOMPARE(added.first().data(), first.data());
+    QCOMPARE(removed.size(), 1);
+    QCOMPARE(removed.first().data(), last.data());
+
+    // Everything
+    diff(mountPoints, {});
+    QCOMPARE(removed.size(), mountPoints.size());
+    QVERIFY(added.isEmpty());
+}
+
 #include "moc_kmountpointtest.cpp"
@@ -16,8 +16,10 @@ private Q_SLOTS:
     void initTestCase();
 
     void testCurrentMountPoints();
+    void testFindByPathInCurrentMountPoints();
     void testCurrentMountPointOptions();
     void testPossibleMountPoints();
+    void testDiffMountPoints();
 
 private:
 };
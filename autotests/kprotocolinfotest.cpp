@@ -31,6 +31,8 @@ private Q_SLOTS:
     void testWorkerProtocol();
     void testProxySettings_data();
     void testProxySettings();
+    void testProxyCacheKey();
+    void testNoProxySubnets();
     void testCapabilities();
     void testProtocolForArchiveMimetype();
     void testHelperProtocols();
@@ -121,6 +123,95 @@ void KProtocolInfoTest::testProxySettings()
     KProtocolManager::reparseConfiguration();
 }
 
+void KProtocolInfoTest::testProxyCacheKey()
+{
+    // One lookup per scheme, host and port
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("http://a:180/dir"))), QStringLiteral("http://a:180"));
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("http://a1:80/dir"))), QStringLiteral("http://a1:80"));
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("http://a/dir/file"))), QStringLiteral("http://a"));
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("ftp://a/dir/file"))), QStringLiteral("ftp://a"));
+
+    KConfig config(QStringLiteral("kioslaverc"), KConfig::NoGlobals);
+    KConfigGroup cfg(&config, "Proxy Settings");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::PACProxy));
+    cfg.writeEntry("PathDependentProxyScript", true);
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+
+    // The script looks at the whole URL, but the user info and the fragment aren't sent to it
+    const QUrl url(QStringLiteral("http://user:pass@a:180/dir/file?q=1#fragment"));
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(url), QStringLiteral("http://a:180/dir/file?q=1"));
+    QVERIFY(KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("http://a:180/dir/other")))
+            != KProtocolManagerPrivate::proxyCacheKey(QUrl(QStringLiteral("http://a:180/dir/file"))));
+
+    // The option is only about proxy scripts
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::ManualProxy));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+    QCOMPARE(KProtocolManagerPrivate::proxyCacheKey(url), QStringLiteral("http://a:180"));
+
+    // restore
+    cfg.deleteEntry("PathDependentProxyScript");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::NoProxy));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+}
+
+void KProtocolInfoTest::testNoProxySubnets()
+{
+    KConfig config(QStringLiteral("kioslaverc"), KConfig::NoGlobals);
+    KConfigGroup cfg(&config, "Proxy Settings");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::ManualProxy));
+    cfg.writeEntry("httpProxy", QStringLiteral("http://proxy.example:3128"));
+    cfg.writeEntry("NoProxyFor", QStringLiteral("127.0.0.0/8,::1/128,example.org"));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+
+    const QStringList proxy{QStringLiteral("http://proxy.example:3128")};
+    QString protocol;
+    QStringList proxyList;
+
+    // Addresses and the names of the list are matched right away
+    QVERIFY(KProtocolManagerPrivate::cachedWorkerProtocol(QUrl(QStringLiteral("http://127.0.0.1:8080/")), protocol, proxyList));
+    QCOMPARE(protocol, QStringLiteral("http"));
+    QVERIFY(proxyList.isEmpty());
+    QVERIFY(KProtocolManagerPrivate::cachedWorkerProtocol(QUrl(QStringLiteral("http://10.1.1.10/")), protocol, proxyList));
+    QCOMPARE(proxyList, proxy);
+    QVERIFY(KProtocolManagerPrivate::cachedWorkerProtocol(QUrl(QStringLiteral("http://www.example.org/")), protocol, proxyList));
+    QVERIFY(proxyList.isEmpty());
+
+    // Other names have to be looked up first, which doesn't happen here
+    const QUrl url(QStringLiteral("http://localhost:8080/"));
+    QVERIFY(!KProtocolManagerPrivate::cachedWorkerProtocol(url, protocol, proxyList));
+
+    bool found = false;
+    protocol.clear();
+    proxyList = proxy;
+    KProtocolManagerPrivate::lookupWorkerProtocol(url, this, [&](const QString &workerProtocol, const QStringList &proxies) {
+        found = true;
+        protocol = workerProtocol;
+        proxyList = proxies;
+    });
+    QVERIFY(!found);
+    QTRY_VERIFY(found);
+    QCOMPARE(protocol, QStringLiteral("http"));
+    QVERIFY(proxyList.isEmpty());
+
+    // The answer is cached, and so is the address for the other ports
+    QVERIFY(KProtocolManagerPrivate::cachedWorkerProtocol(url, protocol, proxyList));
+    QVERIFY(proxyList.isEmpty());
+    QVERIFY(KProtocolManagerPrivate::cachedWorkerProtocol(QUrl(QStringLiteral("http://localhost:8081/")), protocol, proxyList));
+    QVERIFY(proxyList.isEmpty());
+    QCOMPARE(KProtocolManagerPrivate::proxiesForUrl(QUrl(QStringLiteral("http://localhost:8082/"))), QStringList{QStringLiteral("DIRECT")});
+
+    // restore
+    cfg.deleteEntry("httpProxy");
+    cfg.deleteEntry("NoProxyFor");
+    cfg.writeEntry("ProxyType", static_cast<int>(KProtocolManager::NoProxy));
+    cfg.sync();
+    KProtocolManager::reparseConfiguration();
+}
+
 void KProtocolInfoTest::testCapabilities()
 {
     QStringList capabilities = KProtocolInfo::capabilities(QStringLiteral("imap"));
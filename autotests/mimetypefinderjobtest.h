@@ -24,6 +24,8 @@ private Q_SLOTS:
 
     void invalidUrl();
     void nonExistingFile();
+    void cachedMimeType();
+    void cachedRemoteMimeType();
 
     void httpUrlWithKIO();
     void killHttp();
@@ -121,6 +121,20 @@ private Q_SLOTS:
         QVERIFY(QFile::exists(url.toLocalFile()));
     }
 
+    void shouldFailIfFileExists()
+    {
+        const QString filePath = m_dir + "/file";
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+        KIO::MkpathJob *job = KIO::mkpath(QUrl::fromLocalFile(filePath + "/subdir/subsubdir"));
+        job->setUiDelegate(nullptr);
+        QSignalSpy spy(job, &KIO::MkpathJob::directoryCreated);
+        QVERIFY(!job->exec());
+        QCOMPARE(job->error(), KIO::ERR_FILE_ALREADY_EXIST);
+        QCOMPARE(spy.count(), 0);
+    }
+
 private:
     QTemporaryDir m_tempDir;
     QString m_dir;
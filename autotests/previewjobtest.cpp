@@ -0,0 +1,163 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <KIO/PreviewJob>
+
+#include <KConfigGroup>
+#include <KFileItem>
+#include <KPluginMetaData>
+#include <KSharedConfig>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QPixmap>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <algorithm>
+
+// The thumbnail worker isn't part of KIO. The previews of the files with a thumbnail
+// in the cache don't need it, the others fail without it.
+class PreviewJobTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+
+        // See fakethumbnail.cpp
+        const QList<KPluginMetaData> plugins = KIO::PreviewJob::availableThumbnailerPlugins();
+        QVERIFY(std::any_of(plugins.cbegin(), plugins.cend(), [](const KPluginMetaData &plugin) {
+            return plugin.pluginId() == QLatin1String("fakethumbnail");
+        }));
+    }
+
+    void init()
+    {
+        QDir(thumbnailRoot()).removeRecursively();
+    }
+
+    void cleanupTestCase()
+    {
+        QDir(thumbnailRoot()).removeRecursively();
+    }
+
+    void shouldReportEachItemOnce()
+    {
+        KFileItemList items;
+        for (int i = 0; i < 4; ++i) {
+            createFile(QStringLiteral("cached_%1").arg(i), true, items);
+        }
+        for (int i = 0; i < 2; ++i) {
+            createFile(QStringLiteral("uncached_%1").arg(i), false, items);
+        }
+        // No plugin for that MIME type
+        QFile unsupportedFile(m_tempDir.filePath(QStringLiteral("unsupported")));
+        QVERIFY(unsupportedFile.open(QIODevice::WriteOnly));
+        unsupportedFile.close();
+        const QUrl unsupportedUrl = QUrl::fromLocalFile(unsupportedFile.fileName());
+        items.append(KFileItem(unsupportedUrl, QStringLiteral("application/octet-stream"), KFileItem::Unknown));
+
+        KIO::PreviewJob *job = KIO::filePreview(items, QSize(128, 128), &m_plugins);
+        QList<QUrl> previews;
+        QList<QUrl> failures;
+        bool nullPreview = false;
+        connect(job, &KIO::PreviewJob::gotPreview, this, [&](const KFileItem &item, const QPixmap &preview) {
+            previews.append(item.url());
+            nullPreview = nullPreview || preview.isNull();
+        });
+        connect(job, &KIO::PreviewJob::failed, this, [&](const KFileItem &item) {
+            failures.append(item.url());
+        });
+        QVERIFY(job->exec());
+
+        QVERIFY(!nullPreview);
+        QCOMPARE(previews.size() + failures.size(), items.size());
+        for (const KFileItem &item : std::as_const(items)) {
+            QVERIFY2(previews.count(item.url()) + failures.count(item.url()) == 1, qPrintable(item.name()));
+            if (item.name().startsWith(QLatin1String("cached_"))) {
+                QVERIFY2(previews.contains(item.url()), qPrintable(item.name()));
+            }
+        }
+        QVERIFY(failures.contains(unsupportedUrl));
+    }
+
+    void shouldStartPrioritizedItemsFirst()
+    {
+        // One item at a time, so that the previews come in the order of the queue
+        KConfigGroup group(KSharedConfig::openConfig(), QStringLiteral("PreviewSettings"));
+        group.writeEntry("MaximumWorkers", 1);
+
+        KFileItemList items;
+        for (int i = 0; i < 6; ++i) {
+            createFile(QStringLiteral("item_%1").arg(i), true, items);
+        }
+
+        KIO::PreviewJob *job = KIO::filePreview(items, QSize(128, 128), &m_plugins);
+        QList<QUrl> previews;
+        QList<QUrl> failures;
+        connect(job, &KIO::PreviewJob::gotPreview, this, [&](const KFileItem &item) {
+            if (previews.isEmpty()) {
+                // The first item was started, the others are queued
+                job->prioritizeItems({items.at(4).url(), items.at(2).url()});
+                job->removeItem(items.at(5).url());
+            }
+            previews.append(item.url());
+        });
+        connect(job, &KIO::PreviewJob::failed, this, [&](const KFileItem &item) {
+            failures.append(item.url());
+        });
+        QVERIFY(job->exec());
+        group.deleteEntry("MaximumWorkers");
+
+        QVERIFY(failures.isEmpty());
+        const QList<QUrl> expected{items.at(0).url(), items.at(4).url(), items.at(2).url(), items.at(1).url(), items.at(3).url()};
+        QCOMPARE(previews, expected);
+    }
+
+private:
+    static QString thumbnailRoot()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/thumbnails/");
+    }
+
+    // Appends a text file to @p items, with a thumbnail of 128x128 in the cache if @p cached
+    void createFile(const QString &name, bool cached, KFileItemList &items)
+    {
+        const QString path = m_tempDir.filePath(name);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Hello world");
+        file.close();
+
+        if (cached) {
+            const QFileInfo info(path);
+            const QByteArray uri = QUrl::fromLocalFile(info.canonicalFilePath()).toEncoded();
+            const QString thumbName = QString::fromLatin1(QCryptographicHash::hash(uri, QCryptographicHash::Md5).toHex()) + QLatin1String(".png");
+            QImage thumb(128, 128, QImage::Format_ARGB32);
+            thumb.fill(Qt::blue);
+            thumb.setText(QStringLiteral("Thumb::URI"), QString::fromUtf8(uri));
+            thumb.setText(QStringLiteral("Thumb::MTime"), QString::number(info.lastModified().toSecsSinceEpoch()));
+            QVERIFY(QDir().mkpath(thumbnailRoot() + QLatin1String("normal")));
+            QVERIFY(thumb.save(thumbnailRoot() + QLatin1String("normal/") + thumbName, "PNG"));
+        }
+        items.append(KFileItem(QUrl::fromLocalFile(path), QStringLiteral("text/plain"), KFileItem::Unknown));
+    }
+
+    QTemporaryDir m_tempDir;
+    const QStringList m_plugins{QStringLiteral("fakethumbnail")};
+};
+
+QTEST_MAIN(PreviewJobTest)
+
+#include "previewjobtest.moc"
@@ -0,0 +1,160 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "thumbnailcachecleaner_p.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace KIO;
+
+static QString thumbnailPath(const QString &dir, const QString &name)
+{
+    return ThumbnailCacheCleaner::thumbnailRoot() + dir + QLatin1Char('/') + name;
+}
+
+// Creates a thumbnail of @p size bytes, last used @p age seconds ago
+static void createThumbnail(const QString &path, int size, qint64 age)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(size, 'x'));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(-age), QFileDevice::FileModificationTime));
+}
+
+class ThumbnailCacheCleanerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void init()
+    {
+        QDir(ThumbnailCacheCleaner::thumbnailRoot()).removeRecursively();
+    }
+
+    void cleanupTestCase()
+    {
+        QDir(ThumbnailCacheCleaner::thumbnailRoot()).removeRecursively();
+    }
+
+    void shouldRemoveOldThumbnails()
+    {
+        const qint64 day = 24 * 60 * 60;
+        createThumbnail(thumbnailPath(QStringLiteral("normal"), QStringLiteral("old.png")), 10, 10 * day);
+        createThumbnail(thumbnailPath(QStringLiteral("large"), QStringLiteral("recent.png")), 10, day);
+
+        QVERIFY(ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 5 * day, 0, 100));
+
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("normal"), QStringLiteral("old.png"))));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("recent.png"))));
+    }
+
+    void shouldRemoveLeastRecentlyUsedThumbnails()
+    {
+        // 4 thumbnails of 1000 bytes, for a budget of 2500 bytes
+        for (int i = 0; i < 4; ++i) {
+            createThumbnail(thumbnailPath(QStringLiteral("x-large"), QStringLiteral("%1.png").arg(i)), 1000, 100 * (i + 1));
+        }
+
+        QVERIFY(ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 0, 2500, 100));
+
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("x-large"), QStringLiteral("0.png"))));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("x-large"), QStringLiteral("1.png"))));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("x-large"), QStringLiteral("2.png"))));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("x-large"), QStringLiteral("3.png"))));
+    }
+
+    void shouldFollowTheJournal()
+    {
+        const qint64 day = 24 * 60 * 60;
+        // The first pass builds the index from the directories
+        for (int i = 0; i < 4; ++i) {
+            createThumbnail(thumbnailPath(QStringLiteral("large"), QStringLiteral("%1.png").arg(i)), 1000, (5 - i) * day);
+        }
+        QVERIFY(ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 0, 0, 100));
+
+        // Using the oldest ones makes the others the least recently used
+        for (int i = 0; i < 2; ++i) {
+            QFile file(thumbnailPath(QStringLiteral("large"), QStringLiteral("%1.png").arg(i)));
+            QVERIFY(file.open(QIODevice::ReadOnly));
+            ThumbnailCacheCleaner::thumbnailUsed(file);
+        }
+        // Written now that there is an index: only known through the journal
+        const QString written = thumbnailPath(QStringLiteral("large"), QStringLiteral("4.png"));
+        createThumbnail(written, 1000, 0);
+        ThumbnailCacheCleaner::thumbnailWritten(written);
+        // Not recorded, so not accounted for: the directories aren't scanned again
+        createThumbnail(thumbnailPath(QStringLiteral("large"), QStringLiteral("unknown.png")), 1000, 0);
+
+        // 5000 bytes known, down to 90% of 3500
+        QVERIFY(ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 0, 3500, 100));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("0.png"))));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("1.png"))));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("2.png"))));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("3.png"))));
+        QVERIFY(QFile::exists(written));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("large"), QStringLiteral("unknown.png"))));
+    }
+
+    void shouldRemoveABoundedNumberPerPass()
+    {
+        const qint64 day = 24 * 60 * 60;
+        for (int i = 0; i < 5; ++i) {
+            createThumbnail(thumbnailPath(QStringLiteral("normal"), QStringLiteral("%1.png").arg(i)), 10, (10 + i) * day);
+        }
+
+        QVERIFY(!ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 5 * day, 0, 2));
+        QCOMPARE(QDir(thumbnailPath(QStringLiteral("normal"), QString())).entryList(QDir::Files).size(), 3);
+        // The oldest first
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("normal"), QStringLiteral("4.png"))));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("normal"), QStringLiteral("3.png"))));
+
+        QVERIFY(!ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 5 * day, 0, 2));
+        QVERIFY(ThumbnailCacheCleaner::clean(ThumbnailCacheCleaner::thumbnailRoot(), 5 * day, 0, 2));
+        QVERIFY(QDir(thumbnailPath(QStringLiteral("normal"), QString())).entryList(QDir::Files).isEmpty());
+    }
+
+    void shouldRecordUse()
+    {
+        const QString path = thumbnailPath(QStringLiteral("normal"), QStringLiteral("used.png"));
+        createThumbnail(path, 10, 3 * 24 * 60 * 60);
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        ThumbnailCacheCleaner::thumbnailUsed(file);
+        file.close();
+        QVERIFY(QFileInfo(path).lastModified().secsTo(QDateTime::currentDateTime()) < 60);
+    }
+
+    void shouldRemoveThumbnailsOfUrl()
+    {
+        const QUrl url = QUrl::fromLocalFile(QStringLiteral("/tmp/some file.jpg"));
+        const QString name = QString::fromLatin1(QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Md5).toHex()) + QLatin1String(".png");
+        createThumbnail(thumbnailPath(QStringLiteral("normal"), name), 10, 0);
+        createThumbnail(thumbnailPath(QStringLiteral("xx-large"), name), 10, 0);
+        createThumbnail(thumbnailPath(QStringLiteral("normal"), QStringLiteral("other.png")), 10, 0);
+
+        ThumbnailCacheCleaner::removeThumbnails(url);
+
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("normal"), name)));
+        QVERIFY(!QFile::exists(thumbnailPath(QStringLiteral("xx-large"), name)));
+        QVERIFY(QFile::exists(thumbnailPath(QStringLiteral("normal"), QStringLiteral("other.png"))));
+    }
+};
+
+QTEST_GUILESS_MAIN(ThumbnailCacheCleanerTest)
+
+#include "thumbnailcachecleanertest.moc"
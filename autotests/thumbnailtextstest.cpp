@@ -0,0 +1,93 @@
+/*
+    This file is part of the KDE project
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "thumbnailtexts_p.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QTest>
+
+using namespace KIO;
+
+// A thumbnail as PreviewJob saves it
+static QByteArray thumbnailData(const QString &uri, const QString &software)
+{
+    QImage image(16, 16, QImage::Format_ARGB32);
+    image.fill(Qt::red);
+    image.setText(QStringLiteral("Thumb::URI"), uri);
+    image.setText(QStringLiteral("Thumb::MTime"), QStringLiteral("1700000000"));
+    image.setText(QStringLiteral("Thumb::Size"), QStringLiteral("1234"));
+    image.setText(QStringLiteral("Software"), software);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return buffer.data();
+}
+
+class ThumbnailTextsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void shouldReadTexts_data()
+    {
+        QTest::addColumn<QString>("uri");
+        QTest::addColumn<QString>("software");
+
+        QTest::newRow("short") << QStringLiteral("file:///a.png") << QStringLiteral("KDE");
+        // Qt compresses the values of 40 characters or more
+        QTest::newRow("long") << QStringLiteral("file:///home/user/Pictures/Holidays/2026/some picture.png")
+                              << QStringLiteral("KDE Thumbnail Generator imagethumbnail (v5)");
+        // Written as iTXt
+        QTest::newRow("non-latin1") << QStringLiteral("file:///home/user/Pictures/Holidays/2026/\u65E5\u672C/\u5199\u771F.png")
+                                    << QStringLiteral("KDE Thumbnail Generator imagethumbnail (v5)");
+    }
+
+    void shouldReadTexts()
+    {
+        QFETCH(QString, uri);
+        QFETCH(QString, software);
+
+        const QByteArray data = thumbnailData(uri, software);
+        if (uri.size() >= 40) {
+            // Make sure the compressed chunks are tested
+            QVERIFY(!data.contains(uri.toUtf8()));
+        }
+
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        ThumbnailTexts texts;
+        QVERIFY(texts.read(&buffer));
+        QCOMPARE(texts.uri, uri);
+        QCOMPARE(texts.mtime, QStringLiteral("1700000000"));
+        QCOMPARE(texts.size, QStringLiteral("1234"));
+        QCOMPARE(texts.software, software);
+    }
+
+    void shouldRejectInvalidFiles()
+    {
+        QByteArray data = thumbnailData(QStringLiteral("file:///a.png"), QStringLiteral("KDE"));
+
+        QBuffer notPng;
+        notPng.setData(data.mid(1));
+        notPng.open(QIODevice::ReadOnly);
+        ThumbnailTexts texts;
+        QVERIFY(!texts.read(&notPng));
+
+        // Truncated before the texts
+        QBuffer truncated;
+        truncated.setData(data.left(20));
+        truncated.open(QIODevice::ReadOnly);
+        QVERIFY(!texts.read(&truncated));
+    }
+};
+
+QTEST_GUILESS_MAIN(ThumbnailTextsTest)
+
+#include "thumbnailtextstest.moc"
@@ -9,13 +9,19 @@
 
 #include "copyjob.h"
 #include "job_p.h"
+#include "jobuidelegateextension.h"
+#ifndef KIO_ANDROID_STUB
+#include "kdirnotify.h"
+#endif
 
 #include <QMimeDatabase>
 #include <QTimer>
 
 #include <KLocalizedString>
 
+#include <algorithm>
 #include <set>
+#include <tuple>
 
 using namespace KIO;
 
@@ -88,12 +94,30 @@ public:
     const JobFlags m_flags;
     QTimer m_reportTimer;
 
+    // Renaming in batches, with one worker request for many items
+    KIO::SimpleJob *m_batchJob = nullptr;
+    QList<QUrl> m_batchSrcUrls;
+    QList<QUrl> m_batchDestUrls;
+    qsizetype m_batchProcessed = 0;
+    std::set<qsizetype> m_batchConflicts;
+    bool m_batchConflictsRead = false;
+    bool m_workerCanRenameBatch = true;
+    // Items renamed by the current batch, announced together once it's done
+    QList<QUrl> m_renamedSrcUrls;
+    QList<QUrl> m_renamedDestUrls;
+    // Items renamed one by one with CopyJob, e.g. those whose new name is taken
+    QList<std::pair<QUrl, QUrl>> m_itemsToRenameAlone;
+
     Q_DECLARE_PUBLIC(BatchRenameJob)
 
     void slotStart();
     void slotReport();
+    void startBatch();
+    void slotBatchProgress(qsizetype processed);
+    void emitBatchRenamed();
 
     QString indexedName(const QString &name, int index, QChar placeHolder) const;
+    QUrl newUrl(const QUrl &oldUrl, int index) const;
 
     static inline BatchRenameJob *newJob(const QList<QUrl> &src, const QString &newName, int index, QChar placeHolder, JobFlags flags)
     {
@@ -126,6 +150,9 @@ BatchRenameJob::BatchRenameJob(BatchRenameJobPrivate &dd)
 
 BatchRenameJob::~BatchRenameJob()
 {
+    Q_D(BatchRenameJob);
+    // When killed in the middle of a batch
+    d->emitBatchRenamed();
 }
 
 QString BatchRenameJobPrivate::indexedName(const QString &name, int index, QChar placeHolder) const
@@ -153,6 +180,20 @@ QString BatchRenameJobPrivate::indexedName(const QString &name, int index, QChar
     return newName;
 }
 
+QUrl BatchRenameJobPrivate::newUrl(const QUrl &oldUrl, int index) const
+{
+    QString newName = indexedName(m_newName, index, m_placeHolder);
+    QMimeDatabase db;
+    const QString extension = db.suffixForFileName(oldUrl.path());
+    if (!extension.isEmpty()) {
+        newName += QLatin1Char('.') + extension;
+    }
+
+    QUrl url = oldUrl.adjusted(QUrl::RemoveFilename);
+    url.setPath(url.path() + KIO::encodeFileName(newName));
+    return url;
+}
+
 void BatchRenameJobPrivate::slotStart()
 {
     Q_Q(BatchRenameJob);
@@ -161,20 +202,21 @@ void BatchRenameJobPrivate::slotStart()
         q->setTotalAmount(KJob::Items, m_srcList.count());
     }
 
-    if (m_listIterator != m_srcList.constEnd()) {
-        QString newName = indexedName(m_newName, m_index, m_placeHolder);
-        const QUrl oldUrl = *m_listIterator;
-        QMimeDatabase db;
-        const QString extension = db.suffixForFileName(oldUrl.path());
-        if (!extension.isEmpty()) {
-            newName += QLatin1Char('.') + extension;
+    if (m_itemsToRenameAlone.isEmpty() && m_listIterator != m_srcList.constEnd()) {
+        // Rename the following items with a single request, if the worker can
+        if (m_workerCanRenameBatch && m_srcList.constEnd() - m_listIterator > 1) {
+            startBatch();
+            return;
         }
+        m_itemsToRenameAlone.append({*m_listIterator, newUrl(*m_listIterator, m_index)});
+        ++m_listIterator;
+        ++m_index;
+    }
 
-        m_oldUrl = oldUrl;
-        m_newUrl = oldUrl.adjusted(QUrl::RemoveFilename);
-        m_newUrl.setPath(m_newUrl.path() + KIO::encodeFileName(newName));
+    if (!m_itemsToRenameAlone.isEmpty()) {
+        std::tie(m_oldUrl, m_newUrl) = m_itemsToRenameAlone.takeFirst();
 
-        KIO::Job *job = KIO::moveAs(oldUrl, m_newUrl, KIO::HideProgressInfo);
+        KIO::Job *job = KIO::moveAs(m_oldUrl, m_newUrl, KIO::HideProgressInfo);
         job->setParentJob(q);
         q->addSubjob(job);
     } else {
@@ -184,11 +226,90 @@ void BatchRenameJobPrivate::slotStart()
     }
 }
 
+void BatchRenameJobPrivate::startBatch()
+{
+    Q_Q(BatchRenameJob);
+
+    // Keeps the request to the worker (and its reply) reasonably small
+    constexpr qsizetype maxBatchSize = 1000;
+
+    // A batch goes to a single worker, so it only holds items from the same host
+    const QUrl host = m_listIterator->adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment);
+    m_batchSrcUrls.clear();
+    m_batchDestUrls.clear();
+    m_batchProcessed = 0;
+    m_batchConflicts.clear();
+    m_batchConflictsRead = false;
+    int index = m_index;
+    for (auto it = m_listIterator; it != m_srcList.constEnd() && m_batchSrcUrls.size() < maxBatchSize; ++it, ++index) {
+        if (it->adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment) != host) {
+            break;
+        }
+        m_batchSrcUrls.append(*it);
+        m_batchDestUrls.append(newUrl(*it, index));
+    }
+
+    KIO_ARGS << m_batchSrcUrls << m_batchDestUrls << qint8(false);
+    m_batchJob = SimpleJobPrivate::newJobNoUi(m_batchSrcUrls.constFirst(), CMD_RENAME_BATCH, packedArgs);
+    m_batchJob->setParentJob(q);
+    q->connect(m_batchJob, &KJob::processedSize, q, [this](KJob *, qulonglong processed) {
+        slotBatchProgress(processed);
+    });
+    q->addSubjob(m_batchJob);
+}
+
+void BatchRenameJobPrivate::slotBatchProgress(qsizetype processed)
+{
+    Q_Q(BatchRenameJob);
+    // The worker sends the items it skipped before renaming the others
+    if (!m_batchConflictsRead) {
+        m_batchConflictsRead = true;
+        const QString conflicts = m_batchJob->queryMetaData(QStringLiteral("renameBatchConflicts"));
+        for (QStringView index : QStringView(conflicts).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+            m_batchConflicts.insert(index.toLongLong());
+        }
+    }
+
+    processed = std::min(processed, m_batchSrcUrls.size());
+    for (; m_batchProcessed < processed; ++m_batchProcessed) {
+        const QUrl &srcUrl = m_batchSrcUrls.at(m_batchProcessed);
+        const QUrl &destUrl = m_batchDestUrls.at(m_batchProcessed);
+        if (m_batchConflicts.count(m_batchProcessed)) {
+            // Let CopyJob handle the conflict, so that the user can resolve it
+            m_itemsToRenameAlone.append({srcUrl, destUrl});
+        } else {
+            m_oldUrl = srcUrl;
+            m_newUrl = destUrl;
+            m_renamedSrcUrls.append(srcUrl);
+            m_renamedDestUrls.append(destUrl);
+            Q_EMIT q->fileRenamed(srcUrl, destUrl);
+            if (m_uiDelegateExtension) {
+                m_uiDelegateExtension->updateUrlInClipboard(srcUrl, destUrl);
+            }
+        }
+        ++m_listIterator;
+        ++m_index;
+    }
+}
+
+void BatchRenameJobPrivate::emitBatchRenamed()
+{
+    if (m_renamedSrcUrls.isEmpty()) {
+        return;
+    }
+#ifndef KIO_ANDROID_STUB
+    // A single notification, listers update the items in place
+    org::kde::KDirNotify::emitFilesRenamed(m_renamedSrcUrls, m_renamedDestUrls);
+#endif
+    m_renamedSrcUrls.clear();
+    m_renamedDestUrls.clear();
+}
+
 void BatchRenameJobPrivate::slotReport()
 {
     Q_Q(BatchRenameJob);
 
-    const auto processed = m_listIterator - m_srcList.constBegin();
+    const auto processed = m_listIterator - m_srcList.constBegin() - m_itemsToRenameAlone.size();
 
     q->setProcessedAmount(KJob::Items, processed);
     q->emitPercent(processed, m_srcList.count());
@@ -199,6 +320,37 @@ void BatchRenameJobPrivate::slotReport()
 void BatchRenameJob::slotResult(KJob *job)
 {
     Q_D(BatchRenameJob);
+    if (job == d->m_batchJob) {
+        d->m_batchJob = nullptr;
+        d->emitBatchRenamed();
+        switch (job->error()) {
+        case KIO::ERR_UNSUPPORTED_ACTION:
+            // Rename the remaining items one by one
+            d->m_workerCanRenameBatch = false;
+            break;
+        case KIO::ERR_FILE_ALREADY_EXIST:
+        case KIO::ERR_DIR_ALREADY_EXIST:
+            // The new name of the next item was taken meanwhile, let CopyJob handle it
+            if (d->m_listIterator == d->m_srcList.constEnd()) {
+                break;
+            }
+            d->m_itemsToRenameAlone.append({*d->m_listIterator, d->newUrl(*d->m_listIterator, d->m_index)});
+            ++d->m_listIterator;
+            ++d->m_index;
+            break;
+        default:
+            if (job->error()) {
+                d->m_reportTimer.stop();
+                d->slotReport();
+                KIO::Job::slotResult(job);
+                return;
+            }
+        }
+        removeSubjob(job);
+        d->slotStart();
+        return;
+    }
+
     if (job->error()) {
         d->m_reportTimer.stop();
         d->slotReport();
@@ -208,9 +360,7 @@ void BatchRenameJob::slotResult(KJob *job)
 
     removeSubjob(job);
 
-    Q_EMIT fileRenamed(*d->m_listIterator, d->m_newUrl);
-    ++d->m_listIterator;
-    ++d->m_index;
+    Q_EMIT fileRenamed(d->m_oldUrl, d->m_newUrl);
     d->slotStart();
 }
 
@@ -27,19 +27,15 @@ namespace KIO
 struct ChmodInfo {
     QUrl url;
     int permissions;
-};
-
-enum ChmodJobState {
-    CHMODJOB_STATE_LISTING,
-    CHMODJOB_STATE_CHMODING,
+    // true for a directory whose contents have to be changed as well
+    bool recursive = false;
 };
 
 class ChmodJobPrivate : public KIO::JobPrivate
 {
 public:
     ChmodJobPrivate(const KFileItemList &lstItems, int permissions, int mask, KUserId newOwner, KGroupId newGroup, bool recursive)
-        : state(CHMODJOB_STATE_LISTING)
-        , m_permissions(permissions)
+        : m_permissions(permissions)
         , m_mask(mask)
         , m_newOwner(newOwner)
         , m_newGroup(newGroup)
@@ -49,19 +45,26 @@ public:
     {
     }
 
-    ChmodJobState state;
     int m_permissions;
     int m_mask;
     KUserId m_newOwner;
     KGroupId m_newGroup;
     bool m_recursive;
     bool m_bAutoSkipFiles;
+    // false once a worker reported that it can't process a whole directory tree
+    bool m_workerCanChmodRecursively = true;
+    KIO::SimpleJob *m_chmodRecursiveJob = nullptr;
+    ChmodInfo m_recursiveInfo;
+    QUrl m_listedUrl;
     KFileItemList m_lstItems;
     std::stack<ChmodInfo> m_infos;
 
     void chmodNextFile();
     void slotEntries(KIO::Job *, const KIO::UDSEntryList &);
     void processList();
+    void startChmodRecursiveJob(const ChmodInfo &info);
+    void listDirectory(const ChmodInfo &info);
+    void addAclMetaData(KIO::SimpleJob *job);
 
     Q_DECLARE_PUBLIC(ChmodJob)
 
@@ -101,9 +104,7 @@ ChmodJob::~ChmodJob()
 
 void ChmodJobPrivate::processList()
 {
-    Q_Q(ChmodJob);
-    while (!m_lstItems.isEmpty()) {
-        const KFileItem item = m_lstItems.first();
+    for (const KFileItem &item : std::as_const(m_lstItems)) {
         if (!item.isLink()) { // don't do anything with symlinks
             // File or directory -> remember to chmod
             ChmodInfo info;
@@ -117,27 +118,68 @@ void ChmodJobPrivate::processList()
                           << "\n with ~mask (mask bits we keep) =" << QString::number((uint)~m_mask,8)
                           << "\n bits we keep =" << QString::number(permissions & ~m_mask,8)
                           << "\n new permissions = " << QString::number(info.permissions,8);*/
+            // Directory and recursive -> its contents are handled when we get to it,
+            // in the same order as the other items
+            info.recursive = item.isDir() && m_recursive;
             m_infos.push(std::move(info));
             // qDebug() << "processList : Adding info for " << info.url;
-            // Directory and recursive -> list
-            if (item.isDir() && m_recursive) {
-                // qDebug() << "ChmodJob::processList dir -> listing";
-                KIO::ListJob *listJob = KIO::listRecursive(item.url(), KIO::HideProgressInfo);
-                q->connect(listJob, &KIO::ListJob::entries, q, [this](KIO::Job *job, const KIO::UDSEntryList &entries) {
-                    slotEntries(job, entries);
-                });
-                q->addSubjob(listJob);
-                return; // we'll come back later, when this one's finished
-            }
         }
-        m_lstItems.removeFirst();
     }
-    // qDebug() << "ChmodJob::processList -> going to STATE_CHMODING";
-    // We have finished, move on
-    state = CHMODJOB_STATE_CHMODING;
+    m_lstItems.clear();
     chmodNextFile();
 }
 
+// Lets the worker process the whole tree in one go
+void ChmodJobPrivate::startChmodRecursiveJob(const ChmodInfo &info)
+{
+    Q_Q(ChmodJob);
+    const QString owner = m_newOwner.isValid() ? KUser(m_newOwner).loginName() : QString();
+    const QString group = m_newGroup.isValid() ? KUserGroup(m_newGroup).name() : QString();
+
+    KIO_ARGS << info.url << m_permissions << m_mask << owner << group;
+    m_recursiveInfo = info;
+    m_chmodRecursiveJob = SimpleJobPrivate::newJobNoUi(info.url, CMD_CHMOD_RECURSIVE, packedArgs);
+    m_chmodRecursiveJob->setParentJob(q);
+    addAclMetaData(m_chmodRecursiveJob);
+
+    const qulonglong processedBefore = q->processedAmount(KJob::Files);
+    q->connect(m_chmodRecursiveJob, &KJob::processedSize, q, [q, processedBefore](KJob *, qulonglong items) {
+        q->setProcessedAmount(KJob::Files, processedBefore + items);
+    });
+    q->addSubjob(m_chmodRecursiveJob);
+}
+
+// Lists the directory of @p info, to chmod its contents item by item before the directory itself
+void ChmodJobPrivate::listDirectory(const ChmodInfo &info)
+{
+    Q_Q(ChmodJob);
+    ChmodInfo directoryInfo = info;
+    directoryInfo.recursive = false;
+    m_infos.push(std::move(directoryInfo));
+
+    // qDebug() << "ChmodJob::listDirectory dir -> listing";
+    m_listedUrl = info.url;
+    KIO::ListJob *listJob = KIO::listRecursive(info.url, KIO::HideProgressInfo);
+    q->connect(listJob, &KIO::ListJob::entries, q, [this](KIO::Job *job, const KIO::UDSEntryList &entries) {
+        slotEntries(job, entries);
+    });
+    q->addSubjob(listJob);
+}
+
+void ChmodJobPrivate::addAclMetaData(KIO::SimpleJob *job)
+{
+    Q_Q(ChmodJob);
+    // copy the metadata for acl and default acl
+    const QString aclString = q->queryMetaData(QStringLiteral("ACL_STRING"));
+    const QString defaultAclString = q->queryMetaData(QStringLiteral("DEFAULT_ACL_STRING"));
+    if (!aclString.isEmpty()) {
+        job->addMetaData(QStringLiteral("ACL_STRING"), aclString);
+    }
+    if (!defaultAclString.isEmpty()) {
+        job->addMetaData(QStringLiteral("DEFAULT_ACL_STRING"), defaultAclString);
+    }
+}
+
 void ChmodJobPrivate::slotEntries(KIO::Job *, const KIO::UDSEntryList &list)
 {
     KIO::UDSEntryList::ConstIterator it = list.begin();
@@ -150,7 +192,7 @@ void ChmodJobPrivate::slotEntries(KIO::Job *, const KIO::UDSEntryList &list)
             const mode_t permissions = entry.numberValue(KIO::UDSEntry::UDS_ACCESS) & 0777; // get rid of "set gid" and other special flags
 
             ChmodInfo info;
-            info.url = m_lstItems.first().url(); // base directory
+            info.url = m_listedUrl; // base directory
             info.url.setPath(Utils::concatPaths(info.url.path(), relativePath));
             int mask = m_mask;
             // Emulate -X: only give +x to files that had a +x bit already
@@ -191,6 +233,14 @@ void ChmodJobPrivate::chmodNextFile()
     if (!m_infos.empty()) {
         ChmodInfo info = m_infos.top();
         m_infos.pop();
+        if (info.recursive) {
+            if (m_workerCanChmodRecursively) {
+                startChmodRecursiveJob(info);
+            } else {
+                listDirectory(info);
+            }
+            return; // we'll come back later, when this one's finished
+        }
         // First update group / owner (if local file)
         // (permissions have to be set after, in case of suid and sgid)
         if (info.url.isLocalFile() && (m_newOwner.isValid() || m_newGroup.isValid())) {
@@ -243,15 +293,7 @@ void ChmodJobPrivate::chmodNextFile()
         /*qDebug() << "chmod'ing" << info.url << "to" << QString::number(info.permissions,8);*/
         KIO::SimpleJob *job = KIO::chmod(info.url, info.permissions);
         job->setParentJob(q);
-        // copy the metadata for acl and default acl
-        const QString aclString = q->queryMetaData(QStringLiteral("ACL_STRING"));
-        const QString defaultAclString = q->queryMetaData(QStringLiteral("DEFAULT_ACL_STRING"));
-        if (!aclString.isEmpty()) {
-            job->addMetaData(QStringLiteral("ACL_STRING"), aclString);
-        }
-        if (!defaultAclString.isEmpty()) {
-            job->addMetaData(QStringLiteral("DEFAULT_ACL_STRING"), defaultAclString);
-        }
+        addAclMetaData(job);
         q->addSubjob(job);
     } else { // We have finished
         q->emitResult();
@@ -262,27 +304,26 @@ void ChmodJob::slotResult(KJob *job)
 {
     Q_D(ChmodJob);
     removeSubjob(job);
+    if (job == d->m_chmodRecursiveJob) {
+        d->m_chmodRecursiveJob = nullptr;
+        // Process this directory item by item: either the worker can't do it at all,
+        // or some ownership couldn't be changed and the user gets to skip those files.
+        if (job->error() == ERR_UNSUPPORTED_ACTION || job->error() == ERR_CANNOT_CHOWN) {
+            if (job->error() == ERR_UNSUPPORTED_ACTION) {
+                d->m_workerCanChmodRecursively = false;
+            }
+            d->listDirectory(d->m_recursiveInfo);
+            return;
+        }
+    }
     if (job->error()) {
         setError(job->error());
         setErrorText(job->errorText());
         emitResult();
         return;
     }
-    // qDebug() << "d->m_lstItems:" << d->m_lstItems.count();
-    switch (d->state) {
-    case CHMODJOB_STATE_LISTING:
-        d->m_lstItems.removeFirst();
-        // qDebug() << "-> processList";
-        d->processList();
-        return;
-    case CHMODJOB_STATE_CHMODING:
-        // qDebug() << "-> chmodNextFile";
-        d->chmodNextFile();
-        return;
-    default:
-        Q_ASSERT(false);
-        return;
-    }
+    // qDebug() << "-> chmodNextFile";
+    d->chmodNextFile();
 }
 
 ChmodJob *KIO::chmod(const KFileItemList &lstItems, int permissions, int mask, const QString &owner, const QString &group, bool recursive, JobFlags flags)
@@ -10,6 +10,10 @@
 
 #include "kiocore_export.h"
 
+#include <QList>
+#include <QString>
+#include <QUrl>
+
 namespace KIO
 {
 /**
@@ -53,10 +57,58 @@ enum Command {
     CMD_HOST_INFO = 94,
     CMD_FILESYSTEMFREESPACE = 95,
     CMD_TRUNCATE = 96,
+    CMD_DIRECTORYSIZE = 97,
+    CMD_CHMOD_RECURSIVE = 98,
+    CMD_MKPATH = 99,
+    // 100 is reserved: it is MSG_DATA, which the application sends to the worker as well
+    CMD_RENAME_BATCH = 101,
+    CMD_DATA_CREDIT = 102, // flow control, see TransferJob::setFlowControlWindow()
+    CMD_DATA_PIPE = 103, // answers MSG_DATA_REQ: read the data from the "data-pipe-in" metadata from now on
+    CMD_LISTDIR_RECURSIVE = 104,
     // Add new ones here once a release is done, to avoid breaking binary compatibility.
     // Note that protocol-specific commands shouldn't be added here, but should use special.
 };
 
+/**
+ * @internal
+ * Arguments of CMD_CHMOD_RECURSIVE, handed to the worker through virtual_hook().
+ */
+struct ChmodRecursiveArgs {
+    QUrl url;
+    int permissions = 0;
+    int mask = 0;
+    QString owner;
+    QString group;
+};
+
+/**
+ * @internal
+ * Arguments of CMD_MKPATH, handed to the worker through virtual_hook().
+ */
+struct MkpathArgs {
+    QUrl url;
+    QUrl baseUrl;
+};
+
+/**
+ * @internal
+ * Arguments of CMD_RENAME_BATCH, handed to the worker through virtual_hook().
+ */
+struct RenameBatchArgs {
+    QList<QUrl> srcUrls;
+    QList<QUrl> destUrls;
+    bool overwrite = false;
+};
+
+/**
+ * @internal
+ * Arguments of CMD_LISTDIR_RECURSIVE, handed to the worker through virtual_hook().
+ */
+struct ListRecursiveArgs {
+    QUrl url;
+    bool includeHidden = true;
+};
+
 } // namespace
 
 #endif
@@ -63,7 +63,7 @@ void ConnectionPrivate::setBackend(ConnectionBackend *b)
         q->connect(backend, &ConnectionBackend::disconnected, q, [this]() {
             disconnected();
         });
-        backend->setSuspended(suspended);
+        backend->setSuspended(suspended && !flowControlled);
     }
 }
 
@@ -83,7 +83,7 @@ void Connection::suspend()
 {
     // qDebug() << this << "Suspended";
     d->suspended = true;
-    if (d->backend) {
+    if (d->backend && !d->flowControlled) {
         d->backend->setSuspended(true);
     }
 }
@@ -131,6 +131,17 @@ bool Connection::suspended() const
     return d->suspended;
 }
 
+void Connection::setFlowControlled(bool flowControlled)
+{
+    if (d->flowControlled == flowControlled) {
+        return;
+    }
+    d->flowControlled = flowControlled;
+    if (d->suspended && d->backend) {
+        d->backend->setSuspended(!flowControlled);
+    }
+}
+
 void Connection::connectToRemote(const QUrl &address)
 {
     // qDebug() << "Connection requested to" << address;
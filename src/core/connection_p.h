@@ -123,6 +123,13 @@ public:
      */
     bool suspended() const;
 
+    /**
+     * Sets whether the peer limits the data it sends until we allow more
+     * (see CMD_DATA_CREDIT). Suspending such a connection only stops handling
+     * incoming data: it can be buffered, instead of throttling the socket.
+     */
+    void setFlowControlled(bool flowControlled);
+
     void setReadMode(ReadMode mode);
 
 Q_SIGNALS:
@@ -142,6 +149,7 @@ public:
         : backend(nullptr)
         , q(nullptr)
         , suspended(false)
+        , flowControlled(false)
         , readMode(Connection::ReadMode::EventDriven)
     {
     }
@@ -156,6 +164,7 @@ public:
     ConnectionBackend *backend;
     Connection *q;
     bool suspended;
+    bool flowControlled;
     Connection::ReadMode readMode;
 };
 
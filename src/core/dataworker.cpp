@@ -144,6 +144,7 @@ void DataWorker::send(int cmd, const QByteArray &arr)
     // ignore these (must not emit error, otherwise SIGSEGV occurs)
     case CMD_REPARSECONFIGURATION:
     case CMD_META_DATA:
+    case CMD_DATA_CREDIT:
         break;
     default:
         Q_EMIT error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(QStringLiteral("data"), cmd));
@@ -25,6 +25,7 @@ public:
         : m_totalSize(0L)
         , m_totalFiles(0L)
         , m_totalSubdirs(0L)
+        , m_totalAllocatedSize(0L)
         , m_currentItem(0)
     {
     }
@@ -32,6 +33,7 @@ public:
         : m_totalSize(0L)
         , m_totalFiles(0L)
         , m_totalSubdirs(0L)
+        , m_totalAllocatedSize(0L)
         , m_lstItems(lstItems)
         , m_currentItem(0)
     {
@@ -39,14 +41,24 @@ public:
     KIO::filesize_t m_totalSize;
     KIO::filesize_t m_totalFiles;
     KIO::filesize_t m_totalSubdirs;
+    KIO::filesize_t m_totalAllocatedSize;
     KFileItemList m_lstItems;
     int m_currentItem;
     QHash<long, std::set<long>> m_visitedInodes; // device -> set of inodes
+    // The worker-side computation currently running, if any
+    KIO::SimpleJob *m_workerJob = nullptr;
 
     void startNextJob(const QUrl &url);
+    void startListJob(const QUrl &url);
     void slotEntries(KIO::Job *, const KIO::UDSEntryList &);
     void processNextItem();
 
+    // Intermediate total reported by the running worker job
+    KIO::filesize_t workerTotal(const QString &key) const
+    {
+        return m_workerJob ? m_workerJob->metaData().value(key).toULongLong() : 0;
+    }
+
     Q_DECLARE_PUBLIC(DirectorySizeJob)
 
     static inline DirectorySizeJob *newJob(const QUrl &directory)
@@ -85,17 +97,26 @@ DirectorySizeJob::~DirectorySizeJob()
 
 KIO::filesize_t DirectorySizeJob::totalSize() const
 {
-    return d_func()->m_totalSize;
+    Q_D(const DirectorySizeJob);
+    return d->m_totalSize + d->workerTotal(QStringLiteral("size"));
 }
 
 KIO::filesize_t DirectorySizeJob::totalFiles() const
 {
-    return d_func()->m_totalFiles;
+    Q_D(const DirectorySizeJob);
+    return d->m_totalFiles + d->workerTotal(QStringLiteral("files"));
 }
 
 KIO::filesize_t DirectorySizeJob::totalSubdirs() const
 {
-    return d_func()->m_totalSubdirs;
+    Q_D(const DirectorySizeJob);
+    return d->m_totalSubdirs + d->workerTotal(QStringLiteral("subdirs"));
+}
+
+KIO::filesize_t DirectorySizeJob::totalAllocatedSize() const
+{
+    Q_D(const DirectorySizeJob);
+    return d->m_totalAllocatedSize + d->workerTotal(QStringLiteral("allocated"));
 }
 
 void DirectorySizeJobPrivate::processNextItem()
@@ -131,6 +152,16 @@ void DirectorySizeJobPrivate::startNextJob(const QUrl &url)
 {
     Q_Q(DirectorySizeJob);
     // qDebug() << url;
+    // Let the worker do the whole traversal if it can, this saves sending every
+    // single entry to the application. See slotResult for the fallback.
+    KIO_ARGS << url;
+    m_workerJob = SimpleJobPrivate::newJobNoUi(url, CMD_DIRECTORYSIZE, packedArgs);
+    q->addSubjob(m_workerJob);
+}
+
+void DirectorySizeJobPrivate::startListJob(const QUrl &url)
+{
+    Q_Q(DirectorySizeJob);
     KIO::ListJob *listJob = KIO::listRecursive(url, KIO::HideProgressInfo);
     listJob->addMetaData(QStringLiteral("details"), QString::number(KIO::StatBasic | KIO::StatResolveSymlink | KIO::StatInode));
     q->connect(listJob, &KIO::ListJob::entries, q, [this](KIO::Job *job, const KIO::UDSEntryList &list) {
@@ -179,6 +210,23 @@ void DirectorySizeJob::slotResult(KJob *job)
 {
     Q_D(DirectorySizeJob);
     // qDebug() << d->m_totalSize;
+    if (job == d->m_workerJob) {
+        const QUrl url = d->m_workerJob->url();
+        if (job->error() == KIO::ERR_UNSUPPORTED_ACTION) {
+            // The worker can't compute the size by itself, do a recursive listing instead
+            d->m_workerJob = nullptr;
+            removeSubjob(job);
+            d->startListJob(url);
+            return;
+        }
+        if (!job->error()) {
+            d->m_totalSize += d->workerTotal(QStringLiteral("size"));
+            d->m_totalFiles += d->workerTotal(QStringLiteral("files"));
+            d->m_totalSubdirs += d->workerTotal(QStringLiteral("subdirs"));
+            d->m_totalAllocatedSize += d->workerTotal(QStringLiteral("allocated"));
+        }
+        d->m_workerJob = nullptr;
+    }
     removeSubjob(job);
     if (d->m_currentItem < d->m_lstItems.count()) {
         d->processNextItem();
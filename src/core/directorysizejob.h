@@ -21,6 +21,11 @@ class DirectorySizeJobPrivate;
  * Computes a directory size (similar to "du", but doesn't give the same results
  * since we simply sum up the dir and file sizes, whereas du speaks disk blocks)
  *
+ * Workers able to do so (e.g.\ file) compute the size in a single request;
+ * for the others the job falls back to a recursive listing.
+ *
+ * The totals can be queried while the job is running, to show progress.
+ *
  * Usage: see KIO::directorySize.
  */
 class KIOCORE_EXPORT DirectorySizeJob : public KIO::Job
@@ -49,6 +54,14 @@ public:
      */
     KIO::filesize_t totalSubdirs() const;
 
+    /**
+     * @return the disk space actually allocated for the files and sub-directories
+     * (similar to what "du" reports), or 0 if the worker handling the URL
+     * cannot determine it
+     * @since 6.0
+     */
+    KIO::filesize_t totalAllocatedSize() const;
+
 protected Q_SLOTS:
     void slotResult(KJob *job) override;
 
@@ -0,0 +1,277 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "dirlistingcache_p.h"
+#include "kiocoredebug.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+using namespace KIO;
+
+static constexpr quint32 s_magic = 0x4B444C43; // "KDLC"
+static constexpr quint32 s_version = 1;
+// The size cap is only enforced every so many writes, walking the cache isn't free
+static constexpr int s_writesBetweenTrims = 32;
+
+static QString cacheFilePath(const QUrl &dir)
+{
+    // Never write passwords to the disk
+    const QByteArray key = dir.adjusted(QUrl::RemovePassword | QUrl::StripTrailingSlash).toEncoded();
+    const QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    return DirListingCache::cacheDirectory() + QLatin1Char('/') + dir.scheme() + QLatin1Char('/') + QString::fromLatin1(hash);
+}
+
+static QUrl parentDir(const QUrl &url)
+{
+    return url.adjusted(QUrl::StripTrailingSlash).adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+}
+
+DirListingCache::DirListingCache()
+    : m_writesSinceTrim(s_writesBetweenTrims)
+{
+    const KConfigGroup group(KSharedConfig::openConfig(QStringLiteral("kioslaverc"), KConfig::NoGlobals), QStringLiteral("Directory Listing Cache"));
+    m_enabled = group.readEntry("Enabled", false);
+    m_protocols = group.readEntry("Protocols",
+                                  QStringList{QStringLiteral("sftp"),
+                                              QStringLiteral("smb"),
+                                              QStringLiteral("webdav"),
+                                              QStringLiteral("webdavs"),
+                                              QStringLiteral("ftp"),
+                                              QStringLiteral("fish"),
+                                              QStringLiteral("nfs")});
+    m_maxAge = qint64(group.readEntry("MaxAgeDays", 30)) * 24 * 60 * 60;
+    m_maxSize = qint64(group.readEntry("MaxSizeMiB", 50)) * 1024 * 1024;
+}
+
+QString DirListingCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kio_dirlisting");
+}
+
+bool DirListingCache::isEnabledFor(const QUrl &dir) const
+{
+    return m_enabled && !dir.isLocalFile() && m_protocols.contains(dir.scheme());
+}
+
+bool DirListingCache::read(const QUrl &dir, Listing &listing) const
+{
+    QFile file(cacheFilePath(dir));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic;
+    quint32 version;
+    QUrl storedUrl;
+    stream >> magic >> version;
+    if (magic != s_magic || version != s_version) {
+        return false;
+    }
+    stream >> storedUrl >> listing.listedAt >> listing.rootEntry;
+    // A different URL means a hash collision
+    if (storedUrl != dir.adjusted(QUrl::RemovePassword | QUrl::StripTrailingSlash)) {
+        return false;
+    }
+
+    quint32 count;
+    stream >> count;
+    listing.entries.clear();
+    listing.entries.reserve(std::min<quint32>(count, 100000)); // don't trust a corrupted count
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        KIO::UDSEntry entry;
+        stream >> entry;
+        listing.entries.append(entry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(KIO_CORE) << "Corrupted directory listing cache for" << dir.toDisplayString() << "in" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+bool DirListingCache::write(const QUrl &dir, const Listing &listing)
+{
+    const QString filePath = cacheFilePath(dir);
+    QDir().mkpath(filePath.left(filePath.lastIndexOf(QLatin1Char('/'))));
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KIO_CORE) << "Couldn't write the directory listing cache" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << s_magic << s_version;
+    stream << dir.adjusted(QUrl::RemovePassword | QUrl::StripTrailingSlash) << listing.listedAt << listing.rootEntry;
+    stream << quint32(listing.entries.size());
+    for (const KIO::UDSEntry &entry : listing.entries) {
+        stream << entry;
+    }
+    if (!file.commit()) {
+        qCWarning(KIO_CORE) << "Couldn't write the directory listing cache" << filePath << file.errorString();
+        return false;
+    }
+
+    if (++m_writesSinceTrim >= s_writesBetweenTrims) {
+        trim();
+    }
+    return true;
+}
+
+bool DirListingCache::load(const QUrl &dir, KIO::UDSEntry &rootEntry, KIO::UDSEntryList &entries) const
+{
+    if (!isEnabledFor(dir)) {
+        return false;
+    }
+
+    Listing listing;
+    if (!read(dir, listing)) {
+        return false;
+    }
+    if (QDateTime::currentSecsSinceEpoch() - listing.listedAt > m_maxAge) {
+        QFile::remove(cacheFilePath(dir));
+        return false;
+    }
+    rootEntry = std::move(listing.rootEntry);
+    entries = std::move(listing.entries);
+    return true;
+}
+
+void DirListingCache::save(const QUrl &dir, const KIO::UDSEntry &rootEntry, const KIO::UDSEntryList &entries)
+{
+    if (!isEnabledFor(dir)) {
+        return;
+    }
+
+    write(dir, Listing{QDateTime::currentSecsSinceEpoch(), rootEntry, entries});
+}
+
+void DirListingCache::remove(const QUrl &dir)
+{
+    if (isEnabledFor(dir)) {
+        QFile::remove(cacheFilePath(dir));
+    }
+}
+
+void DirListingCache::removeItems(const QList<QUrl> &urls)
+{
+    // Group the notifications by parent dirs, usually there is only one
+    QMap<QUrl, QStringList> removedNamesByDir;
+    for (const QUrl &url : urls) {
+        if (!isEnabledFor(url)) {
+            continue;
+        }
+        remove(url); // in case it was a directory
+        removedNamesByDir[parentDir(url)].append(url.adjusted(QUrl::StripTrailingSlash).fileName());
+    }
+
+    for (auto it = removedNamesByDir.cbegin(); it != removedNamesByDir.cend(); ++it) {
+        Listing listing;
+        if (!read(it.key(), listing)) {
+            continue;
+        }
+        const QStringList &names = it.value();
+        const auto oldSize = listing.entries.size();
+        listing.entries.removeIf([&names](const KIO::UDSEntry &entry) {
+            return names.contains(entry.stringValue(KIO::UDSEntry::UDS_NAME));
+        });
+        // Keep the time of the listing, the merge doesn't make it more recent
+        if (listing.entries.size() != oldSize) {
+            write(it.key(), listing);
+        }
+    }
+}
+
+void DirListingCache::renameItem(const QUrl &src, const QUrl &dst)
+{
+    if (!isEnabledFor(src)) {
+        return;
+    }
+    const QUrl srcDir = parentDir(src);
+    if (srcDir != parentDir(dst)) {
+        // Moved elsewhere: gone from here, and the destination gets listed again
+        // anyway following the FilesAdded notification
+        removeItems({src});
+        return;
+    }
+    remove(src); // in case it was a directory
+
+    Listing listing;
+    if (!read(srcDir, listing)) {
+        return;
+    }
+    const QString srcName = src.adjusted(QUrl::StripTrailingSlash).fileName();
+    const QString dstName = dst.adjusted(QUrl::StripTrailingSlash).fileName();
+    // An overwritten destination is replaced by the renamed item
+    listing.entries.removeIf([&dstName](const KIO::UDSEntry &entry) {
+        return entry.stringValue(KIO::UDSEntry::UDS_NAME) == dstName;
+    });
+    auto it = std::find_if(listing.entries.begin(), listing.entries.end(), [&srcName](const KIO::UDSEntry &entry) {
+        return entry.stringValue(KIO::UDSEntry::UDS_NAME) == srcName;
+    });
+    if (it != listing.entries.end()) {
+        it->replace(KIO::UDSEntry::UDS_NAME, dstName);
+        write(srcDir, listing);
+    }
+}
+
+void DirListingCache::trim()
+{
+    m_writesSinceTrim = 0;
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    std::vector<std::tuple<qint64, qint64, QString>> files; // time of the last write, size, path
+    qint64 totalSize = 0;
+    QDirIterator it(cacheDirectory(), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        const qint64 writtenAt = info.lastModified().toSecsSinceEpoch();
+        if (now - writtenAt > m_maxAge) {
+            QFile::remove(info.filePath());
+            continue;
+        }
+        totalSize += info.size();
+        files.emplace_back(writtenAt, info.size(), info.filePath());
+    }
+    if (totalSize <= m_maxSize) {
+        return;
+    }
+
+    // Drop the oldest listings, leaving some room so that this doesn't happen on every write
+    std::sort(files.begin(), files.end());
+    const qint64 targetSize = m_maxSize * 3 / 4;
+    for (const auto &[writtenAt, size, path] : files) {
+        if (totalSize <= targetSize) {
+            break;
+        }
+        if (QFile::remove(path)) {
+            totalSize -= size;
+        }
+    }
+}
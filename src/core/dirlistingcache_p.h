@@ -0,0 +1,86 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef DIRLISTINGCACHE_P_H
+#define DIRLISTINGCACHE_P_H
+
+#include "udsentry.h"
+#include <kiocore_export.h>
+
+#include <QStringList>
+
+class QUrl;
+
+namespace KIO
+{
+/**
+ * @internal
+ * Keeps the last known listings of remote directories on disk, one file per directory,
+ * under the generic cache location, so that KCoreDirLister can show them immediately
+ * while the directory is listed again in the background.
+ *
+ * This is opt-in, configured in the "Directory Listing Cache" group of kioslaverc:
+ * @code
+ * [Directory Listing Cache]
+ * Enabled=true
+ * Protocols=sftp,smb,webdav,webdavs,ftp,fish,nfs
+ * MaxAgeDays=30
+ * MaxSizeMiB=50
+ * @endcode
+ * Listings older than MaxAgeDays are dropped, and the oldest listings are dropped
+ * when the cache takes more than MaxSizeMiB.
+ *
+ * Exported for the unit test.
+ */
+class KIOCORE_EXPORT DirListingCache
+{
+public:
+    DirListingCache();
+
+    // Whether the listings of @p dir are kept on disk
+    bool isEnabledFor(const QUrl &dir) const;
+
+    // Reads the last known listing of @p dir, "." excepted, which goes into @p rootEntry.
+    // Returns false if there is none or if it expired.
+    bool load(const QUrl &dir, KIO::UDSEntry &rootEntry, KIO::UDSEntryList &entries) const;
+
+    // Stores the listing of @p dir, @p rootEntry can be empty
+    void save(const QUrl &dir, const KIO::UDSEntry &rootEntry, const KIO::UDSEntryList &entries);
+
+    // Forgets about the listing of @p dir
+    void remove(const QUrl &dir);
+
+    // Merges a KDirNotify FilesRemoved notification into the stored listings
+    void removeItems(const QList<QUrl> &urls);
+
+    // Merges a KDirNotify FileRenamed notification into the stored listings
+    void renameItem(const QUrl &src, const QUrl &dst);
+
+    // The directory holding the listings, one subdirectory per protocol
+    static QString cacheDirectory();
+
+private:
+    struct Listing {
+        qint64 listedAt = 0; // seconds since epoch
+        KIO::UDSEntry rootEntry;
+        KIO::UDSEntryList entries;
+    };
+
+    bool read(const QUrl &dir, Listing &listing) const;
+    bool write(const QUrl &dir, const Listing &listing);
+    void trim();
+
+    bool m_enabled = false;
+    QStringList m_protocols;
+    qint64 m_maxAge; // seconds
+    qint64 m_maxSize; // bytes
+    int m_writesSinceTrim;
+};
+
+}
+
+#endif // DIRLISTINGCACHE_P_H
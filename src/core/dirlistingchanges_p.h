@@ -0,0 +1,37 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef DIRLISTINGCHANGES_P_H
+#define DIRLISTINGCHANGES_P_H
+
+#include "kfileitem.h"
+#include "udsentry.h"
+
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace KIO
+{
+// What changed in a directory since its previous listing, see compareDirListing()
+struct DirListingChanges {
+    qsizetype dotEntry = -1; // the index of the "." entry, if any
+    std::vector<qsizetype> newEntries; // the indexes of the entries which weren't listed before
+    std::vector<std::pair<qsizetype, qsizetype>> changedItems; // the index of an item, and of its new entry
+    std::vector<qsizetype> deletedItems; // the indexes of the items which aren't listed anymore, sorted
+};
+
+// Matches the @p entries of a new listing with the @p items of the previous one by name,
+// on arrays sorted by name: unlike a hash of all the items, this doesn't allocate per item.
+// An item whose entry equals the new one is left out without creating a KFileItem, unless it
+// is in @p pendingUpdates or the ".hidden" file changed. This is the bulk of the work done by
+// KCoreDirLister when updating a directory. Exported for the benchmark.
+KIOCORE_EXPORT DirListingChanges
+compareDirListing(const QList<KFileItem> &items, const KIO::UDSEntryList &entries, const std::set<KFileItem> &pendingUpdates);
+}
+
+#endif // DIRLISTINGCHANGES_P_H
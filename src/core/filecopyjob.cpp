@@ -7,8 +7,10 @@
 */
 
 #include "filecopyjob.h"
+#include "filecopyjob_p.h"
 #include "askuseractioninterface.h"
 #include "job_p.h"
+#include "kprotocolinfo.h"
 #include "kprotocolmanager.h"
 #include "scheduler.h"
 #include "worker_p.h"
@@ -17,7 +19,14 @@
 #include <KLocalizedString>
 
 #include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
 #include <QTimer>
+#include <QUuid>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 using namespace KIO;
 
@@ -52,6 +61,8 @@ public:
     QUrl m_src;
     QUrl m_dest;
     QByteArray m_buffer;
+    // Where the put worker reads the data from the get worker, empty if the data goes through us
+    QString m_dataPipe;
     SimpleJob *m_moveJob;
     SimpleJob *m_copyJob;
     SimpleJob *m_delJob;
@@ -66,6 +77,20 @@ public:
     bool m_bFileCopyInProgress : 1;
     JobFlags m_flags;
 
+    // A range of bytes fetched by one get job, in segmented mode
+    struct Segment {
+        TransferJob *job = nullptr;
+        KIO::filesize_t offset = 0; // where the next data goes
+        KIO::filesize_t end = 0; // exclusive, 0 while the size of the source is unknown
+        bool openEnded = false; // the job was started without a range end
+        bool rangeConfirmed = false; // the worker said it starts at offset
+        int retries = 0;
+    };
+    int m_segmentCount = 1;
+    std::vector<Segment> m_segments;
+    std::unique_ptr<QFile> m_segmentFile; // the "<dest>.part" file the segments are written to
+    KIO::filesize_t m_segmentedProcessed = 0;
+
     void startBestCopyMethod();
     void startCopyJob();
     void startCopyJob(const QUrl &workerUrl);
@@ -85,8 +110,25 @@ public:
     void slotCanResume(KIO::Job *job, KIO::filesize_t offset);
     void processCanResumeResult(KIO::Job *job, RenameDialog_Result result, KIO::filesize_t offset);
 
+    int maxSegmentCount(KIO::filesize_t size) const;
+    bool canDownloadSegmented() const;
+    void startSegmentedDownload();
+    bool splitSegments(KIO::filesize_t size);
+    void startSegment(int index);
+    int segmentIndex(const KJob *job) const;
+    void slotSegmentTotalSize(KIO::filesize_t size);
+    void slotSegmentData(KIO::Job *job, const QByteArray &data);
+    void slotSegmentResult(KJob *job);
+    void finishSegmentedDownload();
+    void abortSegmentedDownload(int error, const QString &errorText);
+
     Q_DECLARE_PUBLIC(FileCopyJob)
 
+    static FileCopyJobPrivate *get(FileCopyJob *job)
+    {
+        return job->d_func();
+    }
+
     static inline FileCopyJob *newJob(const QUrl &src, const QUrl &dest, int permissions, bool move, JobFlags flags)
     {
         // qDebug() << src << "->" << dest;
@@ -104,6 +146,42 @@ public:
     }
 };
 
+// The data flow control window of the get job, when using a data pipe
+static constexpr qint64 s_dataPipeWindow = 1024 * 1024;
+
+// Returns an address for the put worker to listen on, so that the get worker
+// sends it the data directly, instead of going through the application
+static QString createDataPipeAddress(const QUrl &src)
+{
+    if (src.scheme() == QLatin1String("data")) {
+        return QString(); // not a real worker, see DataWorker
+    }
+    // Only a name, no file is created: the worker's listen() fails if it exists already
+    const QString prefix = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    return prefix + QLatin1String("/kio") + QString::fromLatin1(QUuid::createUuid().toByteArray(QUuid::Id128)) + QLatin1String(".datapipe");
+}
+
+// Smaller segments aren't worth the latency of an additional connection
+static constexpr KIO::filesize_t s_minSegmentSize = 512 * 1024;
+// How many times a segment is fetched again after a network error
+static constexpr int s_maxSegmentRetries = 3;
+
+// Errors after which fetching a segment again may succeed
+static bool isTransientError(int error)
+{
+    switch (error) {
+    case ERR_CANNOT_CONNECT:
+    case ERR_CONNECTION_BROKEN:
+    case ERR_CANNOT_READ:
+    case ERR_SERVER_TIMEOUT:
+    case ERR_INTERNAL_SERVER:
+    case ERR_WORKER_DIED:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static bool isSrcDestSameWorkerProcess(const QUrl &src, const QUrl &dest)
 {
     /* clang-format off */
@@ -165,6 +243,8 @@ void FileCopyJobPrivate::startBestCopyMethod()
         startCopyJob(m_dest);
     } else if (m_dest.isLocalFile() && KProtocolManager::canCopyToFile(m_src) && !KIO::Scheduler::isWorkerOnHoldFor(m_src)) {
         startCopyJob(m_src);
+    } else if (canDownloadSegmented()) {
+        startSegmentedDownload();
     } else {
         startDataPump();
     }
@@ -189,6 +269,17 @@ void FileCopyJob::setModificationTime(const QDateTime &mtime)
     d->m_modificationTime = mtime;
 }
 
+void FileCopyJob::setSegmentCount(int count)
+{
+    Q_D(FileCopyJob);
+    d->m_segmentCount = qMax(1, count);
+}
+
+int FileCopyJob::segmentCount() const
+{
+    return d_func()->m_segmentCount;
+}
+
 QUrl FileCopyJob::srcUrl() const
 {
     return d_func()->m_src;
@@ -283,6 +374,12 @@ bool FileCopyJob::doSuspend()
         d->m_putJob->suspend();
     }
 
+    for (const FileCopyJobPrivate::Segment &segment : d->m_segments) {
+        if (segment.job) {
+            segment.job->suspend();
+        }
+    }
+
     Job::doSuspend();
     return true;
 }
@@ -306,6 +403,12 @@ bool FileCopyJob::doResume()
         d->m_putJob->resume();
     }
 
+    for (const FileCopyJobPrivate::Segment &segment : d->m_segments) {
+        if (segment.job) {
+            segment.job->resume();
+        }
+    }
+
     Job::doResume();
     return true;
 }
@@ -320,6 +423,14 @@ void FileCopyJobPrivate::startDataPump()
     m_getJob = nullptr; // for now
     m_putJob = put(m_dest, m_permissions, (m_flags | HideProgressInfo) /* no GUI */);
     m_putJob->setParentJob(q);
+    m_dataPipe = createDataPipeAddress(m_src);
+    if (!m_dataPipe.isEmpty()) {
+        // The put worker listens right away. Its first data request is answered
+        // with CMD_DATA_PIPE, see slotDataReq(), after which it reads the data
+        // from the get worker, which we only get progress information from.
+        m_putJob->addMetaData(QStringLiteral("data-pipe-in"), m_dataPipe);
+        m_putJob->setAsyncDataEnabled(true);
+    }
     // qDebug() << "m_putJob=" << m_putJob << "m_dest=" << m_dest;
     if (m_modificationTime.isValid()) {
         m_putJob->setModificationTime(m_modificationTime);
@@ -416,8 +527,20 @@ void FileCopyJobPrivate::processCanResumeResult(KIO::Job *job, RenameDialog_Resu
     }
 
     if (job == m_putJob) {
+        if (!m_resumeAnswerSent && !m_dataPipe.isEmpty()) {
+            // We tell the put worker whether to resume once the get job
+            // sent data, so it has to go through us
+            m_dataPipe.clear();
+            m_putJob->setAsyncDataEnabled(false);
+        }
+
         m_getJob = KIO::get(m_src, NoReload, HideProgressInfo /* no GUI */);
         m_getJob->setParentJob(q);
+        if (!m_dataPipe.isEmpty()) {
+            m_getJob->addMetaData(QStringLiteral("data-pipe-out"), m_dataPipe);
+            // Don't let the data pile up in the pipe when we are suspended
+            m_getJob->setFlowControlWindow(s_dataPipeWindow);
+        }
         // qDebug() << "m_getJob=" << m_getJob << m_src;
         m_getJob->addMetaData(QStringLiteral("errorPage"), QStringLiteral("false"));
         m_getJob->addMetaData(QStringLiteral("AllowCompressedPage"), QStringLiteral("false"));
@@ -437,7 +560,9 @@ void FileCopyJobPrivate::processCanResumeResult(KIO::Job *job, RenameDialog_Resu
         }
         jobWorker(m_putJob)->setOffset(offset);
 
-        m_putJob->d_func()->internalSuspend();
+        if (m_dataPipe.isEmpty()) {
+            m_putJob->d_func()->internalSuspend();
+        }
         q->addSubjob(m_getJob);
         connectSubjob(m_getJob); // Progress info depends on get
         m_getJob->d_func()->internalResume(); // Order a beer
@@ -453,11 +578,25 @@ void FileCopyJobPrivate::processCanResumeResult(KIO::Job *job, RenameDialog_Resu
 
 void FileCopyJobPrivate::slotData(KIO::Job *, const QByteArray &data)
 {
+    Q_Q(FileCopyJob);
     // qDebug() << "data size:" << data.size();
     Q_ASSERT(m_putJob);
     if (!m_putJob) {
         return; // Don't crash
     }
+    if (!m_dataPipe.isEmpty()) {
+        // The get worker couldn't connect to the data pipe, the put worker is waiting in vain
+        q->setError(ERR_INTERNAL);
+        q->setErrorText(QStringLiteral("'Get' job could not send the data to the 'put' job"));
+        m_getJob->kill(FileCopyJob::Quietly);
+        q->removeSubjob(m_getJob);
+        m_getJob = nullptr;
+        m_putJob->kill(FileCopyJob::Quietly);
+        q->removeSubjob(m_putJob);
+        m_putJob = nullptr;
+        q->emitResult();
+        return;
+    }
     m_getJob->d_func()->internalSuspend();
     m_putJob->d_func()->internalResume(); // Drink the beer
     m_buffer += data;
@@ -485,6 +624,11 @@ void FileCopyJobPrivate::slotDataReq(KIO::Job *, QByteArray &data)
         q->emitResult();
         return;
     }
+    if (!m_dataPipe.isEmpty()) {
+        // The put worker reads from the get worker from now on
+        jobWorker(m_putJob)->send(CMD_DATA_PIPE);
+        return;
+    }
     if (m_getJob) {
         m_getJob->d_func()->internalResume(); // Order more beer
         m_putJob->d_func()->internalSuspend();
@@ -493,6 +637,307 @@ void FileCopyJobPrivate::slotDataReq(KIO::Job *, QByteArray &data)
     m_buffer = QByteArray();
 }
 
+int FileCopyJobPrivate::maxSegmentCount(KIO::filesize_t size) const
+{
+    int count = m_segmentCount;
+    // More connections would only wait for the scheduler
+    const int maxWorkersPerHost = KProtocolInfo::maxWorkersPerHost(m_src.scheme());
+    if (maxWorkersPerHost > 0) {
+        count = qMin(count, maxWorkersPerHost);
+    }
+    return int(std::min<KIO::filesize_t>(count, size / s_minSegmentSize));
+}
+
+bool FileCopyJobPrivate::canDownloadSegmented() const
+{
+    /* clang-format off */
+    return m_segmentCount > 1
+        && !m_move
+        && !(m_flags & Resume)
+        && m_dest.isLocalFile()
+        && (m_src.scheme() == QLatin1String("http") || m_src.scheme() == QLatin1String("https"))
+        && !KIO::Scheduler::isWorkerOnHoldFor(m_src);
+    /* clang-format on */
+}
+
+void FileCopyJobPrivate::startSegmentedDownload()
+{
+    Q_Q(FileCopyJob);
+    const QString destPath = m_dest.toLocalFile();
+    const QFileInfo destInfo(destPath);
+    if (destInfo.isDir()) {
+        q->setError(ERR_DIR_ALREADY_EXIST);
+        q->setErrorText(destPath);
+        q->emitResult();
+        return;
+    }
+    if (destInfo.exists() && !(m_flags & Overwrite)) {
+        q->setError(ERR_FILE_ALREADY_EXIST);
+        q->setErrorText(destPath);
+        q->emitResult();
+        return;
+    }
+
+    m_segmentFile = std::make_unique<QFile>(destPath + QLatin1String(".part"));
+    if (!m_segmentFile->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        m_segmentFile.reset();
+        q->setError(ERR_CANNOT_OPEN_FOR_WRITING);
+        q->setErrorText(destPath);
+        q->emitResult();
+        return;
+    }
+
+    m_segments.resize(1);
+    if (m_sourceSize != filesize_t(-1) && maxSegmentCount(m_sourceSize) > 1) {
+        if (!splitSegments(m_sourceSize)) {
+            return;
+        }
+    }
+    // Otherwise the first segment tells us the size, see slotSegmentTotalSize()
+    for (int i = 0; i < int(m_segments.size()); ++i) {
+        startSegment(i);
+    }
+}
+
+bool FileCopyJobPrivate::splitSegments(KIO::filesize_t size)
+{
+    // Reserve the space of the whole file, so that the segments can be written at their offsets
+    if (!m_segmentFile->resize(qint64(size))) {
+        abortSegmentedDownload(ERR_DISK_FULL, m_dest.toDisplayString());
+        return false;
+    }
+
+    const int count = maxSegmentCount(size);
+    const KIO::filesize_t segmentSize = size / count;
+    m_segments.resize(count);
+    for (int i = 0; i < count; ++i) {
+        Segment &segment = m_segments[i];
+        if (i > 0) {
+            segment.offset = i * segmentSize;
+        }
+        segment.end = (i == count - 1) ? size : (i + 1) * segmentSize;
+    }
+    return true;
+}
+
+void FileCopyJobPrivate::startSegment(int index)
+{
+    Q_Q(FileCopyJob);
+    Segment &segment = m_segments[index];
+    segment.openEnded = segment.end == 0;
+    segment.rangeConfirmed = segment.offset == 0;
+
+    // Partial content never comes from the cache
+    const bool ranged = segment.offset > 0 || !segment.openEnded;
+    TransferJob *job = KIO::get(m_src, ranged ? Reload : NoReload, HideProgressInfo /* no GUI */);
+    job->setParentJob(q);
+    job->addMetaData(QStringLiteral("errorPage"), QStringLiteral("false"));
+    job->addMetaData(QStringLiteral("AllowCompressedPage"), QStringLiteral("false"));
+    if (segment.offset > 0) {
+        job->addMetaData(QStringLiteral("range-start"), KIO::number(segment.offset));
+    }
+    if (!segment.openEnded) {
+        job->addMetaData(QStringLiteral("range-end"), KIO::number(segment.end - 1)); // inclusive
+    }
+    segment.job = job;
+
+    // Only emitted if the server supports ranges
+    q->connect(job, &KIO::TransferJob::canResume, q, [this](KIO::Job *job) {
+        const int index = segmentIndex(job);
+        if (index != -1) {
+            m_segments[index].rangeConfirmed = true;
+        }
+    });
+    q->connect(job, &KIO::TransferJob::data, q, [this](KIO::Job *job, const QByteArray &data) {
+        slotSegmentData(job, data);
+    });
+    if (index == 0) {
+        q->connect(job, &KIO::TransferJob::mimeTypeFound, q, [this](KIO::Job *job, const QString &type) {
+            slotMimetype(job, type);
+        });
+    }
+    if (segment.openEnded && m_segments.size() == 1) {
+        q->connect(job, &KJob::totalSize, q, [this](KJob *, qulonglong size) {
+            slotSegmentTotalSize(size);
+        });
+    }
+
+    q->addSubjob(job);
+    if (q->isSuspended()) {
+        job->suspend();
+    }
+}
+
+int FileCopyJobPrivate::segmentIndex(const KJob *job) const
+{
+    for (int i = 0; i < int(m_segments.size()); ++i) {
+        if (m_segments[i].job == job) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void FileCopyJobPrivate::slotSegmentTotalSize(KIO::filesize_t size)
+{
+    Q_Q(FileCopyJob);
+    // Only the first response decides how the file is split
+    if (size == 0 || m_segments.size() != 1 || m_segments[0].end != 0) {
+        return;
+    }
+    m_sourceSize = size;
+    q->setTotalAmount(KJob::Bytes, size);
+    if (maxSegmentCount(size) < 2 || !splitSegments(size)) {
+        return;
+    }
+    // The first segment keeps going until its end, see slotSegmentData()
+    for (int i = 1; i < int(m_segments.size()); ++i) {
+        startSegment(i);
+    }
+}
+
+void FileCopyJobPrivate::slotSegmentData(KIO::Job *job, const QByteArray &data)
+{
+    Q_Q(FileCopyJob);
+    int index = segmentIndex(job);
+    if (index == -1 || data.isEmpty()) {
+        return;
+    }
+
+    if (!m_segments[index].rangeConfirmed) {
+        // The server ignored the range and sends the file from its beginning,
+        // keep this connection only
+        qCDebug(KIO_CORE) << "Ranges not supported for" << m_src << ", downloading it over a single connection";
+        Segment single = m_segments[index];
+        single.offset = 0;
+        single.end = m_segments.back().end;
+        single.openEnded = true;
+        single.rangeConfirmed = true;
+        for (const Segment &segment : m_segments) {
+            if (segment.job && segment.job != job) {
+                segment.job->kill(FileCopyJob::Quietly);
+                q->removeSubjob(segment.job);
+            }
+        }
+        m_segments = {single};
+        m_segmentedProcessed = 0;
+        index = 0;
+    }
+
+    Segment &segment = m_segments[index];
+    qint64 size = data.size();
+    if (segment.end != 0) {
+        // An open-ended segment goes on past its end
+        size = qMin<qint64>(size, qint64(segment.end) - qint64(segment.offset));
+    }
+    if (size > 0) {
+        if (!m_segmentFile->seek(qint64(segment.offset)) || m_segmentFile->write(data.constData(), size) != size) {
+            abortSegmentedDownload(ERR_CANNOT_WRITE, m_dest.toDisplayString());
+            return;
+        }
+        segment.offset += size;
+        m_segmentedProcessed += size;
+        q->setProcessedAmount(KJob::Bytes, m_segmentedProcessed);
+    }
+
+    if (segment.openEnded && segment.end != 0 && segment.offset >= segment.end) {
+        // The rest of the file comes from the other segments
+        segment.job->kill(FileCopyJob::Quietly);
+        q->removeSubjob(segment.job);
+        segment.job = nullptr;
+        const bool running = std::any_of(m_segments.cbegin(), m_segments.cend(), [](const Segment &other) {
+            return other.job != nullptr;
+        });
+        if (!running) {
+            finishSegmentedDownload();
+        }
+    }
+}
+
+void FileCopyJobPrivate::slotSegmentResult(KJob *job)
+{
+    const int index = segmentIndex(job);
+    Segment &segment = m_segments[index];
+    segment.job = nullptr;
+
+    if (job->error() || segment.offset < segment.end) {
+        // Resume the segment where it stopped
+        if (segment.retries < s_maxSegmentRetries && (!job->error() || isTransientError(job->error()))) {
+            qCDebug(KIO_CORE) << "Fetching" << m_src << "again from" << segment.offset << "after error" << job->error();
+            ++segment.retries;
+            startSegment(index);
+            return;
+        }
+        if (job->error()) {
+            abortSegmentedDownload(job->error(), job->errorText());
+        } else {
+            abortSegmentedDownload(ERR_CONNECTION_BROKEN, m_src.host());
+        }
+        return;
+    }
+
+    if (segment.end == 0) {
+        segment.end = segment.offset; // the size wasn't known, the whole file is here
+    }
+    const bool running = std::any_of(m_segments.cbegin(), m_segments.cend(), [](const Segment &other) {
+        return other.job != nullptr;
+    });
+    if (!running) {
+        finishSegmentedDownload();
+    }
+}
+
+void FileCopyJobPrivate::finishSegmentedDownload()
+{
+    Q_Q(FileCopyJob);
+    const QString destPath = m_dest.toLocalFile();
+    m_segments.clear();
+
+    if (m_modificationTime.isValid()) {
+        m_segmentFile->setFileTime(m_modificationTime, QFileDevice::FileModificationTime);
+    }
+    if (!m_segmentFile->flush()) {
+        abortSegmentedDownload(ERR_CANNOT_WRITE, destPath);
+        return;
+    }
+    m_segmentFile->close();
+    if (m_flags & Overwrite) {
+        QFile::remove(destPath);
+    }
+    if (!m_segmentFile->rename(destPath)) {
+        abortSegmentedDownload(ERR_CANNOT_RENAME_PARTIAL, destPath);
+        return;
+    }
+    m_segmentFile.reset();
+
+    // If m_permissions == -1, keep the default permissions
+    if (m_permissions != -1) {
+        m_chmodJob = chmod(m_dest, m_permissions);
+        q->addSubjob(m_chmodJob);
+        return; // see FileCopyJob::slotResult()
+    }
+    q->emitResult();
+}
+
+void FileCopyJobPrivate::abortSegmentedDownload(int error, const QString &errorText)
+{
+    Q_Q(FileCopyJob);
+    for (const Segment &segment : m_segments) {
+        if (segment.job) {
+            segment.job->kill(FileCopyJob::Quietly);
+            q->removeSubjob(segment.job);
+        }
+    }
+    m_segments.clear();
+    if (m_segmentFile) {
+        m_segmentFile->remove();
+        m_segmentFile.reset();
+    }
+    q->setError(error);
+    q->setErrorText(errorText);
+    q->emitResult();
+}
+
 void FileCopyJobPrivate::slotMimetype(KIO::Job *, const QString &type)
 {
     Q_Q(FileCopyJob);
@@ -505,6 +950,11 @@ void FileCopyJob::slotResult(KJob *job)
     // qDebug() << "this=" << this << "job=" << job;
     removeSubjob(job);
 
+    if (d->segmentIndex(job) != -1) {
+        d->slotSegmentResult(job);
+        return;
+    }
+
     // If result comes from copyjob then we are not writing anymore.
     if (job == d->m_copyJob) {
         d->m_bFileCopyInProgress = false;
@@ -609,13 +1059,19 @@ void FileCopyJob::slotResult(KJob *job)
 
 bool FileCopyJob::doKill()
 {
+    Q_D(FileCopyJob);
+
+    // The segments are written at their offsets, the file can't be resumed later
+    if (d->m_segmentFile) {
+        d->m_segmentFile->remove();
+    }
+
 #ifdef Q_OS_WIN
     // TODO Use SetConsoleCtrlHandler on Windows or similar behaviour.
     // https://stackoverflow.com/questions/2007516/is-there-a-posix-sigterm-alternative-on-windows-a-gentle-kill-for-console-ap
     // https://danielkaes.wordpress.com/2009/06/04/how-to-catch-kill-events-with-python/
     // https://phabricator.kde.org/D25117#566107
 
-    Q_D(FileCopyJob);
 
     // If we are interrupted in the middle of file copying,
     // we may end up with corrupted file at the destination.
@@ -633,6 +1089,11 @@ bool FileCopyJob::doKill()
     return Job::doKill();
 }
 
+QString KIO::_fileCopyJobDataPipe(FileCopyJob *job)
+{
+    return FileCopyJobPrivate::get(job)->m_dataPipe;
+}
+
 FileCopyJob *KIO::file_copy(const QUrl &src, const QUrl &dest, int permissions, JobFlags flags)
 {
     return FileCopyJobPrivate::newJob(src, dest, permissions, false, flags);
@@ -44,6 +44,34 @@ public:
      */
     void setModificationTime(const QDateTime &mtime);
 
+    /**
+     * Downloads the file over up to @p count parallel connections, each one
+     * fetching a range of bytes, which is written at its offset into the destination.
+     * This speeds up large downloads over links where a single connection is slow.
+     *
+     * This is only used when copying (not moving) from http(s) to a local file,
+     * without @ref JobFlag::Resume. The data is written to a "<dest>.part" file,
+     * preallocated to the size of the source, and renamed when done.
+     * A range interrupted by a network error is resumed from where it stopped.
+     *
+     * If the size of the source isn't known in advance (see setSourceSize()),
+     * it comes from the first response. If the server turns out not to support
+     * ranges, or the file is small, a single connection is used.
+     *
+     * Call this before the job starts, i.e. right after KIO::file_copy().
+     *
+     * @param count the maximum number of connections, 1 (the default) disables segmented downloads
+     * @since 6.0
+     */
+    void setSegmentCount(int count);
+
+    /**
+     * @return the maximum number of connections used to download the file
+     * @see setSegmentCount()
+     * @since 6.0
+     */
+    int segmentCount() const;
+
     /**
      * Returns the source URL.
      * @return the source URL
@@ -0,0 +1,27 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KIO_FILECOPYJOB_P_H
+#define KIO_FILECOPYJOB_P_H
+
+#include "kiocore_export.h"
+
+#include <QString>
+
+namespace KIO
+{
+class FileCopyJob;
+
+// don't export FileCopyJobPrivate to avoid unnecessary symbols
+/**
+ * The address of the data pipe between the get and the put workers of @p job,
+ * empty if the data goes through the application. For the unit tests.
+ */
+KIOCORE_EXPORT QString _fileCopyJobDataPipe(FileCopyJob *job);
+}
+
+#endif
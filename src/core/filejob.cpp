@@ -10,6 +10,16 @@
 #include "job_p.h"
 #include "worker_p.h"
 
+#include <algorithm>
+#include <deque>
+
+// Read-ahead requests start small and grow while the application waits for data
+static constexpr KIO::filesize_t s_minReadAheadChunk = 64 * 1024;
+static constexpr KIO::filesize_t s_maxReadAheadChunk = 1024 * 1024;
+static constexpr int s_maxReadsInFlight = 4;
+// Writes are coalesced until this much data is buffered
+static constexpr qsizetype s_writeBehindSize = 256 * 1024;
+
 class KIO::FileJobPrivate : public KIO::SimpleJobPrivate
 {
 public:
@@ -24,6 +34,63 @@ public:
     QString m_mimetype;
     KIO::filesize_t m_size;
 
+    // Requests sent to the worker, which answers them in order.
+    // Replies to requests the job made on its own aren't forwarded.
+    enum class ReadKind {
+        Direct,
+        ReadAhead,
+        Discard,
+    };
+    struct PendingRead {
+        KIO::filesize_t size;
+        ReadKind kind;
+    };
+    std::deque<PendingRead> m_pendingReads;
+    std::deque<bool> m_pendingSeeks; // whether position() is forwarded
+    std::deque<bool> m_pendingWrites; // whether written() is forwarded
+
+    // Buffered mode: the application's requests, processed in order once the
+    // read-ahead data they need has arrived
+    enum class OperationType {
+        Read,
+        Write,
+        Seek,
+        Truncate,
+        Close,
+    };
+    struct Operation {
+        OperationType type;
+        KIO::filesize_t value = 0;
+        QByteArray data = {};
+    };
+    bool m_buffered = false;
+    bool m_processingOperations = false;
+    bool m_processingScheduled = false;
+    bool m_eof = false; // the read-ahead reached the end of the file
+    bool m_reading = false; // the application reads sequentially, keep reading ahead
+    std::deque<Operation> m_operations;
+    KIO::filesize_t m_position = 0; // position of the application in the file
+    QByteArray m_readBuffer; // read-ahead data, m_readBuffer[m_readOffset] is at m_position
+    qsizetype m_readOffset = 0;
+    KIO::filesize_t m_readAheadInFlight = 0;
+    int m_readsAheadInFlight = 0;
+    KIO::filesize_t m_readAheadChunk = s_minReadAheadChunk;
+    QByteArray m_writeBuffer;
+
+    qsizetype bufferedBytes() const
+    {
+        return m_readBuffer.size() - m_readOffset;
+    }
+
+    void enqueue(Operation &&operation);
+    void scheduleProcessing();
+    void processOperations();
+    void readAhead();
+    QByteArray takeReadBuffer(qsizetype size);
+    void discardReadAhead();
+    void syncWorkerPosition();
+    void flushWrites();
+
     void slotRedirection(const QUrl &url);
     void slotData(const QByteArray &data);
     void slotMimetype(const QString &mimetype);
@@ -70,8 +137,14 @@ void FileJob::read(KIO::filesize_t size)
         return;
     }
 
+    if (d->m_buffered || !d->m_operations.empty()) {
+        d->enqueue({FileJobPrivate::OperationType::Read, size});
+        return;
+    }
+
     KIO_ARGS << size;
     d->m_worker->send(CMD_READ, packedArgs);
+    d->m_pendingReads.push_back({size, FileJobPrivate::ReadKind::Direct});
 }
 
 void FileJob::write(const QByteArray &_data)
@@ -81,7 +154,13 @@ void FileJob::write(const QByteArray &_data)
         return;
     }
 
+    if (d->m_buffered || !d->m_operations.empty()) {
+        d->enqueue({FileJobPrivate::OperationType::Write, KIO::filesize_t(_data.size()), _data});
+        return;
+    }
+
     d->m_worker->send(CMD_WRITE, _data);
+    d->m_pendingWrites.push_back(true);
 }
 
 void FileJob::seek(KIO::filesize_t offset)
@@ -91,8 +170,14 @@ void FileJob::seek(KIO::filesize_t offset)
         return;
     }
 
+    if (d->m_buffered || !d->m_operations.empty()) {
+        d->enqueue({FileJobPrivate::OperationType::Seek, offset});
+        return;
+    }
+
     KIO_ARGS << KIO::filesize_t(offset);
     d->m_worker->send(CMD_SEEK, packedArgs);
+    d->m_pendingSeeks.push_back(true);
 }
 
 void FileJob::truncate(KIO::filesize_t length)
@@ -102,6 +187,11 @@ void FileJob::truncate(KIO::filesize_t length)
         return;
     }
 
+    if (d->m_buffered || !d->m_operations.empty()) {
+        d->enqueue({FileJobPrivate::OperationType::Truncate, length});
+        return;
+    }
+
     KIO_ARGS << KIO::filesize_t(length);
     d->m_worker->send(CMD_TRUNCATE, packedArgs);
 }
@@ -113,10 +203,215 @@ void FileJob::close()
         return;
     }
 
+    if (d->m_buffered || !d->m_operations.empty()) {
+        d->enqueue({FileJobPrivate::OperationType::Close});
+        return;
+    }
+
     d->m_worker->send(CMD_CLOSE);
     // ###  close?
 }
 
+void FileJob::setBuffered(bool buffered)
+{
+    Q_D(FileJob);
+    if (d->m_buffered == buffered) {
+        return;
+    }
+    d->m_buffered = buffered;
+    if (!buffered && d->m_open && d->m_operations.empty()) {
+        // Later requests go straight to the worker, which must be where the application is
+        d->flushWrites();
+        d->syncWorkerPosition();
+    }
+}
+
+bool FileJob::isBuffered() const
+{
+    Q_D(const FileJob);
+    return d->m_buffered;
+}
+
+void FileJobPrivate::enqueue(Operation &&operation)
+{
+    m_operations.push_back(std::move(operation));
+    scheduleProcessing();
+}
+
+void FileJobPrivate::scheduleProcessing()
+{
+    // Results are always delivered asynchronously, like without buffering
+    if (m_processingScheduled) {
+        return;
+    }
+    m_processingScheduled = true;
+    Q_Q(FileJob);
+    QMetaObject::invokeMethod(
+        q,
+        [this]() {
+            m_processingScheduled = false;
+            processOperations();
+        },
+        Qt::QueuedConnection);
+}
+
+void FileJobPrivate::processOperations()
+{
+    Q_Q(FileJob);
+    // Slots connected to our signals may make new requests, they are queued
+    if (m_processingOperations) {
+        return;
+    }
+    m_processingOperations = true;
+
+    while (m_open && !m_operations.empty()) {
+        Operation operation = std::move(m_operations.front());
+        if (operation.type == OperationType::Read) {
+            // The data to read may be the data written, the worker must get the writes first.
+            // The read-ahead was dropped when writing, so the worker is then at m_position.
+            flushWrites();
+            m_reading = true;
+            const qsizetype available = bufferedBytes();
+            if (KIO::filesize_t(available) < operation.value && !m_eof) {
+                // The application waits for data: read further ahead
+                if (available == 0) {
+                    m_readAheadChunk = std::min(m_readAheadChunk * 2, s_maxReadAheadChunk);
+                }
+                break;
+            }
+        }
+        m_operations.pop_front();
+
+        switch (operation.type) {
+        case OperationType::Read: {
+            const QByteArray data = takeReadBuffer(qsizetype(std::min(operation.value, KIO::filesize_t(bufferedBytes()))));
+            Q_EMIT q->data(q, data);
+            break;
+        }
+        case OperationType::Write:
+            m_reading = false;
+            syncWorkerPosition();
+            m_writeBuffer += operation.data;
+            m_position += operation.value;
+            if (m_writeBuffer.size() >= s_writeBehindSize) {
+                flushWrites();
+            }
+            Q_EMIT q->written(q, operation.value);
+            break;
+        case OperationType::Seek:
+            flushWrites();
+            if (operation.value >= m_position && operation.value - m_position <= KIO::filesize_t(bufferedBytes())) {
+                takeReadBuffer(qsizetype(operation.value - m_position));
+            } else {
+                // Random access, start again with a small read-ahead
+                discardReadAhead();
+                KIO_ARGS << operation.value;
+                m_worker->send(CMD_SEEK, packedArgs);
+                m_pendingSeeks.push_back(false);
+                m_position = operation.value;
+                m_readAheadChunk = s_minReadAheadChunk;
+            }
+            Q_EMIT q->position(q, m_position);
+            break;
+        case OperationType::Truncate: {
+            flushWrites();
+            // The read-ahead data may not exist anymore
+            syncWorkerPosition();
+            KIO_ARGS << operation.value;
+            m_worker->send(CMD_TRUNCATE, packedArgs);
+            break;
+        }
+        case OperationType::Close:
+            flushWrites();
+            discardReadAhead();
+            m_reading = false;
+            m_worker->send(CMD_CLOSE);
+            break;
+        }
+    }
+
+    if (m_open && !m_buffered && m_operations.empty()) {
+        // Back to unbuffered requests
+        flushWrites();
+        syncWorkerPosition();
+    } else if (m_reading) {
+        readAhead();
+    }
+
+    m_processingOperations = false;
+}
+
+void FileJobPrivate::readAhead()
+{
+    if (!m_open || m_eof || !m_worker) {
+        return;
+    }
+    // Keep enough requests in flight for the window, and for the read the application waits for
+    KIO::filesize_t wanted = m_readAheadChunk * s_maxReadsInFlight;
+    if (!m_operations.empty() && m_operations.front().type == OperationType::Read) {
+        wanted = std::max(wanted, m_operations.front().value);
+    }
+    while (m_readsAheadInFlight < s_maxReadsInFlight && KIO::filesize_t(bufferedBytes()) + m_readAheadInFlight < wanted) {
+        KIO_ARGS << m_readAheadChunk;
+        m_worker->send(CMD_READ, packedArgs);
+        m_pendingReads.push_back({m_readAheadChunk, ReadKind::ReadAhead});
+        m_readAheadInFlight += m_readAheadChunk;
+        ++m_readsAheadInFlight;
+    }
+}
+
+QByteArray FileJobPrivate::takeReadBuffer(qsizetype size)
+{
+    const QByteArray data = m_readBuffer.mid(m_readOffset, size);
+    m_readOffset += data.size();
+    m_position += data.size();
+    if (m_readOffset == m_readBuffer.size()) {
+        m_readBuffer.clear();
+        m_readOffset = 0;
+    } else if (m_readOffset > m_readBuffer.size() / 2) {
+        m_readBuffer.remove(0, m_readOffset);
+        m_readOffset = 0;
+    }
+    return data;
+}
+
+void FileJobPrivate::discardReadAhead()
+{
+    for (PendingRead &read : m_pendingReads) {
+        if (read.kind == ReadKind::ReadAhead) {
+            read.kind = ReadKind::Discard;
+        }
+    }
+    m_readBuffer.clear();
+    m_readOffset = 0;
+    m_readAheadInFlight = 0;
+    m_readsAheadInFlight = 0;
+    m_eof = false;
+}
+
+void FileJobPrivate::syncWorkerPosition()
+{
+    // The worker is ahead of the application by the data read ahead
+    if (bufferedBytes() == 0 && m_readsAheadInFlight == 0) {
+        return;
+    }
+    discardReadAhead();
+    KIO_ARGS << m_position;
+    m_worker->send(CMD_SEEK, packedArgs);
+    m_pendingSeeks.push_back(false);
+}
+
+void FileJobPrivate::flushWrites()
+{
+    if (m_writeBuffer.isEmpty()) {
+        return;
+    }
+    m_worker->send(CMD_WRITE, m_writeBuffer);
+    m_pendingWrites.push_back(false); // written() was emitted already
+    m_writeBuffer.clear();
+    m_eof = false;
+}
+
 KIO::filesize_t FileJob::size()
 {
     Q_D(FileJob);
@@ -131,7 +426,30 @@ KIO::filesize_t FileJob::size()
 void FileJobPrivate::slotData(const QByteArray &_data)
 {
     Q_Q(FileJob);
-    Q_EMIT q_func()->data(q, _data);
+    if (m_pendingReads.empty()) {
+        Q_EMIT q->data(q, _data);
+        return;
+    }
+
+    const PendingRead read = m_pendingReads.front();
+    m_pendingReads.pop_front();
+    switch (read.kind) {
+    case ReadKind::Direct:
+        Q_EMIT q->data(q, _data);
+        break;
+    case ReadKind::ReadAhead:
+        m_readAheadInFlight -= read.size;
+        --m_readsAheadInFlight;
+        if (_data.isEmpty()) {
+            m_eof = true;
+        } else {
+            m_readBuffer += _data;
+        }
+        processOperations();
+        break;
+    case ReadKind::Discard:
+        break;
+    }
 }
 
 void FileJobPrivate::slotRedirection(const QUrl &url)
@@ -151,7 +469,13 @@ void FileJobPrivate::slotMimetype(const QString &type)
 void FileJobPrivate::slotPosition(KIO::filesize_t pos)
 {
     Q_Q(FileJob);
-    Q_EMIT q->position(q, pos);
+    const bool forward = m_pendingSeeks.empty() || m_pendingSeeks.front();
+    if (!m_pendingSeeks.empty()) {
+        m_pendingSeeks.pop_front();
+    }
+    if (forward) {
+        Q_EMIT q->position(q, pos);
+    }
 }
 
 void FileJobPrivate::slotTruncated(KIO::filesize_t length)
@@ -177,7 +501,13 @@ void FileJobPrivate::slotOpen()
 void FileJobPrivate::slotWritten(KIO::filesize_t t_written)
 {
     Q_Q(FileJob);
-    Q_EMIT q->written(q, t_written);
+    const bool forward = m_pendingWrites.empty() || m_pendingWrites.front();
+    if (!m_pendingWrites.empty()) {
+        m_pendingWrites.pop_front();
+    }
+    if (forward) {
+        Q_EMIT q->written(q, t_written);
+    }
 }
 
 void FileJobPrivate::slotFinished()
@@ -185,6 +515,7 @@ void FileJobPrivate::slotFinished()
     Q_Q(FileJob);
     // qDebug() << this << m_url;
     m_open = false;
+    m_operations.clear();
 
     Q_EMIT q->fileClosed(q);
 
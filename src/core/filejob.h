@@ -21,6 +21,10 @@ class FileJobPrivate;
  *  It allows block-wise reading and writing, and allows seeking and truncation. Results are returned through signals.
  *
  *  Should always be created using KIO::open(const QUrl&, QIODevice::OpenMode).
+ *
+ *  By default every call maps to one request to the worker. Applications doing many
+ *  small sequential reads or writes should enable setBuffered(), or use
+ *  KIO::FileJobDevice to access the file through the QIODevice API.
  */
 
 class KIOCORE_EXPORT FileJob : public SimpleJob
@@ -104,6 +108,29 @@ public:
      */
     KIO::filesize_t size();
 
+    /**
+     * Enables or disables the buffered mode.
+     *
+     * In buffered mode, sequential reads are served from a read-ahead buffer which
+     * keeps several requests in flight to the worker; its window grows while the
+     * application consumes data faster than it arrives. Small writes are coalesced
+     * and sent to the worker in larger blocks, written() being emitted as soon as
+     * the data was accepted (write-behind); write errors are then reported through
+     * result() only. seek() within the read-ahead buffer doesn't involve the worker.
+     *
+     * Requests are still answered asynchronously and in the order they were made.
+     *
+     * @param buffered whether to buffer reads and writes
+     * @since 6.0
+     */
+    void setBuffered(bool buffered);
+
+    /**
+     * @return whether the buffered mode is enabled, see setBuffered()
+     * @since 6.0
+     */
+    bool isBuffered() const;
+
 Q_SIGNALS:
     /**
      * Data from the worker has arrived. Emitted after read().
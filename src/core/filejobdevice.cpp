@@ -0,0 +1,346 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "filejobdevice.h"
+
+#include "filejob.h"
+
+#include <QEventLoop>
+#include <QPointer>
+#include <QTimer>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+
+using namespace KIO;
+
+// Read by waitForReadyRead() when the application didn't ask for a size yet
+static constexpr qint64 s_readChunkSize = 64 * 1024;
+
+class KIO::FileJobDevicePrivate
+{
+public:
+    explicit FileJobDevicePrivate(FileJobDevice *qq, FileJob *job)
+        : q(qq)
+        , m_job(job)
+    {
+    }
+
+    // The only place running an event loop, until @p done returns true or for at most @p msecs
+    bool waitFor(const std::function<bool()> &done, int msecs);
+    bool checkJob();
+    void requestRead(qint64 size);
+    void slotData(const QByteArray &data);
+    bool hasActiveRead() const;
+    // Forgets the data read ahead, e.g. before moving the position of the job
+    void dropReadData();
+
+    struct PendingRead {
+        qint64 remaining;
+        bool discard; // the position changed since it was requested
+    };
+
+    FileJobDevice *const q;
+    QPointer<FileJob> m_job;
+    QEventLoop *m_eventLoop = nullptr;
+    bool m_opened = false;
+    bool m_closing = false;
+    bool m_closed = false;
+    bool m_finished = false;
+    // The data at pos(), then the data of the pending reads which aren't discarded.
+    // A read may be answered with several data() signals, depending on the worker.
+    QByteArray m_readBuffer;
+    std::deque<PendingRead> m_pendingReads;
+    bool m_atEnd = false;
+    KIO::filesize_t m_writtenEnd = 0; // the file grows when writing past its end
+};
+
+bool FileJobDevicePrivate::waitFor(const std::function<bool()> &done, int msecs)
+{
+    if (done()) {
+        return true;
+    }
+    QEventLoop eventLoop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, &eventLoop, &QEventLoop::quit);
+    if (msecs >= 0) {
+        timer.start(msecs);
+    }
+    m_eventLoop = &eventLoop;
+    while (!done() && !m_finished && checkJob() && (msecs < 0 || timer.isActive())) {
+        eventLoop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+    m_eventLoop = nullptr;
+    return done();
+}
+
+bool FileJobDevicePrivate::checkJob()
+{
+    if (!m_job || m_job->error()) {
+        q->setErrorString(m_job ? m_job->errorString() : QString());
+        return false;
+    }
+    return true;
+}
+
+void FileJobDevicePrivate::requestRead(qint64 size)
+{
+    // Where the file ends we get less, possibly in an empty reply
+    const qint64 pos = q->pos() + m_readBuffer.size();
+    const qint64 fileSize = q->size();
+    const qint64 expected = fileSize > 0 ? std::clamp<qint64>(fileSize - pos, 0, size) : size;
+    m_pendingReads.push_back({expected, false});
+    m_job->read(KIO::filesize_t(size));
+}
+
+void FileJobDevicePrivate::slotData(const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        // The end of the file, which completes the oldest read
+        if (!m_pendingReads.empty()) {
+            m_atEnd = !m_pendingReads.front().discard;
+            m_pendingReads.pop_front();
+        }
+        return;
+    }
+
+    bool gotData = false;
+    qsizetype offset = 0;
+    while (offset < data.size()) {
+        if (m_pendingReads.empty()) {
+            // The file grew since the reads were requested
+            m_readBuffer.append(data.constData() + offset, data.size() - offset);
+            gotData = true;
+            break;
+        }
+        PendingRead &read = m_pendingReads.front();
+        const qsizetype size = qsizetype(std::min<qint64>(data.size() - offset, read.remaining));
+        if (!read.discard) {
+            m_readBuffer.append(data.constData() + offset, size);
+            gotData = true;
+        }
+        offset += size;
+        read.remaining -= size;
+        if (read.remaining <= 0) {
+            m_pendingReads.pop_front();
+        }
+    }
+    if (gotData) {
+        Q_EMIT q->readyRead();
+    }
+}
+
+bool FileJobDevicePrivate::hasActiveRead() const
+{
+    return std::any_of(m_pendingReads.cbegin(), m_pendingReads.cend(), [](const PendingRead &read) {
+        return !read.discard;
+    });
+}
+
+void FileJobDevicePrivate::dropReadData()
+{
+    m_readBuffer.clear();
+    for (PendingRead &read : m_pendingReads) {
+        read.discard = true;
+    }
+    m_atEnd = false;
+}
+
+FileJobDevice::FileJobDevice(FileJob *job, QObject *parent)
+    : QIODevice(parent)
+    , d(new FileJobDevicePrivate(this, job))
+{
+    job->setBuffered(true);
+    // Keep the job after its result, to report its error
+    job->setAutoDelete(false);
+
+    auto quitEventLoop = [this]() {
+        if (d->m_eventLoop) {
+            d->m_eventLoop->quit();
+        }
+    };
+    connect(job, &FileJob::open, this, [this, quitEventLoop]() {
+        d->m_opened = true;
+        quitEventLoop();
+    });
+    connect(job, &FileJob::data, this, [this, quitEventLoop](KIO::Job *, const QByteArray &data) {
+        d->slotData(data);
+        quitEventLoop();
+    });
+    connect(job, &FileJob::fileClosed, this, [this, quitEventLoop]() {
+        d->m_closed = true;
+        quitEventLoop();
+    });
+    connect(job, &KJob::result, this, [this, quitEventLoop]() {
+        d->m_finished = true;
+        quitEventLoop();
+    });
+}
+
+FileJobDevice::~FileJobDevice()
+{
+    if (!d->m_job) {
+        return;
+    }
+    // Never wait here: a job writing the file closes it on its own, then deletes itself
+    d->m_job->disconnect(this);
+    if (d->m_opened && !d->m_closed && !d->m_finished) {
+        if (!d->m_closing) {
+            d->m_job->close();
+        }
+        d->m_job->setAutoDelete(true);
+        return;
+    }
+    if (!d->m_finished) {
+        d->m_job->kill();
+    }
+    delete d->m_job;
+}
+
+FileJob *FileJobDevice::job() const
+{
+    return d->m_job;
+}
+
+bool FileJobDevice::waitForOpened(int msecs)
+{
+    if (!d->waitFor(
+            [this]() {
+                return d->m_opened;
+            },
+            msecs)) {
+        d->checkJob();
+        return false;
+    }
+    return true;
+}
+
+bool FileJobDevice::open(OpenMode mode)
+{
+    if (!d->checkJob()) {
+        return false;
+    }
+    if (!d->m_opened || d->m_closing) {
+        setErrorString(d->m_closing ? i18n("The file was closed.") : i18n("The file isn't opened yet."));
+        return false;
+    }
+    // The job buffers the data already
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void FileJobDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    d->dropReadData();
+    if (d->m_job && d->m_opened && !d->m_closed) {
+        d->m_closing = true;
+        d->m_job->close();
+    }
+}
+
+bool FileJobDevice::waitForClosed(int msecs)
+{
+    if (!d->m_closing && !d->m_closed) {
+        return false;
+    }
+    return d->waitFor(
+               [this]() {
+                   return d->m_closed;
+               },
+               msecs)
+        && d->checkJob();
+}
+
+bool FileJobDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 FileJobDevice::size() const
+{
+    if (!d->m_job) {
+        return 0;
+    }
+    return qint64(std::max(d->m_job->size(), d->m_writtenEnd));
+}
+
+bool FileJobDevice::seek(qint64 pos)
+{
+    const qint64 oldPos = this->pos();
+    if (!QIODevice::seek(pos) || !d->checkJob()) {
+        return false;
+    }
+    if (pos >= oldPos && pos - oldPos <= d->m_readBuffer.size()) {
+        // Within the data read already, the pending reads go on after it
+        d->m_readBuffer.remove(0, pos - oldPos);
+        return true;
+    }
+    d->dropReadData();
+    // Requests are processed in order, no need to wait for the position
+    d->m_job->seek(KIO::filesize_t(pos));
+    return true;
+}
+
+bool FileJobDevice::waitForReadyRead(int msecs)
+{
+    if (!isOpen() || !d->checkJob()) {
+        return false;
+    }
+    if (d->m_readBuffer.isEmpty() && !d->hasActiveRead() && !d->m_atEnd) {
+        d->requestRead(s_readChunkSize);
+    }
+    return d->waitFor(
+        [this]() {
+            return !d->m_readBuffer.isEmpty() || (d->m_atEnd && !d->hasActiveRead());
+        },
+        msecs)
+        && !d->m_readBuffer.isEmpty();
+}
+
+qint64 FileJobDevice::readData(char *data, qint64 maxSize)
+{
+    if (!d->checkJob()) {
+        return -1;
+    }
+    // Never blocks: returns what arrived already, and asks for the rest
+    const qint64 size = std::min(qint64(d->m_readBuffer.size()), maxSize);
+    memcpy(data, d->m_readBuffer.constData(), size);
+    d->m_readBuffer.remove(0, size);
+    if (size < maxSize && !d->hasActiveRead() && !d->m_atEnd) {
+        d->requestRead(maxSize - size);
+    }
+    return size;
+}
+
+qint64 FileJobDevice::writeData(const char *data, qint64 maxSize)
+{
+    if (!d->checkJob()) {
+        return -1;
+    }
+    if (!d->m_readBuffer.isEmpty() || !d->m_pendingReads.empty()) {
+        // The job is ahead of pos() because of the data read ahead
+        const bool readAhead = !d->m_readBuffer.isEmpty() || d->hasActiveRead();
+        d->dropReadData();
+        if (readAhead) {
+            d->m_job->seek(KIO::filesize_t(pos()));
+        }
+    }
+    d->m_atEnd = false;
+    d->m_job->write(QByteArray(data, maxSize));
+    d->m_writtenEnd = std::max(d->m_writtenEnd, KIO::filesize_t(pos() + maxSize));
+    return maxSize;
+}
+
+#include "moc_filejobdevice.cpp"
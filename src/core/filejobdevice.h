@@ -0,0 +1,120 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KIO_FILEJOBDEVICE_H
+#define KIO_FILEJOBDEVICE_H
+
+#include "kiocore_export.h"
+
+#include <QIODevice>
+
+#include <memory>
+
+namespace KIO
+{
+class FileJob;
+class FileJobDevicePrivate;
+
+/**
+ * @class KIO::FileJobDevice filejobdevice.h <KIO/FileJobDevice>
+ *
+ * A QIODevice reading and writing a file through a KIO::FileJob, so that code
+ * written for QFile can access files of any protocol supporting KIO::open().
+ *
+ * The job is switched to buffered mode (see FileJob::setBuffered()), which makes
+ * sequential access fast. Like with a socket, nothing blocks unless asked for:
+ * reads return the data which arrived already and request the rest, readyRead()
+ * is emitted when more data arrived. waitForOpened(), waitForReadyRead() and
+ * waitForClosed() block, running a local event loop, for code which can't wait
+ * for the signals. Writes are buffered and their errors are reported by later calls.
+ *
+ * @code
+ * KIO::FileJob *job = KIO::open(url, QIODevice::ReadOnly);
+ * KIO::FileJobDevice device(job);
+ * if (device.waitForOpened() && device.open(QIODevice::ReadOnly)) {
+ *     QByteArray header;
+ *     while (header.size() < 512 && device.waitForReadyRead(30000)) {
+ *         header += device.read(512 - header.size());
+ *     }
+ *     ...
+ * }
+ * @endcode
+ *
+ * @since 6.0
+ */
+class KIOCORE_EXPORT FileJobDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates a device for @p job, which must not have been opened yet:
+     * create the device right after calling KIO::open().
+     * The device takes ownership of the job.
+     */
+    explicit FileJobDevice(FileJob *job, QObject *parent = nullptr);
+
+    /**
+     * Doesn't wait for the job: a file still open is closed once its pending
+     * data was written, then the job deletes itself.
+     */
+    ~FileJobDevice() override;
+
+    /**
+     * @return the job used by this device
+     */
+    FileJob *job() const;
+
+    /**
+     * Blocks until the job opened the file, for at most @p msecs milliseconds
+     * (-1 for no limit).
+     * @return false if the file couldn't be opened in time, see errorString()
+     */
+    bool waitForOpened(int msecs = 30000);
+
+    /**
+     * Opens the device, once the job opened the file: see waitForOpened() and
+     * FileJob::open(). @p mode should match the mode given to KIO::open().
+     * @return false if the file isn't opened, see errorString()
+     */
+    bool open(OpenMode mode) override;
+
+    /**
+     * Closes the file once the pending data was written, without waiting for it.
+     * @see waitForClosed()
+     */
+    void close() override;
+
+    /**
+     * Blocks until the file was closed after close(), for at most @p msecs
+     * milliseconds (-1 for no limit).
+     * @return false if the pending data couldn't be written, see errorString()
+     */
+    bool waitForClosed(int msecs = 30000);
+
+    /**
+     * Blocks until data can be read at the current position, for at most
+     * @p msecs milliseconds (-1 for no limit).
+     * @return false at the end of the file, on errors and on timeout
+     */
+    bool waitForReadyRead(int msecs) override;
+
+    bool isSequential() const override;
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    std::unique_ptr<FileJobDevicePrivate> const d;
+};
+
+} // namespace KIO
+
+#endif
@@ -0,0 +1,83 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "filesystemtypecache_p.h"
+#include "kmountpoint_p.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <chrono>
+
+using namespace KIO;
+using namespace std::chrono_literals;
+
+#ifdef Q_OS_LINUX
+// Checking for mount table changes is cheap, but not free: not for every item
+static constexpr auto s_mountTableCheckInterval = 100ms;
+#else
+// Mount table changes aren't detected, keep the entries only for the duration of a listing
+static constexpr auto s_mountTableCheckInterval = 5s;
+#endif
+
+class KIO::FileSystemTypeCachePrivate
+{
+public:
+    QMutex mutex; // protects all the member variables below
+    QHash<qint64, KFileSystemType::Type> types; // by device ID
+    std::chrono::steady_clock::time_point lastCheck;
+    quint64 mountTableChangeCount = 0; // see KIO::mountTableChangeCount()
+};
+
+FileSystemTypeCache *FileSystemTypeCache::instance()
+{
+    static FileSystemTypeCache s_cache;
+    return &s_cache;
+}
+
+FileSystemTypeCache::FileSystemTypeCache()
+    : d(new FileSystemTypeCachePrivate)
+{
+}
+
+FileSystemTypeCache::~FileSystemTypeCache() = default;
+
+KFileSystemType::Type FileSystemTypeCache::fileSystemType(qint64 deviceId, const QString &path)
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - d->lastCheck >= s_mountTableCheckInterval) {
+            d->lastCheck = now;
+            if (const quint64 changeCount = KIO::mountTableChangeCount(); changeCount != d->mountTableChangeCount) {
+                d->mountTableChangeCount = changeCount;
+                d->types.clear();
+            }
+        }
+        auto it = d->types.constFind(deviceId);
+        if (it != d->types.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // Not under the lock, statfs() can block on a network file system
+    const KFileSystemType::Type type = KFileSystemType::fileSystemType(path);
+    QMutexLocker locker(&d->mutex);
+    d->types.insert(deviceId, type);
+    return type;
+}
+
+bool FileSystemTypeCache::isSlow(KFileSystemType::Type type)
+{
+    return type == KFileSystemType::Nfs || type == KFileSystemType::Smb;
+}
+
+void FileSystemTypeCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->types.clear();
+}
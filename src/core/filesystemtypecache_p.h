@@ -0,0 +1,56 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef FILESYSTEMTYPECACHE_P_H
+#define FILESYSTEMTYPECACHE_P_H
+
+#include <kiocore_export.h>
+
+#include <KFileSystemType>
+
+#include <memory>
+
+namespace KIO
+{
+class FileSystemTypeCachePrivate;
+
+/**
+ * @internal
+ * Process-wide cache of the file system types, by device ID (st_dev, UDS_DEVICE_ID),
+ * so that KFileItem::isSlow() doesn't need a statfs() per item: all the items of a
+ * directory listing are usually on the same device.
+ *
+ * Device IDs get reused when file systems are unmounted and mounted, so the cache is
+ * emptied whenever the mount table changes. On Linux, this is detected by the mount
+ * table shared with KMountPoint. Elsewhere, the entries are forgotten after a few seconds.
+ *
+ * Thread-safe. Exported for the unit test.
+ */
+class KIOCORE_EXPORT FileSystemTypeCache
+{
+public:
+    static FileSystemTypeCache *instance();
+
+    // The type of the file system of @p path, which is on the device @p deviceId
+    KFileSystemType::Type fileSystemType(qint64 deviceId, const QString &path);
+
+    // Whether files on the file system type @p type are slow to access (network file systems)
+    static bool isSlow(KFileSystemType::Type type);
+
+    // Forgets everything
+    void clear();
+
+private:
+    FileSystemTypeCache();
+    ~FileSystemTypeCache();
+
+    std::unique_ptr<FileSystemTypeCachePrivate> const d;
+};
+
+}
+
+#endif // FILESYSTEMTYPECACHE_P_H
@@ -324,8 +324,13 @@ void ForwardingWorkerBasePrivate::connectJob(KIO::Job *job)
     // display it itself
     job->setUiDelegate(nullptr);
 
-    // Forward metadata (e.g. modification time for put())
-    job->setMetaData(q->allMetaData());
+    // Forward metadata (e.g. modification time for put()), except the data flow
+    // control and pipes: they apply to the data we send or read ourselves
+    MetaData metaData = q->allMetaData();
+    metaData.remove(QStringLiteral("flow-control-window"));
+    metaData.remove(QStringLiteral("data-pipe-in"));
+    metaData.remove(QStringLiteral("data-pipe-out"));
+    job->setMetaData(metaData);
 
     q->connect(job, &KJob::result, q, [this](KJob *job) {
         _k_slotResult(job);
@@ -0,0 +1,119 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "globmatcher_p.h"
+
+#include <algorithm>
+
+using namespace KIO;
+
+static bool hasWildcard(QStringView str)
+{
+    return std::any_of(str.cbegin(), str.cend(), [](QChar c) {
+        return c == QLatin1Char('*') || c == QLatin1Char('?') || c == QLatin1Char('[') || c == QLatin1Char('\\');
+    });
+}
+
+GlobMatcher::GlobMatcher()
+    : m_caseSensitivity(Qt::CaseInsensitive)
+{
+}
+
+GlobMatcher::GlobMatcher(const QStringList &patterns, Qt::CaseSensitivity caseSensitivity)
+    : m_caseSensitivity(caseSensitivity)
+{
+    QStringList regexPatterns;
+    for (const QString &pattern : patterns) {
+        if (pattern.isEmpty()) {
+            continue;
+        }
+        m_isEmpty = false;
+
+        const QStringView view(pattern);
+        if (pattern == QLatin1Char('*')) {
+            m_matchesAll = true;
+        } else if (!hasWildcard(view)) {
+            m_names.append(pattern);
+        } else if (view.startsWith(QLatin1String("*.")) && !hasWildcard(view.mid(2)) && !view.mid(2).contains(QLatin1Char('/'))) {
+            const QString extension = pattern.mid(2);
+            m_extensions.push_back(caseSensitivity == Qt::CaseInsensitive ? extension.toLower() : extension);
+        } else if (view.startsWith(QLatin1Char('*')) && !hasWildcard(view.mid(1))) {
+            m_suffixes.append(pattern.mid(1));
+        } else if (view.endsWith(QLatin1Char('*')) && !hasWildcard(view.chopped(1))) {
+            m_prefixes.append(pattern.chopped(1));
+        } else {
+            regexPatterns.append(QRegularExpression::wildcardToRegularExpression(pattern));
+        }
+    }
+
+    std::sort(m_extensions.begin(), m_extensions.end());
+    m_extensions.erase(std::unique(m_extensions.begin(), m_extensions.end()), m_extensions.end());
+
+    if (!regexPatterns.isEmpty()) {
+        // Each converted pattern is anchored already
+        m_regex.setPattern(regexPatterns.join(QLatin1Char('|')));
+        m_regex.setPatternOptions(caseSensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption);
+        m_regex.optimize();
+    }
+}
+
+bool GlobMatcher::isEmpty() const
+{
+    return m_isEmpty;
+}
+
+bool GlobMatcher::matchesExtension(const QString &name, qsizetype slashPos) const
+{
+    auto isExtension = [this](QStringView extension) {
+        if (m_caseSensitivity == Qt::CaseInsensitive) {
+            // Extensions are short, a lowercase copy is cheap
+            return std::binary_search(m_extensions.cbegin(), m_extensions.cend(), extension.toString().toLower());
+        }
+        return std::binary_search(m_extensions.cbegin(), m_extensions.cend(), extension, [](QStringView lhs, QStringView rhs) {
+            return lhs < rhs;
+        });
+    };
+
+    // Try "gz" and "tar.gz" for "foo.tar.gz". Like with the regular expression, '*' doesn't match a '/'
+    for (qsizetype dotPos = name.indexOf(QLatin1Char('.'), slashPos + 1); dotPos != -1; dotPos = name.indexOf(QLatin1Char('.'), dotPos + 1)) {
+        if (isExtension(QStringView(name).mid(dotPos + 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GlobMatcher::matches(const QString &name) const
+{
+    if (m_matchesAll) {
+        return true;
+    }
+
+    for (const QString &exactName : m_names) {
+        if (name.compare(exactName, m_caseSensitivity) == 0) {
+            return true;
+        }
+    }
+
+    const qsizetype slashPos = name.lastIndexOf(QLatin1Char('/'));
+    if (!m_extensions.empty() && matchesExtension(name, slashPos)) {
+        return true;
+    }
+    for (const QString &suffix : m_suffixes) {
+        // The suffix can have a '/' itself, only the part matched by '*' can't
+        if (name.endsWith(suffix, m_caseSensitivity) && !QStringView(name).first(name.size() - suffix.size()).contains(QLatin1Char('/'))) {
+            return true;
+        }
+    }
+    for (const QString &prefix : m_prefixes) {
+        if (name.startsWith(prefix, m_caseSensitivity) && slashPos < prefix.size()) {
+            return true;
+        }
+    }
+
+    return !m_regex.pattern().isEmpty() && m_regex.match(name).hasMatch();
+}
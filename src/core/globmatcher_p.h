@@ -0,0 +1,58 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef GLOBMATCHER_P_H
+#define GLOBMATCHER_P_H
+
+#include <kiocore_export.h>
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <vector>
+
+namespace KIO
+{
+/**
+ * @internal
+ * Matches names against a set of wildcard patterns such as "*.png", "README*" or "image/*",
+ * with the semantics of QRegularExpression::wildcardToRegularExpression().
+ *
+ * The patterns are compiled once: "*.ext" patterns go into a sorted list of extensions,
+ * "abc*", "*abc" and "abc" into prefix, suffix and exact checks. Only the remaining patterns
+ * (with '?', '[' or several '*') go through a single regular expression.
+ *
+ * Exported for KIOFileWidgets and the unit test.
+ */
+class KIOCORE_EXPORT GlobMatcher
+{
+public:
+    GlobMatcher();
+    explicit GlobMatcher(const QStringList &patterns, Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive);
+
+    // Whether there are no patterns at all, in which case nothing matches
+    bool isEmpty() const;
+
+    // Whether @p name matches any of the patterns
+    bool matches(const QString &name) const;
+
+private:
+    bool matchesExtension(const QString &name, qsizetype slashPos) const;
+
+    Qt::CaseSensitivity m_caseSensitivity;
+    bool m_isEmpty = true;
+    bool m_matchesAll = false;
+    std::vector<QString> m_extensions; // sorted, without the dot, lowercase if case insensitive
+    QStringList m_prefixes;
+    QStringList m_suffixes;
+    QStringList m_names;
+    QRegularExpression m_regex; // the other patterns, if any
+};
+
+}
+
+#endif // GLOBMATCHER_P_H
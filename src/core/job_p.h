@@ -280,6 +280,9 @@ public:
     bool m_closedBeforeStart;
     QPointer<QIODevice> m_outgoingDataSource;
     QMetaObject::Connection m_readChannelFinishedConnection;
+    qint64 m_flowControlWindow = 0;
+    qint64 m_unsentCredit = 0; // acknowledged data we didn't tell the worker about yet
+    bool m_manualDataAcknowledgement = false;
 
     /**
      * Flow control. Suspend data processing from the worker.
@@ -289,6 +292,10 @@ public:
      * Flow control. Resume data processing from the worker.
      */
     void internalResume();
+    /**
+     * Flow control. Lets the worker send @p bytes more data.
+     */
+    void grantCredit(qint64 bytes);
     /**
      * @internal
      * Called by the scheduler when a worker gets to
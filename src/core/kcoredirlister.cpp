@@ -13,23 +13,29 @@
 #include "kcoredirlister_p.h"
 
 #include "../utils_p.h"
+#include "dirlistingchanges_p.h"
 #include "kiocoredebug.h"
 #include "kmountpoint.h"
 #include "kprotocolmanager.h"
+#include "mimetypecache_p.h"
 #include <kio/listjob.h>
 
 #include <KJobUiDelegate>
 #include <KLocalizedString>
 
 #include <QDir>
+#include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QMimeDatabase>
-#include <QRegularExpression>
 #include <QTextStream>
 #include <QThreadStorage>
+#include <QtConcurrentRun>
 
+#include <algorithm>
 #include <list>
+#include <vector>
 
 #include <QLoggingCategory>
 Q_DECLARE_LOGGING_CATEGORY(KIO_CORE_DIRLISTER)
@@ -45,6 +51,17 @@ Q_LOGGING_CATEGORY(KIO_CORE_DIRLISTER, "kf.kio.core.dirlister", QtWarningMsg)
 
 QThreadStorage<KCoreDirListerCache> s_kDirListerCache;
 
+// The details requested from the workers when listing. The device IDs let
+// KFileItem::isSlow() find the file system type of the items by device.
+static KIO::StatDetails listingDetails(bool requestMimeType)
+{
+    KIO::StatDetails details = KIO::StatDefaultDetails | KIO::StatInode;
+    if (requestMimeType) {
+        details |= KIO::StatMimeType;
+    }
+    return details;
+}
+
 KCoreDirListerCache::KCoreDirListerCache()
     : itemsCached(10)
     , // keep the last 10 directories around
@@ -55,6 +72,10 @@ KCoreDirListerCache::KCoreDirListerCache()
     connect(&pendingUpdateTimer, &QTimer::timeout, this, &KCoreDirListerCache::processPendingUpdates);
     pendingUpdateTimer.setSingleShot(true);
 
+    connect(&diskCacheSaveTimer, &QTimer::timeout, this, &KCoreDirListerCache::processPendingDiskCacheSaves);
+    diskCacheSaveTimer.setSingleShot(true);
+    diskCacheSaveTimer.setInterval(2000);
+
     connect(KDirWatch::self(), &KDirWatch::dirty, this, &KCoreDirListerCache::slotFileDirty);
     connect(KDirWatch::self(), &KDirWatch::created, this, &KCoreDirListerCache::slotFileCreated);
     connect(KDirWatch::self(), &KDirWatch::deleted, this, &KCoreDirListerCache::slotFileDeleted);
@@ -62,9 +83,12 @@ KCoreDirListerCache::KCoreDirListerCache()
 #ifndef KIO_ANDROID_STUB
     kdirnotify = new org::kde::KDirNotify(QString(), QString(), QDBusConnection::sessionBus(), this);
     connect(kdirnotify, &org::kde::KDirNotify::FileRenamedWithLocalPath, this, &KCoreDirListerCache::slotFileRenamed);
+    connect(kdirnotify, &org::kde::KDirNotify::FilesRenamed, this, &KCoreDirListerCache::slotFilesRenamed);
     connect(kdirnotify, &org::kde::KDirNotify::FilesAdded, this, &KCoreDirListerCache::slotFilesAdded);
     connect(kdirnotify, &org::kde::KDirNotify::FilesChanged, this, &KCoreDirListerCache::slotFilesChanged);
     connect(kdirnotify, &org::kde::KDirNotify::FilesRemoved, this, qOverload<const QStringList &>(&KCoreDirListerCache::slotFilesRemoved));
+    // The listed items get their MIME types from there
+    KIO::MimeTypeCache::instance()->followKDirNotify();
 #endif
 }
 
@@ -72,6 +96,8 @@ KCoreDirListerCache::~KCoreDirListerCache()
 {
     qCDebug(KIO_CORE_DIRLISTER);
 
+    processPendingDiskCacheSaves();
+
     qDeleteAll(itemsInUse);
     itemsInUse.clear();
 
@@ -196,18 +222,14 @@ bool KCoreDirListerCache::listDir(KCoreDirLister *lister, const QUrl &dirUrl, bo
                 itemU->incAutoUpdate();
             }
 
-            KIO::ListJob *job = KIO::listDir(_url, KIO::HideProgressInfo);
-            if (lister->requestMimeTypeWhileListing()) {
-                job->addMetaData(QStringLiteral("details"), QString::number(KIO::StatDefaultDetails | KIO::StatMimeType));
+            if (!_reload && diskListingCache.isEnabledFor(_url)) {
+                Q_EMIT lister->started(_url);
+                // The ListJob is only started if there is no usable listing on disk
+                loadFromDiskCache(_url);
+                return true;
             }
-            runningListJobs.insert(job, KIO::UDSEntryList());
-
-            lister->jobStarted(job);
-            lister->d->connectJob(job);
 
-            connect(job, &KIO::ListJob::entries, this, &KCoreDirListerCache::slotEntries);
-            connect(job, &KJob::result, this, &KCoreDirListerCache::slotResult);
-            connect(job, &KIO::ListJob::redirection, this, &KCoreDirListerCache::slotRedirection);
+            startListJob(_url);
 
             Q_EMIT lister->started(_url);
 
@@ -230,6 +252,11 @@ bool KCoreDirListerCache::listDir(KCoreDirLister *lister, const QUrl &dirUrl, bo
             itemU->incAutoUpdate();
         }
 
+        if (runningDiskCacheLoads.find(_url) != runningDiskCacheLoads.cend()) {
+            // The items are emitted to all the listers once read
+            return true;
+        }
+
         KIO::ListJob *job = jobForUrl(_url);
         // job will be 0 if we were listing from cache rather than listing from a kio job.
         if (job) {
@@ -403,7 +430,21 @@ void KCoreDirListerCache::stopListingUrl(KCoreDirLister *lister, const QUrl &_u,
     KCoreDirListerCacheDirectoryData &dirData = dirit.value();
     if (dirData.listersCurrentlyListing.contains(lister)) {
         qCDebug(KIO_CORE_DIRLISTER) << " found lister" << lister << "in list - for" << url;
-        if (dirData.listersCurrentlyListing.count() == 1) {
+        if (runningDiskCacheLoads.find(url) != runningDiskCacheLoads.cend()) {
+            // Like for a killed ListJob, the lister keeps holding the (incomplete) directory
+            if (dirData.listersCurrentlyListing.count() == 1) {
+                runningDiskCacheLoads.erase(url);
+            }
+            dirData.listersCurrentlyListing.removeAll(lister);
+            dirData.listersCurrentlyHolding.append(lister);
+            if (lister->d->numJobs() == 0) {
+                lister->d->complete = true;
+            }
+            if (!silent) {
+                Q_EMIT lister->canceled();
+                Q_EMIT lister->listingDirCanceled(url);
+            }
+        } else if (dirData.listersCurrentlyListing.count() == 1) {
             // This was the only dirlister interested in the list job -> kill the job
             stopListJob(url, silent);
         } else {
@@ -583,6 +624,8 @@ void KCoreDirListerCache::forgetDirs(KCoreDirLister *lister, const QUrl &_url, b
 
     // Inserting into QCache must be done last, since it might delete the item
     if (item && insertIntoCache) {
+        // Includes the changes notified by KDirNotify since the last listing
+        saveToDiskCache(item);
         qCDebug(KIO_CORE_DIRLISTER) << lister << "item moved into cache:" << url;
         itemsCached.insert(url, item);
     }
@@ -662,9 +705,7 @@ void KCoreDirListerCache::updateDirectory(const QUrl &_dir)
         return lister->requestMimeTypeWhileListing();
     });
 
-    if (requestFromListers || requestFromholders) {
-        job->addMetaData(QStringLiteral("details"), QString::number(KIO::StatDefaultDetails | KIO::StatMimeType));
-    }
+    job->addMetaData(QStringLiteral("details"), QString::number(listingDetails(requestFromListers || requestFromholders)));
 
     connect(job, &KIO::ListJob::entries, this, &KCoreDirListerCache::slotUpdateEntries);
     connect(job, &KJob::result, this, &KCoreDirListerCache::slotUpdateResult);
@@ -804,6 +845,10 @@ void KCoreDirListerCache::slotFilesRemoved(const QStringList &fileList) // from
 void KCoreDirListerCache::slotFilesRemoved(const QList<QUrl> &fileList)
 {
     qCDebug(KIO_CORE_DIRLISTER) << fileList.count();
+    // The snapshots still have the removed items, write them first so that they get merged
+    processPendingDiskCacheSaves();
+    diskListingCache.removeItems(fileList);
+
     // Group notifications by parent dirs (usually there would be only one parent dir)
     QMap<QUrl, KFileItemList> removedItemsByDir;
     QList<QUrl> deletedSubdirs;
@@ -897,6 +942,8 @@ void KCoreDirListerCache::slotFileRenamed(const QString &_src, const QString &_d
     QUrl src(_src);
     QUrl dst(_dst);
     qCDebug(KIO_CORE_DIRLISTER) << src << "->" << dst;
+    processPendingDiskCacheSaves();
+    diskListingCache.renameItem(src, dst);
 #ifdef DEBUG_CACHE
     printDebug();
 #endif
@@ -968,6 +1015,14 @@ void KCoreDirListerCache::slotFileRenamed(const QString &_src, const QString &_d
 #endif
 }
 
+void KCoreDirListerCache::slotFilesRenamed(const QStringList &srcUrls, const QStringList &dstUrls) // from KDirNotify signals
+{
+    const qsizetype count = std::min(srcUrls.size(), dstUrls.size());
+    for (qsizetype i = 0; i < count; ++i) {
+        slotFileRenamed(srcUrls.at(i), dstUrls.at(i), QString());
+    }
+}
+
 std::set<KCoreDirLister *> KCoreDirListerCache::emitRefreshItem(const KFileItem &oldItem, const KFileItem &fileitem)
 {
     qCDebug(KIO_CORE_DIRLISTER) << "old:" << oldItem.name() << oldItem.url() << "new:" << fileitem.name() << fileitem.url();
@@ -1065,10 +1120,22 @@ void KCoreDirListerCache::slotFileDirty(const QString &path)
 // Called by slotFileDirty
 void KCoreDirListerCache::handleDirDirty(const QUrl &url)
 {
+    const QString dir = url.toLocalFile();
+
+    if (hasFileEvents(url)) {
+        // The changed files come as separate events, only make sure that nothing was missed
+        if (checkUpdate(url)) {
+            const auto [it, isInserted] = pendingDirectoryChecks.insert(dir);
+            if (isInserted && !pendingUpdateTimer.isActive()) {
+                pendingUpdateTimer.start(200);
+            }
+        }
+        return;
+    }
+
     // A dir: launch an update job if anyone cares about it
 
     // This also means we can forget about pending updates to individual files in that dir
-    const QString dir = url.toLocalFile();
     const QString dirPath = Utils::slashAppended(dir);
 
     for (auto pendingIt = pendingUpdates.cbegin(); pendingIt != pendingUpdates.cend(); /* */) {
@@ -1096,8 +1163,9 @@ void KCoreDirListerCache::handleFileDirty(const QUrl &url)
     // A file: do we know about it already?
     const KFileItem &existingItem = findByUrl(nullptr, url);
     const QUrl dir = url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
-    if (existingItem.isNull()) {
+    if (existingItem.isNull() && !hasFileEvents(dir)) {
         // No - update the parent dir then
+        // (otherwise processPendingUpdates() adds the item for that file alone)
         handleDirDirty(dir);
     }
 
@@ -1114,10 +1182,20 @@ void KCoreDirListerCache::handleFileDirty(const QUrl &url)
 void KCoreDirListerCache::slotFileCreated(const QString &path) // from KDirWatch
 {
     qCDebug(KIO_CORE_DIRLISTER) << path;
-    // XXX: how to avoid a complete rescan here?
-    // We'd need to stat that one file separately and refresh the item(s) for it.
-    QUrl fileUrl(QUrl::fromLocalFile(path));
-    itemsAddedInDirectory(fileUrl.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash));
+    const QUrl fileUrl = QUrl::fromLocalFile(path).adjusted(QUrl::StripTrailingSlash);
+    const QUrl dirUrl = fileUrl.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    const QList<QUrl> urls = directoriesForCanonicalPath(dirUrl);
+    if (urls.isEmpty() || !hasFileEvents(urls.first())) {
+        // We don't get events for the files in that directory, list it again
+        itemsAddedInDirectory(dirUrl);
+        return;
+    }
+    // Stat that one file and add the item for it, see processPendingUpdates()
+    for (const QUrl &dir : urls) {
+        QUrl aliasUrl(dir);
+        aliasUrl.setPath(Utils::concatPaths(aliasUrl.path(), fileUrl.fileName()));
+        handleFileDirty(aliasUrl);
+    }
 }
 
 void KCoreDirListerCache::slotFileDeleted(const QString &path) // from KDirWatch
@@ -1309,6 +1387,7 @@ void KCoreDirListerCache::slotResult(KJob *j)
         DirItem *dir = itemsInUse.value(jobUrl);
         Q_ASSERT(dir);
         dir->complete = true;
+        saveToDiskCache(dir);
 
         for (KCoreDirLister *kdl : listers) {
             kdl->d->jobDone(job);
@@ -1724,90 +1803,103 @@ void KCoreDirListerCache::slotUpdateResult(KJob *j)
         delayedMimeTypes &= kdl->d->delayedMimeTypes;
     }
 
-    typedef QHash<QString, KFileItem> FileItemHash; // fileName -> KFileItem
-    FileItemHash fileItems;
+    const KIO::UDSEntryList &buf = runningListJobs.value(job);
+    const KIO::DirListingChanges changes = KIO::compareDirListing(dir->lstItems, buf, pendingRemoteUpdates);
+
+    // if the update was started before finishing the original listing
+    // there is no root item yet
+    if (changes.dotEntry != -1 && dir->rootItem.isNull()) {
+        dir->rootItem = KFileItem(buf.at(changes.dotEntry), jobUrl, delayedMimeTypes, true);
 
-    // Fill the hash from the old list of items. We'll remove entries as we see them
-    // in the new listing, and the resulting hash entries will be the deleted items.
-    for (const KFileItem &item : std::as_const(dir->lstItems)) {
-        fileItems.insert(item.name(), item);
+        for (KCoreDirLister *kdl : listers) {
+            if (kdl->d->rootFileItem.isNull() && kdl->d->url == jobUrl) {
+                kdl->d->rootFileItem = dir->rootItem;
+            }
+        }
     }
 
     CacheHiddenFile *cachedHidden = nullptr;
     bool dotHiddenChecked = false;
-    const KIO::UDSEntryList &buf = runningListJobs.value(job);
-    KFileItemList newItems;
-    for (const auto &entry : buf) {
+    auto createItem = [&](const KIO::UDSEntry &entry) {
         // Form the complete url
         KFileItem item(entry, jobUrl, delayedMimeTypes, true);
 
-        const QString name = item.name();
-        Q_ASSERT(!name.isEmpty()); // A KIO worker setting an empty UDS_NAME is utterly broken, fix the KIO worker!
-
-        // we duplicate the check for dotdot here, to avoid iterating over
-        // all items again and checking in matchesFilter() that way.
-        if (name.isEmpty() || name == QLatin1String("..")) {
-            continue;
-        }
-
-        if (name == QLatin1Char('.')) {
-            // if the update was started before finishing the original listing
-            // there is no root item yet
-            if (dir->rootItem.isNull()) {
-                dir->rootItem = item;
-
-                for (KCoreDirLister *kdl : listers) {
-                    if (kdl->d->rootFileItem.isNull() && kdl->d->url == jobUrl) {
-                        kdl->d->rootFileItem = dir->rootItem;
-                    }
-                }
-            }
-            continue;
-        } else {
-            // get the names of the files listed in ".hidden", if it exists and is a local file
-            if (!dotHiddenChecked) {
-                const QString localPath = item.localPath();
-                if (!localPath.isEmpty()) {
-                    const QString rootItemPath = QFileInfo(localPath).absolutePath();
-                    cachedHidden = cachedDotHiddenForDir(rootItemPath);
-                }
-                dotHiddenChecked = true;
+        // get the names of the files listed in ".hidden", if it exists and is a local file
+        if (!dotHiddenChecked) {
+            const QString localPath = item.localPath();
+            if (!localPath.isEmpty()) {
+                const QString rootItemPath = QFileInfo(localPath).absolutePath();
+                cachedHidden = cachedDotHiddenForDir(rootItemPath);
             }
+            dotHiddenChecked = true;
         }
 
         // hide file if listed in ".hidden"
-        if (cachedHidden && cachedHidden->listedFiles.find(name) != cachedHidden->listedFiles.cend()) {
+        if (cachedHidden && cachedHidden->listedFiles.find(item.name()) != cachedHidden->listedFiles.cend()) {
             item.setHidden();
         }
+        return item;
+    };
 
-        // Find this item
-        FileItemHash::iterator fiit = fileItems.find(item.name());
-        if (fiit != fileItems.end()) {
-            const KFileItem tmp = fiit.value();
-            auto pru_it = pendingRemoteUpdates.find(tmp);
-            const bool inPendingRemoteUpdates = pru_it != pendingRemoteUpdates.end();
-
-            // check if something changed for this file, using KFileItem::cmp()
-            if (!tmp.cmp(item) || inPendingRemoteUpdates) {
-                if (inPendingRemoteUpdates) {
-                    pendingRemoteUpdates.erase(pru_it);
-                }
+    KFileItemList newItems;
+    newItems.reserve(changes.newEntries.size());
+    for (qsizetype entryIndex : changes.newEntries) {
+        newItems.append(createItem(buf.at(entryIndex)));
+        qCDebug(KIO_CORE_DIRLISTER) << "new file:" << newItems.constLast().name();
+    }
+
+    std::vector<std::pair<KFileItem, QUrl>> movedItems;
+    for (const auto &[itemIndex, entryIndex] : changes.changedItems) {
+        const KFileItem tmp = dir->lstItems.at(itemIndex);
+        auto pru_it = pendingRemoteUpdates.find(tmp);
+        const bool inPendingRemoteUpdates = pru_it != pendingRemoteUpdates.end();
+
+        // check if something changed for this file, using KFileItem::cmp()
+        const KFileItem item = createItem(buf.at(entryIndex));
+        if (!tmp.cmp(item) || inPendingRemoteUpdates) {
+            if (inPendingRemoteUpdates) {
+                pendingRemoteUpdates.erase(pru_it);
+            }
 
-                qCDebug(KIO_CORE_DIRLISTER) << "file changed:" << tmp.name();
+            qCDebug(KIO_CORE_DIRLISTER) << "file changed:" << tmp.name();
 
-                reinsert(item, tmp.url());
-                for (KCoreDirLister *kdl : listers) {
-                    kdl->d->addRefreshItem(jobUrl, tmp, item);
-                }
+            if (item.url() == tmp.url()) {
+                // Same position in the sorted list
+                dir->lstItems[itemIndex] = item;
+            } else {
+                // Keep the indexes valid until all the entries were matched
+                movedItems.emplace_back(item, tmp.url());
+            }
+            for (KCoreDirLister *kdl : listers) {
+                kdl->d->addRefreshItem(jobUrl, tmp, item);
             }
-            // Seen, remove
-            fileItems.erase(fiit);
-        } else { // this is a new file
-            qCDebug(KIO_CORE_DIRLISTER) << "new file:" << name;
-            newItems.append(item);
         }
     }
 
+    KFileItemList deletedItems;
+    deletedItems.reserve(changes.deletedItems.size());
+    for (qsizetype itemIndex : changes.deletedItems) {
+        deletedItems.append(dir->lstItems.at(itemIndex));
+    }
+
+    // Remove the deleted items in one pass
+    if (!changes.deletedItems.empty()) {
+        qsizetype index = 0;
+        auto deletedIt = changes.deletedItems.cbegin();
+        auto it = std::remove_if(dir->lstItems.begin(), dir->lstItems.end(), [&](const KFileItem &) {
+            const bool deleted = deletedIt != changes.deletedItems.cend() && *deletedIt == index;
+            if (deleted) {
+                ++deletedIt;
+            }
+            ++index;
+            return deleted;
+        });
+        dir->lstItems.erase(it, dir->lstItems.end());
+    }
+    for (const auto &[item, oldUrl] : movedItems) {
+        reinsert(item, oldUrl);
+    }
+
     // sort by url using KFileItem::operator<
     std::sort(newItems.begin(), newItems.end());
 
@@ -1820,10 +1912,15 @@ void KCoreDirListerCache::slotUpdateResult(KJob *j)
 
     runningListJobs.remove(job);
 
-    if (!fileItems.isEmpty()) {
-        deleteUnmarkedItems(listers, dir->lstItems, fileItems);
+    if (!deletedItems.isEmpty()) {
+        for (const KFileItem &item : std::as_const(deletedItems)) {
+            qCDebug(KIO_CORE_DIRLISTER) << "deleted:" << item.name() << item;
+        }
+        itemsDeleted(listers, deletedItems);
     }
 
+    saveToDiskCache(dir);
+
     for (KCoreDirLister *kdl : listers) {
         kdl->d->emitItems();
 
@@ -1844,6 +1941,78 @@ void KCoreDirListerCache::slotUpdateResult(KJob *j)
     }
 }
 
+KIO::DirListingChanges KIO::compareDirListing(const QList<KFileItem> &items, const KIO::UDSEntryList &entries, const std::set<KFileItem> &pendingUpdates)
+{
+    DirListingChanges changes;
+
+    using NameAndIndex = std::pair<QString, qsizetype>;
+    std::vector<NameAndIndex> oldNames;
+    oldNames.reserve(items.size());
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        oldNames.emplace_back(items.at(i).name(), i);
+    }
+    std::sort(oldNames.begin(), oldNames.end());
+
+    std::vector<NameAndIndex> newNames;
+    newNames.reserve(entries.size());
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        const QString name = entries.at(i).stringValue(KIO::UDSEntry::UDS_NAME);
+        Q_ASSERT(!name.isEmpty()); // A KIO worker setting an empty UDS_NAME is utterly broken, fix the KIO worker!
+
+        if (name.isEmpty() || name == QLatin1String("..")) {
+            continue;
+        }
+        if (name == QLatin1Char('.')) {
+            changes.dotEntry = i;
+            continue;
+        }
+        newNames.emplace_back(name, i);
+    }
+    std::sort(newNames.begin(), newNames.end());
+
+    auto findName = [](const std::vector<NameAndIndex> &names, const QString &name) {
+        auto it = std::lower_bound(names.cbegin(), names.cend(), name, [](const NameAndIndex &nameAndIndex, const QString &name) {
+            return nameAndIndex.first < name;
+        });
+        return (it != names.cend() && it->first == name) ? it->second : -1;
+    };
+
+    // The items hidden by the ".hidden" file might change along with it,
+    // compare all the items then
+    const QString dotHidden = QStringLiteral(".hidden");
+    const qsizetype oldDotHidden = findName(oldNames, dotHidden);
+    const qsizetype newDotHidden = findName(newNames, dotHidden);
+    const bool dotHiddenChanged =
+        (oldDotHidden == -1) != (newDotHidden == -1) || (newDotHidden != -1 && !(items.at(oldDotHidden).entry() == entries.at(newDotHidden)));
+
+    auto oldIt = oldNames.cbegin();
+    const auto oldEnd = oldNames.cend();
+    for (const auto &[name, entryIndex] : newNames) {
+        while (oldIt != oldEnd && oldIt->first < name) {
+            changes.deletedItems.push_back(oldIt->second);
+            ++oldIt;
+        }
+        if (oldIt == oldEnd || oldIt->first != name) { // this is a new file
+            changes.newEntries.push_back(entryIndex);
+            continue;
+        }
+
+        const qsizetype itemIndex = oldIt->second;
+        ++oldIt;
+        // The common case: nothing changed since the last listing
+        const KFileItem &item = items.at(itemIndex);
+        if (!dotHiddenChanged && item.entry() == entries.at(entryIndex) && pendingUpdates.find(item) == pendingUpdates.cend()) {
+            continue;
+        }
+        changes.changedItems.emplace_back(itemIndex, entryIndex);
+    }
+    for (; oldIt != oldEnd; ++oldIt) {
+        changes.deletedItems.push_back(oldIt->second);
+    }
+    std::sort(changes.deletedItems.begin(), changes.deletedItems.end());
+    return changes;
+}
+
 // private
 
 KIO::ListJob *KCoreDirListerCache::jobForUrl(const QUrl &url, KIO::ListJob *not_job)
@@ -1875,28 +2044,6 @@ void KCoreDirListerCache::killJob(KIO::ListJob *job)
     job->kill();
 }
 
-void KCoreDirListerCache::deleteUnmarkedItems(const QList<KCoreDirLister *> &listers,
-                                              QList<KFileItem> &lstItems,
-                                              const QHash<QString, KFileItem> &itemsToDelete)
-{
-    // Make list of deleted items (for emitting)
-    KFileItemList deletedItems;
-    deletedItems.reserve(itemsToDelete.size());
-    for (auto kit = itemsToDelete.cbegin(), endIt = itemsToDelete.cend(); kit != endIt; ++kit) {
-        const KFileItem item = kit.value();
-        deletedItems.append(item);
-        qCDebug(KIO_CORE_DIRLISTER) << "deleted:" << item.name() << item;
-    }
-
-    // Delete all remaining items
-    auto it = std::remove_if(lstItems.begin(), lstItems.end(), [&itemsToDelete](const KFileItem &item) {
-        return itemsToDelete.contains(item.name());
-    });
-    lstItems.erase(it, lstItems.end());
-
-    itemsDeleted(listers, deletedItems);
-}
-
 void KCoreDirListerCache::itemsDeleted(const QList<KCoreDirLister *> &listers, const KFileItemList &deletedItems)
 {
     for (KCoreDirLister *kdl : listers) {
@@ -1979,10 +2126,216 @@ void KCoreDirListerCache::deleteDir(const QUrl &_dirUrl)
     removeDirFromCache(dirUrl);
 }
 
+bool KCoreDirListerCache::hasFileEvents(const QUrl &url) const
+{
+    const DirItem *dirItem = dirItemForUrl(url);
+    return dirItem && dirItem->watchesFiles && dirItem->autoUpdates > 0;
+}
+
+std::set<KCoreDirLister *> KCoreDirListerCache::addCreatedItem(const QUrl &url)
+{
+    const QUrl dirUrl = url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    DirItem *dirItem = itemsInUse.value(dirUrl);
+    if (!dirItem || !dirItem->complete) {
+        return {};
+    }
+
+    const QList<KCoreDirLister *> listers = directoryData.value(dirUrl).listersCurrentlyHolding;
+    bool delayedMimeTypes = true;
+    for (const KCoreDirLister *kdl : listers) {
+        delayedMimeTypes &= kdl->d->delayedMimeTypes;
+    }
+
+    KFileItem item(url);
+    if (item.entry().count() == 0) {
+        return {}; // already gone
+    }
+    item.setDelayedMimeTypes(delayedMimeTypes);
+    if (CacheHiddenFile *cachedHidden = cachedDotHiddenForDir(dirUrl.toLocalFile())) {
+        if (cachedHidden->listedFiles.find(item.name()) != cachedHidden->listedFiles.cend()) {
+            item.setHidden();
+        }
+    }
+
+    qCDebug(KIO_CORE_DIRLISTER) << "new file:" << url;
+    dirItem->insert(item);
+    for (KCoreDirLister *kdl : listers) {
+        kdl->d->addNewItem(dirUrl, item);
+    }
+    return {listers.cbegin(), listers.cend()};
+}
+
+KCoreDirListerCache::DiskSummary KCoreDirListerCache::readDiskSummary(const QString &path)
+{
+    // QDirIterator gets the names and types from readdir(), without stat'ing the files
+    DiskSummary summary;
+    QDirIterator it(path, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        ++summary.count;
+        const QFileInfo info = it.fileInfo();
+        if (!info.isSymLink() && info.isDir()) {
+            summary.subdirectories.append(it.fileName());
+        }
+    }
+    return summary;
+}
+
+bool KCoreDirListerCache::isInSyncWithDisk(const DirItem *dir, const DiskSummary &summary) const
+{
+    if (summary.count != dir->lstItems.count()) {
+        return false;
+    }
+    for (const QString &name : summary.subdirectories) {
+        QUrl url(dir->url);
+        url.setPath(Utils::concatPaths(url.path(), name));
+        auto itemIt = std::lower_bound(dir->lstItems.cbegin(), dir->lstItems.cend(), url);
+        if (itemIt == dir->lstItems.cend() || itemIt->url() != url || !itemIt->isDir()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KCoreDirListerCache::checkDirectory(const QString &dir)
+{
+    if (runningDirectoryChecks.find(dir) != runningDirectoryChecks.cend()) {
+        // The running check may have read the directory before the latest change
+        directoriesToCheckAgain.insert(dir);
+        return;
+    }
+    runningDirectoryChecks.insert(dir);
+
+    // Reading a large directory takes a while, don't block the GUI thread
+    auto *watcher = new QFutureWatcher<DiskSummary>(this);
+    connect(watcher, &QFutureWatcher<DiskSummary>::finished, this, [this, watcher, dir]() {
+        watcher->deleteLater();
+        runningDirectoryChecks.erase(dir);
+        if (directoriesToCheckAgain.erase(dir)) {
+            checkDirectory(dir);
+            return;
+        }
+        const QUrl dirUrl = QUrl::fromLocalFile(dir);
+        const DirItem *dirItem = itemsInUse.value(dirUrl);
+        if (dirItem && dirItem->complete && !jobForUrl(dirUrl) && !isInSyncWithDisk(dirItem, watcher->result())) {
+            qCDebug(KIO_CORE_DIRLISTER) << "missed changes in" << dir;
+            updateDirectory(dirUrl);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&KCoreDirListerCache::readDiskSummary, dir));
+}
+
+void KCoreDirListerCache::startListJob(const QUrl &url)
+{
+    const QList<KCoreDirLister *> listers = directoryData.value(url).listersCurrentlyListing;
+    Q_ASSERT(!listers.isEmpty());
+
+    KIO::ListJob *job = KIO::listDir(url, KIO::HideProgressInfo);
+    job->addMetaData(QStringLiteral("details"), QString::number(listingDetails(listers.first()->requestMimeTypeWhileListing())));
+    runningListJobs.insert(job, KIO::UDSEntryList());
+
+    for (KCoreDirLister *kdl : listers) {
+        kdl->jobStarted(job);
+        kdl->d->connectJob(job);
+    }
+
+    connect(job, &KIO::ListJob::entries, this, &KCoreDirListerCache::slotEntries);
+    connect(job, &KJob::result, this, &KCoreDirListerCache::slotResult);
+    connect(job, &KIO::ListJob::redirection, this, &KCoreDirListerCache::slotRedirection);
+}
+
+void KCoreDirListerCache::loadFromDiskCache(const QUrl &url)
+{
+    runningDiskCacheLoads.insert(url);
+
+    // A listing can hold many thousands of entries, don't deserialize them in the GUI thread
+    auto *watcher = new QFutureWatcher<DiskCacheListing>(this);
+    connect(watcher, &QFutureWatcher<DiskCacheListing>::finished, this, [this, watcher, url]() {
+        watcher->deleteLater();
+        // Not there anymore if the listers stopped listing meanwhile
+        if (runningDiskCacheLoads.erase(url) == 0) {
+            return;
+        }
+        DirItem *dir = itemsInUse.value(url);
+        const QList<KCoreDirLister *> listers = directoryData.value(url).listersCurrentlyListing;
+        if (!dir || listers.isEmpty()) {
+            return;
+        }
+
+        const DiskCacheListing listing = watcher->result();
+        if (!listing.found) {
+            startListJob(url);
+            return;
+        }
+        qCDebug(KIO_CORE_DIRLISTER) << "Entry in disk cache:" << url;
+
+        bool delayedMimeTypes = true;
+        for (const KCoreDirLister *kdl : listers) {
+            delayedMimeTypes &= kdl->d->delayedMimeTypes;
+        }
+
+        // Like in slotEntries, prefer the item from the parent directory listing
+        dir->rootItem = itemForUrl(url);
+        if (dir->rootItem.isNull() && listing.rootEntry.count() > 0) {
+            dir->rootItem = KFileItem(listing.rootEntry, url, delayedMimeTypes, false);
+        }
+
+        KFileItemList items;
+        items.reserve(listing.entries.size());
+        for (const KIO::UDSEntry &entry : listing.entries) {
+            items.append(KFileItem(entry, url, delayedMimeTypes, true));
+        }
+        std::sort(items.begin(), items.end());
+        dir->insertSortedItems(items);
+
+        // Show the last known contents, the directory is then updated
+        // by emitItemsFromCache since it isn't complete
+        for (KCoreDirLister *kdl : listers) {
+            new KCoreDirListerPrivate::CachedItemsJob(kdl, url, false);
+        }
+    });
+    // A copy, which only holds the settings, in case this cache is destroyed meanwhile
+    watcher->setFuture(QtConcurrent::run([cache = diskListingCache, url]() {
+        DiskCacheListing listing;
+        listing.found = cache.load(url, listing.rootEntry, listing.entries);
+        return listing;
+    }));
+}
+
+void KCoreDirListerCache::saveToDiskCache(const DirItem *dir)
+{
+    if (!dir || !diskListingCache.isEnabledFor(dir->url)) {
+        return;
+    }
+
+    // Snapshot the entries now: the item can be evicted from itemsCached before the timer fires
+    PendingDiskCacheSave &save = pendingDiskCacheSaves[dir->url];
+    save.rootEntry = dir->rootItem.entry();
+    save.entries.clear();
+    save.entries.reserve(dir->lstItems.size());
+    for (const KFileItem &item : dir->lstItems) {
+        save.entries.append(item.entry());
+    }
+    // Not restarted, so that a directory which keeps changing is still saved
+    if (!diskCacheSaveTimer.isActive()) {
+        diskCacheSaveTimer.start();
+    }
+}
+
+void KCoreDirListerCache::processPendingDiskCacheSaves()
+{
+    diskCacheSaveTimer.stop();
+    for (const auto &[url, save] : pendingDiskCacheSaves) {
+        diskListingCache.save(url, save.rootEntry, save.entries);
+    }
+    pendingDiskCacheSaves.clear();
+}
+
 // delayed updating of files, FAM is flooding us with events
 void KCoreDirListerCache::processPendingUpdates()
 {
     std::set<KCoreDirLister *> listers;
+    std::set<QString> deferredUpdates;
     for (const QString &file : pendingUpdates) { // always a local path
         qCDebug(KIO_CORE_DIRLISTER) << file;
         QUrl u = QUrl::fromLocalFile(file);
@@ -1996,13 +2349,30 @@ void KCoreDirListerCache::processPendingUpdates()
                 reinsert(item, oldItem.url());
                 listers.merge(emitRefreshItem(oldItem, item));
             }
+        } else if (const QUrl dirUrl = u.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash); hasFileEvents(dirUrl)) {
+            // A new file, see handleFileDirty()
+            if (jobForUrl(dirUrl)) {
+                // The listing might have missed it, we are called again when it's done
+                deferredUpdates.insert(file);
+            } else {
+                listers.merge(addCreatedItem(u));
+            }
         }
     }
-    pendingUpdates.clear();
+    pendingUpdates = std::move(deferredUpdates);
     for (KCoreDirLister *kdl : listers) {
         kdl->d->emitItems();
     }
 
+    // Directories watched with file events: only list them again when we missed something
+    for (const QString &dir : pendingDirectoryChecks) {
+        const DirItem *dirItem = itemsInUse.value(QUrl::fromLocalFile(dir));
+        if (dirItem && dirItem->complete) {
+            checkDirectory(dir);
+        }
+    }
+    pendingDirectoryChecks.clear();
+
     // Directories in need of updating
     for (const QString &dir : pendingDirectoryUpdates) {
         updateDirectory(QUrl::fromLocalFile(dir));
@@ -2305,13 +2675,9 @@ void KCoreDirLister::setNameFilter(const QString &nameFilter)
 
     d->prepareForSettingsChange();
 
-    d->settings.lstFilters.clear();
     d->nameFilter = nameFilter;
     // Split on white space
-    const QStringList list = nameFilter.split(QLatin1Char(' '), Qt::SkipEmptyParts);
-    for (const QString &filter : list) {
-        d->settings.lstFilters.append(QRegularExpression(QRegularExpression::wildcardToRegularExpression(filter), QRegularExpression::CaseInsensitiveOption));
-    }
+    d->settings.nameFilters = KIO::GlobMatcher(nameFilter.split(QLatin1Char(' '), Qt::SkipEmptyParts));
 }
 
 QString KCoreDirLister::nameFilter() const
@@ -2357,9 +2723,7 @@ QStringList KCoreDirLister::mimeFilters() const
 
 bool KCoreDirListerPrivate::matchesFilter(const QString &name) const
 {
-    return std::any_of(settings.lstFilters.cbegin(), settings.lstFilters.cend(), [&name](const QRegularExpression &filter) {
-        return filter.match(name).hasMatch();
-    });
+    return settings.nameFilters.matches(name);
 }
 
 bool KCoreDirListerPrivate::matchesMimeFilter(const QString &mime) const
@@ -2381,7 +2745,7 @@ bool KCoreDirLister::matchesFilter(const KFileItem &item) const
         return false;
     }
 
-    if (item.isDir() || d->settings.lstFilters.isEmpty()) {
+    if (item.isDir() || d->settings.nameFilters.isEmpty()) {
         return true;
     }
 
@@ -8,6 +8,8 @@
 #ifndef KCOREDIRLISTER_P_H
 #define KCOREDIRLISTER_P_H
 
+#include "dirlistingcache_p.h"
+#include "globmatcher_p.h"
 #include "kfileitem.h"
 
 #ifndef KIO_ANDROID_STUB
@@ -26,9 +28,9 @@
 #include <KDirWatch>
 #include <kio/global.h>
 
+#include <map>
 #include <set>
 
-class QRegularExpression;
 class KCoreDirLister;
 namespace KIO
 {
@@ -122,7 +124,7 @@ public:
 
     QList<CachedItemsJob *> m_cachedItemsJobs;
 
-    QString nameFilter; // parsed into lstFilters
+    QString nameFilter; // parsed into nameFilters
 
     struct FilterSettings {
         FilterSettings()
@@ -132,7 +134,7 @@ public:
         }
         bool isShowingDotFiles;
         bool dirOnlyMode;
-        QList<QRegularExpression> lstFilters;
+        KIO::GlobMatcher nameFilters;
         QStringList mimeFilter;
         QStringList mimeExcludeFilter;
     };
@@ -217,6 +219,7 @@ public Q_SLOTS:
      */
     void slotFilesChanged(const QStringList &fileList);
     void slotFileRenamed(const QString &srcUrl, const QString &dstUrl, const QString &dstPath);
+    void slotFilesRenamed(const QStringList &srcUrls, const QStringList &dstUrls);
 
 private Q_SLOTS:
     void slotFileDirty(const QString &_file);
@@ -253,17 +256,45 @@ private:
     void handleFileDirty(const QUrl &url);
     void handleDirDirty(const QUrl &url);
 
-    // when there were items deleted from the filesystem all the listers holding
-    // the parent directory need to be notified, the items have to be deleted
-    // and removed from the cache including all the children.
-    void deleteUnmarkedItems(const QList<KCoreDirLister *> &, QList<KFileItem> &lstItems, const QHash<QString, KFileItem> &itemsToDelete);
+    // Returns true if @p url is a directory whose file changes are reported by KDirWatch
+    bool hasFileEvents(const QUrl &url) const;
 
-    // Helper method called when we know that a list of items was deleted
+    // Adds the item for the new local file @p url to its directory, and emits it
+    std::set<KCoreDirLister *> addCreatedItem(const QUrl &url);
+
+    // The entries of a directory on disk, as far as isInSyncWithDisk() is concerned
+    struct DiskSummary {
+        qsizetype count = 0;
+        QStringList subdirectories;
+    };
+    // Reads the directory @p path without stat'ing anything, called in a thread
+    static DiskSummary readDiskSummary(const QString &path);
+    // Checks whether the items of @p dir still match the directory on disk,
+    // i.e. whether KDirWatch didn't miss any change.
+    // Subdirectories are checked by name since their creation isn't reported.
+    bool isInSyncWithDisk(const DirItem *dir, const DiskSummary &summary) const;
+    // Reads the directory @p dir in a thread, and lists it again if isInSyncWithDisk() fails
+    void checkDirectory(const QString &dir);
+
+    // Starts the ListJob for @p url, for the listers currently listing it
+    void startListJob(const QUrl &url);
+    // Reads the last known listing of @p url from diskListingCache in a thread.
+    // If there is one, its items are shown to the listers currently listing @p url,
+    // and the directory gets updated since it isn't complete, otherwise it's listed.
+    void loadFromDiskCache(const QUrl &url);
+    // Stores the items of @p dir in diskListingCache, if enabled for its protocol.
+    // Writing is delayed a little, so that a burst of changes is written once.
+    void saveToDiskCache(const DirItem *dir);
+    void processPendingDiskCacheSaves();
+
+    // Helper method called when we know that a list of items was deleted:
+    // all the listers holding the parent directory need to be notified,
+    // and the deleted directories removed from the cache including all the children.
     void itemsDeleted(const QList<KCoreDirLister *> &listers, const KFileItemList &deletedItems);
     void slotFilesRemoved(const QList<QUrl> &urls);
     // common for slotRedirection and slotFileRenamed
     void renameDir(const QUrl &oldUrl, const QUrl &url);
-    // common for deleteUnmarkedItems and slotFilesRemoved
+    // common for itemsDeleted and slotFilesRemoved
     void deleteDir(const QUrl &dirUrl);
     // remove directory from cache (itemsCached), including all child dirs
     void removeDirFromCache(const QUrl &dir);
@@ -380,7 +411,7 @@ private:
 
                 if (newUrl.isLocalFile()) {
                     m_canonicalPath = QFileInfo(newUrl.toLocalFile()).canonicalFilePath();
-                    KDirWatch::self()->addDir(m_canonicalPath);
+                    startWatching();
                 }
                 sendSignal(true, newUrl);
             }
@@ -396,7 +427,7 @@ private:
         {
             if (autoUpdates++ == 0) {
                 if (url.isLocalFile()) {
-                    KDirWatch::self()->addDir(m_canonicalPath);
+                    startWatching();
                 }
                 sendSignal(true, url);
             }
@@ -416,6 +447,15 @@ private:
             }
         }
 
+        void startWatching()
+        {
+            // With inotify, KDirWatch reports the files created, deleted or modified in the
+            // directory without adding a watch per file: single items can then be updated
+            // instead of listing the whole directory again
+            watchesFiles = KDirWatch::self()->internalMethod() == KDirWatch::INotify;
+            KDirWatch::self()->addDir(m_canonicalPath, watchesFiles ? KDirWatch::WatchFiles : KDirWatch::WatchDirOnly);
+        }
+
         // Insert the item in the sorted list
         void insert(const KFileItem &item)
         {
@@ -429,11 +469,18 @@ private:
             if (items.isEmpty()) {
                 return;
             }
-            lstItems.reserve(lstItems.size() + items.size());
-            auto it = lstItems.begin();
-            for (const auto &item : items) {
-                it = std::lower_bound(it, lstItems.end(), item.url());
-                it = lstItems.insert(it, item);
+            // Merge backwards in place, O(n + m) rather than one insertion per item
+            const qsizetype oldSize = lstItems.size();
+            lstItems.resize(oldSize + items.size());
+            auto out = lstItems.end();
+            auto oldIt = lstItems.begin() + oldSize;
+            auto newIt = items.cend();
+            while (newIt != items.cbegin()) {
+                if (oldIt != lstItems.begin() && *(newIt - 1) < *(oldIt - 1)) {
+                    *--out = std::move(*--oldIt);
+                } else {
+                    *--out = *--newIt;
+                }
             }
         }
 
@@ -446,6 +493,9 @@ private:
         // the directory is watched while being in the cache (useful for proper incAutoUpdate/decAutoUpdate count)
         bool watchedWhileInCache;
 
+        // KDirWatch reports the changes of the files in this directory, see startWatching()
+        bool watchesFiles = false;
+
         // the complete url of this directory
         QUrl url;
 
@@ -465,6 +515,9 @@ private:
     QHash<QUrl, DirItem *> itemsInUse;
     QCache<QUrl, DirItem> itemsCached;
 
+    // the last known listings of remote directories, kept across sessions (opt-in)
+    KIO::DirListingCache diskListingCache;
+
     // cache of ".hidden" files
     QCache<QString /*dot hidden file*/, CacheHiddenFile> m_cacheHiddenFiles;
 
@@ -480,9 +533,30 @@ private:
     // We temporize the notifications by keeping them 500ms in this list.
     std::set<QString /*path*/> pendingUpdates;
     std::set<QString /*path*/> pendingDirectoryUpdates;
+    // Directories watched with file events which changed: only listed again if
+    // isInSyncWithDisk() says that some change was missed
+    std::set<QString /*path*/> pendingDirectoryChecks;
+    // See checkDirectory()
+    std::set<QString /*path*/> runningDirectoryChecks;
+    std::set<QString /*path*/> directoriesToCheckAgain;
     // The timer for doing the delayed updates
     QTimer pendingUpdateTimer;
 
+    // The directories being read from diskListingCache, see loadFromDiskCache()
+    std::set<QUrl> runningDiskCacheLoads;
+    struct DiskCacheListing {
+        bool found = false;
+        KIO::UDSEntry rootEntry;
+        KIO::UDSEntryList entries;
+    };
+    // The listings to be written to diskListingCache, see saveToDiskCache()
+    struct PendingDiskCacheSave {
+        KIO::UDSEntry rootEntry;
+        KIO::UDSEntryList entries;
+    };
+    std::map<QUrl, PendingDiskCacheSave> pendingDiskCacheSaves;
+    QTimer diskCacheSaveTimer;
+
     // Set of remote files that have changed recently -- but we can't emit those
     // changes yet, we need to wait for the "update" directory listing.
     // The cmp() call can't differ MIME types since they are determined on demand,
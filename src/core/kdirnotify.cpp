@@ -41,6 +41,11 @@ void OrgKdeKDirNotifyInterface::emitFileRenamedWithLocalPath(const QUrl &src, co
     emitSignal(QStringLiteral("FileRenamedWithLocalPath"), QVariantList{src.toString(), dst.toString(), dstPath});
 }
 
+void OrgKdeKDirNotifyInterface::emitFilesRenamed(const QList<QUrl> &srcList, const QList<QUrl> &dstList)
+{
+    emitSignal(QStringLiteral("FilesRenamed"), QVariantList{QVariant(QUrl::toStringList(srcList)), QVariant(QUrl::toStringList(dstList))});
+}
+
 void OrgKdeKDirNotifyInterface::emitFileMoved(const QUrl &src, const QUrl &dst)
 {
     emitSignal(QStringLiteral("FileMoved"), QVariantList{src.toString(), dst.toString()});
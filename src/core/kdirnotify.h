@@ -89,6 +89,7 @@ public Q_SLOTS: // METHODS
 Q_SIGNALS: // SIGNALS
     void FileRenamed(const QString &src, const QString &dst);
     void FileRenamedWithLocalPath(const QString &src, const QString &dst, const QString &dstPath);
+    void FilesRenamed(const QStringList &srcList, const QStringList &dstList);
     void FileMoved(const QString &src, const QString &dst);
     void FilesAdded(const QString &directory);
     void FilesChanged(const QStringList &fileList);
@@ -106,6 +107,13 @@ public:
      * @since 5.20
      */
     static void emitFileRenamedWithLocalPath(const QUrl &src, const QUrl &dst, const QString &dstPath);
+    /**
+     * Notifies that several files have been renamed at once, e.g. by a batch rename.
+     * \param srcList The old URLs of the renamed files.
+     * \param dstList The new URLs of the files, in the same order as @p srcList.
+     * @since 6.0
+     */
+    static void emitFilesRenamed(const QList<QUrl> &srcList, const QList<QUrl> &dstList);
     static void emitFileMoved(const QUrl &src, const QUrl &dst);
     static void emitFilesAdded(const QUrl &directory);
     static void emitFilesChanged(const QList<QUrl> &fileList);
@@ -16,7 +16,9 @@
 
 #include "../utils_p.h"
 #include "kiocoredebug.h"
+#include "filesystemtypecache_p.h"
 #include "kioglobal_p.h"
+#include "mimetypecache_p.h"
 
 #include <QDataStream>
 #include <QDate>
@@ -115,6 +117,12 @@ public:
      */
     void determineMimeTypeHelper(const QUrl &url) const;
 
+    /**
+     * Whether determineMimeTypeHelper(@p url) matches the content of the file,
+     * and remembers the result in the MIME type cache
+     */
+    bool cachesMimeTypeFromContent(const QUrl &url) const;
+
     /**
      * The UDSEntry that contains the data for this fileitem, if it came from a directory listing.
      */
@@ -544,6 +552,23 @@ inline QString KFileItemPrivate::parsePermissions(mode_t perm) const
 void KFileItemPrivate::determineMimeTypeHelper(const QUrl &url) const
 {
     QMimeDatabase db;
+    const bool isLocal = url.isLocalFile();
+    // The cache helps when the content of a local file would be read,
+    // or when MimeTypeFinderJob had to download the start of a remote file
+    const QDateTime mtime = time(KFileItem::ModificationTime);
+    const bool useCache = mtime.isValid() && (!isLocal || !m_bSkipMimeTypeFromContent);
+    const KIO::filesize_t fileSize = useCache ? size() : 0;
+    if (useCache) {
+        const QString cachedMimeType = KIO::MimeTypeCache::instance()->mimeTypeForUrl(url, fileSize, mtime);
+        if (!cachedMimeType.isEmpty()) {
+            const QMimeType mime = db.mimeTypeForName(cachedMimeType);
+            if (mime.isValid()) {
+                m_mimeType = mime;
+                return;
+            }
+        }
+    }
+
     if (m_bSkipMimeTypeFromContent) {
         const QString scheme = url.scheme();
         if (scheme.startsWith(QLatin1String("http")) || scheme == QLatin1String("mailto")) {
@@ -553,9 +578,23 @@ void KFileItemPrivate::determineMimeTypeHelper(const QUrl &url) const
         }
     } else {
         m_mimeType = db.mimeTypeForUrl(url);
+        // For remote files this only looked at the file name, don't remember that
+        if (cachesMimeTypeFromContent(url)) {
+            KIO::MimeTypeCache::instance()->setMimeTypeForUrl(url, fileSize, mtime, m_mimeType.name());
+        }
     }
 }
 
+bool KFileItemPrivate::cachesMimeTypeFromContent(const QUrl &url) const
+{
+    return url.isLocalFile() && !m_bSkipMimeTypeFromContent && time(KFileItem::ModificationTime).isValid();
+}
+
+bool _kfileitemCachesMimeTypeFromContent(const KFileItem &item)
+{
+    return item.d && !item.isDir() && item.d->cachesMimeTypeFromContent(item.mostLocalUrl());
+}
+
 ///////
 
 KFileItem::KFileItem()
@@ -855,10 +894,14 @@ int KFileItem::groupId() const
 bool KFileItemPrivate::isSlow() const
 {
     if (m_slow == SlowUnknown) {
+        ensureInitialized();
         const QString path = localPath();
         if (!path.isEmpty()) {
-            const KFileSystemType::Type fsType = KFileSystemType::fileSystemType(path);
-            m_slow = (fsType == KFileSystemType::Nfs || fsType == KFileSystemType::Smb) ? Slow : Fast;
+            // The device of a symlink isn't the one of its target, which statfs() looks at
+            const qint64 deviceId = m_bLink ? -1 : m_entry.numberValue(KIO::UDSEntry::UDS_DEVICE_ID, -1);
+            const KFileSystemType::Type fsType = deviceId != -1 ? KIO::FileSystemTypeCache::instance()->fileSystemType(deviceId, path)
+                                                                : KFileSystemType::fileSystemType(path);
+            m_slow = KIO::FileSystemTypeCache::isSlow(fsType) ? Slow : Fast;
         } else {
             m_slow = Slow;
         }
@@ -928,7 +971,7 @@ bool KFileItem::isMimeTypeKnown() const
     return d->m_bMimeTypeKnown && d->m_guessedMimeType.isEmpty();
 }
 
-static bool isDirectoryMounted(const QUrl &url)
+static bool isDirectoryMounted(const KFileItem &item, const QUrl &url)
 {
     // Stating .directory files can cause long freezes when e.g. /home
     // uses autofs for every user's home directory, i.e. opening /home
@@ -938,6 +981,11 @@ static bool isDirectoryMounted(const QUrl &url)
     // be mounted, but those are unlikely to contain .directory (and checking
     // this would require checking with KMountPoint).
 
+    // The listing says already, unless the size is the one of a symlink
+    if (!item.isLink() && item.entry().contains(KIO::UDSEntry::UDS_SIZE)) {
+        return !item.isDir() || item.size() != 0;
+    }
+
     // TODO: maybe this could be checked with KFileSystemType instead?
     QFileInfo info(url.toLocalFile());
     if (info.isDir() && info.size() == 0) {
@@ -980,7 +1028,7 @@ QString KFileItem::mimeComment() const
     }
 
     // Support for .directory file in directories
-    if (isLocalUrl && isDir() && !d->isSlow() && isDirectoryMounted(url)) {
+    if (isLocalUrl && isDir() && !d->isSlow() && isDirectoryMounted(*this, url)) {
         QUrl u(url);
         u.setPath(Utils::concatPaths(u.path(), QStringLiteral(".directory")));
         const KDesktopFile cfg(u.toLocalFile());
@@ -1097,7 +1145,7 @@ QString KFileItem::iconName() const
         }
 
         if (isDir()) {
-            if (isDirectoryMounted(url)) {
+            if (isDirectoryMounted(*this, url)) {
                 d->m_iconName = iconFromDirectoryFile(localFile);
                 if (!d->m_iconName.isEmpty()) {
                     d->m_useIconNameCache = d->m_bMimeTypeKnown;
@@ -603,6 +603,7 @@ private:
 
     friend class KFileItemTest;
     friend class KCoreDirListerCache;
+    KIOCORE_EXPORT friend bool _kfileitemCachesMimeTypeFromContent(const KFileItem &item);
 };
 
 Q_DECLARE_METATYPE(KFileItem)
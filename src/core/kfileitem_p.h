@@ -0,0 +1,23 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KFILEITEM_P_H
+#define KFILEITEM_P_H
+
+#include "kiocore_export.h"
+
+class KFileItem;
+
+/**
+ * @internal
+ * Whether KFileItem::determineMimeType() matches the content of the local file of @p item,
+ * i.e. of its mostLocalUrl(), and remembers the result in KIO::MimeTypeCache.
+ * Exported for KFilePreviewGenerator, which fills the cache for those in a thread.
+ */
+KIOCORE_EXPORT bool _kfileitemCachesMimeTypeFromContent(const KFileItem &item);
+
+#endif // KFILEITEM_P_H
@@ -7,6 +7,7 @@
 */
 
 #include "kmountpoint.h"
+#include "kmountpoint_p.h"
 
 #include <stdlib.h>
 
@@ -14,14 +15,23 @@
 #include <config-kmountpoint.h>
 #include <kioglobal_p.h> // Defines QT_LSTAT on windows to kio_windows_lstat
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QSocketNotifier>
 #include <QTextStream>
 
 #include <qplatformdefs.h>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
 static const Qt::CaseSensitivity cs = Qt::CaseInsensitive;
@@ -48,6 +58,10 @@ static const Qt::CaseSensitivity cs = Qt::CaseSensitive;
 // Linux
 #if HAVE_LIB_MOUNT
 #include <libmount/libmount.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #endif
 
 static bool isNetfs(const QString &mountType)
@@ -78,6 +92,14 @@ public:
     void resolveGvfsMountPoints(KMountPoint::List &result);
     void finalizePossibleMountPoint(KMountPoint::DetailsNeededFlags infoNeeded);
     void finalizeCurrentMountPoint(KMountPoint::DetailsNeededFlags infoNeeded);
+#if HAVE_LIB_MOUNT
+    // Without the mounts of gvfsd-fuse, see addGvfsMountPoints()
+    static KMountPoint::List readMountInfo(KMountPoint::DetailsNeededFlags infoNeeded);
+    static bool hasGvfsMountPoints(const KMountPoint::List &mountPoints);
+    // Returns @p mountPoints with the mounts of gvfsd-fuse before its mount point,
+    // and the index in the result of each of @p mountPoints in @p indexes
+    static KMountPoint::List addGvfsMountPoints(const KMountPoint::List &mountPoints, std::vector<qsizetype> &indexes);
+#endif
 
     QString m_mountedFrom;
     QString m_device; // Only available when the NeedRealDeviceName flag was set.
@@ -282,6 +304,253 @@ void KMountPointPrivate::resolveGvfsMountPoints(KMountPoint::List &result)
     }
 }
 
+#if HAVE_LIB_MOUNT
+KMountPoint::List KMountPointPrivate::readMountInfo(KMountPoint::DetailsNeededFlags infoNeeded)
+{
+    KMountPoint::List result;
+
+    if (struct libmnt_table *table = mnt_new_table()) {
+        // if "/etc/mtab" is a regular file,
+        // "/etc/mtab" is used by default instead of "/proc/self/mountinfo" file.
+        // This leads to NTFS mountpoints being hidden.
+        if (mnt_table_parse_mtab(table, "/proc/self/mountinfo") == 0) {
+            struct libmnt_iter *itr = mnt_new_iter(MNT_ITER_FORWARD);
+            struct libmnt_fs *fs;
+
+            while (mnt_table_next_fs(table, itr, &fs) == 0) {
+                KMountPoint::Ptr mp(new KMountPoint);
+                mp->d->m_mountedFrom = QFile::decodeName(mnt_fs_get_source(fs));
+                mp->d->m_mountPoint = QFile::decodeName(mnt_fs_get_target(fs));
+                mp->d->m_mountType = QFile::decodeName(mnt_fs_get_fstype(fs));
+                mp->d->m_isNetFs = mnt_fs_is_netfs(fs) == 1;
+                mp->d->m_deviceId = mnt_fs_get_devno(fs);
+
+                if (infoNeeded & KMountPoint::NeedMountOptions) {
+                    mp->d->m_mountOptions = QFile::decodeName(mnt_fs_get_options(fs)).split(QLatin1Char(','));
+                }
+
+                if (infoNeeded & KMountPoint::NeedRealDeviceName) {
+                    if (mp->d->m_mountedFrom.startsWith(QLatin1Char('/'))) {
+                        mp->d->m_device = mp->d->m_mountedFrom;
+                    }
+                }
+
+                mp->d->finalizeCurrentMountPoint(infoNeeded);
+                result.push_back(mp);
+            }
+
+            mnt_free_iter(itr);
+        }
+
+        mnt_free_table(table);
+    }
+
+    return result;
+}
+
+bool KMountPointPrivate::hasGvfsMountPoints(const KMountPoint::List &mountPoints)
+{
+    return std::any_of(mountPoints.cbegin(), mountPoints.cend(), [](const KMountPoint::Ptr &mp) {
+        return mp->d->m_mountedFrom == QLatin1String("gvfsd-fuse");
+    });
+}
+
+KMountPoint::List KMountPointPrivate::addGvfsMountPoints(const KMountPoint::List &mountPoints, std::vector<qsizetype> &indexes)
+{
+    KMountPoint::List result;
+    result.reserve(mountPoints.size());
+    indexes.clear();
+    indexes.reserve(mountPoints.size());
+    for (const KMountPoint::Ptr &mp : mountPoints) {
+        mp->d->resolveGvfsMountPoints(result);
+        indexes.push_back(result.size());
+        result.append(mp);
+    }
+    return result;
+}
+
+// Mount points by path component, for findByPath() on the current mount points
+class MountPointTrie
+{
+public:
+    MountPointTrie() = default;
+    explicit MountPointTrie(const KMountPoint::List &mountPoints)
+    {
+        m_nodes.emplace_back(); // "/"
+        for (qsizetype i = 0; i < mountPoints.size(); ++i) {
+            int node = 0;
+            const QStringList components = mountPoints.at(i)->mountPoint().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+            for (const QString &component : components) {
+                auto it = m_nodes[node].children.constFind(component);
+                if (it != m_nodes[node].children.constEnd()) {
+                    node = it.value();
+                } else {
+                    m_nodes.emplace_back();
+                    const int child = static_cast<int>(m_nodes.size()) - 1;
+                    m_nodes[node].children.insert(component, child);
+                    node = child;
+                }
+            }
+            m_nodes[node].mountPoints.push_back(i);
+        }
+    }
+
+    // The index in the list of the first mount point on the device @p deviceId
+    // which is @p path or one of its parents, or -1
+    qsizetype find(const KMountPoint::List &mountPoints, const QString &path, dev_t deviceId) const
+    {
+        qsizetype result = -1;
+        auto check = [&](const Node &node) {
+            for (qsizetype i : node.mountPoints) {
+                if ((result == -1 || i < result) && mountPoints.at(i)->deviceId() == deviceId) {
+                    result = i;
+                }
+            }
+        };
+        if (m_nodes.empty()) {
+            return result;
+        }
+        int node = 0;
+        check(m_nodes[node]);
+        for (const QStringView component : QStringView(path).split(QLatin1Char('/'), Qt::SkipEmptyParts)) {
+            auto it = m_nodes[node].children.constFind(component.toString());
+            if (it == m_nodes[node].children.constEnd()) {
+                break;
+            }
+            node = it.value();
+            check(m_nodes[node]);
+        }
+        return result;
+    }
+
+private:
+    struct Node {
+        QHash<QString, int> children; // index in m_nodes, by path component
+        std::vector<qsizetype> mountPoints; // index in the list, of the mount points at this path
+    };
+    std::vector<Node> m_nodes;
+};
+
+// The current mount points, shared by all the callers of currentMountPoints(). They are read
+// again only when poll() reports a change of /proc/self/mountinfo. Thread-safe.
+// The mounts of gvfsd-fuse aren't in mountinfo, so they are listed on every call.
+class MountTable
+{
+public:
+    MountTable()
+        : m_fd(::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC))
+    {
+    }
+
+    ~MountTable()
+    {
+        if (m_fd != -1) {
+            ::close(m_fd);
+        }
+    }
+
+    KMountPoint::List mountPoints()
+    {
+        QMutexLocker locker(&m_mutex);
+        checkForChanges();
+        if (!m_valid) {
+            m_mountPoints = KMountPointPrivate::readMountInfo(KMountPoint::NeedMountOptions | KMountPoint::NeedRealDeviceName);
+            m_hasGvfs = KMountPointPrivate::hasGvfsMountPoints(m_mountPoints);
+            m_trie = MountPointTrie(m_mountPoints);
+            m_gvfsMountPoints.clear();
+            m_gvfsIndexes.clear();
+            m_valid = true;
+        }
+        if (!m_hasGvfs) {
+            return m_mountPoints;
+        }
+
+        // Not while locked, listing the gvfsd-fuse directory could take a while
+        const KMountPoint::List mountPoints = m_mountPoints;
+        locker.unlock();
+        std::vector<qsizetype> indexes;
+        const KMountPoint::List result = KMountPointPrivate::addGvfsMountPoints(mountPoints, indexes);
+        locker.relock();
+        if (mountPoints.constData() == m_mountPoints.constData()) {
+            m_gvfsMountPoints = result;
+            m_gvfsIndexes = std::move(indexes);
+        }
+        return result;
+    }
+
+    // Sets @p index to the result of findByPath(), if @p mountPoints is the current list
+    bool findByPath(const KMountPoint::List &mountPoints, const QString &path, dev_t deviceId, qsizetype &index)
+    {
+        QMutexLocker locker(&m_mutex);
+        // Copies of the list share their data, as long as they're not modified
+        if (!m_valid || mountPoints.isEmpty()) {
+            return false;
+        }
+        if (mountPoints.constData() == m_mountPoints.constData()) {
+            index = m_trie.find(m_mountPoints, path, deviceId);
+            return true;
+        }
+        // The mounts of gvfsd-fuse have no device id, they are never found
+        if (m_hasGvfs && mountPoints.constData() == m_gvfsMountPoints.constData()) {
+            index = m_trie.find(m_mountPoints, path, deviceId);
+            if (index != -1) {
+                index = m_gvfsIndexes.at(index);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    quint64 changeCount()
+    {
+        QMutexLocker locker(&m_mutex);
+        checkForChanges();
+        return m_changeCount;
+    }
+
+private:
+    void checkForChanges()
+    {
+        if (m_fd == -1) {
+            // Without change notifications, read it every time
+            m_valid = false;
+            ++m_changeCount;
+            return;
+        }
+        // The kernel flags a change once per file descriptor, until it's polled again
+        pollfd pfd{m_fd, POLLPRI, 0};
+        if (::poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+            m_valid = false;
+            ++m_changeCount;
+        }
+    }
+
+    QMutex m_mutex; // protects all the member variables below
+    const int m_fd;
+    bool m_valid = false;
+    quint64 m_changeCount = 0;
+    KMountPoint::List m_mountPoints; // without the mounts of gvfsd-fuse
+    MountPointTrie m_trie;
+    bool m_hasGvfs = false;
+    // The last list returned by mountPoints() with the mounts of gvfsd-fuse,
+    // and the index in that list of each of m_mountPoints
+    KMountPoint::List m_gvfsMountPoints;
+    std::vector<qsizetype> m_gvfsIndexes;
+};
+
+Q_GLOBAL_STATIC(MountTable, s_mountTable)
+#endif
+
+quint64 KIO::mountTableChangeCount()
+{
+#if HAVE_LIB_MOUNT
+    return s_mountTable()->changeCount();
+#else
+    static std::atomic<quint64> s_changeCount = 0;
+    return ++s_changeCount;
+#endif
+}
+
 KMountPoint::List KMountPoint::currentMountPoints(DetailsNeededFlags infoNeeded)
 {
     KMountPoint::List result;
@@ -339,43 +608,8 @@ KMountPoint::List KMountPoint::currentMountPoints(DetailsNeededFlags infoNeeded)
     }
 
 #elif HAVE_LIB_MOUNT
-    if (struct libmnt_table *table = mnt_new_table()) {
-        // if "/etc/mtab" is a regular file,
-        // "/etc/mtab" is used by default instead of "/proc/self/mountinfo" file.
-        // This leads to NTFS mountpoints being hidden.
-        if (mnt_table_parse_mtab(table, "/proc/self/mountinfo") == 0) {
-            struct libmnt_iter *itr = mnt_new_iter(MNT_ITER_FORWARD);
-            struct libmnt_fs *fs;
-
-            while (mnt_table_next_fs(table, itr, &fs) == 0) {
-                Ptr mp(new KMountPoint);
-                mp->d->m_mountedFrom = QFile::decodeName(mnt_fs_get_source(fs));
-                mp->d->m_mountPoint = QFile::decodeName(mnt_fs_get_target(fs));
-                mp->d->m_mountType = QFile::decodeName(mnt_fs_get_fstype(fs));
-                mp->d->m_isNetFs = mnt_fs_is_netfs(fs) == 1;
-                mp->d->m_deviceId = mnt_fs_get_devno(fs);
-
-                if (infoNeeded & NeedMountOptions) {
-                    mp->d->m_mountOptions = QFile::decodeName(mnt_fs_get_options(fs)).split(QLatin1Char(','));
-                }
-
-                if (infoNeeded & NeedRealDeviceName) {
-                    if (mp->d->m_mountedFrom.startsWith(QLatin1Char('/'))) {
-                        mp->d->m_device = mp->d->m_mountedFrom;
-                    }
-                }
-
-                mp->d->resolveGvfsMountPoints(result);
-
-                mp->d->finalizeCurrentMountPoint(infoNeeded);
-                result.push_back(mp);
-            }
-
-            mnt_free_iter(itr);
-        }
-
-        mnt_free_table(table);
-    }
+    Q_UNUSED(infoNeeded) // the shared table has all the details
+    result = s_mountTable()->mountPoints();
 #endif
 
     return result;
@@ -435,6 +669,11 @@ KMountPoint::Ptr KMountPoint::List::findByPath(const QString &path) const
     KMountPoint::Ptr result;
 
     if (QT_STATBUF buff; QT_LSTAT(QFile::encodeName(realPath).constData(), &buff) == 0) {
+#if HAVE_LIB_MOUNT
+        if (qsizetype index = -1; s_mountTable()->findByPath(*this, realPath, buff.st_dev, index)) {
+            return index != -1 ? at(index) : result;
+        }
+#endif
         auto it = std::find_if(this->cbegin(), this->cend(), [&buff, &realPath](const KMountPoint::Ptr &mountPtr) {
             // For a bind mount, the deviceId() is that of the base mount point, e.g. /mnt/foo,
             // however the path we're looking for, e.g. /home/user/bar, doesn't start with the
@@ -526,3 +765,105 @@ KIOCORE_EXPORT QDebug operator<<(QDebug debug, const KMountPoint::Ptr &mp)
     // clang-format on
     return debug;
 }
+
+class KMountPointWatcherPrivate
+{
+public:
+    // Compares the current mount points with the previous ones
+    void update(KMountPointWatcher *q);
+
+    KMountPoint::List m_mountPoints;
+#if HAVE_LIB_MOUNT
+    int m_fd = -1;
+#endif
+};
+
+// What tells mount points apart, in the lists of before and after a change
+static QString mountPointKey(const KMountPoint::Ptr &mountPoint)
+{
+    return mountPoint->mountPoint() + QLatin1Char('\n') + mountPoint->mountedFrom() + QLatin1Char('\n') + mountPoint->mountType();
+}
+
+void KIO::diffMountPoints(const KMountPoint::List &oldMountPoints,
+                          const KMountPoint::List &newMountPoints,
+                          KMountPoint::List &added,
+                          KMountPoint::List &removed)
+{
+    // The same file system can be mounted several times at the same place
+    QHash<QString, int> oldCounts;
+    for (const KMountPoint::Ptr &mountPoint : oldMountPoints) {
+        ++oldCounts[mountPointKey(mountPoint)];
+    }
+    for (const KMountPoint::Ptr &mountPoint : newMountPoints) {
+        auto it = oldCounts.find(mountPointKey(mountPoint));
+        if (it != oldCounts.end() && it.value() > 0) {
+            --it.value();
+        } else {
+            added.append(mountPoint);
+        }
+    }
+    // What's left was unmounted, the last ones of the old list for mount points stacked on each other
+    const qsizetype removedStart = removed.size();
+    for (auto it = oldMountPoints.crbegin(); it != oldMountPoints.crend(); ++it) {
+        int &count = oldCounts[mountPointKey(*it)];
+        if (count > 0) {
+            --count;
+            removed.append(*it);
+        }
+    }
+    std::reverse(removed.begin() + removedStart, removed.end());
+}
+
+void KMountPointWatcherPrivate::update(KMountPointWatcher *q)
+{
+    const KMountPoint::List oldMountPoints = m_mountPoints;
+    m_mountPoints = KMountPoint::currentMountPoints();
+
+    KMountPoint::List added;
+    KMountPoint::List removed;
+    KIO::diffMountPoints(oldMountPoints, m_mountPoints, added, removed);
+    for (const KMountPoint::Ptr &mountPoint : std::as_const(removed)) {
+        Q_EMIT q->mountPointRemoved(mountPoint);
+    }
+    for (const KMountPoint::Ptr &mountPoint : std::as_const(added)) {
+        Q_EMIT q->mountPointAdded(mountPoint);
+    }
+}
+
+KMountPointWatcher *KMountPointWatcher::self()
+{
+    // Deleted along with the application
+    static QPointer<KMountPointWatcher> s_self;
+    if (!s_self) {
+        s_self = new KMountPointWatcher;
+    }
+    return s_self;
+}
+
+KMountPointWatcher::KMountPointWatcher()
+    : QObject(QCoreApplication::instance())
+    , d(new KMountPointWatcherPrivate)
+{
+#if HAVE_LIB_MOUNT
+    // A file descriptor of its own: the kernel reports each change once per file descriptor
+    d->m_fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (d->m_fd != -1) {
+        d->m_mountPoints = currentMountPoints();
+        auto *notifier = new QSocketNotifier(d->m_fd, QSocketNotifier::Exception, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this]() {
+            d->update(this);
+        });
+    }
+#endif
+}
+
+KMountPointWatcher::~KMountPointWatcher()
+{
+#if HAVE_LIB_MOUNT
+    if (d->m_fd != -1) {
+        ::close(d->m_fd);
+    }
+#endif
+}
+
+#include "moc_kmountpoint.cpp"
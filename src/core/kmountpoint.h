@@ -12,6 +12,7 @@
 #include "kiocore_export.h"
 
 #include <QExplicitlySharedDataPointer>
+#include <QObject>
 #include <QStringList>
 
 #include <memory>
@@ -43,6 +44,9 @@ public:
          * Find the mountpoint on which resides @p path
          * For instance if /home is a separate partition, findByPath("/home/user/blah")
          * will return /home
+         *
+         * On the list returned by currentMountPoints(), this doesn't go through all the
+         * mount points, it looks up the parent directories of @p path.
          * @param path the path to check
          * @return the mount point of the given file
          */
@@ -91,10 +95,15 @@ public:
     /**
      * Returns a list of all current mountpoints.
      *
+     * On Linux, the list is shared by all the callers and only read again
+     * when the kernel reports a change of the mount table, so calling this
+     * repeatedly is cheap. It then has all the details, whatever @p infoNeeded.
+     *
      * @param infoNeeded Flags that specify which additional information
      * should be fetched.
      *
      * @note This method will return an empty list on @c Android
+     * @see KMountPointWatcher
      */
     static List currentMountPoints(DetailsNeededFlags infoNeeded = BasicInfoNeeded);
 
@@ -197,6 +206,47 @@ private:
 
 KIOCORE_EXPORT QDebug operator<<(QDebug debug, const KMountPoint::Ptr &mp);
 
+class KMountPointWatcherPrivate;
+
+/**
+ * @class KMountPointWatcher kmountpoint.h <KMountPoint>
+ *
+ * Notifies about file systems being mounted and unmounted.
+ *
+ * The changes are only detected on Linux, where the kernel reports them
+ * for /proc/self/mountinfo. Elsewhere, the signals are never emitted.
+ *
+ * @since 6.0
+ */
+class KIOCORE_EXPORT KMountPointWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Returns the instance of the application.
+     * Must be called from the main thread.
+     */
+    static KMountPointWatcher *self();
+
+    ~KMountPointWatcher() override;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a file system got mounted at @p mountPoint.
+     */
+    void mountPointAdded(const KMountPoint::Ptr &mountPoint);
+
+    /**
+     * Emitted when the file system at @p mountPoint got unmounted.
+     */
+    void mountPointRemoved(const KMountPoint::Ptr &mountPoint);
+
+private:
+    KIOCORE_NO_EXPORT KMountPointWatcher();
+
+    std::unique_ptr<KMountPointWatcherPrivate> const d;
+};
+
 Q_DECLARE_OPERATORS_FOR_FLAGS(KMountPoint::DetailsNeededFlags)
 
 #endif // KMOUNTPOINT_H
@@ -0,0 +1,27 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KMOUNTPOINT_P_H
+#define KMOUNTPOINT_P_H
+
+#include "kmountpoint.h"
+
+namespace KIO
+{
+// Increases whenever the mount table changes. Where changes aren't reported,
+// i.e. other than on Linux, it increases on every call.
+quint64 mountTableChangeCount();
+
+// Appends to @p added the mount points of @p newMountPoints which aren't in @p oldMountPoints,
+// and to @p removed the reverse, in the order of the lists. Exported for the unit test.
+KIOCORE_EXPORT void diffMountPoints(const KMountPoint::List &oldMountPoints,
+                                    const KMountPoint::List &newMountPoints,
+                                    KMountPoint::List &added,
+                                    KMountPoint::List &removed);
+}
+
+#endif // KMOUNTPOINT_P_H
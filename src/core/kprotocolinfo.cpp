@@ -41,6 +41,8 @@ KProtocolInfoPrivate::KProtocolInfoPrivate(const QString &name, const QString &e
     m_supportsMoving = json.value(QStringLiteral("moving")).toBool();
     m_supportsOpening = json.value(QStringLiteral("opening")).toBool();
     m_supportsTruncating = json.value(QStringLiteral("truncating")).toBool();
+    m_supportsMakePath = json.value(QStringLiteral("makepath")).toBool();
+    m_supportsListRecursive = json.value(QStringLiteral("listrecursive")).toBool();
     m_canCopyFromFile = json.value(QStringLiteral("copyFromFile")).toBool();
     m_canCopyToFile = json.value(QStringLiteral("copyToFile")).toBool();
     m_canRenameFromFile = json.value(QStringLiteral("renameFromFile")).toBool();
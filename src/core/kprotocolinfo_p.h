@@ -39,6 +39,8 @@ public:
     bool m_supportsMoving : 1;
     bool m_supportsOpening : 1;
     bool m_supportsTruncating : 1;
+    bool m_supportsMakePath : 1;
+    bool m_supportsListRecursive : 1;
     bool m_determineMimetypeFromExtension : 1;
     bool m_canCopyFromFile : 1;
     bool m_canCopyToFile : 1;
@@ -29,7 +29,10 @@
 #include <QCache>
 #include <QCoreApplication>
 #ifndef KIO_ANDROID_STUB
-#include <QDBusInterface>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusReply>
 #endif
 #include <QHostAddress>
@@ -123,30 +126,64 @@ KProtocolManagerPrivate::~KProtocolManagerPrivate()
 {
 }
 
-/*
- * Returns true if url is in the no proxy list.
- */
-bool KProtocolManagerPrivate::shouldIgnoreProxyFor(const QUrl &url)
+void KProtocolManagerPrivate::readNoProxyList()
 {
-    bool isMatch = false;
-    const KProtocolManager::ProxyType type = proxyType();
-    const bool useRevProxy = ((type == KProtocolManager::ManualProxy) && useReverseProxy());
-    const bool useNoProxyList = (type == KProtocolManager::ManualProxy || type == KProtocolManager::EnvVarProxy);
+    if (noProxyListRead) {
+        return;
+    }
+    noProxyListRead = true;
 
     // No proxy only applies to ManualProxy and EnvVarProxy types...
-    if (useNoProxyList && noProxyFor.isEmpty()) {
-        QStringList noProxyForList(readNoProxyFor().split(QLatin1Char(',')));
-        QMutableStringListIterator it(noProxyForList);
-        while (it.hasNext()) {
-            SubnetPair subnet = QHostAddress::parseSubnet(it.next());
-            if (!subnet.first.isNull()) {
-                noProxySubnets << subnet;
-                it.remove();
-            }
+    const KProtocolManager::ProxyType type = proxyType();
+    if (type != KProtocolManager::ManualProxy && type != KProtocolManager::EnvVarProxy) {
+        return;
+    }
+
+    QStringList noProxyForList(readNoProxyFor().split(QLatin1Char(',')));
+    QMutableStringListIterator it(noProxyForList);
+    while (it.hasNext()) {
+        SubnetPair subnet = QHostAddress::parseSubnet(it.next());
+        if (!subnet.first.isNull()) {
+            noProxySubnets << subnet;
+            it.remove();
         }
-        noProxyFor = noProxyForList.join(QLatin1Char(','));
+    }
+    noProxyFor = noProxyForList.join(QLatin1Char(','));
+}
+
+/*
+ * Returns true if the host of url has to be looked up to match it against the subnets
+ * of the no proxy list. Otherwise, address is set to its address, if known.
+ */
+bool KProtocolManagerPrivate::needsHostLookup(const QUrl &url, QHostAddress &address)
+{
+    readNoProxyList();
+
+    const QString host(url.host());
+    address = QHostAddress(host);
+    if (noProxySubnets.isEmpty() || host.isEmpty() || !address.isNull()) {
+        return false;
     }
 
+    const QList<QHostAddress> addresses = KIO::HostInfo::lookupCachedHostInfoFor(host).addresses();
+    if (!addresses.isEmpty()) {
+        address = addresses.first();
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Returns true if url is in the no proxy list. address is the address of its host,
+ * see needsHostLookup().
+ */
+bool KProtocolManagerPrivate::shouldIgnoreProxyFor(const QUrl &url, const QHostAddress &address)
+{
+    readNoProxyList();
+
+    bool isMatch = false;
+    const bool useRevProxy = ((proxyType() == KProtocolManager::ManualProxy) && useReverseProxy());
+
     if (!noProxyFor.isEmpty()) {
         QString qhost = url.host().toLower();
         QByteArray host = qhost.toLatin1();
@@ -170,27 +207,11 @@ bool KProtocolManagerPrivate::shouldIgnoreProxyFor(const QUrl &url)
         }
     }
 
-    const QString host(url.host());
-
-    if (!noProxySubnets.isEmpty() && !host.isEmpty()) {
-        QHostAddress address(host);
-        // If request url is not IP address, do a DNS lookup of the hostname.
-        // TODO: Perhaps we should make configurable ?
-        if (address.isNull()) {
-            // qDebug() << "Performing DNS lookup for" << host;
-            QHostInfo info = KIO::HostInfo::lookupHost(host, 2000);
-            const QList<QHostAddress> addresses = info.addresses();
-            if (!addresses.isEmpty()) {
-                address = addresses.first();
-            }
-        }
-
-        if (!address.isNull()) {
-            for (const SubnetPair &subnet : std::as_const(noProxySubnets)) {
-                if (address.isInSubnet(subnet)) {
-                    isMatch = true;
-                    break;
-                }
+    if (!isMatch && !address.isNull()) {
+        for (const SubnetPair &subnet : std::as_const(noProxySubnets)) {
+            if (address.isInSubnet(subnet)) {
+                isMatch = true;
+                break;
             }
         }
     }
@@ -220,7 +241,10 @@ void KProtocolManager::reparseConfiguration()
         d->configPtr->reparseConfiguration();
     }
     d->cachedProxyData.clear();
+    ++d->proxyCacheGeneration;
     d->noProxyFor.clear();
+    d->noProxySubnets.clear();
+    d->noProxyListRead = false;
     d->modifiers.clear();
     d->useragent.clear();
     lock.unlock();
@@ -251,6 +275,12 @@ bool KProtocolManagerPrivate::useReverseProxy()
     return cg.readEntry("ReversedException", false);
 }
 
+bool KProtocolManagerPrivate::pathDependentProxyScript()
+{
+    KConfigGroup cg(config(), "Proxy Settings");
+    return cg.readEntry("PathDependentProxyScript", false);
+}
+
 QString KProtocolManagerPrivate::readNoProxyFor()
 {
     QString noProxy = config()->group("Proxy Settings").readEntry("NoProxyFor");
@@ -474,52 +504,113 @@ QStringList KProtocolManagerPrivate::getSystemProxyFor(const QUrl &url)
     return proxies;
 }
 
+// The protocols proxyscout is asked about
+static bool isProxyScoutProtocol(const QString &protocol)
+{
+    return protocol.startsWith(QLatin1String("http")) || protocol.startsWith(QLatin1String("ftp"));
+}
+
+#ifndef KIO_ANDROID_STUB
+static QDBusMessage proxyScoutRequest(const QUrl &url)
+{
+    QUrl u(url);
+    u.setScheme(adjustProtocol(u.scheme()));
+
+    QDBusMessage message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.kded6"),
+                                                          QStringLiteral("/modules/proxyscout"),
+                                                          QStringLiteral("org.kde.KPAC.ProxyScout"),
+                                                          QStringLiteral("proxiesForUrl"));
+    message << u.toString();
+    return message;
+}
+#endif
+
+KProtocolManagerPrivate::ProxySource KProtocolManagerPrivate::proxySource(const QUrl &url, const QHostAddress &address)
+{
+    if (shouldIgnoreProxyFor(url, address)) {
+        return ProxySource::None;
+    }
+
+    switch (proxyType()) {
+    case KProtocolManager::EnvVarProxy:
+    case KProtocolManager::ManualProxy:
+        return ProxySource::Config;
+    case KProtocolManager::PACProxy:
+    case KProtocolManager::WPADProxy:
+#ifndef KIO_ANDROID_STUB
+        if (isProxyScoutProtocol(adjustProtocol(url.scheme()))) {
+            return ProxySource::ProxyScout;
+        }
+#endif
+        break;
+    case KProtocolManager::NoProxy:
+        break;
+    }
+    return ProxySource::None;
+}
+
+QStringList KProtocolManagerPrivate::configuredProxiesFor(const QUrl &url)
+{
+    QStringList proxyList;
+    switch (proxyType()) {
+    case KProtocolManager::EnvVarProxy:
+        proxyList = getSystemProxyFor(url);
+        break;
+    case KProtocolManager::ManualProxy: {
+        QString proxy(proxyFor(url.scheme()));
+        if (!proxy.isEmpty()) {
+            proxyList << proxy;
+        }
+        // Add the socks proxy as an alternate proxy if it exists,
+        proxy = proxyFor(QStringLiteral("socks"));
+        if (!proxy.isEmpty()) {
+            // Make sure the scheme of SOCKS proxy is always set to "socks://".
+            const int index = proxy.indexOf(QLatin1String("://"));
+            const int offset = (index == -1) ? 0 : (index + 3);
+            proxy = QLatin1String("socks://") + QStringView(proxy).mid(offset);
+            proxyList << proxy;
+        }
+        break;
+    }
+    case KProtocolManager::PACProxy:
+    case KProtocolManager::WPADProxy:
+    case KProtocolManager::NoProxy:
+        break;
+    }
+    return proxyList;
+}
+
 QStringList KProtocolManagerPrivate::proxiesForUrl(const QUrl &url)
 {
     QStringList proxyList;
 
     KProtocolManagerPrivate *d = kProtocolManagerPrivate();
     QMutexLocker lock(&d->mutex);
-    if (!d->shouldIgnoreProxyFor(url)) {
-        switch (d->proxyType()) {
-        case KProtocolManager::PACProxy:
-        case KProtocolManager::WPADProxy: {
-            QUrl u(url);
-            const QString protocol = adjustProtocol(u.scheme());
-            u.setScheme(protocol);
+    QHostAddress address;
+    if (d->needsHostLookup(url, address)) {
+        lock.unlock();
+        // qDebug() << "Performing DNS lookup for" << url.host();
+        const QList<QHostAddress> addresses = KIO::HostInfo::lookupHost(url.host(), 2000).addresses();
+        if (!addresses.isEmpty()) {
+            address = addresses.first();
+        }
+        lock.relock();
+    }
 
+    switch (d->proxySource(url, address)) {
+    case ProxySource::ProxyScout: {
 #ifndef KIO_ANDROID_STUB
-            if (protocol.startsWith(QLatin1String("http")) || protocol.startsWith(QLatin1String("ftp"))) {
-                QDBusReply<QStringList> reply =
-                    QDBusInterface(QStringLiteral("org.kde.kded6"), QStringLiteral("/modules/proxyscout"), QStringLiteral("org.kde.KPAC.ProxyScout"))
-                        .call(QStringLiteral("proxiesForUrl"), u.toString());
-                proxyList = reply;
-            }
+        lock.unlock();
+        const QDBusReply<QStringList> reply = QDBusConnection::sessionBus().call(proxyScoutRequest(url));
+        proxyList = reply;
 #endif
-            break;
-        }
-        case KProtocolManager::EnvVarProxy:
-            proxyList = d->getSystemProxyFor(url);
-            break;
-        case KProtocolManager::ManualProxy: {
-            QString proxy(d->proxyFor(url.scheme()));
-            if (!proxy.isEmpty()) {
-                proxyList << proxy;
-            }
-            // Add the socks proxy as an alternate proxy if it exists,
-            proxy = d->proxyFor(QStringLiteral("socks"));
-            if (!proxy.isEmpty()) {
-                // Make sure the scheme of SOCKS proxy is always set to "socks://".
-                const int index = proxy.indexOf(QLatin1String("://"));
-                const int offset = (index == -1) ? 0 : (index + 3);
-                proxy = QLatin1String("socks://") + QStringView(proxy).mid(offset);
-                proxyList << proxy;
-            }
-            break;
-        }
-        case KProtocolManager::NoProxy:
-            break;
-        }
+        break;
+    }
+    case ProxySource::Config:
+        proxyList = d->configuredProxiesFor(url);
+        break;
+    case ProxySource::None:
+        break;
     }
 
     if (proxyList.isEmpty()) {
@@ -530,44 +621,47 @@ QStringList KProtocolManagerPrivate::proxiesForUrl(const QUrl &url)
 }
 
 // Generates proxy cache key from request given url.
+// A proxy script gets the whole URL, but looks at the host only most of the time, so its
+// results are shared by all URLs of a host too, unless the user says the script needs the path.
 static QString extractProxyCacheKeyFromUrl(const QUrl &u)
 {
-    QString key = u.scheme();
-    key += u.host();
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    Q_ASSERT(!d->mutex.tryLock()); // the caller must have locked the mutex
+    const KProtocolManager::ProxyType type = d->proxyType();
+    if ((type == KProtocolManager::PACProxy || type == KProtocolManager::WPADProxy) && d->pathDependentProxyScript()) {
+        return u.adjusted(QUrl::RemoveUserInfo | QUrl::RemoveFragment).toString();
+    }
 
+    QString key = u.scheme() + QLatin1String("://") + u.host();
     if (u.port() > 0) {
-        key += QString::number(u.port());
+        key += QLatin1Char(':') + QString::number(u.port());
     }
     return key;
 }
 
-QString KProtocolManagerPrivate::workerProtocol(const QUrl &url, QStringList &proxyList)
+QString KProtocolManagerPrivate::proxyCacheKey(const QUrl &url)
 {
-    proxyList.clear();
-
-    // Do not perform a proxy lookup for any url classified as a ":local" url or
-    // one that does not have a host component or if proxy is disabled.
-    QString protocol(url.scheme());
-    if (url.host().isEmpty() || KProtocolInfo::protocolClass(protocol) == QLatin1String(":local")
-        || KProtocolManager::proxyType() == KProtocolManager::NoProxy) {
-        return protocol;
-    }
-
-    const QString proxyCacheKey = extractProxyCacheKeyFromUrl(url);
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
+    return extractProxyCacheKeyFromUrl(url);
+}
 
+void KProtocolManagerPrivate::clearProxyCache()
+{
     KProtocolManagerPrivate *d = kProtocolManagerPrivate();
     QMutexLocker lock(&d->mutex);
-    // Look for cached proxy information to avoid more work.
-    if (d->cachedProxyData.contains(proxyCacheKey)) {
-        KProxyData *data = d->cachedProxyData.object(proxyCacheKey);
-        proxyList = data->proxyList;
-        return data->protocol;
-    }
-    lock.unlock();
+    d->cachedProxyData.clear();
+    ++d->proxyCacheGeneration;
+}
 
-    const QStringList proxies = KProtocolManagerPrivate::proxiesForUrl(url);
-    const int count = proxies.count();
+// Turns the proxies found for @p url into the worker protocol and the usable proxies.
+// The result is cached, unless the cache was cleared since the lookup started at @p generation.
+static QString cacheWorkerProtocol(const QUrl &url, const QStringList &proxies, QStringList &proxyList, quint64 generation)
+{
+    QString protocol(url.scheme());
+    proxyList.clear();
 
+    const int count = proxies.count();
     if (count > 0 && !(count == 1 && proxies.first() == QLatin1String("DIRECT"))) {
         for (const QString &proxy : proxies) {
             if (proxy == QLatin1String("DIRECT")) {
@@ -597,12 +691,131 @@ QString KProtocolManagerPrivate::workerProtocol(const QUrl &url, QStringList &pr
         }
     }
 
-    lock.relock();
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
     // cache the proxy information...
-    d->cachedProxyData.insert(proxyCacheKey, new KProxyData(protocol, proxyList));
+    if (d->proxyCacheGeneration == generation) {
+        d->cachedProxyData.insert(extractProxyCacheKeyFromUrl(url), new KProxyData(protocol, proxyList));
+    }
     return protocol;
 }
 
+bool KProtocolManagerPrivate::cachedWorkerProtocol(const QUrl &url, QString &protocol, QStringList &proxyList)
+{
+    proxyList.clear();
+    protocol = url.scheme();
+
+    // Do not perform a proxy lookup for any url classified as a ":local" url or
+    // one that does not have a host component or if proxy is disabled.
+    if (url.host().isEmpty() || KProtocolInfo::protocolClass(protocol) == QLatin1String(":local")
+        || KProtocolManager::proxyType() == KProtocolManager::NoProxy) {
+        return true;
+    }
+
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
+    // Look for cached proxy information to avoid more work.
+    if (const KProxyData *data = d->cachedProxyData.object(extractProxyCacheKeyFromUrl(url))) {
+        proxyList = data->proxyList;
+        protocol = data->protocol;
+        return true;
+    }
+
+    // Neither wait for a DNS lookup nor for proxyscout here
+    QHostAddress address;
+    if (d->needsHostLookup(url, address)) {
+        return false;
+    }
+    const ProxySource source = d->proxySource(url, address);
+    if (source == ProxySource::ProxyScout) {
+        return false;
+    }
+    const QStringList proxies = (source == ProxySource::Config) ? d->configuredProxiesFor(url) : QStringList();
+    const quint64 generation = d->proxyCacheGeneration;
+    lock.unlock();
+
+    protocol = cacheWorkerProtocol(url, proxies, proxyList, generation);
+    return true;
+}
+
+QString KProtocolManagerPrivate::workerProtocol(const QUrl &url, QStringList &proxyList)
+{
+    QString protocol;
+    if (cachedWorkerProtocol(url, protocol, proxyList)) {
+        return protocol;
+    }
+
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
+    const quint64 generation = d->proxyCacheGeneration;
+    lock.unlock();
+
+    // Blocks until the host is looked up and proxyscout answers
+    return cacheWorkerProtocol(url, KProtocolManagerPrivate::proxiesForUrl(url), proxyList, generation);
+}
+
+// Second half of lookupWorkerProtocol(), once the address of the host of @p url is known
+static void lookupProxies(const QUrl &url,
+                          const QHostAddress &address,
+                          QObject *context,
+                          const KProtocolManagerPrivate::WorkerProtocolCallback &callback,
+                          quint64 generation)
+{
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
+    const KProtocolManagerPrivate::ProxySource source = d->proxySource(url, address);
+    if (source != KProtocolManagerPrivate::ProxySource::ProxyScout) {
+        const QStringList proxies = (source == KProtocolManagerPrivate::ProxySource::Config) ? d->configuredProxiesFor(url) : QStringList();
+        lock.unlock();
+
+        QStringList proxyList;
+        const QString protocol = cacheWorkerProtocol(url, proxies, proxyList, generation);
+        callback(protocol, proxyList);
+        return;
+    }
+    lock.unlock();
+
+#ifndef KIO_ANDROID_STUB
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(proxyScoutRequest(url)), context);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished, context, [url, callback, generation](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        const QDBusPendingReply<QStringList> reply = *watcher;
+        QStringList proxies;
+        if (reply.isValid()) {
+            proxies = reply.value();
+        }
+
+        QStringList proxyList;
+        const QString protocol = cacheWorkerProtocol(url, proxies, proxyList, generation);
+        callback(protocol, proxyList);
+    });
+#else
+    Q_UNUSED(context);
+#endif
+}
+
+void KProtocolManagerPrivate::lookupWorkerProtocol(const QUrl &url, QObject *context, const WorkerProtocolCallback &callback)
+{
+    KProtocolManagerPrivate *d = kProtocolManagerPrivate();
+    QMutexLocker lock(&d->mutex);
+    const quint64 generation = d->proxyCacheGeneration;
+    QHostAddress address;
+    const bool needsHostLookup = d->needsHostLookup(url, address);
+    lock.unlock();
+
+    if (!needsHostLookup) {
+        lookupProxies(url, address, context, callback, generation);
+        return;
+    }
+
+    // The no proxy list has subnets, the proxies depend on the address of the host
+    QHostInfo::lookupHost(url.host(), context, [url, context, callback, generation](const QHostInfo &info) {
+        KIO::HostInfo::cacheLookup(info);
+        const QList<QHostAddress> addresses = info.addresses();
+        lookupProxies(url, addresses.isEmpty() ? QHostAddress() : addresses.first(), context, callback, generation);
+    });
+}
+
 /*================================= USER-AGENT SETTINGS =====================*/
 
 QString KProtocolManager::defaultUserAgent()
@@ -969,6 +1182,26 @@ bool KProtocolManager::supportsTruncating(const QUrl &url)
     return prot->m_supportsTruncating;
 }
 
+bool KProtocolManager::supportsMakePath(const QUrl &url)
+{
+    KProtocolInfoPrivate *prot = findProtocol(url);
+    if (!prot) {
+        return false;
+    }
+
+    return prot->m_supportsMakePath;
+}
+
+bool KProtocolManager::supportsListRecursive(const QUrl &url)
+{
+    KProtocolInfoPrivate *prot = findProtocol(url);
+    if (!prot) {
+        return false;
+    }
+
+    return prot->m_supportsListRecursive;
+}
+
 bool KProtocolManager::canCopyFromFile(const QUrl &url)
 {
     KProtocolInfoPrivate *prot = findProtocol(url);
@@ -342,6 +342,32 @@ public:
      */
     static bool supportsTruncating(const QUrl &url);
 
+    /**
+     * Returns whether the worker can create a directory and all its missing
+     * parents in one request, which is used by KIO::mkpath().
+     *
+     * This corresponds to the "makepath=" field in the protocol description file.
+     * Valid values for this field are "true" or "false" (default).
+     *
+     * @param url the url to check
+     * @return true if the protocol supports creating paths
+     * @since 6.0
+     */
+    static bool supportsMakePath(const QUrl &url);
+
+    /**
+     * Returns whether the worker can list a directory and all its subdirectories
+     * in one request, which is used by KIO::listRecursive().
+     *
+     * This corresponds to the "listrecursive=" field in the protocol description file.
+     * Valid values for this field are "true" or "false" (default).
+     *
+     * @param url the url to check
+     * @return true if the protocol supports recursive listing
+     * @since 6.0
+     */
+    static bool supportsListRecursive(const QUrl &url);
+
     /**
      * Returns whether the protocol can copy files/objects directly from the
      * filesystem itself. If not, the application will read files from the
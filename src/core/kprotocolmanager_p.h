@@ -22,6 +22,8 @@
 
 #include <KSharedConfig>
 
+#include <functional>
+
 #include "kprotocolmanager.h"
 
 class KProxyData : public QObject
@@ -48,12 +50,24 @@ class KIOCORE_EXPORT KProtocolManagerPrivate
 public:
     using SubnetPair = QPair<QHostAddress, int>;
 
+    // Where the proxies of a URL come from
+    enum class ProxySource {
+        None,
+        Config,
+        ProxyScout,
+    };
+
     KProtocolManagerPrivate();
     ~KProtocolManagerPrivate();
-    bool shouldIgnoreProxyFor(const QUrl &url);
+    bool needsHostLookup(const QUrl &url, QHostAddress &address);
+    bool shouldIgnoreProxyFor(const QUrl &url, const QHostAddress &address);
+    ProxySource proxySource(const QUrl &url, const QHostAddress &address);
+    QStringList configuredProxiesFor(const QUrl &url);
     void sync();
     KProtocolManager::ProxyType proxyType();
     bool useReverseProxy();
+    bool pathDependentProxyScript();
+    void readNoProxyList();
     QString readNoProxyFor();
     QString proxyFor(const QString &protocol);
     QStringList getSystemProxyFor(const QUrl &url);
@@ -65,7 +79,10 @@ public:
     QString useragent;
     QString noProxyFor;
     QList<SubnetPair> noProxySubnets;
+    bool noProxyListRead = false;
     QCache<QString, KProxyData> cachedProxyData;
+    // Bumped whenever cachedProxyData is cleared, so that lookups started before don't refill it
+    quint64 proxyCacheGeneration = 0;
 
     QMap<QString /*mimetype*/, QString /*protocol*/> protocolForArchiveMimetypes;
 
@@ -82,6 +99,35 @@ public:
      */
     static QString workerProtocol(const QUrl &url, QStringList &proxy);
 
+    /**
+     * Like workerProtocol(), but only if the answer is at hand, that is, if it needs neither
+     * asking proxyscout nor looking up the host for the subnets of the no proxy list.
+     * Returns false otherwise, see lookupWorkerProtocol().
+     */
+    static bool cachedWorkerProtocol(const QUrl &url, QString &protocol, QStringList &proxyList);
+
+    using WorkerProtocolCallback = std::function<void(const QString &protocol, const QStringList &proxyList)>;
+
+    /**
+     * Finds the proxies of @p url without blocking, looking up its host and asking proxyscout
+     * as needed, and calls @p callback with the worker protocol and the proxies once done,
+     * unless @p context is gone.
+     * The answer is cached like the one of workerProtocol().
+     */
+    static void lookupWorkerProtocol(const QUrl &url, QObject *context, const WorkerProtocolCallback &callback);
+
+    /**
+     * Returns the key under which the proxies of @p url are cached. It's the host of @p url,
+     * or the whole URL when the "PathDependentProxyScript" option is set for a PAC or WPAD script.
+     * URLs with the same key share a proxy lookup.
+     */
+    static QString proxyCacheKey(const QUrl &url);
+
+    /**
+     * Forgets the cached proxies, for instance because proxyscout reloaded its script.
+     */
+    static void clearProxyCache();
+
     /**
      * Returns all the possible proxy server addresses for @p url.
      *
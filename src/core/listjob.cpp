@@ -9,6 +9,8 @@
 #include "listjob.h"
 #include "../utils_p.h"
 #include "job_p.h"
+#include "kprotocolmanager.h"
+#include "scheduler.h"
 #include "worker_p.h"
 #include <QTimer>
 #include <kurlauthorized.h>
@@ -36,6 +38,10 @@ public:
     unsigned long m_processedEntries;
     QUrl m_redirectionURL;
 
+    // Sets the command and its arguments to list @p url: a top-level recursive listing
+    // is done by the worker itself when it supports it, see WorkerBase::listRecursive()
+    void setListUrl(const QUrl &url);
+
     /**
      * @internal
      * Called by the scheduler when a @p worker gets to
@@ -73,14 +79,26 @@ ListJob::ListJob(ListJobPrivate &dd)
     Q_D(ListJob);
     // We couldn't set the args when calling the parent constructor,
     // so do it now.
-    QDataStream stream(&d->m_packedArgs, QIODevice::WriteOnly);
-    stream << d->m_url;
+    d->setListUrl(d->m_url);
 }
 
 ListJob::~ListJob()
 {
 }
 
+void ListJobPrivate::setListUrl(const QUrl &url)
+{
+    m_packedArgs.truncate(0);
+    QDataStream stream(&m_packedArgs, QIODevice::WriteOnly);
+    stream << url;
+    if (recursive && m_prefix.isNull() && KProtocolManager::supportsListRecursive(url)) {
+        m_command = CMD_LISTDIR_RECURSIVE;
+        stream << qint8(includeHidden);
+    } else {
+        m_command = CMD_LISTDIR;
+    }
+}
+
 void ListJobPrivate::slotListEntries(const KIO::UDSEntryList &list)
 {
     Q_Q(ListJob);
@@ -88,6 +106,12 @@ void ListJobPrivate::slotListEntries(const KIO::UDSEntryList &list)
     m_processedEntries += list.count();
     slotProcessedSize(m_processedEntries);
 
+    if (m_command == CMD_LISTDIR_RECURSIVE) {
+        // The worker already sent relative names, without hidden files if requested
+        Q_EMIT q->entries(q, list);
+        return;
+    }
+
     if (recursive) {
         UDSEntryList::ConstIterator it = list.begin();
         const UDSEntryList::ConstIterator end = list.end();
@@ -220,15 +244,30 @@ void ListJob::slotFinished()
         }
 
         if (d->m_redirectionHandlingEnabled) {
-            d->m_packedArgs.truncate(0);
-            QDataStream stream(&d->m_packedArgs, QIODevice::WriteOnly);
-            stream << d->m_redirectionURL;
+            d->setListUrl(d->m_redirectionURL);
 
             d->restartAfterRedirection(&d->m_redirectionURL);
             return;
         }
     }
 
+    if (error() == ERR_UNSUPPORTED_ACTION && d->m_command == CMD_LISTDIR_RECURSIVE) {
+        // The worker can't list this directory recursively after all (e.g. the
+        // file worker for a remote host), list it again with a subjob per subdirectory
+        setError(0);
+        setErrorText(QString());
+        d->m_packedArgs.truncate(0);
+        QDataStream stream(&d->m_packedArgs, QIODevice::WriteOnly);
+        stream << d->m_url;
+        d->m_command = CMD_LISTDIR;
+
+        d->workerDone();
+        if ((d->m_extraFlags & JobPrivate::EF_KillCalled) == 0) {
+            Scheduler::doJob(this);
+        }
+        return;
+    }
+
     // Return worker to the scheduler
     SimpleJob::slotFinished();
 }
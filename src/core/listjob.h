@@ -115,6 +115,11 @@ KIOCORE_EXPORT ListJob *listDir(const QUrl &url, JobFlags flags = DefaultFlags,
  * "." and ".." are returned but only for the toplevel directory.
  * Filter them out if you don't want them.
  *
+ * If the worker supports it (see KProtocolManager::supportsListRecursive()),
+ * the whole tree is listed in a single worker request and subdirectories
+ * which can't be entered are skipped silently. Otherwise every subdirectory
+ * is listed separately, and ListJob::subError() is emitted for those which fail.
+ *
  * @param url the url of the directory
  * @param flags Can be HideProgressInfo here
  * @param includeHidden true for all files, false to cull out UNIX hidden
@@ -0,0 +1,475 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "mimetypecache_p.h"
+
+#ifndef KIO_ANDROID_STUB
+#include "kdirnotify.h"
+#endif
+
+#include <QCache>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLockFile>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUrl>
+
+#include <qplatformdefs.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace KIO;
+
+// The number of entries kept in memory
+static constexpr int s_maxMemoryEntries = 4096;
+// The number of entries kept on disk; when exceeded, the oldest quarter is dropped
+static constexpr int s_maxDiskEntries = 512;
+// Changes to the disk cache are written together, a little later
+static constexpr int s_saveDelay = 5000; // ms
+static constexpr quint32 s_diskCacheVersion = 2;
+
+static QString cacheKey(const QUrl &url)
+{
+    // Never write passwords to the disk
+    const QUrl canonicalUrl = url.adjusted(QUrl::RemovePassword | QUrl::StripTrailingSlash | QUrl::NormalizePathSegments);
+    return QString::fromLatin1(canonicalUrl.toEncoded());
+}
+
+static QString diskCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kio_mimetypes.cache");
+}
+
+// What stat() says about a local file beyond its size and the seconds of its modification
+// time, so that a file replaced or changed twice within a second isn't given its old type
+struct LocalFileStamp {
+    quint64 inode = 0;
+    qint64 mtimeNsecs = 0;
+    qint64 ctime = 0;
+    qint64 ctimeNsecs = 0;
+
+    bool operator==(const LocalFileStamp &other) const
+    {
+        return inode == other.inode && mtimeNsecs == other.mtimeNsecs && ctime == other.ctime && ctimeNsecs == other.ctimeNsecs;
+    }
+};
+
+static LocalFileStamp localFileStamp(const QUrl &url)
+{
+    LocalFileStamp stamp;
+    QT_STATBUF buff;
+    if (QT_STAT(QFile::encodeName(url.toLocalFile()).constData(), &buff) != 0) {
+        return stamp;
+    }
+    stamp.inode = quint64(buff.st_ino);
+    stamp.ctime = qint64(buff.st_ctime);
+#if defined(Q_OS_DARWIN)
+    stamp.mtimeNsecs = buff.st_mtimespec.tv_nsec;
+    stamp.ctimeNsecs = buff.st_ctimespec.tv_nsec;
+#elif defined(Q_OS_UNIX)
+    stamp.mtimeNsecs = buff.st_mtim.tv_nsec;
+    stamp.ctimeNsecs = buff.st_ctim.tv_nsec;
+#endif
+    return stamp;
+}
+
+////
+
+class KIO::MimeTypeCacheSingleton
+{
+public:
+    static void cleanupOnExit();
+
+    MimeTypeCache instance;
+};
+
+Q_GLOBAL_STATIC(MimeTypeCacheSingleton, s_instance)
+
+// Called while the application still exists, unlike the destructor of s_instance
+void MimeTypeCacheSingleton::cleanupOnExit()
+{
+    if (s_instance.exists()) {
+        s_instance->instance.aboutToExit();
+    }
+}
+
+class KIO::MimeTypeCachePrivate
+{
+public:
+    struct Entry {
+        KIO::filesize_t size;
+        qint64 mtime; // milliseconds since epoch, often whole seconds as in UDS_MODIFICATION_TIME
+        QString mimeType;
+        LocalFileStamp localStamp = {}; // local files only
+    };
+    struct DiskEntry {
+        Entry entry;
+        qint64 insertionTime;
+    };
+    using DiskCache = QHash<QString, DiskEntry>;
+
+    static void readDiskCache(DiskCache &cache);
+    static bool removeWithChildren(DiskCache &cache, const QString &key);
+    static void dropOldestEntries(DiskCache &cache);
+
+    void loadDiskCache();
+    void removeFromDisk(const QString &key);
+    void scheduleSave();
+
+    QMutex mutex; // protects all the member variables below
+    QCache<QString, Entry> memoryCache{s_maxMemoryEntries};
+    DiskCache diskCache; // the remote files, loaded on demand
+    // The changes since the last save, applied to what other processes saved meanwhile
+    QSet<QString> changedKeys;
+    QSet<QString> removedKeys; // with the keys below them
+    bool diskCacheLoaded = false;
+    bool diskCacheDirty = false;
+    QTimer *saveTimer = nullptr; // in the main thread
+    QObject *kdirnotify = nullptr;
+};
+
+void MimeTypeCachePrivate::readDiskCache(DiskCache &cache)
+{
+    QFile file(diskCachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> version >> count;
+    if (version != s_diskCacheVersion) {
+        return;
+    }
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString key;
+        DiskEntry diskEntry;
+        stream >> key >> diskEntry.entry.size >> diskEntry.entry.mtime >> diskEntry.entry.mimeType >> diskEntry.insertionTime;
+        cache.insert(key, diskEntry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        cache.clear();
+    }
+}
+
+bool MimeTypeCachePrivate::removeWithChildren(DiskCache &cache, const QString &key)
+{
+    bool changed = false;
+    for (auto it = cache.begin(); it != cache.end();) {
+        const QString &diskKey = it.key();
+        if (diskKey == key || (diskKey.startsWith(key) && diskKey.at(key.size()) == QLatin1Char('/'))) {
+            it = cache.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+void MimeTypeCachePrivate::dropOldestEntries(DiskCache &cache)
+{
+    if (cache.size() < s_maxDiskEntries) {
+        return;
+    }
+    std::vector<std::pair<qint64, QString>> entries; // time of insertion, key
+    entries.reserve(cache.size());
+    for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+        entries.emplace_back(it->insertionTime, it.key());
+    }
+    const auto oldestEnd = entries.begin() + (cache.size() - s_maxDiskEntries + s_maxDiskEntries / 4);
+    std::partial_sort(entries.begin(), oldestEnd, entries.end());
+    for (auto it = entries.begin(); it != oldestEnd; ++it) {
+        cache.remove(it->second);
+    }
+}
+
+void MimeTypeCachePrivate::loadDiskCache()
+{
+    Q_ASSERT(!mutex.tryLock());
+    if (diskCacheLoaded) {
+        return;
+    }
+    diskCacheLoaded = true;
+
+    // Written by KConfig before
+    QFile::remove(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/kio_mimetypes"));
+
+    readDiskCache(diskCache);
+}
+
+void MimeTypeCachePrivate::removeFromDisk(const QString &key)
+{
+    loadDiskCache();
+    if (removeWithChildren(diskCache, key)) {
+        changedKeys.removeIf([&key](const QString &changedKey) {
+            return changedKey == key || (changedKey.startsWith(key) && changedKey.at(key.size()) == QLatin1Char('/'));
+        });
+        removedKeys.insert(key);
+        scheduleSave();
+    }
+}
+
+void MimeTypeCachePrivate::scheduleSave()
+{
+    Q_ASSERT(!mutex.tryLock());
+    if (diskCacheDirty) {
+        return;
+    }
+    diskCacheDirty = true;
+    // Can be called from any thread. Without an application, the cache is saved on exit.
+    if (saveTimer) {
+        QMetaObject::invokeMethod(saveTimer, qOverload<>(&QTimer::start));
+    }
+}
+
+MimeTypeCache *MimeTypeCache::instance()
+{
+    return &s_instance()->instance;
+}
+
+MimeTypeCache::MimeTypeCache()
+    : d(new MimeTypeCachePrivate)
+{
+    // KFileItem can be used in any thread, but the KDirNotify signals must be received by the main thread
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        moveToThread(app->thread());
+        d->saveTimer = new QTimer(this);
+        d->saveTimer->setSingleShot(true);
+        d->saveTimer->setInterval(s_saveDelay);
+        connect(d->saveTimer, &QTimer::timeout, this, &MimeTypeCache::sync);
+        // Workers and other tools without a GUI can do without, the sizes and times catch changed files
+        if (app->inherits("QGuiApplication")) {
+            QMetaObject::invokeMethod(this, &MimeTypeCache::connectToKDirNotify);
+        }
+        qAddPostRoutine(MimeTypeCacheSingleton::cleanupOnExit);
+    }
+}
+
+MimeTypeCache::~MimeTypeCache()
+{
+    sync();
+}
+
+void MimeTypeCache::aboutToExit()
+{
+    sync();
+    QMutexLocker locker(&d->mutex);
+    delete d->kdirnotify;
+    d->kdirnotify = nullptr;
+    delete d->saveTimer;
+    d->saveTimer = nullptr;
+}
+
+void MimeTypeCache::followKDirNotify()
+{
+    if (QCoreApplication::instance()) {
+        QMetaObject::invokeMethod(this, &MimeTypeCache::connectToKDirNotify);
+    }
+}
+
+void MimeTypeCache::connectToKDirNotify()
+{
+#ifndef KIO_ANDROID_STUB
+    {
+        QMutexLocker locker(&d->mutex);
+        if (d->kdirnotify) {
+            return;
+        }
+    }
+    auto *kdirnotify = new org::kde::KDirNotify(QString(), QString(), QDBusConnection::sessionBus(), this);
+    auto removeUrls = [this](const QStringList &urls) {
+        for (const QString &url : urls) {
+            removeUrl(QUrl(url));
+        }
+    };
+    connect(kdirnotify, &org::kde::KDirNotify::FilesChanged, this, removeUrls);
+    connect(kdirnotify, &org::kde::KDirNotify::FilesRemoved, this, removeUrls);
+    connect(kdirnotify, &org::kde::KDirNotify::FilesRenamed, this, removeUrls);
+    // Some emitters only send the plain one
+    connect(kdirnotify, &org::kde::KDirNotify::FileRenamed, this, [this](const QString &src) {
+        removeUrl(QUrl(src));
+    });
+    connect(kdirnotify, &org::kde::KDirNotify::FileRenamedWithLocalPath, this, [this](const QString &src) {
+        removeUrl(QUrl(src));
+    });
+    connect(kdirnotify, &org::kde::KDirNotify::FileMoved, this, [this](const QString &src) {
+        removeUrl(QUrl(src));
+    });
+
+    QMutexLocker locker(&d->mutex);
+    d->kdirnotify = kdirnotify;
+#endif
+}
+
+QString MimeTypeCache::mimeTypeForUrl(const QUrl &url, KIO::filesize_t size, const QDateTime &mtime)
+{
+    if (!mtime.isValid()) {
+        return QString();
+    }
+    const QString key = cacheKey(url);
+    const qint64 mtimeMsecs = mtime.toMSecsSinceEpoch();
+    const bool isLocalFile = url.isLocalFile();
+    const LocalFileStamp localStamp = isLocalFile ? localFileStamp(url) : LocalFileStamp{};
+
+    QMutexLocker locker(&d->mutex);
+    if (const MimeTypeCachePrivate::Entry *entry = d->memoryCache.object(key)) {
+        if (entry->size == size && entry->mtime == mtimeMsecs && entry->localStamp == localStamp) {
+            return entry->mimeType;
+        }
+        return QString(); // the file changed, the disk cache can't have anything newer
+    }
+    if (isLocalFile) {
+        return QString();
+    }
+
+    d->loadDiskCache();
+    const auto it = d->diskCache.constFind(key);
+    if (it == d->diskCache.cend() || it->entry.size != size || it->entry.mtime != mtimeMsecs) {
+        return QString();
+    }
+    d->memoryCache.insert(key, new MimeTypeCachePrivate::Entry(it->entry));
+    return it->entry.mimeType;
+}
+
+void MimeTypeCache::setMimeTypeForUrl(const QUrl &url, KIO::filesize_t size, const QDateTime &mtime, const QString &mimeType)
+{
+    if (!mtime.isValid() || mimeType.isEmpty()) {
+        return;
+    }
+    const QString key = cacheKey(url);
+    const qint64 mtimeMsecs = mtime.toMSecsSinceEpoch();
+    const bool isLocalFile = url.isLocalFile();
+    const LocalFileStamp localStamp = isLocalFile ? localFileStamp(url) : LocalFileStamp{};
+
+    QMutexLocker locker(&d->mutex);
+    d->memoryCache.insert(key, new MimeTypeCachePrivate::Entry{size, mtimeMsecs, mimeType, localStamp});
+    if (isLocalFile) {
+        return; // sniffing local files again is cheap enough
+    }
+
+    d->loadDiskCache();
+    if (!d->diskCache.contains(key)) {
+        MimeTypeCachePrivate::dropOldestEntries(d->diskCache);
+    }
+    d->diskCache.insert(key, {{size, mtimeMsecs, mimeType}, QDateTime::currentSecsSinceEpoch()});
+    d->changedKeys.insert(key);
+    d->scheduleSave();
+}
+
+void MimeTypeCache::removeUrl(const QUrl &url)
+{
+    const QString key = cacheKey(url);
+    const QString childPrefix = key + QLatin1Char('/');
+
+    QMutexLocker locker(&d->mutex);
+    d->memoryCache.remove(key);
+    const QList<QString> keys = d->memoryCache.keys();
+    for (const QString &memoryKey : keys) {
+        if (memoryKey.startsWith(childPrefix)) {
+            d->memoryCache.remove(memoryKey);
+        }
+    }
+    if (!url.isLocalFile()) {
+        d->removeFromDisk(key);
+    }
+}
+
+void MimeTypeCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->memoryCache.clear();
+    d->diskCache.clear();
+    d->changedKeys.clear();
+    d->removedKeys.clear();
+    d->diskCacheLoaded = true;
+    d->diskCacheDirty = false;
+    QFile::remove(diskCachePath());
+}
+
+void MimeTypeCache::sync()
+{
+    QMutexLocker locker(&d->mutex);
+    if (!d->diskCacheDirty) {
+        return;
+    }
+    d->diskCacheDirty = false;
+    // A few hundred entries, cheaper to copy than to write while holding the mutex
+    MimeTypeCachePrivate::DiskCache changedEntries;
+    for (const QString &key : std::as_const(d->changedKeys)) {
+        changedEntries.insert(key, d->diskCache.value(key));
+    }
+    const QSet<QString> removedKeys = d->removedKeys;
+    d->changedKeys.clear();
+    d->removedKeys.clear();
+    locker.unlock();
+
+    // Other processes write the cache too: apply our changes to what they saved, one at a time
+    QDir().mkpath(QFileInfo(diskCachePath()).absolutePath());
+    QLockFile lockFile(diskCachePath() + QLatin1String(".lock"));
+    MimeTypeCachePrivate::DiskCache diskCache;
+    bool saved = false;
+    if (lockFile.tryLock(1000)) {
+        MimeTypeCachePrivate::readDiskCache(diskCache);
+        for (const QString &key : removedKeys) {
+            MimeTypeCachePrivate::removeWithChildren(diskCache, key);
+        }
+        for (auto it = changedEntries.cbegin(); it != changedEntries.cend(); ++it) {
+            if (!diskCache.contains(it.key())) {
+                MimeTypeCachePrivate::dropOldestEntries(diskCache);
+            }
+            diskCache.insert(it.key(), it.value());
+        }
+
+        QSaveFile file(diskCachePath());
+        if (file.open(QIODevice::WriteOnly)) {
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_6_0);
+            stream << s_diskCacheVersion << quint32(diskCache.size());
+            for (auto it = diskCache.cbegin(); it != diskCache.cend(); ++it) {
+                stream << it.key() << it->entry.size << it->entry.mtime << it->entry.mimeType << it->insertionTime;
+            }
+            saved = file.commit();
+        }
+        lockFile.unlock();
+    }
+
+    locker.relock();
+    if (!saved) {
+        // Try again with the next change, or on exit
+        for (auto it = changedEntries.cbegin(); it != changedEntries.cend(); ++it) {
+            if (!d->removedKeys.contains(it.key())) {
+                d->changedKeys.insert(it.key());
+            }
+        }
+        d->removedKeys.unite(removedKeys);
+        // Try again a little later, or on exit
+        d->scheduleSave();
+        return;
+    }
+    // What the other processes saved is ours too now, except for the changes made meanwhile
+    for (const QString &key : std::as_const(d->removedKeys)) {
+        MimeTypeCachePrivate::removeWithChildren(diskCache, key);
+    }
+    for (const QString &key : std::as_const(d->changedKeys)) {
+        diskCache.insert(key, d->diskCache.value(key));
+    }
+    d->diskCache = diskCache;
+}
+
+#include "moc_mimetypecache_p.cpp"
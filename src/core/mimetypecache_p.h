@@ -0,0 +1,80 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef MIMETYPECACHE_P_H
+#define MIMETYPECACHE_P_H
+
+#include "global.h"
+#include <kiocore_export.h>
+
+#include <QObject>
+
+#include <memory>
+
+class QDateTime;
+
+namespace KIO
+{
+class MimeTypeCachePrivate;
+class MimeTypeCacheSingleton;
+
+/**
+ * @internal
+ * Singleton remembering the MIME types determined from the content of files
+ * (memory + disk for remote files), so that they are not sniffed again.
+ *
+ * The entries are keyed by URL, size and modification time, a file which changed
+ * is therefore never given its old MIME type. For local files, the inode and the
+ * change time are compared too, with the nanoseconds where available. In GUI
+ * applications and those listing directories, entries are also removed when
+ * KDirNotify says files changed, got removed or renamed.
+ * The entries of remote files are written to the disk a few seconds after a change,
+ * all at once, and when the application exits. The changes are merged into what
+ * other processes saved meanwhile, under a lock file.
+ * Exported for KFilePreviewGenerator and the unit test.
+ */
+class KIOCORE_EXPORT MimeTypeCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MimeTypeCache *instance();
+
+    // Returns the MIME type name of the file at @p url, or an empty string if
+    // it's not in the cache or if @p size or @p mtime differ from the cached ones
+    QString mimeTypeForUrl(const QUrl &url, KIO::filesize_t size, const QDateTime &mtime);
+
+    // Remembers the MIME type of the file at @p url, with the given size and modification time
+    void setMimeTypeForUrl(const QUrl &url, KIO::filesize_t size, const QDateTime &mtime, const QString &mimeType);
+
+    // Forgets about @p url, and about the files below it
+    void removeUrl(const QUrl &url);
+
+    // Forgets everything, including the disk cache
+    void clear();
+
+    // Writes the pending changes to the disk cache now
+    void sync();
+
+    // Removes the entries KDirNotify signals are about, in applications without
+    // a GUI as well; called by KCoreDirLister
+    void followKDirNotify();
+
+private:
+    friend class MimeTypeCacheSingleton;
+    KIOCORE_NO_EXPORT MimeTypeCache();
+    KIOCORE_NO_EXPORT ~MimeTypeCache() override;
+
+    KIOCORE_NO_EXPORT void connectToKDirNotify();
+    KIOCORE_NO_EXPORT void aboutToExit();
+
+    std::unique_ptr<MimeTypeCachePrivate> const d;
+};
+
+}
+
+#endif // MIMETYPECACHE_P_H
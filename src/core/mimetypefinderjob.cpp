@@ -10,11 +10,13 @@
 #include "global.h"
 #include "job.h" // for buildErrorString
 #include "kiocoredebug.h"
+#include "mimetypecache_p.h"
 #include "statjob.h"
 
 #include <KLocalizedString>
 #include <KProtocolManager>
 
+#include <QDateTime>
 #include <QMimeDatabase>
 #include <QTimer>
 #include <QUrl>
@@ -36,6 +38,10 @@ public:
     KIO::MimeTypeFinderJob *const q;
     QString m_mimeTypeName;
     QString m_suggestedFileName;
+    // From the stat, to look up and store the MIME type in MimeTypeCache
+    KIO::filesize_t m_size = 0;
+    QDateTime m_mtime;
+    QUrl m_statUrl;
     bool m_followRedirections = true;
     bool m_authPrompts = true;
 };
@@ -165,14 +171,30 @@ void KIO::MimeTypeFinderJobPrivate::statFile()
         if (entry.isDir()) {
             m_mimeTypeName = QStringLiteral("inode/directory");
             q->emitResult();
-        } else { // It's a file
-            // Start the timer. Once we get the timer event this
-            // protocol server is back in the pool and we can reuse it.
-            // This gives better performance than starting a new worker
-            QTimer::singleShot(0, q, [this] {
-                scanFileWithGet();
-            });
+            return;
+        }
+
+        // Already determined from the content of the same version of the file?
+        m_size = entry.numberValue(KIO::UDSEntry::UDS_SIZE, 0);
+        const long long mtime = entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, -1);
+        if (mtime != -1) {
+            m_mtime = QDateTime::fromSecsSinceEpoch(mtime);
+            m_statUrl = m_url;
+            m_mimeTypeName = KIO::MimeTypeCache::instance()->mimeTypeForUrl(m_url, m_size, m_mtime);
+            if (!m_mimeTypeName.isEmpty()) {
+                qCDebug(KIO_CORE) << "MIME type of" << m_url << "found in the cache:" << m_mimeTypeName;
+                q->emitResult();
+                return;
+            }
         }
+
+        // It's a file
+        // Start the timer. Once we get the timer event this
+        // protocol server is back in the pool and we can reuse it.
+        // This gives better performance than starting a new worker
+        QTimer::singleShot(0, q, [this] {
+            scanFileWithGet();
+        });
     });
 }
 
@@ -245,6 +267,11 @@ void KIO::MimeTypeFinderJobPrivate::scanFileWithGet()
             m_suggestedFileName = job->queryMetaData(QStringLiteral("content-disposition-filename"));
         }
 
+        // Only files we stat'ed have a size and a modification time
+        if (m_mtime.isValid() && job->url() == m_statUrl) {
+            KIO::MimeTypeCache::instance()->setMimeTypeForUrl(m_statUrl, m_size, m_mtime, m_mimeTypeName);
+        }
+
         q->emitResult();
     });
 }
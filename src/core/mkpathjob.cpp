@@ -9,6 +9,7 @@
 #include "mkpathjob.h"
 #include "../utils_p.h"
 #include "job_p.h"
+#include "kprotocolmanager.h"
 #include "mkdirjob.h"
 
 #include <QFileInfo>
@@ -77,9 +78,12 @@ public:
     QStringList m_pathComponents;
     QStringList::const_iterator m_pathIterator;
     const JobFlags m_flags;
+    KIO::SimpleJob *m_mkpathJob = nullptr;
+    bool m_triedMkpath = false;
     Q_DECLARE_PUBLIC(MkpathJob)
 
     void slotStart();
+    void startMkpathJob();
 
     static inline MkpathJob *newJob(const QUrl &url, const QUrl &baseUrl, JobFlags flags)
     {
@@ -115,6 +119,12 @@ void MkpathJobPrivate::slotStart()
 
     if (m_pathIterator == m_pathComponents.constBegin()) { // first time: emit total
         q->setTotalAmount(KJob::Directories, m_pathComponents.count());
+
+        // Let the worker create the whole path in one request, if it can
+        if (!m_triedMkpath && !m_pathComponents.isEmpty() && KProtocolManager::supportsMakePath(m_url)) {
+            startMkpathJob();
+            return;
+        }
     }
 
     if (m_pathIterator != m_pathComponents.constEnd()) {
@@ -128,9 +138,47 @@ void MkpathJobPrivate::slotStart()
     }
 }
 
+void MkpathJobPrivate::startMkpathJob()
+{
+    Q_Q(MkpathJob);
+    m_triedMkpath = true;
+
+    QUrl url = m_url;
+    for (const QString &pathComponent : std::as_const(m_pathComponents)) {
+        url.setPath(Utils::concatPaths(url.path(), pathComponent));
+    }
+    KIO_ARGS << url << m_url;
+    m_mkpathJob = SimpleJobPrivate::newJobNoUi(url, CMD_MKPATH, packedArgs);
+    m_mkpathJob->setParentJob(q);
+    q->addSubjob(m_mkpathJob);
+}
+
 void MkpathJob::slotResult(KJob *job)
 {
     Q_D(MkpathJob);
+    if (job == d->m_mkpathJob) {
+        d->m_mkpathJob = nullptr;
+        if (job->error() == KIO::ERR_UNSUPPORTED_ACTION) {
+            // Create the directories one by one instead
+            removeSubjob(job);
+            d->slotStart();
+            return;
+        }
+        if (job->error()) {
+            KIO::Job::slotResult(job); // will set the error and emit result(this)
+            return;
+        }
+        removeSubjob(job);
+
+        for (; d->m_pathIterator != d->m_pathComponents.constEnd(); ++d->m_pathIterator) {
+            d->m_url.setPath(Utils::concatPaths(d->m_url.path(), *d->m_pathIterator));
+            Q_EMIT directoryCreated(d->m_url);
+        }
+        setProcessedAmount(KJob::Directories, d->m_pathComponents.count());
+        emitPercent(d->m_pathComponents.count(), d->m_pathComponents.count());
+        emitResult();
+        return;
+    }
     if (job->error() && job->error() != KIO::ERR_DIR_ALREADY_EXIST) {
         KIO::Job::slotResult(job); // will set the error and emit result(this)
         return;
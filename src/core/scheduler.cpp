@@ -25,6 +25,7 @@
 #include <QDBusMessage>
 #endif
 #include <QHash>
+#include <QPointer>
 #include <QThread>
 #include <QThreadStorage>
 
@@ -76,6 +77,8 @@ public:
     SessionData sessionData;
 
     void doJob(SimpleJob *job);
+    void queueJob(SimpleJob *job);
+    void proxiesFound(const QString &proxyCacheKey, const QString &protocol, const QStringList &proxyList);
     void setJobPriority(SimpleJob *job, int priority);
     void cancelJob(SimpleJob *job);
     void jobFinished(KIO::SimpleJob *job, KIO::Worker *worker);
@@ -97,12 +100,15 @@ public:
 
 #ifndef KIO_ANDROID_STUB
     void slotReparseSlaveConfiguration(const QString &, const QDBusMessage &);
+    void slotProxiesChanged();
 #endif
 
     ProtoQueue *protoQ(const QString &protocol, const QString &host);
 
 private:
     QHash<QString, ProtoQueue *> m_protocols;
+    // Jobs waiting for their proxies, by proxy cache key. One lookup serves them all.
+    QHash<QString, QList<QPointer<SimpleJob>>> m_jobsWaitingForProxies;
 };
 
 static QThreadStorage<SchedulerPrivate *> s_storage;
@@ -593,6 +599,12 @@ Scheduler::Scheduler()
                  QStringLiteral("reparseSlaveConfiguration"),
                  this,
                  SLOT(slotReparseSlaveConfiguration(QString, QDBusMessage)));
+    dbus.connect(QString(),
+                 QStringLiteral("/modules/proxyscout"),
+                 QStringLiteral("org.kde.KPAC.ProxyScout"),
+                 QStringLiteral("proxiesChanged"),
+                 this,
+                 SLOT(slotProxiesChanged()));
 #endif
 }
 
@@ -684,16 +696,51 @@ void SchedulerPrivate::slotReparseSlaveConfiguration(const QString &proto, const
         }
     }
 }
+
+void SchedulerPrivate::slotProxiesChanged()
+{
+    KProtocolManagerPrivate::clearProxyCache();
+}
 #endif
 
 void SchedulerPrivate::doJob(SimpleJob *job)
 {
     // qDebug() << job;
     KIO::SimpleJobPrivate *const jobPriv = SimpleJobPrivate::get(job);
-    jobPriv->m_proxyList.clear();
-    jobPriv->m_protocol = KProtocolManagerPrivate::workerProtocol(job->url(), jobPriv->m_proxyList);
+    if (KProtocolManagerPrivate::cachedWorkerProtocol(job->url(), jobPriv->m_protocol, jobPriv->m_proxyList)) {
+        queueJob(job);
+        return;
+    }
 
-    ProtoQueue *proto = protoQ(jobPriv->m_protocol, job->url().host());
+    // The proxies come from a PAC script or depend on the address of the host,
+    // don't block on proxyscout evaluating the script or on the DNS lookup
+    jobPriv->m_protocol.clear();
+    const QString proxyCacheKey = KProtocolManagerPrivate::proxyCacheKey(job->url());
+    QList<QPointer<SimpleJob>> &waitingJobs = m_jobsWaitingForProxies[proxyCacheKey];
+    waitingJobs.append(job);
+    if (waitingJobs.size() == 1) {
+        KProtocolManagerPrivate::lookupWorkerProtocol(job->url(), q, [this, proxyCacheKey](const QString &protocol, const QStringList &proxyList) {
+            proxiesFound(proxyCacheKey, protocol, proxyList);
+        });
+    }
+}
+
+void SchedulerPrivate::proxiesFound(const QString &proxyCacheKey, const QString &protocol, const QStringList &proxyList)
+{
+    const QList<QPointer<SimpleJob>> jobs = m_jobsWaitingForProxies.take(proxyCacheKey);
+    for (SimpleJob *job : jobs) {
+        if (job) {
+            KIO::SimpleJobPrivate *const jobPriv = SimpleJobPrivate::get(job);
+            jobPriv->m_protocol = protocol;
+            jobPriv->m_proxyList = proxyList;
+            queueJob(job);
+        }
+    }
+}
+
+void SchedulerPrivate::queueJob(SimpleJob *job)
+{
+    ProtoQueue *proto = protoQ(SimpleJobPrivate::get(job)->m_protocol, job->url().host());
     proto->queueJob(job);
 }
 
@@ -714,6 +761,10 @@ void SchedulerPrivate::cancelJob(SimpleJob *job)
     // much boilerplate in job code.
     if (jobPriv->m_schedSerial == 0) {
         // qDebug() << "Doing nothing because I don't know job" << job;
+        // It might still be waiting for its proxies though
+        for (auto it = m_jobsWaitingForProxies.begin(); it != m_jobsWaitingForProxies.end(); ++it) {
+            it->removeAll(job);
+        }
         return;
     }
     Worker *worker = jobSWorker(job);
@@ -125,6 +125,7 @@ private:
     // connected to D-Bus signal:
 #ifndef KIO_ANDROID_STUB
     Q_PRIVATE_SLOT(d_func(), void slotReparseSlaveConfiguration(const QString &, const QDBusMessage &))
+    Q_PRIVATE_SLOT(d_func(), void slotProxiesChanged())
 #endif
 
 private:
@@ -185,6 +185,7 @@ void SimpleJobPrivate::workerDone()
             m_worker->send(CMD_CLOSE);
         }
         q->disconnect(m_worker); // Remove all signals between worker and job
+        m_worker->setFlowControlled(false);
     }
     // only finish a job once; Scheduler::jobFinished() resets schedSerial to zero.
     if (m_schedSerial) {
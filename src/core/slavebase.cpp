@@ -22,10 +22,14 @@
 #include <QCoreApplication>
 #include <QDataStream>
 #include <QDateTime>
+#include <QDeadlineTimer>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
 #include <QMap>
+#include <QtEndian>
 #include <QtGlobal>
 
 #include <KConfig>
@@ -74,6 +78,9 @@ static void sigpipe_handler(int sig);
 
 using namespace KIO;
 
+// The application sends MSG_DATA to the worker through the same channel as the commands
+static_assert(CMD_MKPATH < MSG_DATA && CMD_RENAME_BATCH > MSG_DATA, "MSG_DATA must not be used as a command");
+
 typedef QList<QByteArray> AuthKeysList;
 typedef QMap<QString, QByteArray> AuthKeysMap;
 
@@ -139,6 +146,19 @@ public:
     enum { Idle, InsideMethod, InsideTimeoutSpecial, FinishedCalled, ErrorCalled } m_state;
     bool m_finalityCommand = true; // whether finished() or error() may/must be called
     QByteArray timeoutData;
+    // Whether the application limits the data it's ready to receive through data(),
+    // see TransferJob::setFlowControlWindow()
+    bool flowControlled = false;
+    qint64 dataCredit = 0; // can be negative, we don't split data
+
+    // Data pipes let FileCopyJob connect a get() and a put() worker directly.
+    // The data is sent in blocks preceded by their size, the end of data is a block of size 0.
+    QString dataPipeOut; // where data() sends the data, see "data-pipe-out" metadata
+    std::unique_ptr<QLocalSocket> dataPipeOutSocket;
+    std::unique_ptr<QLocalServer> dataPipeServer; // where readData() gets the data from, see "data-pipe-in"
+    std::unique_ptr<QLocalSocket> dataPipeInSocket;
+    bool dataPipeInUsed = false; // the application told us to read from the pipe (CMD_DATA_PIPE)
+    bool dataPipeInEnded = false;
 
 #ifndef KIO_ANDROID_STUB
     std::unique_ptr<KPasswdServerClient> m_passwdServerClient;
@@ -226,6 +246,11 @@ public:
                                             .arg(QCoreApplication::applicationName())));
     }
 
+    bool writeToDataPipe(const QByteArray &data);
+    void closeDataPipes(bool success);
+    int readFromDataPipe(QByteArray &buffer);
+    bool readFromDataPipe(char *data, qint64 size);
+
 #ifndef KIO_ANDROID_STUB
     KPasswdServerClient *passwdServerClient()
     {
@@ -240,6 +265,111 @@ public:
 
 }
 
+bool SlaveBasePrivate::writeToDataPipe(const QByteArray &data)
+{
+    if (!dataPipeOutSocket) {
+        dataPipeOutSocket = std::make_unique<QLocalSocket>();
+        dataPipeOutSocket->connectToServer(dataPipeOut);
+        if (!dataPipeOutSocket->waitForConnected(30000)) {
+            qCWarning(KIO_CORE) << "Couldn't connect to data pipe" << dataPipeOut << dataPipeOutSocket->errorString();
+            return false;
+        }
+    }
+    if (dataPipeOutSocket->state() != QLocalSocket::ConnectedState) {
+        return false;
+    }
+
+    const qint32 size = qToBigEndian<qint32>(data.size());
+    dataPipeOutSocket->write(reinterpret_cast<const char *>(&size), sizeof(size));
+    dataPipeOutSocket->write(data);
+    // Blocking here until the other worker read the data is what paces us
+    while (dataPipeOutSocket->bytesToWrite() > 0) {
+        if (!dataPipeOutSocket->waitForBytesWritten(1000) && (wasKilled || dataPipeOutSocket->state() != QLocalSocket::ConnectedState)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SlaveBasePrivate::closeDataPipes(bool success)
+{
+    if (!dataPipeOut.isEmpty() && success) {
+        // Always connect, even if we had no data, so that the other worker doesn't wait forever
+        writeToDataPipe(QByteArray());
+    }
+    if (dataPipeOutSocket) {
+        dataPipeOutSocket->disconnectFromServer();
+    }
+    dataPipeOut.clear();
+    dataPipeOutSocket.reset();
+
+    dataPipeInSocket.reset();
+    dataPipeServer.reset();
+    dataPipeInUsed = false;
+    dataPipeInEnded = false;
+}
+
+int SlaveBasePrivate::readFromDataPipe(QByteArray &buffer)
+{
+    buffer.clear();
+    if (dataPipeInEnded) {
+        return 0;
+    }
+    if (!dataPipeServer) {
+        return -1;
+    }
+    if (!dataPipeInSocket) {
+        // The other worker connects with its first data, which it gets within its own response
+        // timeout: don't wait longer than that for it, e.g. if it failed before connecting
+        const QDeadlineTimer deadline(std::chrono::seconds(q->responseTimeout()));
+        while (!dataPipeServer->hasPendingConnections()) {
+            if (wasKilled || deadline.hasExpired()) {
+                qCWarning(KIO_CORE) << "Nothing connected to data pipe" << dataPipeServer->fullServerName();
+                return -1;
+            }
+            // Woken up by the connection, checks whether we were killed every second
+            dataPipeServer->waitForNewConnection(int(qMin<qint64>(1000, deadline.remainingTime())));
+        }
+        dataPipeInSocket.reset(dataPipeServer->nextPendingConnection());
+        dataPipeInSocket->setParent(nullptr);
+    }
+
+    qint32 size;
+    if (!readFromDataPipe(reinterpret_cast<char *>(&size), sizeof(size))) {
+        return -1;
+    }
+    size = qFromBigEndian(size);
+    if (size == 0) {
+        dataPipeInEnded = true;
+        return 0;
+    }
+    buffer.resize(size);
+    if (size < 0 || !readFromDataPipe(buffer.data(), size)) {
+        buffer.clear();
+        return -1;
+    }
+    return size;
+}
+
+bool SlaveBasePrivate::readFromDataPipe(char *data, qint64 size)
+{
+    qint64 read = 0;
+    while (read < size) {
+        const qint64 n = dataPipeInSocket->read(data + read, size - read);
+        if (n < 0) {
+            return false;
+        }
+        read += n;
+        if (read < size && !dataPipeInSocket->waitForReadyRead(1000)) {
+            // The other worker failed if it left without sending the end of data
+            if (wasKilled || (dataPipeInSocket->state() != QLocalSocket::ConnectedState && dataPipeInSocket->bytesAvailable() == 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 static volatile bool slaveWriteError = false;
 
 #ifdef Q_OS_UNIX
@@ -491,7 +621,33 @@ KRemoteEncoding *SlaveBase::remoteEncoding()
 
 void SlaveBase::data(const QByteArray &data)
 {
+    if (!d->dataPipeOut.isEmpty() && data.isEmpty()) {
+        return; // the end of data is sent by finished()
+    }
+
+    // With flow control, block until the application consumed enough of the data sent so far
+    while (d->flowControlled && d->dataCredit <= 0 && !data.isEmpty()) {
+        QByteArray buffer;
+        if (waitForAnswer(CMD_DATA_CREDIT, 0, buffer) == -1) {
+            d->flowControlled = false;
+            break;
+        }
+        dispatch(CMD_DATA_CREDIT, buffer);
+    }
+    d->dataCredit -= data.size();
+
     sendMetaData();
+    if (!d->dataPipeOut.isEmpty()) {
+        if (d->writeToDataPipe(data)) {
+            // The application only needs to know how much data went through
+            QByteArray size;
+            QDataStream(&size, QIODevice::WriteOnly) << qint64(data.size());
+            send(MSG_DATA_PIPED, size);
+            return;
+        }
+        // Let the application know, it will abort the transfer
+        d->closeDataPipes(false);
+    }
     send(MSG_DATA, data);
 }
 
@@ -501,6 +657,9 @@ void SlaveBase::dataReq()
     if (d->needSendCanResume) {
         canResume(0);
     }
+    if (d->dataPipeInUsed) {
+        return; // readData() gets the data from the other worker
+    }
     send(MSG_DATA_REQ);
 }
 
@@ -538,6 +697,8 @@ void SlaveBase::error(int _errid, const QString &_text)
 
     d->m_state = d->ErrorCalled;
     mIncomingMetaData.clear(); // Clear meta data
+    d->flowControlled = false;
+    d->closeDataPipes(false);
     d->rebuildConfig();
     mOutgoingMetaData.clear();
     KIO_DATA << static_cast<qint32>(_errid) << _text;
@@ -598,6 +759,8 @@ void SlaveBase::finished()
 
     d->m_state = d->FinishedCalled;
     mIncomingMetaData.clear(); // Clear meta data
+    d->flowControlled = false;
+    d->closeDataPipes(true);
     d->rebuildConfig();
     sendMetaData();
     send(MSG_FINISHED);
@@ -686,6 +849,9 @@ void SlaveBase::speed(unsigned long _bytes_per_second)
 
 void SlaveBase::redirection(const QUrl &_url)
 {
+    // The job will restart on the new URL, and connect to the data pipe from there
+    d->closeDataPipes(false);
+
     KIO_DATA << _url;
     send(INF_REDIRECTION, data);
 }
@@ -701,7 +867,8 @@ static bool isSubCommand(int cmd)
     return cmd == CMD_REPARSECONFIGURATION
         || cmd == CMD_META_DATA
         || cmd == CMD_CONFIG
-        || cmd == CMD_WORKER_STATUS;
+        || cmd == CMD_WORKER_STATUS
+        || cmd == CMD_DATA_CREDIT;
     /* clang-format on */
 }
 
@@ -1076,9 +1243,16 @@ int SlaveBase::waitForAnswer(int expected1, int expected2, QByteArray &data, int
 
 int SlaveBase::readData(QByteArray &buffer)
 {
-    int result = waitForAnswer(MSG_DATA, 0, buffer);
-    // qDebug() << "readData: length = " << result << " ";
-    return result;
+    if (!d->dataPipeInUsed) {
+        int cmd = 0;
+        int result = waitForAnswer(MSG_DATA, CMD_DATA_PIPE, buffer, &cmd);
+        // qDebug() << "readData: length = " << result << " ";
+        if (cmd != CMD_DATA_PIPE) {
+            return result;
+        }
+        d->dataPipeInUsed = true;
+    }
+    return d->readFromDataPipe(buffer);
 }
 
 void SlaveBase::setTimeoutSpecialCommand(int timeout, const QByteArray &data)
@@ -1310,6 +1484,33 @@ void SlaveBase::dispatch(int command, const QByteArray &data)
         // qDebug() << "(" << getpid() << ") Incoming meta-data...";
         stream >> mIncomingMetaData;
         d->rebuildConfig();
+        if (const auto it = mIncomingMetaData.constFind(QStringLiteral("flow-control-window")); it != mIncomingMetaData.cend()) {
+            d->flowControlled = true;
+            d->dataCredit = qMax<qint64>(1, it.value().toLongLong());
+        }
+        if (const auto it = mIncomingMetaData.constFind(QStringLiteral("data-pipe-out")); it != mIncomingMetaData.cend()) {
+            d->dataPipeOut = it.value();
+        }
+        if (const auto it = mIncomingMetaData.constFind(QStringLiteral("data-pipe-in")); it != mIncomingMetaData.cend()) {
+            // Listen right away: the application starts the other worker once we asked for data
+            d->dataPipeServer = std::make_unique<QLocalServer>();
+            if (!d->dataPipeServer->listen(it.value())) {
+                qCWarning(KIO_CORE) << "Couldn't listen on data pipe" << it.value() << d->dataPipeServer->errorString();
+                d->dataPipeServer.reset();
+            }
+        }
+        break;
+    }
+    case CMD_DATA_CREDIT: {
+        qint64 credit;
+        qint8 reset;
+        stream >> credit >> reset;
+        if (reset) {
+            d->flowControlled = credit >= 0;
+            d->dataCredit = credit;
+        } else if (d->flowControlled) { // otherwise it's late credit for a previous command
+            d->dataCredit += credit;
+        }
         break;
     }
     case CMD_NONE: {
@@ -1327,6 +1528,69 @@ void SlaveBase::dispatch(int command, const QByteArray &data)
         d->m_state = d->Idle;
         break;
     }
+    case CMD_DIRECTORYSIZE: {
+        stream >> url;
+
+        void *data = static_cast<void *>(&url);
+
+        d->m_state = d->InsideMethod;
+        virtual_hook(DirectorySize, data);
+        d->verifyState("directorySize()");
+        d->m_state = d->Idle;
+        break;
+    }
+    case CMD_CHMOD_RECURSIVE: {
+        ChmodRecursiveArgs args;
+        stream >> args.url >> args.permissions >> args.mask >> args.owner >> args.group;
+
+        void *data = static_cast<void *>(&args);
+
+        d->m_state = d->InsideMethod;
+        virtual_hook(ChmodRecursive, data);
+        d->verifyState("chmodRecursive()");
+        d->m_state = d->Idle;
+        break;
+    }
+    case CMD_MKPATH: {
+        MkpathArgs args;
+        stream >> args.url >> args.baseUrl;
+
+        void *data = static_cast<void *>(&args);
+
+        d->m_state = d->InsideMethod;
+        virtual_hook(Mkpath, data);
+        d->verifyState("mkpath()");
+        d->m_state = d->Idle;
+        break;
+    }
+    case CMD_RENAME_BATCH: {
+        RenameBatchArgs args;
+        qint8 iOverwrite;
+        stream >> args.srcUrls >> args.destUrls >> iOverwrite;
+        args.overwrite = (iOverwrite != 0);
+
+        void *data = static_cast<void *>(&args);
+
+        d->m_state = d->InsideMethod;
+        virtual_hook(RenameBatch, data);
+        d->verifyState("renameBatch()");
+        d->m_state = d->Idle;
+        break;
+    }
+    case CMD_LISTDIR_RECURSIVE: {
+        ListRecursiveArgs args;
+        qint8 iIncludeHidden;
+        stream >> args.url >> iIncludeHidden;
+        args.includeHidden = (iIncludeHidden != 0);
+
+        void *data = static_cast<void *>(&args);
+
+        d->m_state = d->InsideMethod;
+        virtual_hook(ListRecursive, data);
+        d->verifyState("listRecursive()");
+        d->m_state = d->Idle;
+        break;
+    }
     default: {
         // Some command we don't understand.
         // Just ignore it, it may come from some future version of KIO.
@@ -1480,6 +1744,26 @@ void SlaveBase::virtual_hook(int id, void *data)
         error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_TRUNCATE));
         break;
     }
+    case DirectorySize: {
+        error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_DIRECTORYSIZE));
+        break;
+    }
+    case ChmodRecursive: {
+        error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_CHMOD_RECURSIVE));
+        break;
+    }
+    case Mkpath: {
+        error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_MKPATH));
+        break;
+    }
+    case RenameBatch: {
+        error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_RENAME_BATCH));
+        break;
+    }
+    case ListRecursive: {
+        error(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), CMD_LISTDIR_RECURSIVE));
+        break;
+    }
     }
 }
 
@@ -941,6 +941,11 @@ protected:
         AppConnectionMade = 0,
         GetFileSystemFreeSpace = 1, // KF6 TODO: Turn into a virtual method
         Truncate = 2, // KF6 TODO: Turn into a virtual method
+        DirectorySize = 3,
+        ChmodRecursive = 4,
+        Mkpath = 5,
+        RenameBatch = 6,
+        ListRecursive = 7,
     };
     virtual void virtual_hook(int id, void *data);
 
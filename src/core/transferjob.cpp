@@ -45,9 +45,13 @@ void TransferJob::slotData(const QByteArray &_data)
     // shut up the warning, HACK: downside is that it changes the meaning of the variable
     d->m_isMimetypeEmitted = true;
 
-    if (d->m_redirectionURL.isEmpty() || !d->m_redirectionURL.isValid() || error()) {
+    const bool emitData = d->m_redirectionURL.isEmpty() || !d->m_redirectionURL.isValid() || error();
+    if (emitData) {
         Q_EMIT data(this, _data);
     }
+    if (!emitData || !d->m_manualDataAcknowledgement) {
+        d->grantCredit(_data.size());
+    }
 }
 
 void KIO::TransferJob::setTotalSize(KIO::filesize_t bytes)
@@ -184,6 +188,31 @@ void TransferJob::sendAsyncData(const QByteArray &dataForWorker)
     d->m_extraFlags &= ~JobPrivate::EF_TransferJobNeedData;
 }
 
+void TransferJob::setFlowControlWindow(qint64 bytes)
+{
+    Q_D(TransferJob);
+    d->m_flowControlWindow = qMax<qint64>(0, bytes);
+}
+
+qint64 TransferJob::flowControlWindow() const
+{
+    return d_func()->m_flowControlWindow;
+}
+
+void TransferJob::setManualDataAcknowledgementEnabled(bool enabled)
+{
+    Q_D(TransferJob);
+    d->m_manualDataAcknowledgement = enabled;
+}
+
+void TransferJob::acknowledgeData(qint64 bytes)
+{
+    Q_D(TransferJob);
+    if (d->m_manualDataAcknowledgement) {
+        d->grantCredit(bytes);
+    }
+}
+
 QString TransferJob::mimetype() const
 {
     return d_func()->m_mimetype;
@@ -251,6 +280,21 @@ void TransferJobPrivate::internalResume()
     }
 }
 
+void TransferJobPrivate::grantCredit(qint64 bytes)
+{
+    if (m_flowControlWindow <= 0 || !m_worker) {
+        return;
+    }
+    m_unsentCredit += bytes;
+    // Don't send a command for each block of data. The worker waits only after
+    // sending a whole window, so this can't stall it.
+    if (m_unsentCredit >= m_flowControlWindow / 4) {
+        KIO_ARGS << m_unsentCredit << qint8(false);
+        m_worker->send(CMD_DATA_CREDIT, packedArgs);
+        m_unsentCredit = 0;
+    }
+}
+
 bool TransferJob::doResume()
 {
     Q_D(TransferJob);
@@ -274,6 +318,10 @@ void TransferJobPrivate::start(Worker *worker)
     Q_ASSERT(worker);
     JobPrivate::emitTransferring(q, m_url);
     q->connect(worker, &WorkerInterface::data, q, &TransferJob::slotData);
+    // The data went to another worker, see FileCopyJob
+    q->connect(worker, &WorkerInterface::dataPiped, q, [this](qint64 size) {
+        grantCredit(size);
+    });
 
     if (m_outgoingDataSource) {
         if (m_extraFlags & JobPrivate::EF_TransferJobAsync) {
@@ -316,10 +364,23 @@ void TransferJobPrivate::start(Worker *worker)
 
     if (worker->suspended()) {
         m_mimetype = QStringLiteral("unknown");
+        // The flow control of the job which put the worker on hold doesn't apply to us
+        KIO_ARGS << qint64(-1) << qint8(true);
+        worker->send(CMD_DATA_CREDIT, packedArgs);
         // WABA: The worker was put on hold. Resume operation.
         worker->resume();
     }
 
+    // The worker reads the window along with the command, so that credit
+    // granted by a previous job can't apply to this one
+    m_unsentCredit = 0;
+    if (m_flowControlWindow > 0) {
+        m_outgoingMetaData.insert(QStringLiteral("flow-control-window"), QString::number(m_flowControlWindow));
+    } else {
+        m_outgoingMetaData.remove(QStringLiteral("flow-control-window"));
+    }
+    worker->setFlowControlled(m_flowControlWindow > 0);
+
     SimpleJobPrivate::start(worker);
     if (m_internalSuspended) {
         worker->suspend();
@@ -20,7 +20,10 @@ class TransferJobPrivate;
  * The transfer job pumps data into and/or out of a KIO worker.
  * Data is sent to the worker on request of the worker ( dataReq).
  * If data coming from the worker can not be handled, the
- * reading of data from the worker should be suspended.
+ * reading of data from the worker should be suspended, or limited
+ * using setFlowControlWindow().
+ *
+ * See KIO::TransferJobDevice to read the data through the QIODevice API.
  */
 class KIOCORE_EXPORT TransferJob : public SimpleJob
 {
@@ -81,6 +84,44 @@ public:
      */
     void setTotalSize(KIO::filesize_t bytes);
 
+    /**
+     * Enables flow control for the data sent by the worker: the worker sends
+     * at most @p bytes (plus one block of data) ahead of the data that was
+     * acknowledged, and then waits. By default, data is acknowledged once the
+     * data() signal was emitted, see setManualDataAcknowledgementEnabled().
+     *
+     * This bounds the memory used by a transfer, without having to suspend
+     * and resume the job. It must be called before the job is started,
+     * i.e. right after creating it.
+     *
+     * @param bytes the size of the window, 0 (the default) disables flow control
+     * @since 6.0
+     */
+    void setFlowControlWindow(qint64 bytes);
+
+    /**
+     * @return the size of the flow control window, 0 if flow control is disabled
+     * @since 6.0
+     */
+    qint64 flowControlWindow() const;
+
+    /**
+     * Enable the manual acknowledgement of data, with flow control enabled.
+     * Data received through the data() signal should then be acknowledged by
+     * calling acknowledgeData() once it has been processed, so that the worker
+     * doesn't get more than the flow control window ahead of the consumer.
+     * @since 6.0
+     */
+    void setManualDataAcknowledgementEnabled(bool enabled);
+
+    /**
+     * Acknowledges @p bytes of data received through the data() signal,
+     * when manual acknowledgement is enabled.
+     * @see setManualDataAcknowledgementEnabled()
+     * @since 6.0
+     */
+    void acknowledgeData(qint64 bytes);
+
 protected:
     /**
      * Reimplemented for internal reasons
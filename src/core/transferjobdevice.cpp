@@ -0,0 +1,185 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "transferjobdevice.h"
+
+#include "transferjob.h"
+
+#include <QEventLoop>
+#include <QPointer>
+#include <QTimer>
+
+#include <cstring>
+#include <deque>
+
+using namespace KIO;
+
+class KIO::TransferJobDevicePrivate
+{
+public:
+    TransferJobDevicePrivate(TransferJob *job, qint64 bufferSize)
+        : m_job(job)
+        , m_bufferSize(bufferSize)
+    {
+    }
+
+    QPointer<TransferJob> m_job;
+    const qint64 m_bufferSize;
+    std::deque<QByteArray> m_chunks; // received but not read yet
+    qsizetype m_chunkOffset = 0; // already read from m_chunks.front()
+    qint64 m_buffered = 0;
+    QEventLoop *m_eventLoop = nullptr;
+    bool m_finished = false;
+};
+
+TransferJobDevice::TransferJobDevice(TransferJob *job, qint64 bufferSize, QObject *parent)
+    : QIODevice(parent)
+    , d(new TransferJobDevicePrivate(job, qMax<qint64>(1, bufferSize)))
+{
+    job->setFlowControlWindow(d->m_bufferSize);
+    job->setManualDataAcknowledgementEnabled(true);
+    // Keep the job after its result, to report its error
+    job->setAutoDelete(false);
+
+    connect(job, &TransferJob::data, this, [this](KIO::Job *, const QByteArray &data) {
+        if (data.isEmpty()) {
+            return;
+        }
+        d->m_chunks.push_back(data);
+        d->m_buffered += data.size();
+        if (d->m_eventLoop) {
+            d->m_eventLoop->quit();
+        }
+        Q_EMIT readyRead();
+    });
+    connect(job, &KJob::result, this, [this](KJob *job) {
+        d->m_finished = true;
+        if (job->error()) {
+            setErrorString(job->errorString());
+        }
+        if (d->m_eventLoop) {
+            d->m_eventLoop->quit();
+        }
+        Q_EMIT readChannelFinished();
+    });
+}
+
+TransferJobDevice::~TransferJobDevice()
+{
+    if (d->m_job) {
+        if (!d->m_finished) {
+            d->m_job->kill(KJob::Quietly);
+        }
+        delete d->m_job;
+    }
+}
+
+TransferJob *TransferJobDevice::job() const
+{
+    return d->m_job;
+}
+
+qint64 TransferJobDevice::bufferSize() const
+{
+    return d->m_bufferSize;
+}
+
+bool TransferJobDevice::isFinished() const
+{
+    return d->m_finished;
+}
+
+bool TransferJobDevice::open(OpenMode mode)
+{
+    if ((mode & ReadWrite) != ReadOnly) {
+        return false;
+    }
+    // We buffer the data already
+    return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void TransferJobDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    QIODevice::close();
+    if (d->m_job && !d->m_finished) {
+        d->m_job->kill(KJob::Quietly);
+        d->m_finished = true;
+    }
+    d->m_chunks.clear();
+    d->m_chunkOffset = 0;
+    d->m_buffered = 0;
+}
+
+bool TransferJobDevice::isSequential() const
+{
+    return true;
+}
+
+bool TransferJobDevice::atEnd() const
+{
+    return d->m_finished && d->m_buffered == 0 && QIODevice::atEnd();
+}
+
+qint64 TransferJobDevice::bytesAvailable() const
+{
+    return d->m_buffered + QIODevice::bytesAvailable();
+}
+
+bool TransferJobDevice::waitForReadyRead(int msecs)
+{
+    if (d->m_buffered == 0 && !d->m_finished && isOpen()) {
+        QEventLoop eventLoop;
+        if (msecs >= 0) {
+            QTimer::singleShot(msecs, &eventLoop, &QEventLoop::quit);
+        }
+        d->m_eventLoop = &eventLoop;
+        eventLoop.exec(QEventLoop::ExcludeUserInputEvents);
+        d->m_eventLoop = nullptr;
+    }
+    return d->m_buffered > 0;
+}
+
+qint64 TransferJobDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 read = 0;
+    while (read < maxSize && !d->m_chunks.empty()) {
+        const QByteArray &chunk = d->m_chunks.front();
+        const qint64 size = qMin<qint64>(maxSize - read, chunk.size() - d->m_chunkOffset);
+        memcpy(data + read, chunk.constData() + d->m_chunkOffset, size);
+        read += size;
+        d->m_chunkOffset += size;
+        if (d->m_chunkOffset == chunk.size()) {
+            d->m_chunks.pop_front();
+            d->m_chunkOffset = 0;
+        }
+    }
+    d->m_buffered -= read;
+
+    if (read > 0) {
+        // Let the worker send more data
+        if (d->m_job && !d->m_finished) {
+            d->m_job->acknowledgeData(read);
+        }
+        return read;
+    }
+    if (d->m_finished) {
+        return -1; // end of data, or error
+    }
+    return 0;
+}
+
+qint64 TransferJobDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+
+#include "moc_transferjobdevice.cpp"
@@ -0,0 +1,110 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KIO_TRANSFERJOBDEVICE_H
+#define KIO_TRANSFERJOBDEVICE_H
+
+#include "kiocore_export.h"
+
+#include <QIODevice>
+
+#include <memory>
+
+namespace KIO
+{
+class TransferJob;
+class TransferJobDevicePrivate;
+
+/**
+ * @class KIO::TransferJobDevice transferjobdevice.h <KIO/TransferJobDevice>
+ *
+ * A sequential, read-only QIODevice streaming the data of a KIO::TransferJob,
+ * typically created by KIO::get().
+ *
+ * The device enables flow control on the job (see TransferJob::setFlowControlWindow()),
+ * acknowledging the data as it is read from the device: the worker never gets
+ * more than bufferSize() bytes ahead of the reader, so that large downloads
+ * use a constant amount of memory.
+ *
+ * The readyRead() signal is emitted when data arrives, and readChannelFinished()
+ * once the job is done. waitForReadyRead() allows blocking reads.
+ *
+ * @code
+ * KIO::TransferJobDevice device(KIO::get(url, KIO::NoReload, KIO::HideProgressInfo));
+ * device.open(QIODevice::ReadOnly);
+ * while (device.waitForReadyRead(-1)) {
+ *     process(device.readAll());
+ * }
+ * if (device.job()->error()) {
+ *     ...
+ * }
+ * @endcode
+ *
+ * @since 6.0
+ */
+class KIOCORE_EXPORT TransferJobDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates a device for @p job, which must not have been started yet:
+     * create the device right after creating the job.
+     * The device takes ownership of the job.
+     * @param bufferSize the maximum amount of data buffered ahead of the reader
+     */
+    explicit TransferJobDevice(TransferJob *job, qint64 bufferSize = 1024 * 1024, QObject *parent = nullptr);
+
+    ~TransferJobDevice() override;
+
+    /**
+     * @return the job used by this device
+     */
+    TransferJob *job() const;
+
+    /**
+     * @return the maximum amount of data buffered ahead of the reader
+     */
+    qint64 bufferSize() const;
+
+    /**
+     * @return whether the job finished, successfully or not
+     */
+    bool isFinished() const;
+
+    /**
+     * Opens the device; only QIODevice::ReadOnly is supported.
+     */
+    bool open(OpenMode mode) override;
+
+    /**
+     * Closes the device, and kills the job if it's still running.
+     */
+    void close() override;
+
+    bool isSequential() const override;
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+
+    /**
+     * Runs a local event loop until data arrived, the job finished or
+     * @p msecs milliseconds elapsed (-1 waits without a timeout).
+     * @return true if data is available
+     */
+    bool waitForReadyRead(int msecs) override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    std::unique_ptr<TransferJobDevicePrivate> const d;
+};
+
+} // namespace KIO
+
+#endif
@@ -249,6 +249,11 @@ bool Worker::suspended()
     return m_connection->suspended();
 }
 
+void Worker::setFlowControlled(bool flowControlled)
+{
+    m_connection->setFlowControlled(flowControlled);
+}
+
 void Worker::send(int cmd, const QByteArray &arr)
 {
     m_connection->send(cmd, arr);
@@ -112,6 +112,12 @@ public:
      */
     virtual bool suspended();
 
+    /**
+     * Sets whether the attached kioworker waits for credit before sending data,
+     * which makes suspending it cheaper. See Connection::setFlowControlled().
+     */
+    void setFlowControlled(bool flowControlled);
+
     // == end communication with connected kioworker ==
 private:
     friend class Scheduler;
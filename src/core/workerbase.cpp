@@ -9,6 +9,7 @@
 
 #include "workerbase.h"
 #include "workerbase_p.h"
+#include "../utils_p.h"
 
 #include <commands_p.h>
 
@@ -229,6 +230,11 @@ WorkerResult WorkerBase::listDir(QUrl const &)
     return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_LISTDIR));
 }
 
+WorkerResult WorkerBase::listRecursive(const QUrl &, bool)
+{
+    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_LISTDIR_RECURSIVE));
+}
+
 WorkerResult WorkerBase::get(QUrl const &)
 {
     return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_GET));
@@ -314,6 +320,50 @@ WorkerResult WorkerBase::fileSystemFreeSpace(const QUrl &)
     return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_FILESYSTEMFREESPACE));
 }
 
+WorkerResult WorkerBase::directorySize(const QUrl &)
+{
+    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_DIRECTORYSIZE));
+}
+
+WorkerResult WorkerBase::mkpath(const QUrl &url, const QUrl &baseUrl)
+{
+    const QStringList pathComponents = url.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    const QStringList basePathComponents = baseUrl.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+
+    // Skip the components known to exist, then create the others one at a time
+    QUrl dirUrl = url;
+#ifdef Q_OS_WIN
+    dirUrl.setPath(QString());
+#else
+    dirUrl.setPath(QStringLiteral("/"));
+#endif
+    int i = 0;
+    for (; i < pathComponents.count(); ++i) {
+        if (i >= basePathComponents.count() || pathComponents.at(i) != basePathComponents.at(i)) {
+            break;
+        }
+        dirUrl.setPath(Utils::concatPaths(dirUrl.path(), pathComponents.at(i)));
+    }
+    for (; i < pathComponents.count(); ++i) {
+        dirUrl.setPath(Utils::concatPaths(dirUrl.path(), pathComponents.at(i)));
+        const WorkerResult result = mkdir(dirUrl, -1);
+        if (!result.success() && result.error() != ERR_DIR_ALREADY_EXIST) {
+            return result;
+        }
+    }
+    return WorkerResult::pass();
+}
+
+WorkerResult WorkerBase::renameBatch(const QList<QUrl> &, const QList<QUrl> &, JobFlags)
+{
+    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_RENAME_BATCH));
+}
+
+WorkerResult WorkerBase::chmodRecursive(const QUrl &, int, int, const QString &, const QString &)
+{
+    return WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(d->protocolName(), CMD_CHMOD_RECURSIVE));
+}
+
 void WorkerBase::worker_status()
 {
     workerStatus(QString(), false);
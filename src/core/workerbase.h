@@ -502,6 +502,25 @@ public:
      */
     Q_REQUIRED_RESULT virtual WorkerResult listDir(const QUrl &url);
 
+    /**
+     * Lists the contents of @p url and of all its subdirectories, in a single request.
+     *
+     * The entries are sent with listEntry() like in listDir(), but UDS_NAME holds
+     * the path relative to @p url, e.g. "subdir/file.txt". Only the top-level
+     * directory has "." and ".." entries. Symlinks to directories are listed
+     * but not followed, and subdirectories which can't be entered are skipped.
+     * The entries of a directory may be sent after those of its subdirectories.
+     *
+     * This is only invoked if the worker specifies listrecursive=true in its protocol file.
+     * If the worker returns ERR_UNSUPPORTED_ACTION (the default), KIO::listRecursive()
+     * falls back to calling listDir() for every subdirectory.
+     *
+     * @param url the directory to list
+     * @param includeHidden whether to list hidden files, and the contents of hidden directories
+     * @since 6.0
+     */
+    Q_REQUIRED_RESULT virtual WorkerResult listRecursive(const QUrl &url, bool includeHidden);
+
     /**
      * Create a directory
      * @param url path to the directory to create
@@ -539,6 +558,32 @@ public:
      */
     Q_REQUIRED_RESULT virtual WorkerResult rename(const QUrl &src, const QUrl &dest, JobFlags flags);
 
+    /**
+     * Rename several files or directories in one request, as used by KIO::batchRename().
+     *
+     * The items are renamed in order, with the same rules as rename(). Workers report
+     * the number of items processed so far through processedSize(), which the job uses
+     * as per-item results; processedSize() must be up to date when returning an error,
+     * which then applies to the first item that wasn't processed.
+     *
+     * Destinations that are already taken, including by items of the batch itself,
+     * should be detected before renaming anything. Skip these items, and send their
+     * indexes as a comma separated list in the "renameBatchConflicts" metadata, with
+     * sendMetaData() before renaming the others. The job renames the skipped items on
+     * their own afterwards, so that the user can resolve the conflicts. A destination
+     * taken while renaming fails the request with ERR_FILE_ALREADY_EXIST; the job then
+     * renames that item on its own as well, and sends the remaining ones again.
+     *
+     * If the worker returns ERR_UNSUPPORTED_ACTION (the default), the job renames
+     * the remaining items one by one.
+     *
+     * @param srcUrls the items to rename
+     * @param destUrls the new URLs, in the same order as @p srcUrls
+     * @param flags We support Overwrite here
+     * @since 6.0
+     */
+    Q_REQUIRED_RESULT virtual WorkerResult renameBatch(const QList<QUrl> &srcUrls, const QList<QUrl> &destUrls, JobFlags flags);
+
     /**
      * Creates a symbolic link named @p dest, pointing to @p target, which
      * may be a relative or an absolute path.
@@ -629,6 +674,64 @@ public:
      */
     Q_REQUIRED_RESULT virtual WorkerResult fileSystemFreeSpace(const QUrl &url);
 
+    /**
+     * Computes the disk usage of the directory @p url and everything below it,
+     * without sending the individual entries to the application.
+     *
+     * The totals are reported as metadata: "size" (sum of the apparent sizes),
+     * "allocated" (sum of the allocated disk space, optional), "files" and "subdirs".
+     * They follow the semantics of KIO::DirectorySizeJob: symlinks are counted but
+     * neither followed nor added to the size, and hardlinked files are counted once.
+     * Long computations should periodically call sendMetaData() with the
+     * intermediate totals.
+     *
+     * If the worker returns ERR_UNSUPPORTED_ACTION (the default), the job falls back
+     * to a recursive listing.
+     *
+     * @param url the directory to compute the size of
+     * @since 6.0
+     */
+    Q_REQUIRED_RESULT virtual WorkerResult directorySize(const QUrl &url);
+
+    /**
+     * Changes the permissions, and optionally the ownership, of the directory
+     * @p url and everything below it, in a single request.
+     *
+     * This follows the rules of KIO::chmod(): the bits of @p permissions selected
+     * by @p mask are applied and the other bits are preserved. Below @p url, files
+     * that have no executable bit keep none (emulating chmod's +X), and symlinks
+     * are skipped. Children are processed before their parent directory, and the
+     * "ACL_STRING" and "DEFAULT_ACL_STRING" metadata are applied to every item.
+     * Workers should report the number of processed items through processedSize().
+     *
+     * If the worker returns ERR_UNSUPPORTED_ACTION (the default), the job falls back
+     * to listing the directory and changing each item separately. The job does the
+     * same when ERR_CANNOT_CHOWN is returned, so that the user can skip those items.
+     *
+     * @param url the directory to process
+     * @param permissions the new permissions
+     * @param mask the bits of @p permissions to apply
+     * @param owner the new owner, or empty to keep it unchanged
+     * @param group the new group, or empty to keep it unchanged
+     * @since 6.0
+     */
+    Q_REQUIRED_RESULT virtual WorkerResult chmodRecursive(const QUrl &url, int permissions, int mask, const QString &owner, const QString &group);
+
+    /**
+     * Creates the directory @p url, and all its missing parents, in a single request.
+     * A directory that already exists is not an error.
+     *
+     * This is only invoked if the worker specifies makepath=true in its protocol file.
+     * The default implementation calls mkdir() for each path component below
+     * @p baseUrl, like KIO::mkpath() does otherwise; reimplement it when the
+     * backend can do better than one round trip per component.
+     *
+     * @param url the directory to create
+     * @param baseUrl an ancestor of @p url known to exist, or empty
+     * @since 6.0
+     */
+    Q_REQUIRED_RESULT virtual WorkerResult mkpath(const QUrl &url, const QUrl &baseUrl);
+
     /**
      * Called to get the status of the worker. Worker should respond
      * by calling workerStatus(...)
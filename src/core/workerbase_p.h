@@ -197,6 +197,29 @@ protected:
         case SlaveBase::Truncate:
             maybeError(base->truncate(*static_cast<KIO::filesize_t *>(data)));
             return;
+        case SlaveBase::DirectorySize:
+            finalize(base->directorySize(*static_cast<QUrl *>(data)));
+            return;
+        case SlaveBase::ChmodRecursive: {
+            const auto *args = static_cast<ChmodRecursiveArgs *>(data);
+            finalize(base->chmodRecursive(args->url, args->permissions, args->mask, args->owner, args->group));
+            return;
+        }
+        case SlaveBase::Mkpath: {
+            const auto *args = static_cast<MkpathArgs *>(data);
+            finalize(base->mkpath(args->url, args->baseUrl));
+            return;
+        }
+        case SlaveBase::RenameBatch: {
+            const auto *args = static_cast<RenameBatchArgs *>(data);
+            finalize(base->renameBatch(args->srcUrls, args->destUrls, JobFlags(args->overwrite ? Overwrite : DefaultFlags)));
+            return;
+        }
+        case SlaveBase::ListRecursive: {
+            const auto *args = static_cast<ListRecursiveArgs *>(data);
+            finalize(base->listRecursive(args->url, args->includeHidden));
+            return;
+        }
         }
 
         maybeError(WorkerResult::fail(ERR_UNSUPPORTED_ACTION, unsupportedActionErrorString(protocolName(), id)));
@@ -119,6 +119,12 @@ bool WorkerInterface::dispatch(int _cmd, const QByteArray &rawdata)
     case MSG_DATA_REQ:
         Q_EMIT dataReq();
         break;
+    case MSG_DATA_PIPED: {
+        qint64 size;
+        stream >> size;
+        Q_EMIT dataPiped(size);
+        break;
+    }
     case MSG_OPENED:
         Q_EMIT open();
         break;
@@ -65,6 +65,7 @@ enum Message {
     MSG_HOST_INFO_REQ,
     MSG_PRIVILEGE_EXEC,
     MSG_WORKER_STATUS,
+    MSG_DATA_PIPED, ///< data was sent to another worker through a data pipe, see FileCopyJob
     // add new ones here once a release is done, to avoid breaking binary compatibility
 };
 
@@ -107,6 +108,7 @@ Q_SIGNALS:
 
     void data(const QByteArray &);
     void dataReq();
+    void dataPiped(qint64);
     void error(int, const QString &);
     void connected();
     void finished();
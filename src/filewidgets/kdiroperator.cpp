@@ -11,6 +11,7 @@
 
 #include "../utils_p.h"
 
+#include "globmatcher_p.h"
 #include "kdirmodel.h"
 #include "kdiroperator.h"
 #include "kdiroperatordetailview_p.h"
@@ -1429,14 +1430,12 @@ bool KDirOperatorPrivate::checkPreviewInternal() const
         return true;
     } else {
         QMimeDatabase db;
-        QRegularExpression re;
+        // wildcard matching because the "mimetype" can be "image/*"
+        const KIO::GlobMatcher supportedMatcher(supported, Qt::CaseSensitive);
 
         if (!mimeTypes.isEmpty()) {
-            for (const QString &str : supported) {
-                // wildcard matching because the "mimetype" can be "image/*"
-                re.setPattern(QRegularExpression::wildcardToRegularExpression(str));
-
-                if (mimeTypes.indexOf(re) != -1) { // matches! -> we want previews
+            for (const QString &mimeType : mimeTypes) {
+                if (supportedMatcher.matches(mimeType)) { // matches! -> we want previews
                     return true;
                 }
             }
@@ -1453,15 +1452,8 @@ bool KDirOperatorPrivate::checkPreviewInternal() const
                 if (!mt.isValid()) {
                     continue;
                 }
-                const QString mime = mt.name();
-
-                for (const QString &str : supported) {
-                    // the "mimetypes" we get from the PreviewJob can be "image/*"
-                    // so we need to check in wildcard mode
-                    re.setPattern(QRegularExpression::wildcardToRegularExpression(str));
-                    if (re.match(mime).hasMatch()) {
-                        return true;
-                    }
+                if (supportedMatcher.matches(mt.name())) {
+                    return true;
                 }
             }
         }
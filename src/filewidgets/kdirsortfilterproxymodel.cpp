@@ -19,6 +19,18 @@
 #include <kfileitem.h>
 
 #include <QCollator>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// Below this number of missing collation keys, computing them in other threads isn't worth it
+static constexpr int s_parallelSortKeysThreshold = 2000;
+// The keys of renamed items, or of other strings than the names, are only dropped
+// once there are more than this many keys, or twice as many as rows if more
+static constexpr std::size_t s_maximumSortKeys = 20000;
 
 class Q_DECL_HIDDEN KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate
 {
@@ -28,10 +40,24 @@ public:
     int compare(const QString &, const QString &, Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive);
     void slotNaturalSortingChanged();
 
+    // The collation key of @p str, computed once, for natural sorting
+    const QCollatorSortKey &sortKey(const QString &str, Qt::CaseSensitivity caseSensitivity);
+    // Computes the missing collation keys of the names of the given source rows ahead of sorting them,
+    // in parallel when there are many of them
+    void cacheSortKeys(QAbstractItemModel *sourceModel, const QModelIndex &sourceParent, int first, int last, Qt::CaseSensitivity caseSensitivity);
+    // Drops the collation keys of the names of the given source rows, which are being removed
+    void forgetSortKeys(QAbstractItemModel *sourceModel, const QModelIndex &sourceParent, int first, int last);
+    void clearSortKeys();
+
     bool m_sortFoldersFirst;
     bool m_sortHiddenFilesLast;
     bool m_naturalSorting;
+    bool m_useSortKeys;
     QCollator m_collator;
+    QList<QMetaObject::Connection> m_sourceModelConnections;
+    // Comparing collation keys is a lot cheaper than QCollator::compare, and gives the same result.
+    // By string rather than by item, so that renamed items get a new key. Indexed by Qt::CaseSensitivity.
+    std::unordered_map<QString, QCollatorSortKey> m_sortKeys[2];
 };
 
 KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::KDirSortFilterProxyModelPrivate()
@@ -45,7 +71,9 @@ int KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::compare(const QSt
 {
     int result;
 
-    if (m_naturalSorting) {
+    if (m_useSortKeys) {
+        result = sortKey(a, caseSensitivity).compare(sortKey(b, caseSensitivity));
+    } else if (m_naturalSorting) {
         m_collator.setCaseSensitivity(caseSensitivity);
         result = m_collator.compare(a, b);
     } else {
@@ -67,6 +95,107 @@ void KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::slotNaturalSorti
     KConfigGroup g(KSharedConfig::openConfig(), "KDE");
     m_naturalSorting = g.readEntry("NaturalSorting", true);
     m_collator.setNumericMode(m_naturalSorting);
+    // The sort keys of the C locale don't honor the case sensitivity
+    m_useSortKeys = m_naturalSorting && m_collator.locale().language() != QLocale::C;
+    clearSortKeys();
+}
+
+const QCollatorSortKey &KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::sortKey(const QString &str, Qt::CaseSensitivity caseSensitivity)
+{
+    auto &sortKeys = m_sortKeys[caseSensitivity];
+    auto it = sortKeys.find(str);
+    if (it == sortKeys.end()) {
+        m_collator.setCaseSensitivity(caseSensitivity);
+        it = sortKeys.emplace(str, m_collator.sortKey(str)).first;
+    }
+    return it->second;
+}
+
+void KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::cacheSortKeys(QAbstractItemModel *sourceModel,
+                                                                                const QModelIndex &sourceParent,
+                                                                                int first,
+                                                                                int last,
+                                                                                Qt::CaseSensitivity caseSensitivity)
+{
+    auto &sortKeys = m_sortKeys[caseSensitivity];
+    // Not while sorting: compare() holds references to the keys
+    if (sortKeys.size() > std::max(s_maximumSortKeys, 2 * std::size_t(sourceModel->rowCount(sourceParent)))) {
+        sortKeys.clear();
+    }
+
+    KDirModel *dirModel = qobject_cast<KDirModel *>(sourceModel);
+    if (!m_useSortKeys || !dirModel) {
+        return;
+    }
+
+    QStringList missing;
+    for (int row = first; row <= last; ++row) {
+        QString text = dirModel->itemForIndex(dirModel->index(row, KDirModel::Name, sourceParent)).text();
+        if (sortKeys.find(text) == sortKeys.end()) {
+            missing.append(std::move(text));
+        }
+    }
+    if (missing.size() < s_parallelSortKeysThreshold) {
+        // The keys are computed as needed while sorting
+        return;
+    }
+
+    // A QCollator must not be used from several threads, each chunk of names gets its own
+    struct Chunk {
+        qsizetype begin;
+        qsizetype end;
+        std::vector<QCollatorSortKey> keys;
+    };
+    const qsizetype chunkCount = std::min<qsizetype>(QThread::idealThreadCount(), missing.size() / (s_parallelSortKeysThreshold / 4));
+    const qsizetype chunkSize = (missing.size() + chunkCount - 1) / chunkCount;
+    std::vector<Chunk> chunks;
+    for (qsizetype begin = 0; begin < missing.size(); begin += chunkSize) {
+        chunks.push_back(Chunk{begin, std::min(begin + chunkSize, missing.size()), {}});
+    }
+    const QLocale locale = m_collator.locale();
+    const bool ignorePunctuation = m_collator.ignorePunctuation();
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        QCollator collator(locale);
+        collator.setNumericMode(true);
+        collator.setIgnorePunctuation(ignorePunctuation);
+        collator.setCaseSensitivity(caseSensitivity);
+        chunk.keys.reserve(chunk.end - chunk.begin);
+        for (qsizetype i = chunk.begin; i < chunk.end; ++i) {
+            chunk.keys.push_back(collator.sortKey(missing.at(i)));
+        }
+    });
+
+    sortKeys.reserve(sortKeys.size() + missing.size());
+    for (const Chunk &chunk : chunks) {
+        for (qsizetype i = chunk.begin; i < chunk.end; ++i) {
+            sortKeys.emplace(missing.at(i), chunk.keys.at(i - chunk.begin));
+        }
+    }
+}
+
+void KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::forgetSortKeys(QAbstractItemModel *sourceModel,
+                                                                                 const QModelIndex &sourceParent,
+                                                                                 int first,
+                                                                                 int last)
+{
+    KDirModel *dirModel = qobject_cast<KDirModel *>(sourceModel);
+    if (!dirModel || (m_sortKeys[0].empty() && m_sortKeys[1].empty())) {
+        return;
+    }
+
+    for (int row = first; row <= last; ++row) {
+        const QString text = dirModel->itemForIndex(dirModel->index(row, KDirModel::Name, sourceParent)).text();
+        for (auto &sortKeys : m_sortKeys) {
+            sortKeys.erase(text);
+        }
+    }
+}
+
+void KDirSortFilterProxyModel::KDirSortFilterProxyModelPrivate::clearSortKeys()
+{
+    for (auto &sortKeys : m_sortKeys) {
+        sortKeys.clear();
+    }
 }
 
 KDirSortFilterProxyModel::KDirSortFilterProxyModel(QObject *parent)
@@ -87,6 +216,54 @@ Qt::DropActions KDirSortFilterProxyModel::supportedDragOptions() const
 
 KDirSortFilterProxyModel::~KDirSortFilterProxyModel() = default;
 
+void KDirSortFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (sourceModel == KDirSortFilterProxyModel::sourceModel()) {
+        return;
+    }
+    for (const QMetaObject::Connection &connection : std::as_const(d->m_sourceModelConnections)) {
+        disconnect(connection);
+    }
+    d->m_sourceModelConnections.clear();
+    d->clearSortKeys();
+
+    if (sourceModel) {
+        // Connected before QSortFilterProxyModel's own connections, so that the keys of
+        // new rows are there by the time they get sorted
+        d->m_sourceModelConnections = {
+            connect(sourceModel,
+                    &QAbstractItemModel::rowsInserted,
+                    this,
+                    [this](const QModelIndex &parent, int first, int last) {
+                        d->cacheSortKeys(KDirSortFilterProxyModel::sourceModel(), parent, first, last, sortCaseSensitivity());
+                    }),
+            // Don't keep the keys of the names which are gone
+            connect(sourceModel,
+                    &QAbstractItemModel::rowsAboutToBeRemoved,
+                    this,
+                    [this](const QModelIndex &parent, int first, int last) {
+                        d->forgetSortKeys(KDirSortFilterProxyModel::sourceModel(), parent, first, last);
+                    }),
+            connect(sourceModel,
+                    &QAbstractItemModel::modelReset,
+                    this,
+                    [this]() {
+                        d->clearSortKeys();
+                    }),
+        };
+    }
+
+    KCategorizedSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+void KDirSortFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    if (QAbstractItemModel *model = sourceModel(); model && model->rowCount() > 0) {
+        d->cacheSortKeys(model, QModelIndex(), 0, model->rowCount() - 1, sortCaseSensitivity());
+    }
+    KCategorizedSortFilterProxyModel::sort(column, order);
+}
+
 bool KDirSortFilterProxyModel::hasChildren(const QModelIndex &parent) const
 {
     const QModelIndex sourceParent = mapToSource(parent);
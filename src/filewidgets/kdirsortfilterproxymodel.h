@@ -56,6 +56,17 @@ public:
      */
     bool canFetchMore(const QModelIndex &parent) const override;
 
+    /**
+     * Reimplemented from QAbstractProxyModel.
+     */
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    /**
+     * Reimplemented from QAbstractItemModel.
+     * With natural sorting, the collation keys of large directories are computed in parallel first.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
     /**
      * Returns the permissions in "points". This is useful for sorting by
      * permissions.
@@ -7,6 +7,8 @@
 #include "kfilepreviewgenerator.h"
 
 #include "defaultviewadapter_p.h"
+#include "kfileitem_p.h"
+#include "mimetypecache_p.h"
 #include <KConfigGroup>
 #include <KIconEffect>
 #include <KIconLoader>
@@ -23,15 +25,24 @@
 #include <QAbstractProxyModel>
 #include <QApplication>
 #include <QClipboard>
+#include <QDateTime>
+#include <QFuture>
 #include <QHash>
 #include <QIcon>
 #include <QList>
 #include <QListView>
 #include <QMimeData>
+#include <QMimeDatabase>
 #include <QPainter>
 #include <QPixmap>
 #include <QPointer>
 #include <QTimer>
+#include <QtConcurrentRun>
+
+#include <vector>
+
+// Items whose MIME type is resolved together, the icons are updated once per batch
+static constexpr int s_mimeTypeBatchSize = 64;
 
 class KFilePreviewGeneratorPrivate
 {
@@ -108,8 +119,10 @@ public:
     void startMimeTypeResolving();
 
     /**
-     * Resolves the MIME type for exactly one item of the
-     * m_pendingItems queue.
+     * Resolves the MIME types of the next batch of items of the
+     * m_pendingItems queue. The content of local files is sniffed
+     * in a thread, the results reach the items through
+     * KIO::MimeTypeCache.
      */
     void resolveMimeType();
 
@@ -210,12 +223,6 @@ public:
 
     bool m_previewShown = true;
 
-    /**
-     * True, if m_pendingItems and m_dispatchedItems should be
-     * cleared when the preview jobs have been finished.
-     */
-    bool m_clearItemQueues = true;
-
     /**
      * True if a selection has been done which should cut items.
      */
@@ -278,6 +285,9 @@ public:
 
     KFileItemList m_resolvedMimeTypes;
 
+    // Whether a batch of MIME types is being resolved in a thread
+    bool m_resolvingMimeTypes = false;
+
     QStringList m_enabledPlugins;
 
     std::unique_ptr<TileSet> m_tileSet;
@@ -653,15 +663,13 @@ void KFilePreviewGeneratorPrivate::slotPreviewJobFinished(KJob *job)
             }
         }
 
-        if (m_clearItemQueues) {
-            m_pendingItems.clear();
-            m_dispatchedItems.clear();
-            m_pendingVisibleIconUpdates = 0;
-            auto dispatchFunc = [this]() {
-                dispatchIconUpdateQueue();
-            };
-            QMetaObject::invokeMethod(q, dispatchFunc, Qt::QueuedConnection);
-        }
+        m_pendingItems.clear();
+        m_dispatchedItems.clear();
+        m_pendingVisibleIconUpdates = 0;
+        auto dispatchFunc = [this]() {
+            dispatchIconUpdateQueue();
+        };
+        QMetaObject::invokeMethod(q, dispatchFunc, Qt::QueuedConnection);
         m_sequenceIndices.clear(); // just to be sure that we don't leak anything
     }
 }
@@ -741,8 +749,11 @@ void KFilePreviewGeneratorPrivate::dispatchIconUpdateQueue()
 
         // dispatch MIME type queue
         for (const KFileItem &item : std::as_const(m_resolvedMimeTypes)) {
+            // Resolved in a thread, the item might be gone meanwhile
             const QModelIndex idx = dirModel->indexForItem(item);
-            dirModel->itemChanged(idx);
+            if (idx.isValid()) {
+                dirModel->itemChanged(idx);
+            }
         }
         m_resolvedMimeTypes.clear();
 
@@ -796,13 +807,22 @@ void KFilePreviewGeneratorPrivate::resumeIconUpdates()
         KFileItemList orderedItems = m_pendingItems;
         orderItems(orderedItems);
 
-        // Kill all suspended preview jobs. Usually when a preview job
-        // has been finished, slotPreviewJobFinished() clears all item queues.
-        // This is not wanted in this case, as a new job is created afterwards
-        // for m_pendingItems.
-        m_clearItemQueues = false;
-        killPreviewJobs();
-        m_clearItemQueues = true;
+        if (!m_previewJobs.isEmpty()) {
+            // The pending items are all queued in the suspended preview jobs. Rather than
+            // starting over, move the items which became visible to the front of the queues,
+            // the previews being generated in the meantime are kept.
+            QList<QUrl> visibleUrls;
+            visibleUrls.reserve(m_pendingVisibleIconUpdates);
+            for (int i = 0; i < m_pendingVisibleIconUpdates && i < orderedItems.count(); ++i) {
+                visibleUrls.append(orderedItems.at(i).url());
+            }
+            for (KJob *job : std::as_const(m_previewJobs)) {
+                static_cast<KIO::PreviewJob *>(job)->prioritizeItems(visibleUrls);
+                job->resume();
+            }
+            m_iconUpdateTimer->start();
+            return;
+        }
 
         createPreviews(orderedItems);
     } else {
@@ -819,45 +839,82 @@ void KFilePreviewGeneratorPrivate::startMimeTypeResolving()
 
 void KFilePreviewGeneratorPrivate::resolveMimeType()
 {
-    if (m_pendingItems.isEmpty()) {
+    if (m_pendingItems.isEmpty() || m_resolvingMimeTypes) {
         return;
     }
 
-    // resolve at least one MIME type
-    bool resolved = false;
-    do {
-        KFileItem item = m_pendingItems.takeFirst();
+    // Take the next items whose MIME type is unknown, visible items come first.
+    // The directory model is not informed yet, as a single update
+    // would be very expensive. Instead the items are remembered in
+    // m_resolvedMimeTypes and will be dispatched later
+    // by dispatchIconUpdateQueue().
+    struct SniffedFile {
+        QUrl url;
+        KIO::filesize_t size;
+        QDateTime mtime;
+    };
+    KFileItemList batch;
+    std::vector<SniffedFile> sniffedFiles;
+    while (!m_pendingItems.isEmpty() && batch.count() < s_mimeTypeBatchSize) {
+        const KFileItem item = m_pendingItems.takeFirst();
         if (item.isMimeTypeKnown()) {
             if (m_pendingVisibleIconUpdates > 0) {
                 // The item is visible and the MIME type already known.
                 // Decrease the update counter for dispatchIconUpdateQueue():
                 --m_pendingVisibleIconUpdates;
             }
-        } else {
-            // The MIME type is unknown and must get resolved. The
-            // directory model is not informed yet, as a single update
-            // would be very expensive. Instead the item is remembered in
-            // m_resolvedMimeTypes and will be dispatched later
-            // by dispatchIconUpdateQueue().
+            continue;
+        }
+        batch.append(item);
+        // Matching the content of a local file is the slow part. The name of
+        // the other files is all there is to look at, that's fast enough here.
+        // Same rules as KFileItem, which won't read the file if it's SkipMimeTypeFromContent.
+        if (_kfileitemCachesMimeTypeFromContent(item)) {
+            sniffedFiles.push_back({item.mostLocalUrl(), item.size(), item.time(KFileItem::ModificationTime)});
+        }
+    }
+
+    auto finishBatch = [this, batch]() {
+        for (const KFileItem &item : batch) {
+            // Found in the MIME type cache for the sniffed files
             item.determineMimeType();
             m_resolvedMimeTypes.append(item);
-            resolved = true;
         }
-    } while (!resolved && !m_pendingItems.isEmpty());
 
-    if (m_pendingItems.isEmpty()) {
-        // All MIME types have been resolved now. Assure
-        // that the directory model gets informed about
-        // this, so that an update of the icons is done.
-        dispatchIconUpdateQueue();
-    } else if (!m_iconUpdatesPaused) {
-        // assure that the MIME type of the next
-        // item will be resolved asynchronously
-        auto mimeFunc = [this]() {
-            resolveMimeType();
-        };
-        QMetaObject::invokeMethod(q, mimeFunc, Qt::QueuedConnection);
+        if (m_pendingItems.isEmpty()) {
+            // All MIME types have been resolved now. Assure
+            // that the directory model gets informed about
+            // this, so that an update of the icons is done.
+            dispatchIconUpdateQueue();
+        } else if (!m_iconUpdatesPaused) {
+            // assure that the MIME types of the next
+            // items will be resolved asynchronously
+            auto mimeFunc = [this]() {
+                resolveMimeType();
+            };
+            QMetaObject::invokeMethod(q, mimeFunc, Qt::QueuedConnection);
+        }
+    };
+
+    if (sniffedFiles.empty()) {
+        finishBatch();
+        return;
     }
+
+    m_resolvingMimeTypes = true;
+    KIO::MimeTypeCache *cache = KIO::MimeTypeCache::instance(); // created in the main thread
+    QtConcurrent::run([cache, sniffedFiles = std::move(sniffedFiles)]() {
+        QMimeDatabase db;
+        for (const SniffedFile &file : sniffedFiles) {
+            // KFileItem looks at the cache first too
+            if (cache->mimeTypeForUrl(file.url, file.size, file.mtime).isEmpty()) {
+                cache->setMimeTypeForUrl(file.url, file.size, file.mtime, db.mimeTypeForUrl(file.url).name());
+            }
+        }
+    }).then(q, [this, finishBatch]() {
+        m_resolvingMimeTypes = false;
+        finishBatch();
+    });
 }
 
 bool KFilePreviewGeneratorPrivate::isCutItem(const KFileItem &item) const
@@ -10,6 +10,8 @@
 
 #include "previewjob.h"
 #include "kiogui_debug.h"
+#include "thumbnailcachecleaner_p.h"
+#include "thumbnailtexts_p.h"
 
 #if defined(Q_OS_UNIX) && !defined(Q_OS_ANDROID)
 #define WITH_SHM 1
@@ -28,11 +30,14 @@
 #include <QDir>
 #include <QFile>
 #include <QImage>
+#include <QMutex>
 #include <QPixmap>
 #include <QRegularExpression>
 #include <QSaveFile>
 #include <QTemporaryFile>
+#include <QThread>
 #include <QTimer>
+#include <QtMath>
 
 #include <QCryptographicHash>
 
@@ -49,12 +54,103 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <vector>
 
 #include "job_p.h"
 
 namespace
 {
 static int s_defaultDevicePixelRatio = 1;
+
+#if WITH_SHM
+// The shared memory segments the thumbnail workers write the images to, shared by all the
+// preview jobs of the process. A segment is used by one thumbnail request at a time, and then
+// reused by the next one, rather than created and destroyed for every job.
+class ThumbnailShmPool
+{
+public:
+    struct Segment {
+        int id;
+        uchar *address;
+        size_t size;
+    };
+
+    ~ThumbnailShmPool()
+    {
+        for (const auto &segment : m_freeSegments) {
+            destroy(segment.get());
+        }
+    }
+
+    // Returns a segment of at least @p size bytes, or nullptr if it can't be created
+    Segment *acquire(size_t size)
+    {
+        QMutexLocker locker(&m_mutex);
+        // The smallest free segment which is large enough
+        auto best = m_freeSegments.end();
+        for (auto it = m_freeSegments.begin(); it != m_freeSegments.end(); ++it) {
+            if ((*it)->size >= size && (best == m_freeSegments.end() || (*it)->size < (*best)->size)) {
+                best = it;
+            }
+        }
+        if (best != m_freeSegments.end()) {
+            Segment *segment = best->release();
+            m_freeSegments.erase(best);
+            return segment;
+        }
+        locker.unlock();
+
+        // Sized for the thumbnail size class, 128x128, 256x256, etc. times the DPR squared,
+        // so that the segment can be reused for the other thumbnails of that size
+        const size_t segmentSize = qNextPowerOfTwo(quint64(size - 1));
+        const int id = shmget(IPC_PRIVATE, segmentSize, IPC_CREAT | 0600);
+        if (id == -1) {
+            return nullptr;
+        }
+        uchar *address = static_cast<uchar *>(shmat(id, nullptr, SHM_RDONLY));
+        if (address == reinterpret_cast<uchar *>(-1)) {
+            shmctl(id, IPC_RMID, nullptr);
+            return nullptr;
+        }
+#ifdef Q_OS_LINUX
+        // The thumbnail workers can still attach it, and it's freed even if we crash
+        shmctl(id, IPC_RMID, nullptr);
+#endif
+        return new Segment{id, address, segmentSize};
+    }
+
+    void release(Segment *segment)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_freeSegments.emplace_back(segment);
+        if (m_freeSegments.size() > s_maxFreeSegments) {
+            // Keep the large ones, they can be used for any thumbnail
+            auto smallest = std::min_element(m_freeSegments.begin(), m_freeSegments.end(), [](const auto &left, const auto &right) {
+                return left->size < right->size;
+            });
+            destroy(smallest->get());
+            m_freeSegments.erase(smallest);
+        }
+    }
+
+private:
+    static void destroy(Segment *segment)
+    {
+        shmdt(reinterpret_cast<char *>(segment->address));
+#ifndef Q_OS_LINUX
+        shmctl(segment->id, IPC_RMID, nullptr);
+#endif
+    }
+
+    // About as many as thumbnails generated at the same time
+    static constexpr size_t s_maxFreeSegments = 8;
+    QMutex m_mutex;
+    std::vector<std::unique_ptr<Segment>> m_freeSegments;
+};
+
+Q_GLOBAL_STATIC(ThumbnailShmPool, s_shmPool)
+#endif
 }
 
 namespace KIO
@@ -80,41 +176,66 @@ public:
         , bSave(true)
         , ignoreMaximumSize(false)
         , sequenceIndex(0)
-        , succeeded(false)
         , maximumLocalSize(0)
         , maximumRemoteSize(0)
-        , shmid(-1)
-        , shmaddr(nullptr)
     {
         // https://specifications.freedesktop.org/thumbnail-spec/thumbnail-spec-latest.html#DIRECTORY
         thumbRoot = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/thumbnails/");
     }
 
-    enum {
-        STATE_STATORIG, // if the thumbnail exists
-        STATE_GETORIG, // if we create it
-        STATE_CREATETHUMB, // thumbnail:/ worker
-        STATE_DEVICE_INFO, // additional state check to get needed device ids
-    } state;
+    enum CachePolicy { Prevent, Allow, Unknown };
+
+    // An item being processed. Several items are processed at the same time,
+    // each one by its own thumbnail worker.
+    struct Task {
+        enum {
+            STATE_STATORIG, // if the thumbnail exists
+            STATE_GETORIG, // if we create it
+            STATE_CREATETHUMB, // thumbnail:/ worker
+            STATE_DEVICE_INFO, // additional state check to get needed device ids
+        } state = STATE_STATORIG;
+
+        bool isIdle() const
+        {
+            return item.item.isNull();
+        }
+
+        // The item, null if the task is idle
+        PreviewItem item;
+        // The subjob working on it
+        KJob *job = nullptr;
+        // The modification time of that URL
+        QDateTime tOrig;
+        // Original URL of the item in RFC2396 format
+        // (file:///path/to/a%20file instead of file:/path/to/a file)
+        QByteArray origName;
+        // Thumbnail file name for the item
+        QString thumbName;
+        bool succeeded = false;
+        // If the file to create a thumb for was a temp file, this is its name
+        QString tempName;
+        // Id of the device storing the item
+        int deviceId = 0;
+        CachePolicy cachePolicy = Unknown;
+#if WITH_SHM
+        // Shared memory segment of at least extent x extent x 4 (32 bit image), taken
+        // from the pool while the thumbnail is created
+        ThumbnailShmPool::Segment *shm = nullptr;
+#endif
+    };
 
     KFileItemList initialItems;
     QStringList enabledPlugins;
     // Some plugins support remote URLs, <protocol, mimetypes>
     QHash<QString, QStringList> m_remoteProtocolPlugins;
-    // Our todo list :)
+    // Our todo list :), by priority
     // We remove the first item at every step, so use std::list
     std::list<PreviewItem> items;
-    // The current item
-    PreviewItem currentItem;
-    // The modification time of that URL
-    QDateTime tOrig;
+    // The items being processed, a fixed number of them, so that thumbnails
+    // are created in parallel without starting one worker per item
+    std::vector<Task> tasks;
     // Path to thumbnail cache for the current size
     QString thumbPath;
-    // Original URL of current item in RFC2396 format
-    // (file:///path/to/a%20file instead of file:/path/to/a file)
-    QByteArray origName;
-    // Thumbnail file name for current item
-    QString thumbName;
     // Size of thumbnail
     int width;
     int height;
@@ -126,42 +247,36 @@ public:
     bool bSave;
     bool ignoreMaximumSize;
     int sequenceIndex;
-    bool succeeded;
-    // If the file to create a thumb for was a temp file, this is its name
-    QString tempName;
     KIO::filesize_t maximumLocalSize;
     KIO::filesize_t maximumRemoteSize;
-    // Shared memory segment Id. The segment is allocated to a size
-    // of extent x extent x 4 (32 bit image) on first need.
-    int shmid;
-    // And the data area
-    uchar *shmaddr;
-    // Size of the shm segment
-    size_t shmsize;
     // Root of thumbnail cache
     QString thumbRoot;
     // Metadata returned from the KIO thumbnail worker
     QMap<QString, QString> thumbnailWorkerMetaData;
     int devicePixelRatio = s_defaultDevicePixelRatio;
     static const int idUnknown = -1;
-    // Id of a device storing currently processed file
-    int currentDeviceId = 0;
     // Device ID for each file. Stored while in STATE_DEVICE_INFO state, used later on.
     QMap<QString, int> deviceIdMap;
-    enum CachePolicy { Prevent, Allow, Unknown } currentDeviceCachePolicy = Unknown;
-
-    void getOrCreateThumbnail();
-    bool statResultThumbnail();
-    void createThumbnail(const QString &);
-    void cleanupTempFile();
-    void determineNextFile();
-    void emitPreview(const QImage &thumb);
+    // Cache policy of the directories on each device, once known
+    QHash<int, CachePolicy> deviceCachePolicies;
+
+    void getOrCreateThumbnail(Task &task);
+    bool statResultThumbnail(Task &task);
+    void createThumbnail(Task &task, const QString &);
+    // Removes the temporary file and gives back the shared memory segment of @p task
+    void releaseResources(Task &task);
+    // Starts processing the next items, if there are idle tasks
+    void startNextItems();
+    void startItem(Task &task);
+    // Done with the item of @p task, emits failed() unless a preview was emitted
+    void finishItem(Task &task);
+    void emitPreview(Task &task, const QImage &thumb);
 
     void startPreview();
-    void slotThumbData(KIO::Job *, const QByteArray &);
+    void slotThumbData(Task &task, KIO::Job *, const QByteArray &);
     // Checks if thumbnail is on encrypted partition different than thumbRoot
-    CachePolicy canBeCached(const QString &path);
-    int getDeviceId(const QString &path);
+    CachePolicy canBeCached(Task &task, const QString &path);
+    int getDeviceId(Task &task, const QString &path);
 
     Q_DECLARE_PUBLIC(PreviewJob)
 
@@ -194,7 +309,7 @@ PreviewJob::PreviewJob(const KFileItemList &items, const QSize &size, const QStr
                                    QStringList{QStringLiteral("directorythumbnail"), QStringLiteral("imagethumbnail"), QStringLiteral("jpegthumbnail")});
     }
 
-    // Return to event loop first, determineNextFile() might delete this;
+    // Return to event loop first, startNextItems() might delete this;
     QTimer::singleShot(0, this, [d]() {
         d->startPreview();
     });
@@ -202,13 +317,10 @@ PreviewJob::PreviewJob(const KFileItemList &items, const QSize &size, const QStr
 
 PreviewJob::~PreviewJob()
 {
-#if WITH_SHM
     Q_D(PreviewJob);
-    if (d->shmaddr) {
-        shmdt((char *)d->shmaddr);
-        shmctl(d->shmid, IPC_RMID, nullptr);
+    for (PreviewJobPrivate::Task &task : d->tasks) {
+        d->releaseResources(task);
     }
-#endif
 }
 
 void PreviewJob::setScaleType(ScaleType type)
@@ -340,6 +452,9 @@ void PreviewJobPrivate::startPreview()
     KConfigGroup cg(KSharedConfig::openConfig(), "PreviewSettings");
     maximumLocalSize = cg.readEntry("MaximumSize", std::numeric_limits<KIO::filesize_t>::max());
     maximumRemoteSize = cg.readEntry<KIO::filesize_t>("MaximumRemoteSize", 0);
+    // Each task keeps a thumbnail worker busy
+    const int maximumWorkers = std::max(1, cg.readEntry("MaximumWorkers", std::min(QThread::idealThreadCount(), 4)));
+    tasks.resize(std::min<std::size_t>(maximumWorkers, std::max<std::size_t>(items.size(), 1)));
 
     if (bNeedCache) {
         const int longer = std::max(width, height);
@@ -383,12 +498,14 @@ void PreviewJobPrivate::startPreview()
                 f.setPermissions(QFile::ReadUser | QFile::WriteUser | QFile::ExeUser); // 0700
             }
         }
+        // Keeps the cache within its budget, now that it's growing
+        ThumbnailCacheCleaner::self()->scheduleCleanup();
     } else {
         bSave = false;
     }
 
     initialItems.clear();
-    determineNextFile();
+    startNextItems();
 }
 
 void PreviewJob::removeItem(const QUrl &url)
@@ -402,12 +519,41 @@ void PreviewJob::removeItem(const QUrl &url)
         d->items.erase(it);
     }
 
-    if (d->currentItem.item.url() == url) {
-        KJob *job = subjobs().first();
-        job->kill();
-        removeSubjob(job);
-        d->determineNextFile();
+    for (PreviewJobPrivate::Task &task : d->tasks) {
+        if (!task.isIdle() && task.item.item.url() == url) {
+            if (KJob *job = task.job) {
+                task.job = nullptr;
+                job->kill();
+                removeSubjob(job);
+            }
+            d->finishItem(task);
+        }
+    }
+}
+
+void PreviewJob::prioritizeItems(const QList<QUrl> &urls)
+{
+    Q_D(PreviewJob);
+
+    QHash<QUrl, int> priorities;
+    priorities.reserve(urls.size());
+    for (int i = urls.size() - 1; i >= 0; --i) {
+        priorities.insert(urls.at(i), i);
+    }
+
+    // Take the items out of the queue, in the given order, and put them back in front
+    std::list<PreviewItem> prioritizedItems;
+    for (auto it = d->items.begin(); it != d->items.end();) {
+        auto next = std::next(it);
+        if (priorities.contains(it->item.url())) {
+            prioritizedItems.splice(prioritizedItems.end(), d->items, it);
+        }
+        it = next;
     }
+    prioritizedItems.sort([&priorities](const PreviewItem &left, const PreviewItem &right) {
+        return priorities.value(left.item.url()) < priorities.value(right.item.url());
+    });
+    d->items.splice(d->items.begin(), prioritizedItems);
 }
 
 void KIO::PreviewJob::setSequenceIndex(int index)
@@ -440,63 +586,114 @@ void PreviewJob::setIgnoreMaximumSize(bool ignoreSize)
     d_func()->ignoreMaximumSize = ignoreSize;
 }
 
-void PreviewJobPrivate::cleanupTempFile()
+void PreviewJobPrivate::releaseResources(Task &task)
 {
-    if (!tempName.isEmpty()) {
-        Q_ASSERT((!QFileInfo(tempName).isDir() && QFileInfo(tempName).isFile()) || QFileInfo(tempName).isSymLink());
-        QFile::remove(tempName);
-        tempName.clear();
+    if (!task.tempName.isEmpty()) {
+        Q_ASSERT((!QFileInfo(task.tempName).isDir() && QFileInfo(task.tempName).isFile()) || QFileInfo(task.tempName).isSymLink());
+        QFile::remove(task.tempName);
+        task.tempName.clear();
+    }
+#if WITH_SHM
+    if (task.shm) {
+        s_shmPool->release(task.shm);
+        task.shm = nullptr;
     }
+#endif
 }
 
-void PreviewJobPrivate::determineNextFile()
+void PreviewJobPrivate::startNextItems()
 {
     Q_Q(PreviewJob);
-    if (!currentItem.item.isNull()) {
-        if (!succeeded) {
-            Q_EMIT q->failed(currentItem.item);
+    // Nothing new while the views are scrolling, the queue is probably about to be reordered
+    if (q->isSuspended()) {
+        return;
+    }
+
+    bool busy = false;
+    for (Task &task : tasks) {
+        if (task.isIdle() && !items.empty()) {
+            startItem(task);
         }
+        busy = busy || !task.isIdle();
     }
     // No more items ?
-    if (items.empty()) {
+    if (!busy && !q->isFinished()) {
         q->emitResult();
-        return;
-    } else {
-        // First, stat the orig file
-        state = PreviewJobPrivate::STATE_STATORIG;
-        currentItem = items.front();
-        items.pop_front();
-        succeeded = false;
-        KIO::Job *job = KIO::stat(currentItem.item.url(), StatJob::SourceSide, KIO::StatDefaultDetails | KIO::StatInode, KIO::HideProgressInfo);
-        job->addMetaData(QStringLiteral("thumbnail"), QStringLiteral("1"));
-        job->addMetaData(QStringLiteral("no-auth-prompt"), QStringLiteral("true"));
-        q->addSubjob(job);
     }
 }
 
+void PreviewJobPrivate::startItem(Task &task)
+{
+    Q_Q(PreviewJob);
+    // First, stat the orig file
+    task.state = Task::STATE_STATORIG;
+    task.item = items.front();
+    items.pop_front();
+    task.succeeded = false;
+    task.cachePolicy = Unknown;
+    KIO::Job *job = KIO::stat(task.item.item.url(), StatJob::SourceSide, KIO::StatDefaultDetails | KIO::StatInode, KIO::HideProgressInfo);
+    job->addMetaData(QStringLiteral("thumbnail"), QStringLiteral("1"));
+    job->addMetaData(QStringLiteral("no-auth-prompt"), QStringLiteral("true"));
+    task.job = job;
+    q->addSubjob(job);
+}
+
+void PreviewJobPrivate::finishItem(Task &task)
+{
+    Q_Q(PreviewJob);
+    releaseResources(task);
+    const KFileItem item = task.item.item;
+    task.item = PreviewItem();
+    if (!task.succeeded) {
+        Q_EMIT q->failed(item);
+    }
+    startNextItems();
+}
+
+bool PreviewJob::doResume()
+{
+    Q_D(PreviewJob);
+    if (!KIO::Job::doResume()) {
+        return false;
+    }
+    // The idle tasks weren't given new items while suspended
+    QTimer::singleShot(0, this, [d]() {
+        d->startNextItems();
+    });
+    return true;
+}
+
 void PreviewJob::slotResult(KJob *job)
 {
     Q_D(PreviewJob);
 
     removeSubjob(job);
-    Q_ASSERT(!hasSubjobs()); // We should have only one job at a time ...
-    switch (d->state) {
-    case PreviewJobPrivate::STATE_STATORIG: {
+    auto taskIt = std::find_if(d->tasks.begin(), d->tasks.end(), [job](const PreviewJobPrivate::Task &task) {
+        return task.job == job;
+    });
+    if (taskIt == d->tasks.end()) {
+        return;
+    }
+    PreviewJobPrivate::Task &task = *taskIt;
+    task.job = nullptr;
+
+    switch (task.state) {
+    case PreviewJobPrivate::Task::STATE_STATORIG: {
         if (job->error()) { // that's no good news...
             // Drop this one and move on to the next one
-            d->determineNextFile();
+            d->finishItem(task);
             return;
         }
         const KIO::UDSEntry statResult = static_cast<KIO::StatJob *>(job)->statResult();
-        d->currentDeviceId = statResult.numberValue(KIO::UDSEntry::UDS_DEVICE_ID, 0);
-        d->tOrig = QDateTime::fromSecsSinceEpoch(statResult.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, 0));
+        task.deviceId = statResult.numberValue(KIO::UDSEntry::UDS_DEVICE_ID, 0);
+        task.tOrig = QDateTime::fromSecsSinceEpoch(statResult.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME, 0));
 
         bool skipCurrentItem = false;
         const KIO::filesize_t size = (KIO::filesize_t)statResult.numberValue(KIO::UDSEntry::UDS_SIZE, 0);
-        const QUrl itemUrl = d->currentItem.item.mostLocalUrl();
+        const QUrl itemUrl = task.item.item.mostLocalUrl();
 
         if (itemUrl.isLocalFile() || KProtocolInfo::protocolClass(itemUrl.scheme()) == QLatin1String(":local")) {
-            skipCurrentItem = !d->ignoreMaximumSize && size > d->maximumLocalSize && !d->currentItem.plugin.value(QStringLiteral("IgnoreMaximumSize"), false);
+            skipCurrentItem = !d->ignoreMaximumSize && size > d->maximumLocalSize && !task.item.plugin.value(QStringLiteral("IgnoreMaximumSize"), false);
         } else {
             // For remote items the "IgnoreMaximumSize" plugin property is not respected
             skipCurrentItem = !d->ignoreMaximumSize && size > d->maximumRemoteSize;
@@ -505,32 +702,32 @@ void PreviewJob::slotResult(KJob *job)
             if (!skipCurrentItem) {
                 // TODO update item.mimeType from the UDS entry, in case it wasn't set initially
                 // But we don't use the MIME type anymore, we just use isDir().
-                if (d->currentItem.item.isDir()) {
+                if (task.item.item.isDir()) {
                     skipCurrentItem = true;
                 }
             }
         }
         if (skipCurrentItem) {
-            d->determineNextFile();
+            d->finishItem(task);
             return;
         }
 
-        bool pluginHandlesSequences = d->currentItem.plugin.value(QStringLiteral("HandleSequences"), false);
-        if (!d->currentItem.plugin.value(QStringLiteral("CacheThumbnail"), true) || (d->sequenceIndex && pluginHandlesSequences)) {
+        bool pluginHandlesSequences = task.item.plugin.value(QStringLiteral("HandleSequences"), false);
+        if (!task.item.plugin.value(QStringLiteral("CacheThumbnail"), true) || (d->sequenceIndex && pluginHandlesSequences)) {
             // This preview will not be cached, no need to look for a saved thumbnail
             // Just create it, and be done
-            d->getOrCreateThumbnail();
+            d->getOrCreateThumbnail(task);
             return;
         }
 
-        if (d->statResultThumbnail()) {
+        if (d->statResultThumbnail(task)) {
             return;
         }
 
-        d->getOrCreateThumbnail();
+        d->getOrCreateThumbnail(task);
         return;
     }
-    case PreviewJobPrivate::STATE_DEVICE_INFO: {
+    case PreviewJobPrivate::Task::STATE_DEVICE_INFO: {
         KIO::StatJob *statJob = static_cast<KIO::StatJob *>(job);
         int id;
         QString path = statJob->url().toLocalFile();
@@ -542,79 +739,72 @@ void PreviewJob::slotResult(KJob *job)
             id = statJob->statResult().numberValue(KIO::UDSEntry::UDS_DEVICE_ID, 0);
         }
         d->deviceIdMap[path] = id;
-        d->createThumbnail(d->currentItem.item.localPath());
+        d->createThumbnail(task, task.item.item.localPath());
         return;
     }
-    case PreviewJobPrivate::STATE_GETORIG: {
+    case PreviewJobPrivate::Task::STATE_GETORIG: {
         if (job->error()) {
-            d->cleanupTempFile();
-            d->determineNextFile();
+            d->finishItem(task);
             return;
         }
 
-        d->createThumbnail(static_cast<KIO::FileCopyJob *>(job)->destUrl().toLocalFile());
+        d->createThumbnail(task, static_cast<KIO::FileCopyJob *>(job)->destUrl().toLocalFile());
         return;
     }
-    case PreviewJobPrivate::STATE_CREATETHUMB: {
-        d->cleanupTempFile();
-        d->determineNextFile();
+    case PreviewJobPrivate::Task::STATE_CREATETHUMB: {
+        d->finishItem(task);
         return;
     }
     }
 }
 
-bool PreviewJobPrivate::statResultThumbnail()
+bool PreviewJobPrivate::statResultThumbnail(Task &task)
 {
     if (thumbPath.isEmpty()) {
         return false;
     }
 
     bool isLocal;
-    const QUrl url = currentItem.item.mostLocalUrl(&isLocal);
+    const QUrl url = task.item.item.mostLocalUrl(&isLocal);
     if (isLocal) {
         const QFileInfo localFile(url.toLocalFile());
         const QString canonicalPath = localFile.canonicalFilePath();
-        origName = QUrl::fromLocalFile(canonicalPath).toEncoded(QUrl::RemovePassword | QUrl::FullyEncoded);
-        if (origName.isEmpty()) {
+        task.origName = QUrl::fromLocalFile(canonicalPath).toEncoded(QUrl::RemovePassword | QUrl::FullyEncoded);
+        if (task.origName.isEmpty()) {
             qCWarning(KIO_GUI) << "Failed to convert" << url << "to canonical path";
             return false;
         }
     } else {
         // Don't include the password if any
-        origName = url.toEncoded(QUrl::RemovePassword);
+        task.origName = url.toEncoded(QUrl::RemovePassword);
     }
 
     QCryptographicHash md5(QCryptographicHash::Md5);
-    md5.addData(origName);
-    thumbName = QString::fromLatin1(md5.result().toHex()) + QLatin1String(".png");
+    md5.addData(task.origName);
+    task.thumbName = QString::fromLatin1(md5.result().toHex()) + QLatin1String(".png");
 
-    QImage thumb;
-    QFile thumbFile(thumbPath + thumbName);
-    if (!thumbFile.open(QIODevice::ReadOnly) || !thumb.load(&thumbFile, "png")) {
+    // Check the metadata first, the image is only decoded if the thumbnail is still valid
+    QFile thumbFile(thumbPath + task.thumbName);
+    ThumbnailTexts texts;
+    if (!thumbFile.open(QIODevice::ReadOnly) || !texts.read(&thumbFile)) {
         return false;
     }
 
-    if (thumb.text(QStringLiteral("Thumb::URI")) != QString::fromUtf8(origName)
-        || thumb.text(QStringLiteral("Thumb::MTime")).toLongLong() != tOrig.toSecsSinceEpoch()) {
+    if (texts.uri != QString::fromUtf8(task.origName) || texts.mtime.toLongLong() != task.tOrig.toSecsSinceEpoch()) {
         return false;
     }
 
-    const QString origSize = thumb.text(QStringLiteral("Thumb::Size"));
-    if (!origSize.isEmpty() && origSize.toULongLong() != currentItem.item.size()) {
+    if (!texts.size.isEmpty() && texts.size.toULongLong() != task.item.item.size()) {
         // Thumb::Size is not required, but if it is set it should match
         return false;
     }
 
-    // The DPR of the loaded thumbnail is unspecified (and typically irrelevant).
-    // When a thumbnail is DPR-invariant, use the DPR passed in the request.
-    thumb.setDevicePixelRatio(devicePixelRatio);
-
-    QString thumbnailerVersion = currentItem.plugin.value(QStringLiteral("ThumbnailerVersion"));
+    QString thumbnailerVersion = task.item.plugin.value(QStringLiteral("ThumbnailerVersion"));
 
-    if (!thumbnailerVersion.isEmpty() && thumb.text(QStringLiteral("Software")).startsWith(QLatin1String("KDE Thumbnail Generator"))) {
+    if (!thumbnailerVersion.isEmpty() && texts.software.startsWith(QLatin1String("KDE Thumbnail Generator"))) {
         // Check if the version matches
         // The software string should read "KDE Thumbnail Generator pluginName (vX)"
-        QString softwareString = thumb.text(QStringLiteral("Software")).remove(QStringLiteral("KDE Thumbnail Generator")).trimmed();
+        QString softwareString = texts.software.remove(QStringLiteral("KDE Thumbnail Generator")).trimmed();
         if (softwareString.isEmpty()) {
             // The thumbnail has been created with an older version, recreating
             return false;
@@ -633,21 +823,30 @@ bool PreviewJobPrivate::statResultThumbnail()
         }
     }
 
+    QImage thumb;
+    if (!thumbFile.seek(0) || !thumb.load(&thumbFile, "png")) {
+        return false;
+    }
+    // The DPR of the loaded thumbnail is unspecified (and typically irrelevant).
+    // When a thumbnail is DPR-invariant, use the DPR passed in the request.
+    thumb.setDevicePixelRatio(devicePixelRatio);
+
     // Found it, use it
-    emitPreview(thumb);
-    succeeded = true;
-    determineNextFile();
+    ThumbnailCacheCleaner::thumbnailUsed(thumbFile);
+    emitPreview(task, thumb);
+    task.succeeded = true;
+    finishItem(task);
     return true;
 }
 
-void PreviewJobPrivate::getOrCreateThumbnail()
+void PreviewJobPrivate::getOrCreateThumbnail(Task &task)
 {
     Q_Q(PreviewJob);
     // We still need to load the orig file ! (This is getting tedious) :)
-    const KFileItem &item = currentItem.item;
+    const KFileItem &item = task.item.item;
     const QString localPath = item.localPath();
     if (!localPath.isEmpty()) {
-        createThumbnail(localPath);
+        createThumbnail(task, localPath);
     } else {
         const QUrl fileUrl = item.url();
         // heuristics for remote URL support
@@ -662,59 +861,62 @@ void PreviewJobPrivate::getOrCreateThumbnail()
         }
 
         if (supportsProtocol) {
-            createThumbnail(fileUrl.toString());
+            createThumbnail(task, fileUrl.toString());
             return;
         }
         if (item.isDir()) {
             // Skip remote dirs (bug 208625)
-            cleanupTempFile();
-            determineNextFile();
+            finishItem(task);
             return;
         }
         // No plugin support access to this remote content, copy the file
         // to the local machine, then create the thumbnail
-        state = PreviewJobPrivate::STATE_GETORIG;
+        task.state = Task::STATE_GETORIG;
         QTemporaryFile localFile;
         localFile.setAutoRemove(false);
         localFile.open();
-        tempName = localFile.fileName();
+        task.tempName = localFile.fileName();
         const QUrl currentURL = item.mostLocalUrl();
-        KIO::Job *job = KIO::file_copy(currentURL, QUrl::fromLocalFile(tempName), -1, KIO::Overwrite | KIO::HideProgressInfo /* No GUI */);
+        KIO::Job *job = KIO::file_copy(currentURL, QUrl::fromLocalFile(task.tempName), -1, KIO::Overwrite | KIO::HideProgressInfo /* No GUI */);
         job->addMetaData(QStringLiteral("thumbnail"), QStringLiteral("1"));
+        task.job = job;
         q->addSubjob(job);
     }
 }
 
-PreviewJobPrivate::CachePolicy PreviewJobPrivate::canBeCached(const QString &path)
+PreviewJobPrivate::CachePolicy PreviewJobPrivate::canBeCached(Task &task, const QString &path)
 {
     // If checked file is directory on a different filesystem than its parent, we need to check it separately
     int separatorIndex = path.lastIndexOf(QLatin1Char('/'));
     // special case for root folders
     const QString parentDirPath = separatorIndex == 0 ? path : path.left(separatorIndex);
 
-    int parentId = getDeviceId(parentDirPath);
+    int parentId = getDeviceId(task, parentDirPath);
     if (parentId == idUnknown) {
         return CachePolicy::Unknown;
     }
 
-    bool isDifferentSystem = !parentId || parentId != currentDeviceId;
-    if (!isDifferentSystem && currentDeviceCachePolicy != CachePolicy::Unknown) {
-        return currentDeviceCachePolicy;
+    bool isDifferentSystem = !parentId || parentId != task.deviceId;
+    if (!isDifferentSystem) {
+        const CachePolicy devicePolicy = deviceCachePolicies.value(task.deviceId, CachePolicy::Unknown);
+        if (devicePolicy != CachePolicy::Unknown) {
+            return devicePolicy;
+        }
     }
     int checkedId;
     QString checkedPath;
     if (isDifferentSystem) {
-        checkedId = currentDeviceId;
+        checkedId = task.deviceId;
         checkedPath = path;
     } else {
-        checkedId = getDeviceId(parentDirPath);
+        checkedId = getDeviceId(task, parentDirPath);
         checkedPath = parentDirPath;
         if (checkedId == idUnknown) {
             return CachePolicy::Unknown;
         }
     }
     // If we're checking different filesystem or haven't checked yet see if filesystem matches thumbRoot
-    int thumbRootId = getDeviceId(thumbRoot);
+    int thumbRootId = getDeviceId(task, thumbRoot);
     if (thumbRootId == idUnknown) {
         return CachePolicy::Unknown;
     }
@@ -733,12 +935,12 @@ PreviewJobPrivate::CachePolicy PreviewJobPrivate::canBeCached(const QString &pat
         }
     }
     if (!isDifferentSystem) {
-        currentDeviceCachePolicy = shouldAllow ? CachePolicy::Allow : CachePolicy::Prevent;
+        deviceCachePolicies.insert(task.deviceId, shouldAllow ? CachePolicy::Allow : CachePolicy::Prevent);
     }
     return shouldAllow ? CachePolicy::Allow : CachePolicy::Prevent;
 }
 
-int PreviewJobPrivate::getDeviceId(const QString &path)
+int PreviewJobPrivate::getDeviceId(Task &task, const QString &path)
 {
     Q_Q(PreviewJob);
     auto iter = deviceIdMap.find(path);
@@ -750,36 +952,39 @@ int PreviewJobPrivate::getDeviceId(const QString &path)
         qCWarning(KIO_GUI) << "Could not get device id for file preview, Invalid url" << path;
         return 0;
     }
-    state = PreviewJobPrivate::STATE_DEVICE_INFO;
+    task.state = Task::STATE_DEVICE_INFO;
     KIO::Job *job = KIO::stat(url, StatJob::SourceSide, KIO::StatDefaultDetails | KIO::StatInode, KIO::HideProgressInfo);
     job->addMetaData(QStringLiteral("no-auth-prompt"), QStringLiteral("true"));
+    task.job = job;
     q->addSubjob(job);
 
     return idUnknown;
 }
 
-void PreviewJobPrivate::createThumbnail(const QString &pixPath)
+void PreviewJobPrivate::createThumbnail(Task &task, const QString &pixPath)
 {
     Q_Q(PreviewJob);
-    state = PreviewJobPrivate::STATE_CREATETHUMB;
+    task.state = Task::STATE_CREATETHUMB;
     QUrl thumbURL;
     thumbURL.setScheme(QStringLiteral("thumbnail"));
     thumbURL.setPath(pixPath);
 
-    bool save = bSave && currentItem.plugin.value(QStringLiteral("CacheThumbnail"), true) && !sequenceIndex;
+    bool save = bSave && task.item.plugin.value(QStringLiteral("CacheThumbnail"), true) && !sequenceIndex;
 
-    bool isRemoteProtocol = currentItem.item.localPath().isEmpty();
-    CachePolicy cachePolicy = isRemoteProtocol ? CachePolicy::Prevent : canBeCached(pixPath);
+    bool isRemoteProtocol = task.item.item.localPath().isEmpty();
+    CachePolicy cachePolicy = isRemoteProtocol ? CachePolicy::Prevent : canBeCached(task, pixPath);
 
     if (cachePolicy == CachePolicy::Unknown) {
         // If Unknown is returned, creating thumbnail should be called again by slotResult
         return;
     }
+    task.cachePolicy = cachePolicy;
 
     KIO::TransferJob *job = KIO::get(thumbURL, NoReload, HideProgressInfo);
+    task.job = job;
     q->addSubjob(job);
-    q->connect(job, &KIO::TransferJob::data, q, [this](KIO::Job *job, const QByteArray &data) {
-        slotThumbData(job, data);
+    q->connect(job, &KIO::TransferJob::data, q, [this, &task](KIO::Job *job, const QByteArray &data) {
+        slotThumbData(task, job, data);
     });
 
     int thumb_width = width;
@@ -788,10 +993,10 @@ void PreviewJobPrivate::createThumbnail(const QString &pixPath)
         thumb_width = thumb_height = cacheSize;
     }
 
-    job->addMetaData(QStringLiteral("mimeType"), currentItem.item.mimetype());
+    job->addMetaData(QStringLiteral("mimeType"), task.item.item.mimetype());
     job->addMetaData(QStringLiteral("width"), QString::number(thumb_width));
     job->addMetaData(QStringLiteral("height"), QString::number(thumb_height));
-    job->addMetaData(QStringLiteral("plugin"), currentItem.plugin.fileName());
+    job->addMetaData(QStringLiteral("plugin"), task.item.plugin.fileName());
     job->addMetaData(QStringLiteral("enabledPlugins"), enabledPlugins.join(QLatin1Char(',')));
     job->addMetaData(QStringLiteral("devicePixelRatio"), QString::number(devicePixelRatio));
     job->addMetaData(QStringLiteral("cache"), QString::number(cachePolicy == CachePolicy::Allow));
@@ -800,44 +1005,31 @@ void PreviewJobPrivate::createThumbnail(const QString &pixPath)
     }
 
 #if WITH_SHM
-    size_t requiredSize = thumb_width * devicePixelRatio * thumb_height * devicePixelRatio * 4;
-    if (shmid == -1 || shmsize < requiredSize) {
-        if (shmaddr) {
-            // clean previous shared memory segment
-            shmdt((char *)shmaddr);
-            shmaddr = nullptr;
-            shmctl(shmid, IPC_RMID, nullptr);
-            shmid = -1;
-        }
-        if (requiredSize > 0) {
-            shmid = shmget(IPC_PRIVATE, requiredSize, IPC_CREAT | 0600);
-            if (shmid != -1) {
-                shmsize = requiredSize;
-                shmaddr = (uchar *)(shmat(shmid, nullptr, SHM_RDONLY));
-                if (shmaddr == (uchar *)-1) {
-                    shmctl(shmid, IPC_RMID, nullptr);
-                    shmaddr = nullptr;
-                    shmid = -1;
-                }
-            }
-        }
+    // Each task has its own segment, the workers write to them at the same time
+    const size_t requiredSize = thumb_width * devicePixelRatio * thumb_height * devicePixelRatio * 4;
+    if (task.shm && task.shm->size < requiredSize) {
+        s_shmPool->release(task.shm);
+        task.shm = nullptr;
+    }
+    if (!task.shm && requiredSize > 0) {
+        task.shm = s_shmPool->acquire(requiredSize);
     }
-    if (shmid != -1) {
-        job->addMetaData(QStringLiteral("shmid"), QString::number(shmid));
+    if (task.shm) {
+        job->addMetaData(QStringLiteral("shmid"), QString::number(task.shm->id));
     }
 #endif
 }
 
-void PreviewJobPrivate::slotThumbData(KIO::Job *job, const QByteArray &data)
+void PreviewJobPrivate::slotThumbData(Task &task, KIO::Job *job, const QByteArray &data)
 {
     thumbnailWorkerMetaData = job->metaData();
     /* clang-format off */
     const bool save = bSave
                       && !sequenceIndex
-                      && currentDeviceCachePolicy == CachePolicy::Allow
-                      && currentItem.plugin.value(QStringLiteral("CacheThumbnail"), true)
-                      && (!currentItem.item.url().isLocalFile()
-                          || !currentItem.item.url().adjusted(QUrl::RemoveFilename).toLocalFile().startsWith(thumbRoot));
+                      && task.cachePolicy == CachePolicy::Allow
+                      && task.item.plugin.value(QStringLiteral("CacheThumbnail"), true)
+                      && (!task.item.item.url().isLocalFile()
+                          || !task.item.item.url().adjusted(QUrl::RemoveFilename).toLocalFile().startsWith(thumbRoot));
     /* clang-format on */
 
     QImage thumb;
@@ -850,8 +1042,8 @@ void PreviewJobPrivate::slotThumbData(KIO::Job *job, const QByteArray &data)
     // TODO KF6: add a version number as first parameter
     str >> width >> height >> format >> imgDevicePixelRatio;
 #if WITH_SHM
-    if (shmaddr != nullptr) {
-        thumb = QImage(shmaddr, width, height, format).copy();
+    if (task.shm) {
+        thumb = QImage(task.shm->address, width, height, format).copy();
     } else {
 #endif
         str >> thumb;
@@ -867,33 +1059,33 @@ void PreviewJobPrivate::slotThumbData(KIO::Job *job, const QByteArray &data)
 
     if (thumb.isNull()) {
         // let succeeded in false state
-        // failed will get called in determineNextFile()
+        // failed will get called in finishItem()
         return;
     }
 
     if (save) {
-        thumb.setText(QStringLiteral("Thumb::URI"), QString::fromUtf8(origName));
-        thumb.setText(QStringLiteral("Thumb::MTime"), QString::number(tOrig.toSecsSinceEpoch()));
-        thumb.setText(QStringLiteral("Thumb::Size"), number(currentItem.item.size()));
-        thumb.setText(QStringLiteral("Thumb::Mimetype"), currentItem.item.mimetype());
-        QString thumbnailerVersion = currentItem.plugin.value(QStringLiteral("ThumbnailerVersion"));
-        QString signature = QLatin1String("KDE Thumbnail Generator ") + currentItem.plugin.name();
+        thumb.setText(QStringLiteral("Thumb::URI"), QString::fromUtf8(task.origName));
+        thumb.setText(QStringLiteral("Thumb::MTime"), QString::number(task.tOrig.toSecsSinceEpoch()));
+        thumb.setText(QStringLiteral("Thumb::Size"), number(task.item.item.size()));
+        thumb.setText(QStringLiteral("Thumb::Mimetype"), task.item.item.mimetype());
+        QString thumbnailerVersion = task.item.plugin.value(QStringLiteral("ThumbnailerVersion"));
+        QString signature = QLatin1String("KDE Thumbnail Generator ") + task.item.plugin.name();
         if (!thumbnailerVersion.isEmpty()) {
             signature.append(QLatin1String(" (v") + thumbnailerVersion + QLatin1Char(')'));
         }
         thumb.setText(QStringLiteral("Software"), signature);
-        QSaveFile saveFile(thumbPath + thumbName);
+        QSaveFile saveFile(thumbPath + task.thumbName);
         if (saveFile.open(QIODevice::WriteOnly)) {
-            if (thumb.save(&saveFile, "PNG")) {
-                saveFile.commit();
+            if (thumb.save(&saveFile, "PNG") && saveFile.commit()) {
+                ThumbnailCacheCleaner::thumbnailWritten(thumbPath + task.thumbName);
             }
         }
     }
-    emitPreview(thumb);
-    succeeded = true;
+    emitPreview(task, thumb);
+    task.succeeded = true;
 }
 
-void PreviewJobPrivate::emitPreview(const QImage &thumb)
+void PreviewJobPrivate::emitPreview(Task &task, const QImage &thumb)
 {
     Q_Q(PreviewJob);
     QPixmap pix;
@@ -904,7 +1096,7 @@ void PreviewJobPrivate::emitPreview(const QImage &thumb)
         pix = QPixmap::fromImage(thumb);
     }
     pix.setDevicePixelRatio(ratio);
-    Q_EMIT q->gotPreview(currentItem.item, pix);
+    Q_EMIT q->gotPreview(task.item.item, pix);
 }
 
 QList<KPluginMetaData> PreviewJob::availableThumbnailerPlugins()
@@ -88,6 +88,20 @@ public:
      */
     void removeItem(const QUrl &url);
 
+    /**
+     * Moves the given items to the front of the preview queue, in the given order,
+     * so that their previews are generated next. Use this when other items became
+     * visible, e.g. after scrolling, rather than starting a new job.
+     * Items which aren't queued anymore are ignored.
+     *
+     * Several previews are generated at the same time, each one by its own
+     * thumbnail worker, the queue decides which ones are started first.
+     *
+     * @param urls the urls of the items, most important first
+     * @since 6.0
+     */
+    void prioritizeItems(const QList<QUrl> &urls);
+
     /**
      * If @p ignoreSize is true, then the preview is always
      * generated regardless of the settings
@@ -182,6 +196,9 @@ Q_SIGNALS:
      */
     void failed(const KFileItem &item);
 
+protected:
+    bool doResume() override;
+
 protected Q_SLOTS:
     void slotResult(KJob *job) override;
 
@@ -0,0 +1,354 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "thumbnailcachecleaner_p.h"
+#include "kiogui_debug.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#ifndef KIO_ANDROID_STUB
+#include <kdirnotify.h>
+#endif
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+#include <vector>
+
+using namespace KIO;
+
+static constexpr qint64 s_day = 24 * 60 * 60;
+// When a pass couldn't meet the budget
+static constexpr qint64 s_retryDelay = 60 * 60;
+static constexpr int s_maximumRemovalsPerPass = 2000;
+// Don't slow down the startup of the application which shows the first previews
+static constexpr int s_cleanupDelay = 60 * 1000; // ms
+static constexpr quint32 s_indexVersion = 1;
+
+// The sizes of https://specifications.freedesktop.org/thumbnail-spec/thumbnail-spec-latest.html#DIRECTORY
+static const char *const s_thumbnailDirs[] = {"normal", "large", "x-large", "xx-large"};
+
+// The time of the last cleanup, shared by all the processes
+static QString stampFilePath(const QString &thumbnailRoot)
+{
+    return thumbnailRoot + QLatin1String(".kio-last-cleanup");
+}
+
+static QString journalPath(const QString &thumbnailRoot)
+{
+    return thumbnailRoot + QLatin1String(".kio-thumbnail-journal");
+}
+
+static QString indexPath(const QString &thumbnailRoot)
+{
+    return thumbnailRoot + QLatin1String(".kio-thumbnail-index");
+}
+
+namespace
+{
+struct IndexEntry {
+    qint64 lastUse; // seconds since epoch
+    qint64 size;
+};
+// By path relative to the thumbnail root, e.g. "normal/<md5>.png"
+using Index = QHash<QString, IndexEntry>;
+}
+
+// Journal lines:
+//   W <time> <size> <path>   written
+//   U <time> <path>          used
+//   R <path>                 removed
+static void appendToJournal(const QString &thumbnailRoot, const QByteArray &line)
+{
+    QFile journal(journalPath(thumbnailRoot));
+    // Unbuffered, so that the line is a single O_APPEND write, not mixed with the ones of other processes
+    if (journal.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        journal.write(line + '\n');
+    }
+}
+
+static QByteArray relativePath(const QString &thumbnailRoot, const QString &path)
+{
+    return path.startsWith(thumbnailRoot) ? QStringView(path).mid(thumbnailRoot.size()).toUtf8() : QByteArray();
+}
+
+static void replayJournal(const QString &thumbnailRoot, const QString &path, Index &index)
+{
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    while (!journal.atEnd()) {
+        const QList<QByteArray> fields = journal.readLine().trimmed().split(' ');
+        if (fields.constFirst() == "W" && fields.size() == 4) {
+            index.insert(QString::fromUtf8(fields.at(3)), {fields.at(1).toLongLong(), fields.at(2).toLongLong()});
+        } else if (fields.constFirst() == "U" && fields.size() == 3) {
+            const QString name = QString::fromUtf8(fields.at(2));
+            const qint64 lastUse = fields.at(1).toLongLong();
+            auto it = index.find(name);
+            if (it != index.end()) {
+                it->lastUse = std::max(it->lastUse, lastUse);
+            } else if (const QFileInfo info(thumbnailRoot + name); info.exists()) {
+                // Written by another thumbnailer
+                index.insert(name, {lastUse, info.size()});
+            }
+        } else if (fields.constFirst() == "R" && fields.size() == 2) {
+            index.remove(QString::fromUtf8(fields.at(1)));
+        }
+    }
+}
+
+static bool loadIndex(const QString &thumbnailRoot, Index &index)
+{
+    QFile file(indexPath(thumbnailRoot));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version = 0;
+    stream >> version;
+    if (version != s_indexVersion) {
+        return false;
+    }
+    quint32 count = 0;
+    stream >> count;
+    index.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString name;
+        IndexEntry entry;
+        stream >> name >> entry.lastUse >> entry.size;
+        index.insert(name, entry);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+static void saveIndex(const QString &thumbnailRoot, const Index &index)
+{
+    QSaveFile file(indexPath(thumbnailRoot));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_indexVersion << quint32(index.size());
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        stream << it.key() << it->lastUse << it->size;
+    }
+    file.commit();
+}
+
+// Only when there is no index yet, e.g. for the thumbnails written before the journal existed
+static void buildIndex(const QString &thumbnailRoot, Index &index)
+{
+    index.clear();
+    for (const char *dir : s_thumbnailDirs) {
+        QDirIterator it(thumbnailRoot + QLatin1String(dir), {QStringLiteral("*.png")}, QDir::Files);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            index.insert(QLatin1String(dir) + QLatin1Char('/') + info.fileName(), {info.lastModified().toSecsSinceEpoch(), info.size()});
+        }
+    }
+}
+
+class KIO::ThumbnailCacheCleanerSingleton
+{
+public:
+    ThumbnailCacheCleaner instance;
+};
+
+Q_GLOBAL_STATIC(ThumbnailCacheCleanerSingleton, s_self)
+
+ThumbnailCacheCleaner *ThumbnailCacheCleaner::self()
+{
+    return &s_self()->instance;
+}
+
+ThumbnailCacheCleaner::ThumbnailCacheCleaner()
+{
+    // A pass at a time is enough, and it shouldn't take a thread from the global pool
+    m_threadPool.setMaxThreadCount(1);
+
+#ifndef KIO_ANDROID_STUB
+    auto *kdirnotify = new org::kde::KDirNotify(QString(), QString(), QDBusConnection::sessionBus(), this);
+    connect(kdirnotify, &org::kde::KDirNotify::FilesRemoved, this, [](const QStringList &urls) {
+        for (const QString &url : urls) {
+            removeThumbnails(QUrl(url));
+        }
+    });
+    // The thumbnails are for the URL, they don't follow the file
+    connect(kdirnotify, &org::kde::KDirNotify::FileRenamedWithLocalPath, this, [](const QString &src) {
+        removeThumbnails(QUrl(src));
+    });
+    connect(kdirnotify, &org::kde::KDirNotify::FilesRenamed, this, [](const QStringList &srcUrls) {
+        for (const QString &url : srcUrls) {
+            removeThumbnails(QUrl(url));
+        }
+    });
+    connect(kdirnotify, &org::kde::KDirNotify::FileMoved, this, [](const QString &src) {
+        removeThumbnails(QUrl(src));
+    });
+#endif
+}
+
+QString ThumbnailCacheCleaner::thumbnailRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/thumbnails/");
+}
+
+void ThumbnailCacheCleaner::thumbnailWritten(const QString &path)
+{
+    const QString root = thumbnailRoot();
+    const QByteArray name = relativePath(root, path);
+    const QFileInfo info(path);
+    if (!name.isEmpty() && info.exists()) {
+        appendToJournal(root, "W " + QByteArray::number(QDateTime::currentSecsSinceEpoch()) + ' ' + QByteArray::number(info.size()) + ' ' + name);
+    }
+}
+
+void ThumbnailCacheCleaner::thumbnailUsed(QFile &thumbnailFile)
+{
+    // The modification time is the time of the last recorded use.
+    // One record per day and thumbnail is enough for the cleanup.
+    const QDateTime now = QDateTime::currentDateTime();
+    if (thumbnailFile.fileTime(QFileDevice::FileModificationTime).secsTo(now) > s_day) {
+        thumbnailFile.setFileTime(now, QFileDevice::FileModificationTime);
+        const QString root = thumbnailRoot();
+        const QByteArray name = relativePath(root, thumbnailFile.fileName());
+        if (!name.isEmpty()) {
+            appendToJournal(root, "U " + QByteArray::number(now.toSecsSinceEpoch()) + ' ' + name);
+        }
+    }
+}
+
+void ThumbnailCacheCleaner::removeThumbnails(const QUrl &url)
+{
+    if (!url.isValid()) {
+        return;
+    }
+    // Same name as in PreviewJob, from the URL of the original. The canonical path of
+    // a local file can't be known anymore, so this misses the ones reached through a symlink.
+    const QByteArray origName = url.toEncoded(QUrl::RemovePassword | QUrl::FullyEncoded);
+    const QString thumbName = QString::fromLatin1(QCryptographicHash::hash(origName, QCryptographicHash::Md5).toHex()) + QLatin1String(".png");
+    const QString root = thumbnailRoot();
+    for (const char *dir : s_thumbnailDirs) {
+        const QString name = QLatin1String(dir) + QLatin1Char('/') + thumbName;
+        if (QFile::remove(root + name)) {
+            appendToJournal(root, "R " + name.toUtf8());
+        }
+    }
+}
+
+void ThumbnailCacheCleaner::scheduleCleanup()
+{
+    if (m_cleanupScheduled) {
+        return;
+    }
+    m_cleanupScheduled = true;
+
+    QTimer::singleShot(s_cleanupDelay, this, [this]() {
+        const QString root = thumbnailRoot();
+        const QString stampFile = stampFilePath(root);
+        const QFileInfo stamp(stampFile);
+        if (stamp.exists() && stamp.lastModified().secsTo(QDateTime::currentDateTime()) < s_day) {
+            return;
+        }
+        // Claim this pass before starting, so that the other processes skip it
+        QFile file(stampFile);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return;
+        }
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        file.close();
+
+        const KConfigGroup cg(KSharedConfig::openConfig(), "PreviewSettings");
+        const qint64 maximumAge = cg.readEntry("CacheMaximumAgeDays", 180) * s_day;
+        const qint64 maximumSize = cg.readEntry("CacheMaximumSizeMiB", 512) * qint64(1024 * 1024);
+        m_threadPool.start([root, stampFile, maximumAge, maximumSize]() {
+            if (!clean(root, maximumAge, maximumSize, s_maximumRemovalsPerPass)) {
+                // Continue soon, by making the last pass look older
+                QFile stamp(stampFile);
+                if (stamp.open(QIODevice::ReadWrite)) {
+                    stamp.setFileTime(QDateTime::currentDateTime().addSecs(s_retryDelay - s_day), QFileDevice::FileModificationTime);
+                }
+            }
+        });
+    });
+}
+
+bool ThumbnailCacheCleaner::clean(const QString &thumbnailRoot, qint64 maximumAge, qint64 maximumSize, int maximumRemovals)
+{
+    Index index;
+    if (!loadIndex(thumbnailRoot, index)) {
+        buildIndex(thumbnailRoot, index);
+    }
+
+    // The lines appended from now on go to a new journal, for the next pass. A journal left
+    // by an interrupted pass is merged again, which is harmless.
+    const QString journal = journalPath(thumbnailRoot);
+    const QString mergedJournal = journal + QLatin1String(".merging");
+    if (!QFile::exists(mergedJournal)) {
+        QFile::rename(journal, mergedJournal);
+    }
+    replayJournal(thumbnailRoot, mergedJournal, index);
+
+    qint64 totalSize = 0;
+    std::vector<std::pair<qint64, QString>> byLastUse;
+    byLastUse.reserve(index.size());
+    for (auto it = index.cbegin(); it != index.cend(); ++it) {
+        totalSize += it->size;
+        byLastUse.emplace_back(it->lastUse, it.key());
+    }
+    // Only the least recently used ones are candidates for this pass
+    const auto candidatesEnd = byLastUse.begin() + std::min<qsizetype>(maximumRemovals, byLastUse.size());
+    std::partial_sort(byLastUse.begin(), candidatesEnd, byLastUse.end());
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    // Leave some room when over budget, so that this isn't needed again right away
+    const qint64 targetSize = maximumSize > 0 && totalSize > maximumSize ? maximumSize * 9 / 10 : maximumSize;
+    auto tooOld = [&](qint64 lastUse) {
+        return maximumAge > 0 && now - lastUse > maximumAge;
+    };
+    auto tooBig = [&]() {
+        return maximumSize > 0 && totalSize > targetSize;
+    };
+
+    int removedCount = 0;
+    auto it = byLastUse.begin();
+    for (; it != candidatesEnd && (tooOld(it->first) || tooBig()); ++it) {
+        // Gone already if the removal fails, e.g. by another program
+        QFile::remove(thumbnailRoot + it->second);
+        totalSize -= index.take(it->second).size;
+        ++removedCount;
+    }
+
+    saveIndex(thumbnailRoot, index);
+    QFile::remove(mergedJournal);
+
+    if (removedCount > 0) {
+        qCDebug(KIO_GUI) << "Removed" << removedCount << "thumbnails from" << thumbnailRoot;
+    }
+    if (it != candidatesEnd) {
+        // Stopped at a thumbnail used recently enough, the following ones were used later
+        return true;
+    }
+    return !tooBig() && std::none_of(candidatesEnd, byLastUse.end(), [&](const std::pair<qint64, QString> &entry) {
+        return tooOld(entry.first);
+    });
+}
+
+#include "moc_thumbnailcachecleaner_p.cpp"
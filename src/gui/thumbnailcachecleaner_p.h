@@ -0,0 +1,82 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KIO_THUMBNAILCACHECLEANER_P_H
+#define KIO_THUMBNAILCACHECLEANER_P_H
+
+#include "kiogui_export.h"
+
+#include <QObject>
+#include <QThreadPool>
+#include <QUrl>
+
+class QFile;
+
+namespace KIO
+{
+class ThumbnailCacheCleanerSingleton;
+
+/**
+ * @internal
+ * Keeps the thumbnail cache (~/.cache/thumbnails) within a size and age budget.
+ *
+ * The cache isn't scanned: writing, using (at most once a day per thumbnail) and removing
+ * a thumbnail appends a line to a journal, shared by all the processes. At most once a day,
+ * a cleanup pass runs in a thread: it merges the journal into an index of the thumbnails with
+ * their size and time of last use, then removes the thumbnails unused for longer than the
+ * maximum age, then the least recently used ones until the cache fits in the maximum size.
+ * A pass removes a bounded number of thumbnails; if the budget isn't met, the next pass comes
+ * an hour later. The index is only built from the directories once, when there is none yet.
+ *
+ * The budget is configured in the "PreviewSettings" group:
+ * @code
+ * [PreviewSettings]
+ * CacheMaximumAgeDays=180
+ * CacheMaximumSizeMiB=512
+ * @endcode
+ * 0 means no limit.
+ *
+ * The thumbnails of the files deleted or renamed through KIO are removed right away,
+ * following the KDirNotify notifications.
+ *
+ * Exported for the unit test.
+ */
+class KIOGUI_EXPORT ThumbnailCacheCleaner : public QObject
+{
+    Q_OBJECT
+public:
+    static ThumbnailCacheCleaner *self();
+
+    // Records that the thumbnail at @p path was just written
+    static void thumbnailWritten(const QString &path);
+
+    // Records the use of the cached thumbnail opened in @p thumbnailFile
+    static void thumbnailUsed(QFile &thumbnailFile);
+
+    // Removes the cached thumbnails of @p url, in all sizes
+    static void removeThumbnails(const QUrl &url);
+
+    // Starts a cleanup pass in the background, unless there was one less than a day ago
+    void scheduleCleanup();
+
+    // A cleanup pass, synchronous. @p maximumAge in seconds, @p maximumSize in bytes, 0 for no limit.
+    // Removes at most @p maximumRemovals thumbnails. Returns false if the budget isn't met yet.
+    static bool clean(const QString &thumbnailRoot, qint64 maximumAge, qint64 maximumSize, int maximumRemovals);
+
+    // The root of the thumbnail cache, with a trailing slash
+    static QString thumbnailRoot();
+
+private:
+    friend class ThumbnailCacheCleanerSingleton;
+    ThumbnailCacheCleaner();
+
+    QThreadPool m_threadPool;
+    bool m_cleanupScheduled = false;
+};
+}
+
+#endif // KIO_THUMBNAILCACHECLEANER_P_H
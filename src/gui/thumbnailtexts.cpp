@@ -0,0 +1,101 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "thumbnailtexts_p.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QtEndian>
+
+using namespace KIO;
+
+// Inflates the zlib stream of a zTXt or compressed iTXt chunk
+static QByteArray uncompressText(QByteArrayView data)
+{
+    // qUncompress() wants the uncompressed size first, it's only a hint for the buffer size though
+    QByteArray compressed(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(quint32(data.size()) * 4, compressed.data());
+    compressed.append(data);
+    return qUncompress(compressed);
+}
+
+bool ThumbnailTexts::read(QIODevice *device)
+{
+    static const QByteArray pngSignature("\x89PNG\r\n\x1a\n", 8);
+    if (device->read(8) != pngSignature) {
+        return false;
+    }
+
+    int found = 0;
+    for (;;) {
+        char header[8];
+        if (device->read(header, 8) != 8) {
+            return false; // truncated
+        }
+        const quint32 length = qFromBigEndian<quint32>(header);
+        const QByteArrayView type(header + 4, 4);
+        if (type == "IEND") {
+            return true;
+        }
+
+        const bool isText = type == "tEXt" || type == "zTXt" || type == "iTXt";
+        // Text chunks are small, anything bigger is likely a corrupted file
+        if (isText && length < 64 * 1024) {
+            const QByteArray data = device->read(length);
+            if (data.size() != qsizetype(length)) {
+                return false;
+            }
+            const qsizetype keyEnd = data.indexOf('\0');
+            if (keyEnd != -1) {
+                const QByteArrayView key = QByteArrayView(data).left(keyEnd);
+                QString value;
+                if (type == "tEXt") {
+                    value = QString::fromLatin1(QByteArrayView(data).mid(keyEnd + 1));
+                } else if (type == "zTXt") {
+                    // keyword \0 compression method, compressed text
+                    if (keyEnd + 1 < data.size() && data.at(keyEnd + 1) == 0) {
+                        value = QString::fromLatin1(uncompressText(QByteArrayView(data).mid(keyEnd + 2)));
+                    }
+                } else {
+                    // keyword \0 compression flag, compression method, language tag \0 translated keyword \0 text
+                    const qsizetype languageEnd = data.indexOf('\0', keyEnd + 3);
+                    const qsizetype translatedKeyEnd = languageEnd == -1 ? -1 : data.indexOf('\0', languageEnd + 1);
+                    if (keyEnd + 2 < data.size() && translatedKeyEnd != -1) {
+                        const QByteArrayView text = QByteArrayView(data).mid(translatedKeyEnd + 1);
+                        if (data.at(keyEnd + 1) == 0) {
+                            value = QString::fromUtf8(text);
+                        } else if (data.at(keyEnd + 2) == 0) {
+                            value = QString::fromUtf8(uncompressText(text));
+                        }
+                    }
+                }
+
+                QString *text = nullptr;
+                if (key == "Thumb::URI") {
+                    text = &uri;
+                } else if (key == "Thumb::MTime") {
+                    text = &mtime;
+                } else if (key == "Thumb::Size") {
+                    text = &size;
+                } else if (key == "Software") {
+                    text = &software;
+                }
+                if (text && text->isNull() && !value.isNull()) {
+                    *text = value;
+                    if (++found == 4) {
+                        return true;
+                    }
+                }
+            }
+            if (!device->skip(4)) { // CRC
+                return false;
+            }
+        } else if (!device->seek(device->pos() + qint64(length) + 4)) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/*
+    This file is part of the KDE libraries
+    SPDX-FileCopyrightText: 2026 The KDE Community <kde-devel@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KIO_THUMBNAILTEXTS_P_H
+#define KIO_THUMBNAILTEXTS_P_H
+
+#include "kiogui_export.h"
+
+#include <QString>
+
+class QIODevice;
+
+namespace KIO
+{
+/**
+ * @internal
+ * The text chunks of a cached thumbnail, needed to know whether it's still valid.
+ *
+ * Exported for the unit test.
+ */
+struct KIOGUI_EXPORT ThumbnailTexts {
+    QString uri;
+    QString mtime;
+    QString size;
+    QString software;
+
+    /**
+     * Reads the texts from the PNG file in @p device without decoding the image: the chunk
+     * headers are read, the other chunks (e.g. the image data) are skipped. Stops as soon as
+     * all the texts are found.
+     * Handles tEXt, zTXt and iTXt chunks. Qt compresses the values of 40 characters or more,
+     * which most URIs are.
+     * Returns false if @p device isn't a valid PNG file.
+     */
+    bool read(QIODevice *device);
+};
+}
+
+#endif // KIO_THUMBNAILTEXTS_P_H
@@ -15,6 +15,8 @@ check_include_files("sys/types.h;sys/extattr.h" HAVE_SYS_EXTATTR_H)
 
 check_function_exists(copy_file_range HAVE_COPY_FILE_RANGE)
 
+check_function_exists(renameat2 HAVE_RENAMEAT2)
+
 check_function_exists(posix_fadvise    HAVE_FADVISE)                  # KIO worker
 
 check_struct_has_member("struct dirent" d_type dirent.h HAVE_DIRENT_D_TYPE LANGUAGE CXX)
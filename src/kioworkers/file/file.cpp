@@ -245,6 +245,35 @@ WorkerResult FileProtocol::mkdir(const QUrl &url, int permissions)
     return WorkerResult::fail(KIO::ERR_FILE_ALREADY_EXIST, path);
 }
 
+WorkerResult FileProtocol::mkpath(const QUrl &url, const QUrl &)
+{
+    const QString path(url.adjusted(QUrl::StripTrailingSlash).toLocalFile());
+
+    // Look for the deepest existing ancestor, then create the directories below it
+    QStringList missingDirs;
+    QString existingDir = path;
+    QT_STATBUF buff;
+    while (QT_STAT(QFile::encodeName(existingDir).constData(), &buff) == -1) {
+        const QString parentDir = QFileInfo(existingDir).path();
+        if (parentDir == existingDir) {
+            return WorkerResult::fail(KIO::ERR_CANNOT_MKDIR, path);
+        }
+        missingDirs.prepend(existingDir);
+        existingDir = parentDir;
+    }
+    if (!Utils::isDirMask(buff.st_mode)) {
+        return WorkerResult::fail(KIO::ERR_FILE_ALREADY_EXIST, existingDir);
+    }
+
+    for (const QString &dir : std::as_const(missingDirs)) {
+        const WorkerResult result = mkdir(QUrl::fromLocalFile(dir), -1);
+        if (!result.success() && result.error() != KIO::ERR_DIR_ALREADY_EXIST) {
+            return result;
+        }
+    }
+    return WorkerResult::pass();
+}
+
 WorkerResult FileProtocol::redirect(const QUrl &url)
 {
     QUrl redir(url);
@@ -48,6 +48,7 @@ public:
     KIO::WorkerResult stat(const QUrl &url) override;
     KIO::WorkerResult listDir(const QUrl &url) override;
     KIO::WorkerResult mkdir(const QUrl &url, int permissions) override;
+    KIO::WorkerResult mkpath(const QUrl &url, const QUrl &baseUrl) override;
     KIO::WorkerResult chmod(const QUrl &url, int permissions) override;
     KIO::WorkerResult chown(const QUrl &url, const QString &owner, const QString &group) override;
     KIO::WorkerResult setModificationTime(const QUrl &url, const QDateTime &mtime) override;
@@ -61,6 +62,12 @@ public:
     KIO::WorkerResult close() override;
 
     KIO::WorkerResult fileSystemFreeSpace(const QUrl &url) override;
+#ifdef Q_OS_UNIX
+    KIO::WorkerResult listRecursive(const QUrl &url, bool includeHidden) override;
+    KIO::WorkerResult directorySize(const QUrl &url) override;
+    KIO::WorkerResult chmodRecursive(const QUrl &url, int permissions, int mask, const QString &owner, const QString &group) override;
+    KIO::WorkerResult renameBatch(const QList<QUrl> &srcUrls, const QList<QUrl> &destUrls, KIO::JobFlags flags) override;
+#endif
 
     /**
      * Special commands supported by this worker:
@@ -80,6 +87,11 @@ private:
     QString getUserName(KUserId uid) const;
     QString getGroupName(KGroupId gid) const;
     KIO::WorkerResult deleteRecursive(const QString &path);
+#ifdef Q_OS_UNIX
+    struct ChmodRecursiveState;
+    KIO::WorkerResult chmodDirectoryContents(int dirFd, const QByteArray &path, ChmodRecursiveState &state);
+    KIO::WorkerResult chmodEntry(int dirFd, const char *name, const QByteArray &path, mode_t mode, bool topLevel, ChmodRecursiveState &state);
+#endif
 
     bool privilegeOperationUnitTestMode();
     KIO::WorkerResult execWithElevatedPrivilege(ActionType action, const QVariantList &args, int errcode);
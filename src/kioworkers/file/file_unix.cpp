@@ -20,10 +20,13 @@
 #endif
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QMimeDatabase>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QThread>
+#include <QThreadPool>
 #include <qplatformdefs.h>
 
 #include <KConfigGroup>
@@ -33,7 +36,11 @@
 #include <kmountpoint.h>
 
 #include <array>
+#include <atomic>
 #include <cerrno>
+#include <fcntl.h>
+#include <set>
+#include <utility>
 #include <stdint.h>
 #include <utime.h>
 
@@ -63,6 +70,10 @@
 #include <unistd.h>
 #endif
 
+#if HAVE_RENAMEAT2
+#include <stdio.h> // renameat2, RENAME_NOREPLACE
+#endif
+
 #if HAVE_SYS_XATTR_H
 #include <sys/xattr.h>
 // BSD uses a different include
@@ -1138,6 +1149,617 @@ WorkerResult FileProtocol::listDir(const QUrl &url)
     return WorkerResult::pass();
 }
 
+/**
+ * Computes the totals for FileProtocol::directorySize().
+ *
+ * Every directory is read by a task in a thread pool, entries are stat'ed
+ * relative to the directory fd and subdirectories are queued as new tasks,
+ * so that several directories are read in parallel.
+ */
+class DirectorySizeWalker
+{
+public:
+    explicit DirectorySizeWalker(QThreadPool *pool)
+        : m_pool(pool)
+    {
+    }
+
+    // Accounts for the top-level directory itself (the "." entry of a listing)
+    void addTopLevel(const struct stat &buff)
+    {
+        m_inodes[buff.st_dev].insert(buff.st_ino);
+        m_size += buff.st_size;
+        m_allocated += KIO::filesize_t(buff.st_blocks) * 512;
+    }
+
+    void queueDirectory(const QByteArray &path)
+    {
+        m_pool->start([this, path]() {
+            walkDirectory(path);
+        });
+    }
+
+    void cancel()
+    {
+        m_cancelled = true;
+    }
+
+    void setMetaData(FileProtocol *worker) const
+    {
+        worker->setMetaData(QStringLiteral("size"), QString::number(m_size.load()));
+        worker->setMetaData(QStringLiteral("allocated"), QString::number(m_allocated.load()));
+        worker->setMetaData(QStringLiteral("files"), QString::number(m_files.load()));
+        worker->setMetaData(QStringLiteral("subdirs"), QString::number(m_subdirs.load()));
+    }
+
+private:
+    void walkDirectory(const QByteArray &path)
+    {
+        if (m_cancelled) {
+            return;
+        }
+        const int fd = ::open(path.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd == -1) {
+            return; // Like ListJob, skip subdirectories we can't enter
+        }
+        DIR *dp = fdopendir(fd);
+        if (!dp) {
+            ::close(fd);
+            return;
+        }
+
+        QList<QByteArray> subdirs;
+        QT_DIRENT *ep;
+        while ((ep = QT_READDIR(dp)) != nullptr && !m_cancelled) {
+            const char *name = ep->d_name;
+            if (qstrcmp(name, ".") == 0 || qstrcmp(name, "..") == 0) {
+                continue;
+            }
+            struct stat buff;
+            if (::fstatat(dirfd(dp), name, &buff, AT_SYMLINK_NOFOLLOW) == -1) {
+                continue;
+            }
+            if (S_ISLNK(buff.st_mode)) {
+                // Symlinks are not followed and their size isn't counted,
+                // but a link to a directory counts as a subdirectory
+                struct stat target;
+                if (::fstatat(dirfd(dp), name, &target, 0) == 0 && S_ISDIR(target.st_mode)) {
+                    ++m_subdirs;
+                } else {
+                    ++m_files;
+                }
+                continue;
+            }
+            // Hard-link detection (#67939)
+            if (!S_ISDIR(buff.st_mode) && buff.st_nlink > 1 && !isNewInode(buff)) {
+                continue;
+            }
+            m_size += buff.st_size;
+            m_allocated += KIO::filesize_t(buff.st_blocks) * 512;
+            if (S_ISDIR(buff.st_mode)) {
+                ++m_subdirs;
+                subdirs.append(path + '/' + name);
+            } else {
+                ++m_files;
+            }
+        }
+        closedir(dp);
+
+        for (const QByteArray &subdir : std::as_const(subdirs)) {
+            queueDirectory(subdir);
+        }
+    }
+
+    bool isNewInode(const struct stat &buff)
+    {
+        QMutexLocker locker(&m_inodesMutex);
+        const auto [it, isNew] = m_inodes[buff.st_dev].insert(buff.st_ino);
+        return isNew;
+    }
+
+    QThreadPool *const m_pool;
+    std::atomic<bool> m_cancelled = false;
+    std::atomic<KIO::filesize_t> m_size = 0;
+    std::atomic<KIO::filesize_t> m_allocated = 0;
+    std::atomic<KIO::filesize_t> m_files = 0;
+    std::atomic<KIO::filesize_t> m_subdirs = 0;
+    QMutex m_inodesMutex;
+    QHash<dev_t, std::set<ino_t>> m_inodes; // device -> set of inodes
+};
+
+WorkerResult FileProtocol::directorySize(const QUrl &url)
+{
+    if (!isLocalFileSameHost(url)) {
+        // Let DirectorySizeJob fall back to listing, which handles the redirection
+        return WorkerResult::fail(KIO::ERR_UNSUPPORTED_ACTION, QStringLiteral("directorySize"));
+    }
+    const QString path(url.adjusted(QUrl::StripTrailingSlash).toLocalFile());
+    const QByteArray _path(QFile::encodeName(path));
+
+    struct stat buff;
+    if (::stat(_path.constData(), &buff) == -1) {
+        return WorkerResult::fail(errno == EACCES ? KIO::ERR_ACCESS_DENIED : KIO::ERR_DOES_NOT_EXIST, path);
+    }
+    if (!S_ISDIR(buff.st_mode)) {
+        return WorkerResult::fail(KIO::ERR_IS_FILE, path);
+    }
+    if (::access(_path.constData(), R_OK | X_OK) == -1) {
+        return WorkerResult::fail(KIO::ERR_CANNOT_ENTER_DIRECTORY, path);
+    }
+
+    // The traversal is I/O bound, a few threads are enough to keep the disk busy
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+
+    DirectorySizeWalker walker(&pool);
+    walker.addTopLevel(buff);
+    walker.queueDirectory(_path);
+
+    // Stream intermediate totals, DirectorySizeJob exposes them while running
+    while (!pool.waitForDone(200)) {
+        if (wasKilled()) {
+            walker.cancel();
+            pool.waitForDone();
+            return WorkerResult::pass();
+        }
+        walker.setMetaData(this);
+        sendMetaData();
+    }
+
+    walker.setMetaData(this);
+    return WorkerResult::pass();
+}
+
+/**
+ * Lists a directory tree for FileProtocol::listRecursive().
+ *
+ * Like DirectorySizeWalker, every directory is read by a task in a thread pool,
+ * subdirectories being queued as new tasks. The entries are collected for the
+ * worker thread, which sends them to the application.
+ */
+class RecursiveListWalker
+{
+public:
+    RecursiveListWalker(QThreadPool *pool, KIO::StatDetails details, bool includeHidden)
+        : m_pool(pool)
+        , m_details(details)
+        , m_includeHidden(includeHidden)
+    {
+    }
+
+    // An empty @p prefix means the top-level directory
+    void queueDirectory(const QByteArray &path, const QString &prefix)
+    {
+        m_pool->start([this, path, prefix]() {
+            walkDirectory(path, prefix);
+        });
+    }
+
+    void cancel()
+    {
+        m_cancelled = true;
+    }
+
+    KIO::UDSEntryList takeEntries()
+    {
+        QMutexLocker locker(&m_entriesMutex);
+        return std::exchange(m_entries, KIO::UDSEntryList());
+    }
+
+private:
+    void walkDirectory(const QByteArray &path, const QString &prefix)
+    {
+        if (m_cancelled) {
+            return;
+        }
+        const bool topLevel = prefix.isEmpty();
+        // Symlinks to directories are only followed for the top-level directory, like listDir()
+        const int fd = ::open(path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | (topLevel ? 0 : O_NOFOLLOW));
+        if (fd == -1) {
+            return; // Like ListJob, skip subdirectories we can't enter
+        }
+        DIR *dp = fdopendir(fd);
+        if (!dp) {
+            ::close(fd);
+            return;
+        }
+
+        const QByteArray encodedBasePath = path + '/';
+        KIO::UDSEntryList entries;
+        QList<std::pair<QByteArray, QString>> subdirs; // path, prefix
+        QT_DIRENT *ep;
+        while ((ep = QT_READDIR(dp)) != nullptr && !m_cancelled) {
+            const char *name = ep->d_name;
+            const bool isDotOrDotDot = qstrcmp(name, ".") == 0 || qstrcmp(name, "..") == 0;
+            // Only the top-level directory has "." and ".."
+            if ((isDotOrDotDot && !topLevel) || (!m_includeHidden && name[0] == '.')) {
+                continue;
+            }
+            const QString relativePath = prefix + QFile::decodeName(name);
+
+            KIO::UDSEntry entry;
+            bool isDir;
+            bool isLink;
+            if (m_details == KIO::StatBasic) {
+                // The fast path of listDir(), but we need to know about all the directories
+#ifdef HAVE_DIRENT_D_TYPE
+                if (ep->d_type != DT_UNKNOWN) {
+                    isDir = (ep->d_type == DT_DIR);
+                    isLink = (ep->d_type == DT_LNK);
+                } else
+#endif
+                {
+                    struct stat buff;
+                    if (::fstatat(dirfd(dp), name, &buff, AT_SYMLINK_NOFOLLOW) == -1) {
+                        continue;
+                    }
+                    isDir = S_ISDIR(buff.st_mode);
+                    isLink = S_ISLNK(buff.st_mode);
+                }
+                entry.reserve(isLink ? 3 : 2);
+                entry.fastInsert(KIO::UDSEntry::UDS_NAME, relativePath);
+                entry.fastInsert(KIO::UDSEntry::UDS_FILE_TYPE, isDir ? S_IFDIR : S_IFREG);
+                if (isLink) {
+                    entry.fastInsert(KIO::UDSEntry::UDS_LINK_DEST, QStringLiteral("Dummy Link Target"));
+                }
+            } else {
+                const QByteArray entryPath = encodedBasePath + name;
+                if (!createUDSEntry(relativePath, entryPath, entry, m_details, QFile::decodeName(entryPath))) {
+                    continue;
+                }
+                isDir = entry.isDir();
+                isLink = entry.isLink();
+            }
+
+            if (isDir && !isLink && !isDotOrDotDot) {
+                subdirs.append({encodedBasePath + name, relativePath + QLatin1Char('/')});
+            }
+            entries.append(std::move(entry));
+        }
+        closedir(dp);
+
+        if (!entries.isEmpty()) {
+            QMutexLocker locker(&m_entriesMutex);
+            m_entries.append(std::move(entries));
+        }
+        for (const auto &[subdirPath, subdirPrefix] : std::as_const(subdirs)) {
+            queueDirectory(subdirPath, subdirPrefix);
+        }
+    }
+
+    QThreadPool *const m_pool;
+    const KIO::StatDetails m_details;
+    const bool m_includeHidden;
+    std::atomic<bool> m_cancelled = false;
+    QMutex m_entriesMutex;
+    KIO::UDSEntryList m_entries; // not sent yet
+};
+
+WorkerResult FileProtocol::listRecursive(const QUrl &url, bool includeHidden)
+{
+    if (!isLocalFileSameHost(url)) {
+        // Let ListJob fall back to listing every directory, which handles the redirection
+        return WorkerResult::fail(KIO::ERR_UNSUPPORTED_ACTION, QStringLiteral("listRecursive"));
+    }
+    const QString path(url.toLocalFile());
+    const QByteArray _path(QFile::encodeName(path));
+
+    // Report the errors about the top-level directory like listDir(), the others are skipped
+    const int fd = ::open(_path.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        switch (errno) {
+        case ENOENT:
+            return WorkerResult::fail(KIO::ERR_DOES_NOT_EXIST, path);
+        case ENOTDIR:
+            return WorkerResult::fail(KIO::ERR_IS_FILE, path);
+#ifdef ENOMEDIUM
+        case ENOMEDIUM:
+            return WorkerResult::fail(ERR_WORKER_DEFINED, i18n("No media in device for %1", path));
+#endif
+        default:
+            return WorkerResult::fail(KIO::ERR_CANNOT_ENTER_DIRECTORY, path);
+        }
+    }
+    ::close(fd);
+
+    // The traversal is I/O bound, a few threads are enough to keep the disk busy
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+
+    RecursiveListWalker walker(&pool, getStatDetails(), includeHidden);
+    walker.queueDirectory(_path, QString());
+
+    // Send the entries while walking, so that the application can process them already
+    while (!pool.waitForDone(100)) {
+        if (wasKilled()) {
+            walker.cancel();
+            pool.waitForDone();
+            return WorkerResult::pass();
+        }
+        const KIO::UDSEntryList entries = walker.takeEntries();
+        if (!entries.isEmpty()) {
+            listEntries(entries);
+        }
+    }
+
+    const KIO::UDSEntryList entries = walker.takeEntries();
+    if (!entries.isEmpty()) {
+        listEntries(entries);
+    }
+    return WorkerResult::pass();
+}
+
+struct FileProtocol::ChmodRecursiveState {
+    int permissions;
+    int mask;
+    uid_t uid = uid_t(-1); // -1: unchanged
+    gid_t gid = gid_t(-1);
+    bool hasAcl = false;
+    KIO::filesize_t processedItems = 0;
+    QElapsedTimer progressTimer;
+};
+
+WorkerResult FileProtocol::chmodEntry(int dirFd, const char *name, const QByteArray &path, mode_t mode, bool topLevel, ChmodRecursiveState &state)
+{
+    // First update owner / group, permissions have to be set after, in case of suid and sgid
+    if ((state.uid != uid_t(-1) || state.gid != gid_t(-1)) && ::fchownat(dirFd, name, state.uid, state.gid, AT_SYMLINK_NOFOLLOW) == -1) {
+        auto result = execWithElevatedPrivilege(CHOWN, {path, state.uid, state.gid}, errno);
+        if (!result.success()) {
+            if (!resultWasCancelled(result)) {
+                return WorkerResult::fail(KIO::ERR_CANNOT_CHOWN, QFile::decodeName(path));
+            }
+            return result;
+        }
+    }
+
+    const int currentPermissions = mode & 0777; // get rid of "set gid" and other special flags
+    int mask = state.mask;
+    // Same rules as ChmodJob: emulate +X below the top-level directory,
+    // i.e. only give +x to files that had a +x bit already
+    if (!topLevel && !S_ISDIR(mode)) {
+        const int newPerms = state.permissions & mask;
+        if ((newPerms & 0111) && !(currentPermissions & 0111)) {
+            // don't interfere with mandatory file locking
+            mask &= (newPerms & 02000) ? ~0101 : ~0111;
+        }
+    }
+    const int permissions = (state.permissions & mask) | (currentPermissions & ~mask);
+
+    if (::fchmodat(dirFd, name, permissions, 0) == -1
+        || (state.hasAcl
+            && ((setACL(path.constData(), permissions, false) == -1)
+                /* if not a directory, cannot set default ACLs */
+                || (S_ISDIR(mode) && setACL(path.constData(), permissions, true) == -1)))) {
+        auto result = execWithElevatedPrivilege(CHMOD, {path, permissions}, errno);
+        if (!result.success()) {
+            if (!resultWasCancelled(result)) {
+                const QString filePath = QFile::decodeName(path);
+                switch (result.error()) {
+                case EPERM:
+                case EACCES:
+                    return WorkerResult::fail(KIO::ERR_ACCESS_DENIED, filePath);
+                case ENOSPC:
+                    return WorkerResult::fail(KIO::ERR_DISK_FULL, filePath);
+                default:
+                    // Also ENOTSUP from setACL, chmod can't return it. Not ERR_UNSUPPORTED_ACTION,
+                    // ChmodJob would take that as the worker not supporting the command.
+                    return WorkerResult::fail(KIO::ERR_CANNOT_CHMOD, filePath);
+                }
+            }
+            return result;
+        }
+    }
+
+    ++state.processedItems;
+    if (state.progressTimer.hasExpired(200)) {
+        processedSize(state.processedItems);
+        state.progressTimer.restart();
+    }
+    return WorkerResult::pass();
+}
+
+// Takes ownership of dirFd. Children are handled before their directory,
+// so that removing permissions from a directory can't lock us out of it.
+WorkerResult FileProtocol::chmodDirectoryContents(int dirFd, const QByteArray &path, ChmodRecursiveState &state)
+{
+    DIR *dp = fdopendir(dirFd);
+    if (!dp) {
+        ::close(dirFd);
+        return WorkerResult::fail(KIO::ERR_CANNOT_ENTER_DIRECTORY, QFile::decodeName(path));
+    }
+
+    WorkerResult result = WorkerResult::pass();
+    QT_DIRENT *ep;
+    while (result.success() && (ep = QT_READDIR(dp)) != nullptr) {
+        const char *name = ep->d_name;
+        if (qstrcmp(name, ".") == 0 || qstrcmp(name, "..") == 0) {
+            continue;
+        }
+        struct stat buff;
+        if (::fstatat(dirfd(dp), name, &buff, AT_SYMLINK_NOFOLLOW) == -1 || S_ISLNK(buff.st_mode)) {
+            continue; // don't do anything with symlinks
+        }
+        const QByteArray childPath = path + '/' + name;
+        if (S_ISDIR(buff.st_mode)) {
+            const int childFd = ::openat(dirfd(dp), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            // Like ListJob, skip the contents of subdirectories we can't enter
+            if (childFd != -1) {
+                result = chmodDirectoryContents(childFd, childPath, state);
+            }
+            if (!result.success() || wasKilled()) {
+                break;
+            }
+        }
+        result = chmodEntry(dirfd(dp), name, childPath, buff.st_mode, false, state);
+    }
+    closedir(dp);
+
+    return result;
+}
+
+WorkerResult FileProtocol::chmodRecursive(const QUrl &url, int permissions, int mask, const QString &owner, const QString &group)
+{
+    if (!isLocalFileSameHost(url)) {
+        // Let ChmodJob fall back to listing, which handles the redirection
+        return WorkerResult::fail(KIO::ERR_UNSUPPORTED_ACTION, QStringLiteral("chmodRecursive"));
+    }
+    const QString path(url.adjusted(QUrl::StripTrailingSlash).toLocalFile());
+    const QByteArray _path(QFile::encodeName(path));
+
+    ChmodRecursiveState state;
+    state.permissions = permissions;
+    state.mask = mask;
+    // Unknown names leave the ownership unchanged, like in ChmodJob
+    if (!owner.isEmpty()) {
+        if (struct passwd *p = ::getpwnam(owner.toLocal8Bit().constData())) {
+            state.uid = p->pw_uid;
+        }
+    }
+    if (!group.isEmpty()) {
+        if (struct group *p = ::getgrnam(group.toLocal8Bit().constData())) {
+            state.gid = p->gr_gid;
+        }
+    }
+    state.hasAcl = !metaData(QStringLiteral("ACL_STRING")).isEmpty() || !metaData(QStringLiteral("DEFAULT_ACL_STRING")).isEmpty();
+    state.progressTimer.start();
+
+    struct stat buff;
+    if (::lstat(_path.constData(), &buff) == -1) {
+        return WorkerResult::fail(errno == EACCES ? KIO::ERR_ACCESS_DENIED : KIO::ERR_DOES_NOT_EXIST, path);
+    }
+    if (S_ISLNK(buff.st_mode)) {
+        return WorkerResult::pass(); // don't do anything with symlinks
+    }
+
+    if (S_ISDIR(buff.st_mode)) {
+        const int fd = ::open(_path.constData(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd != -1) {
+            const WorkerResult result = chmodDirectoryContents(fd, _path, state);
+            if (!result.success() || wasKilled()) {
+                return result;
+            }
+        }
+    }
+
+    // This is the toplevel item, no +X emulation here
+    const WorkerResult result = chmodEntry(AT_FDCWD, _path.constData(), _path, buff.st_mode, true, state);
+    processedSize(state.processedItems);
+    return result;
+}
+
+// Renames @p src without replacing an existing @p dest, atomically when the system supports it
+static int renameNoReplace(const char *src, const char *dest)
+{
+#if HAVE_RENAMEAT2
+    if (::renameat2(AT_FDCWD, src, AT_FDCWD, dest, RENAME_NOREPLACE) == 0) {
+        return 0;
+    }
+    if (errno != EINVAL && errno != ENOSYS) { // EINVAL: the filesystem doesn't support RENAME_NOREPLACE
+        return -1;
+    }
+#endif
+    QT_STATBUF buff;
+    if (QT_LSTAT(dest, &buff) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return ::rename(src, dest);
+}
+
+WorkerResult FileProtocol::renameBatch(const QList<QUrl> &srcUrls, const QList<QUrl> &destUrls, KIO::JobFlags flags)
+{
+    if (srcUrls.size() != destUrls.size()) {
+        return WorkerResult::fail(KIO::ERR_INTERNAL, QStringLiteral("renameBatch"));
+    }
+    QList<QByteArray> srcs;
+    QList<QByteArray> dests;
+    srcs.reserve(srcUrls.size());
+    dests.reserve(destUrls.size());
+    for (qsizetype i = 0; i < srcUrls.size(); ++i) {
+        if (!isLocalFileSameHost(srcUrls.at(i)) || !isLocalFileSameHost(destUrls.at(i))) {
+            // Let BatchRenameJob rename the items one by one, which handles the redirection
+            return WorkerResult::fail(KIO::ERR_UNSUPPORTED_ACTION, QStringLiteral("renameBatch"));
+        }
+        srcs.append(QFile::encodeName(srcUrls.at(i).toLocalFile()));
+        dests.append(QFile::encodeName(destUrls.at(i).toLocalFile()));
+    }
+
+    // Find the destinations that are already taken before renaming anything,
+    // taking into account the paths freed and taken by the renames before them.
+    // This catches collisions between items as well as cycles (a -> b, b -> a).
+    // These items are skipped, the job renames them on their own afterwards.
+    QList<bool> conflicts(srcs.size(), false);
+    if (!(flags & KIO::Overwrite)) {
+        QStringList conflictIndexes;
+        QHash<QByteArray, bool> taken; // path -> whether it exists after the previous renames
+        for (qsizetype i = 0; i < srcs.size(); ++i) {
+            const auto it = taken.constFind(dests.at(i));
+            QT_STATBUF buff;
+            if (it != taken.constEnd() ? it.value() : QT_LSTAT(dests.at(i).constData(), &buff) == 0) {
+                conflicts[i] = true;
+                conflictIndexes.append(QString::number(i));
+                continue;
+            }
+            taken.insert(srcs.at(i), false);
+            taken.insert(dests.at(i), true);
+        }
+        if (!conflictIndexes.isEmpty()) {
+            setMetaData(QStringLiteral("renameBatchConflicts"), conflictIndexes.join(QLatin1Char(',')));
+            sendMetaData();
+        }
+    }
+
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    for (qsizetype i = 0; i < srcs.size(); ++i) {
+        if (wasKilled()) {
+            processedSize(i);
+            return WorkerResult::pass();
+        }
+        if (conflicts[i]) {
+            continue;
+        }
+        const char *src = srcs.at(i).constData();
+        const char *dest = dests.at(i).constData();
+        if (((flags & KIO::Overwrite) ? ::rename(src, dest) : renameNoReplace(src, dest)) == -1) {
+            const int errCode = errno;
+            // Like rename(), retry with elevated privileges, unless the destination got taken meanwhile
+            auto result = (errCode == EEXIST || errCode == ENOTEMPTY) ? WorkerResult::fail(errCode)
+                                                                       : execWithElevatedPrivilege(RENAME, {srcs.at(i), dests.at(i)}, errCode);
+            if (!result.success()) {
+                processedSize(i);
+                if (resultWasCancelled(result)) {
+                    return result;
+                }
+                switch (result.error()) {
+                case EEXIST:
+                case ENOTEMPTY:
+                    // Taken since the check above: the job renames this item on its own
+                    return WorkerResult::fail(KIO::ERR_FILE_ALREADY_EXIST, destUrls.at(i).toLocalFile());
+                case EXDEV:
+                    return WorkerResult::fail(KIO::ERR_UNSUPPORTED_ACTION, QStringLiteral("renameBatch"));
+                case EACCES:
+                case EPERM:
+                    return WorkerResult::fail(KIO::ERR_WRITE_ACCESS_DENIED, destUrls.at(i).toLocalFile());
+                case ENOENT:
+                    return WorkerResult::fail(KIO::ERR_DOES_NOT_EXIST, srcUrls.at(i).toLocalFile());
+                case ENOSPC:
+                    return WorkerResult::fail(KIO::ERR_DISK_FULL, destUrls.at(i).toLocalFile());
+                default:
+                    return WorkerResult::fail(KIO::ERR_CANNOT_RENAME, srcUrls.at(i).toLocalFile());
+                }
+            }
+        }
+        if (progressTimer.hasExpired(200)) {
+            processedSize(i + 1);
+            progressTimer.restart();
+        }
+    }
+
+    processedSize(srcs.size());
+    return WorkerResult::pass();
+}
+
 WorkerResult FileProtocol::rename(const QUrl &srcUrl, const QUrl &destUrl, KIO::JobFlags _flags)
 {
     char off_t_should_be_64_bits[sizeof(off_t) >= 8 ? 1 : -1];
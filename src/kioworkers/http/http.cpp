@@ -1191,6 +1191,38 @@ KIO::WorkerResult HTTPProtocol::mkdir(const QUrl &url, int)
     return davError();
 }
 
+KIO::WorkerResult HTTPProtocol::mkpath(const QUrl &url, const QUrl &baseUrl)
+{
+    qCDebug(KIO_HTTP) << url << baseUrl;
+
+    // Optimistically create the deepest collection first, the server answers
+    // 409 Conflict when an intermediate collection is missing
+    KIO::WorkerResult result = mkdir(url, -1);
+    if (result.success() || result.error() == ERR_DIR_ALREADY_EXIST) {
+        return WorkerResult::pass();
+    }
+    if (m_request.responseCode != 409) {
+        return result;
+    }
+
+    const QUrl dirUrl = url.adjusted(QUrl::StripTrailingSlash);
+    const QUrl parentUrl = dirUrl.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    if (parentUrl == dirUrl || parentUrl == baseUrl.adjusted(QUrl::StripTrailingSlash)) {
+        return result; // the parent exists, the conflict is about something else
+    }
+
+    // Create the missing parents, then try again
+    result = mkpath(parentUrl, baseUrl);
+    if (!result.success()) {
+        return result;
+    }
+    result = mkdir(url, -1);
+    if (result.success() || result.error() == ERR_DIR_ALREADY_EXIST) {
+        return WorkerResult::pass();
+    }
+    return result;
+}
+
 KIO::WorkerResult HTTPProtocol::get(const QUrl &url)
 {
     qCDebug(KIO_HTTP) << url;
@@ -212,6 +212,7 @@ public:
     //----------------- Re-implemented methods for WebDAV -----------
     KIO::WorkerResult listDir(const QUrl &url) override;
     KIO::WorkerResult mkdir(const QUrl &url, int _permissions) override;
+    KIO::WorkerResult mkpath(const QUrl &url, const QUrl &baseUrl) override;
 
     KIO::WorkerResult rename(const QUrl &src, const QUrl &dest, KIO::JobFlags flags) override;
     KIO::WorkerResult copy(const QUrl &src, const QUrl &dest, int _permissions, KIO::JobFlags flags) override;
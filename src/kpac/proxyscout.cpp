@@ -22,7 +22,9 @@
 #endif
 
 #include <QDBusConnection>
+#include <QDBusMessage>
 #include <QFileSystemWatcher>
+#include <QTimer>
 
 #include <cstdlib>
 #include <ctime>
@@ -144,6 +146,9 @@ QString ProxyScout::proxyForUrl(const QString &checkUrl, const QDBusMessage &msg
 void ProxyScout::blackListProxy(const QString &proxy)
 {
     m_blackList[proxy] = std::time(nullptr);
+    notifyProxiesChanged();
+    // The proxy can be used again once black listing expired, see handleRequest()
+    QTimer::singleShot(std::chrono::minutes(30), this, &ProxyScout::notifyProxiesChanged);
 }
 
 void ProxyScout::reset()
@@ -157,6 +162,7 @@ void ProxyScout::reset()
     m_blackList.clear();
     m_suspendTime = 0;
     KProtocolManager::reparseConfiguration();
+    notifyProxiesChanged();
 }
 
 bool ProxyScout::startDownload()
@@ -270,7 +276,20 @@ void ProxyScout::downloadResult(bool success)
     // Suppress further attempts for 5 minutes
     if (!success) {
         m_suspendTime = std::time(nullptr);
+        QTimer::singleShot(std::chrono::minutes(5), this, &ProxyScout::notifyProxiesChanged);
     }
+
+    // The script was (re)loaded, or failed to
+    notifyProxiesChanged();
+}
+
+// Clients cache our answers per host, tell them to ask again
+void ProxyScout::notifyProxiesChanged()
+{
+    const QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/modules/proxyscout"),
+                                                            QStringLiteral("org.kde.KPAC.ProxyScout"),
+                                                            QStringLiteral("proxiesChanged"));
+    QDBusConnection::sessionBus().send(message);
 }
 
 void ProxyScout::proxyScriptFileChanged(const QString &path)
@@ -45,6 +45,7 @@ private Q_SLOTS:
 private:
     bool startDownload();
     QStringList handleRequest(const QUrl &url);
+    void notifyProxiesChanged();
 
     QString m_componentName;
     Downloader *m_downloader;
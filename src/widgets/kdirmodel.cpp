@@ -24,13 +24,20 @@
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
+#include <QFuture>
 #include <QIcon>
 #include <QLocale>
 #include <QLoggingCategory>
 #include <QMimeData>
+#include <QStringTokenizer>
+#include <QTimer>
+#include <QtConcurrentRun>
 #include <qplatformdefs.h>
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
@@ -38,6 +45,13 @@
 
 Q_LOGGING_CATEGORY(category, "kf.kio.widgets.kdirmodel", QtInfoMsg)
 
+// Minimum time between two row insertions while listing, see KDirModelPrivate::_k_slotNewItems
+static constexpr int s_insertionInterval = 100; // ms
+// Directories counted together in a thread, see KDirModelPrivate::startChildCounting
+static constexpr int s_childCountBatchSize = 32;
+// Beyond this, the oldest requests are dropped: their rows were most likely scrolled away
+static constexpr int s_maximumQueuedChildCounts = 256;
+
 class KDirModelNode;
 class KDirModelDirNode;
 
@@ -53,6 +67,62 @@ static QUrl cleanupUrl(const QUrl &url)
     return u;
 }
 
+// Returns the number of entries in the local directory @p path, without "." and "..", up to ChildCountMany,
+// or ChildCountUnknown if it can't be read or @p canceled got set meanwhile. Thread-safe.
+static int countDirectoryEntries(const QString &path, const std::atomic_bool &canceled)
+{
+    int count = KDirModel::ChildCountUnknown;
+    // QDir::entryList would be slow, it stats every entry
+#ifdef Q_OS_WIN
+    QString s = path + QLatin1String("\\*.*");
+    s.replace(QLatin1Char('/'), QLatin1Char('\\'));
+    WIN32_FIND_DATA findData;
+    HANDLE hFile = FindFirstFile((LPWSTR)s.utf16(), &findData);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        count = 0;
+        do {
+            if (canceled.load(std::memory_order_relaxed)) {
+                count = KDirModel::ChildCountUnknown;
+                break;
+            }
+            if (!(findData.cFileName[0] == '.' && findData.cFileName[1] == '\0')
+                && !(findData.cFileName[0] == '.' && findData.cFileName[1] == '.' && findData.cFileName[2] == '\0')) {
+                if (++count == KDirModel::ChildCountMany) {
+                    break;
+                }
+            }
+        } while (FindNextFile(hFile, &findData) != 0);
+        FindClose(hFile);
+    }
+#else
+    DIR *dir = QT_OPENDIR(QFile::encodeName(path).constData());
+    if (dir) {
+        count = 0;
+        QT_DIRENT *dirEntry = nullptr;
+        while ((dirEntry = QT_READDIR(dir))) {
+            if (canceled.load(std::memory_order_relaxed)) {
+                count = KDirModel::ChildCountUnknown;
+                break;
+            }
+            if (dirEntry->d_name[0] == '.') {
+                if (dirEntry->d_name[1] == '\0') { // skip "."
+                    continue;
+                }
+                if (dirEntry->d_name[1] == '.' && dirEntry->d_name[2] == '\0') { // skip ".."
+                    continue;
+                }
+            }
+            // Don't read huge directories to the end
+            if (++count == KDirModel::ChildCountMany) {
+                break;
+            }
+        }
+        QT_CLOSEDIR(dir);
+    }
+#endif
+    return count;
+}
+
 // We create our own tree behind the scenes to have fast lookup from an item to its parent,
 // and also to get the children of an item fast.
 class KDirModelNode
@@ -122,6 +192,8 @@ public:
         qDeleteAll(m_childNodes);
     }
     QList<KDirModelNode *> m_childNodes; // owns the nodes
+    // The child nodes whose url is <url of this directory>/<name>, by name, see KDirModelPrivate::nodeForUrl
+    QHash<QString, KDirModelNode *> m_childNodesByName;
 
     // If we listed the directory, the child count is known. Otherwise it can be set via setChildCount.
     int childCount() const
@@ -149,7 +221,7 @@ public:
         return item().isSlow();
     }
 
-    // For removing all child urls from the global hash.
+    // For removing all child urls from the global hash of irregular nodes.
     QList<QUrl> collectAllChildUrls() const
     {
         QList<QUrl> urls;
@@ -186,13 +258,31 @@ public:
         : q(qq)
         , m_rootNode(new KDirModelDirNode(nullptr, KFileItem()))
     {
+        m_pendingNewItemsTimer.setSingleShot(true);
+        m_pendingNewItemsTimer.setInterval(s_insertionInterval);
+        QObject::connect(&m_pendingNewItemsTimer, &QTimer::timeout, q, [this]() {
+            if (!m_pendingNewItems.empty()) {
+                flushPendingNewItems();
+                // Keep throttling as long as items keep coming
+                m_pendingNewItemsTimer.start();
+            }
+        });
+        // Lets the views request the child counts of all the rows they paint, before counting
+        m_childCountTimer.setSingleShot(true);
+        m_childCountTimer.setInterval(0);
+        QObject::connect(&m_childCountTimer, &QTimer::timeout, q, [this]() {
+            startChildCounting();
+        });
     }
     ~KDirModelPrivate()
     {
+        m_childCountCanceled->store(true);
         delete m_rootNode;
     }
 
     void _k_slotNewItems(const QUrl &directoryUrl, const KFileItemList &);
+    void insertNewItems(const QUrl &directoryUrl, const KFileItemList &);
+    void flushPendingNewItems();
     void _k_slotCompleted(const QUrl &directoryUrl);
     void _k_slotDeleteItems(const KFileItemList &);
     void _k_slotRefreshItems(const QList<QPair<KFileItem, KFileItem>> &);
@@ -202,6 +292,8 @@ public:
 
     void clear()
     {
+        m_pendingNewItems.clear();
+        cancelChildCounts();
         delete m_rootNode;
         m_rootNode = new KDirModelDirNode(nullptr, KFileItem());
         m_showNodeForListedUrl = false;
@@ -256,8 +348,21 @@ public:
         return url;
     }
 
+    // Makes @p node, a new child of @p dirNode, findable by nodeForUrl
+    void insertIntoLookup(KDirModelDirNode *dirNode, KDirModelNode *node, const QUrl &dirUrl, const QString &dirPath);
+    // The opposite, for @p node only; @p url is the url it was inserted with
+    void removeFromLookup(KDirModelNode *node, const QUrl &url);
+    // Same, including all the children of @p node
     void removeFromNodeHash(KDirModelNode *node, const QUrl &url);
     void clearAllPreviews(KDirModelDirNode *node);
+
+    // Queues the counting of the entries of @p dirNode, a local directory at @p path
+    void requestChildCount(KDirModelDirNode *dirNode, const QString &path);
+    // Counts the most recently requested directories in a thread
+    void startChildCounting();
+    // Forgets the child count of @p dirNode, and any counting in progress for it
+    void invalidateChildCount(KDirModelDirNode *dirNode, const QUrl &url);
+    void cancelChildCounts();
 #ifndef NDEBUG
     void dump();
 #endif
@@ -272,28 +377,135 @@ public:
     // key = current known parent node (always a KDirModelDirNode but KDirModelNode is more convenient),
     // value = final url[s] being fetched
     QMap<KDirModelNode *, QList<QUrl>> m_urlsBeingFetched;
-    QHash<QUrl, KDirModelNode *> m_nodeHash; // global node hash: url -> node
+    // Global node hash: url -> node, only for the nodes which can't be found through their
+    // parent directory, since their url isn't <url of the parent>/<name> (e.g. search results)
+    QHash<QUrl, KDirModelNode *> m_nodeHash;
+    // The items added while the previous insertion happened less than s_insertionInterval ago,
+    // by directory, in the order KDirLister emitted them
+    std::vector<std::pair<QUrl, KFileItemList>> m_pendingNewItems;
+    QTimer m_pendingNewItemsTimer;
+
+    struct ChildCountRequest {
+        QUrl url;
+        QString path;
+        quint64 serial;
+        int count;
+    };
+    // Requested child counts, in the order of the requests, not given to a thread yet
+    std::vector<ChildCountRequest> m_childCountQueue;
+    // The serial number of every queued or running request, by url. A result whose
+    // serial number doesn't match anymore was invalidated meanwhile, and is dropped.
+    QHash<QUrl, quint64> m_childCountSerials;
+    quint64 m_lastChildCountSerial = 0;
+    bool m_childCountRunning = false;
+    QTimer m_childCountTimer;
+    // Stops the counting in progress, replaced on every cancelChildCounts()
+    std::shared_ptr<std::atomic_bool> m_childCountCanceled = std::make_shared<std::atomic_bool>(false);
     QStringList m_allCurrentDestUrls; // list of all dest urls that have jobs on them (e.g. copy, download)
 };
 
-KDirModelNode *KDirModelPrivate::nodeForUrl(const QUrl &_url) const // O(1), well, O(length of url as a string)
+KDirModelNode *KDirModelPrivate::nodeForUrl(const QUrl &_url) const // O(depth)
 {
-    QUrl url = cleanupUrl(_url);
-    if (url == urlForNode(m_rootNode)) {
+    const QUrl url = cleanupUrl(_url);
+    const QUrl rootUrl = urlForNode(m_rootNode);
+    if (url == rootUrl) {
         return m_rootNode;
     }
-    return m_nodeHash.value(url);
+    if (m_nodeHash.isEmpty()) {
+        // All the nodes are <url of their directory>/<name>: walk down from the root node,
+        // name by name, without creating the urls of the intermediate directories
+        if (url.adjusted(QUrl::RemovePath) != rootUrl.adjusted(QUrl::RemovePath)) {
+            return nullptr;
+        }
+        const QString path = url.path();
+        const QString rootPath = rootUrl.path();
+        const qsizetype separatorSize = rootPath.endsWith(QLatin1Char('/')) ? 0 : 1;
+        if (path.size() <= rootPath.size() + separatorSize || !path.startsWith(rootPath)
+            || (separatorSize != 0 && path.at(rootPath.size()) != QLatin1Char('/'))) {
+            return nullptr;
+        }
+        KDirModelNode *node = m_rootNode;
+        for (QStringView name : qTokenize(QStringView(path).mid(rootPath.size() + separatorSize), QLatin1Char('/'))) {
+            if (!isDir(node)) {
+                return nullptr;
+            }
+            node = static_cast<KDirModelDirNode *>(node)->m_childNodesByName.value(name.toString());
+            if (!node) {
+                return nullptr;
+            }
+        }
+        return node;
+    }
+    if (KDirModelNode *node = m_nodeHash.value(url)) {
+        return node;
+    }
+
+    // Some nodes have irregular urls, look for the name in the parent directory
+    const QUrl parentUrl = url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash);
+    if (parentUrl == url) {
+        return nullptr;
+    }
+    KDirModelNode *parentNode = nodeForUrl(parentUrl);
+    if (!parentNode || !isDir(parentNode)) {
+        return nullptr;
+    }
+    return static_cast<KDirModelDirNode *>(parentNode)->m_childNodesByName.value(url.fileName());
+}
+
+// Whether @p url is <dirUrl>/<name>, ignoring the query and fragment like cleanupUrl() does.
+// This is called for every listed item, so it avoids creating urls.
+static bool isUrlInDirectory(const QUrl &url, const QString &name, const QUrl &dirUrl, const QString &dirPath)
+{
+    if (name.isEmpty() || name.contains(QLatin1Char('/')) || url.scheme() != dirUrl.scheme() || url.host() != dirUrl.host() || url.port() != dirUrl.port()
+        || url.userName() != dirUrl.userName()) {
+        return false;
+    }
+    const QString path = url.path();
+    const qsizetype separatorSize = dirPath.endsWith(QLatin1Char('/')) ? 0 : 1;
+    return path.size() == dirPath.size() + separatorSize + name.size() && path.startsWith(dirPath) && path.endsWith(name)
+        && (separatorSize == 0 || path.at(dirPath.size()) == QLatin1Char('/'));
+}
+
+void KDirModelPrivate::insertIntoLookup(KDirModelDirNode *dirNode, KDirModelNode *node, const QUrl &dirUrl, const QString &dirPath)
+{
+    const KFileItem &item = node->item();
+    const QUrl url = item.url();
+    if (isUrlInDirectory(url, item.name(), dirUrl, dirPath)) {
+        dirNode->m_childNodesByName.insert(item.name(), node);
+    } else {
+        m_nodeHash.insert(cleanupUrl(url), node);
+    }
+}
+
+void KDirModelPrivate::removeFromLookup(KDirModelNode *node, const QUrl &url)
+{
+    if (KDirModelDirNode *dirNode = node->parent()) {
+        auto it = dirNode->m_childNodesByName.find(url.fileName());
+        if (it != dirNode->m_childNodesByName.end() && it.value() == node) {
+            dirNode->m_childNodesByName.erase(it);
+        }
+    }
+    if (!m_nodeHash.isEmpty()) {
+        auto it = m_nodeHash.find(cleanupUrl(url));
+        if (it != m_nodeHash.end() && it.value() == node) {
+            m_nodeHash.erase(it);
+        }
+    }
 }
 
 void KDirModelPrivate::removeFromNodeHash(KDirModelNode *node, const QUrl &url)
 {
-    if (node->item().isDir()) {
+    if (!m_childCountSerials.isEmpty()) {
+        m_childCountSerials.remove(cleanupUrl(url));
+    }
+    // The children found by name go away with their parent node
+    if (!m_nodeHash.isEmpty() && node->item().isDir()) {
         const QList<QUrl> urls = static_cast<KDirModelDirNode *>(node)->collectAllChildUrls();
         for (const QUrl &u : urls) {
             m_nodeHash.remove(u);
         }
     }
-    m_nodeHash.remove(cleanupUrl(url));
+    removeFromLookup(node, url);
 }
 
 KDirModelNode *KDirModelPrivate::expandAllParentsUntil(const QUrl &_url) const // O(depth)
@@ -367,6 +579,7 @@ KDirModelNode *KDirModelPrivate::expandAllParentsUntil(const QUrl &_url) const /
 void KDirModelPrivate::dump()
 {
     qCDebug(category) << "Dumping contents of KDirModel" << q << "dirLister url:" << m_dirLister->url();
+    qCDebug(category) << "Nodes not found by name in their parent:";
     QHashIterator<QUrl, KDirModelNode *> it(m_nodeHash);
     while (it.hasNext()) {
         it.next();
@@ -471,7 +684,7 @@ void KDirModel::openUrl(const QUrl &inputUrl, OpenUrlFlags flags)
                 const KIO::UDSEntry entry = statJob->statResult();
                 KFileItem visibleRootItem(entry, url);
                 visibleRootItem.setName(url.path() == QLatin1String("/") ? QStringLiteral("/") : url.fileName());
-                d->_k_slotNewItems(parentUrl, QList<KFileItem>{visibleRootItem});
+                d->insertNewItems(parentUrl, QList<KFileItem>{visibleRootItem});
                 Q_ASSERT(d->m_rootNode->m_childNodes.count() == 1);
                 expandToUrl(url);
             } else {
@@ -494,6 +707,34 @@ KDirLister *KDirModel::dirLister() const
 }
 
 void KDirModelPrivate::_k_slotNewItems(const QUrl &directoryUrl, const KFileItemList &items)
+{
+    // Each row insertion makes the views and proxy models update their mappings, or even sort again.
+    // Rather than inserting every batch listed by the worker, insert at most every s_insertionInterval,
+    // everything that was listed in the meantime.
+    if (m_pendingNewItemsTimer.isActive()) {
+        if (!m_pendingNewItems.empty() && m_pendingNewItems.back().first == directoryUrl) {
+            m_pendingNewItems.back().second += items;
+        } else {
+            m_pendingNewItems.emplace_back(directoryUrl, items);
+        }
+        return;
+    }
+
+    insertNewItems(directoryUrl, items);
+    m_pendingNewItemsTimer.start();
+}
+
+void KDirModelPrivate::flushPendingNewItems()
+{
+    // insertNewItems can lead to listing more directories (fetchMore), which can emit items synchronously
+    const std::vector<std::pair<QUrl, KFileItemList>> pendingNewItems = std::move(m_pendingNewItems);
+    m_pendingNewItems.clear();
+    for (const auto &[directoryUrl, items] : pendingNewItems) {
+        insertNewItems(directoryUrl, items);
+    }
+}
+
+void KDirModelPrivate::insertNewItems(const QUrl &directoryUrl, const KFileItemList &items)
 {
     // qDebug() << "directoryUrl=" << directoryUrl;
 
@@ -530,7 +771,10 @@ void KDirModelPrivate::_k_slotNewItems(const QUrl &directoryUrl, const KFileItem
 
     QList<QModelIndex> emitExpandFor;
 
+    const QUrl dirUrl = urlForNode(dirNode);
+    const QString dirPath = dirUrl.path();
     dirNode->m_childNodes.reserve(newRowCount);
+    dirNode->m_childNodesByName.reserve(newRowCount);
     for (const auto &item : items) {
         const bool isDir = item.isDir();
         KDirModelNode *node = isDir ? new KDirModelDirNode(dirNode, item) : new KDirModelNode(dirNode, item);
@@ -545,18 +789,17 @@ void KDirModelPrivate::_k_slotNewItems(const QUrl &directoryUrl, const KFileItem
         //}
 #endif
         dirNode->m_childNodes.append(node);
+        insertIntoLookup(dirNode, node, dirUrl, dirPath);
         const QUrl url = item.url();
-        m_nodeHash.insert(cleanupUrl(url), node);
 
         if (!urlsBeingFetched.isEmpty()) {
-            const QUrl &dirUrl = url;
             for (const QUrl &urlFetched : std::as_const(urlsBeingFetched)) {
-                if (dirUrl.matches(urlFetched, QUrl::StripTrailingSlash) || dirUrl.isParentOf(urlFetched)) {
-                    // qDebug() << "Listing found" << dirUrl.url() << "which is a parent of fetched url" << urlFetched;
+                if (url.matches(urlFetched, QUrl::StripTrailingSlash) || url.isParentOf(urlFetched)) {
+                    // qDebug() << "Listing found" << url.url() << "which is a parent of fetched url" << urlFetched;
                     const QModelIndex parentIndex = indexForNode(node, dirNode->m_childNodes.count() - 1);
                     Q_ASSERT(parentIndex.isValid());
                     emitExpandFor.append(parentIndex);
-                    if (isDir && dirUrl != urlFetched) {
+                    if (isDir && url != urlFetched) {
                         q->fetchMore(parentIndex);
                         m_urlsBeingFetched[node].append(urlFetched);
                     }
@@ -576,6 +819,8 @@ void KDirModelPrivate::_k_slotNewItems(const QUrl &directoryUrl, const KFileItem
 
 void KDirModelPrivate::_k_slotCompleted(const QUrl &directoryUrl)
 {
+    flushPendingNewItems();
+
     KDirModelNode *result = nodeForUrl(directoryUrl); // O(depth)
     Q_ASSERT(isDir(result));
     KDirModelDirNode *dirNode = static_cast<KDirModelDirNode *>(result);
@@ -585,6 +830,7 @@ void KDirModelPrivate::_k_slotCompleted(const QUrl &directoryUrl)
 void KDirModelPrivate::_k_slotDeleteItems(const KFileItemList &items)
 {
     qCDebug(category) << items.count() << "items";
+    flushPendingNewItems();
 
     // I assume all items are from the same directory.
     // From KDirLister's code, this should be the case, except maybe emitChanges?
@@ -610,6 +856,9 @@ void KDirModelPrivate::_k_slotDeleteItems(const KFileItemList &items)
         q->beginRemoveRows(parentIndex, r, r);
         removeFromNodeHash(node, url);
         delete dirNode->m_childNodes.takeAt(r);
+        if (dirNode->m_childNodes.isEmpty()) {
+            dirNode->setChildCount(0); // it was listed, this is known
+        }
         q->endRemoveRows();
         return;
     }
@@ -659,10 +908,15 @@ void KDirModelPrivate::_k_slotDeleteItems(const KFileItemList &items)
         }
         lastVal = val;
     }
+    if (dirNode->m_childNodes.isEmpty()) {
+        dirNode->setChildCount(0);
+    }
 }
 
 void KDirModelPrivate::_k_slotRefreshItems(const QList<QPair<KFileItem, KFileItem>> &items)
 {
+    flushPendingNewItems();
+
     QModelIndex topLeft;
     QModelIndex bottomRight;
 
@@ -681,24 +935,31 @@ void KDirModelPrivate::_k_slotRefreshItems(const QList<QPair<KFileItem, KFileIte
         if (node != m_rootNode) { // we never set an item in the rootnode, we use m_dirLister->rootItem instead.
             bool hasNewNode = false;
             // A file became directory (well, it was overwritten)
+            KDirModelDirNode *dirNode = node->parent();
             if (oldItem.isDir() != newItem.isDir()) {
                 // qDebug() << "DIR/FILE STATUS CHANGE";
                 const int r = node->rowNumber();
                 removeFromNodeHash(node, oldUrl);
-                KDirModelDirNode *dirNode = node->parent();
                 delete dirNode->m_childNodes.takeAt(r); // i.e. "delete node"
                 node = newItem.isDir() ? new KDirModelDirNode(dirNode, newItem) : new KDirModelNode(dirNode, newItem);
                 dirNode->m_childNodes.insert(r, node); // same position!
                 hasNewNode = true;
-            } else {
-                node->setItem(newItem);
+            } else if (oldUrl != newUrl || oldItem.name() != newItem.name()) {
+                removeFromLookup(node, oldUrl);
             }
 
-            if (oldUrl != newUrl || hasNewNode) {
+            if (oldUrl != newUrl || oldItem.name() != newItem.name() || hasNewNode) {
                 // What if a renamed dir had children? -> kdirlister takes care of emitting for each item
                 // qDebug() << "Renaming" << oldUrl << "to" << newUrl << "in node hash";
-                m_nodeHash.remove(cleanupUrl(oldUrl));
-                m_nodeHash.insert(cleanupUrl(newUrl), node);
+                node->setItem(newItem);
+                const QUrl dirUrl = urlForNode(dirNode);
+                insertIntoLookup(dirNode, node, dirUrl, dirUrl.path());
+            } else {
+                node->setItem(newItem);
+            }
+            // The directory changed, its entries may have too
+            if (newItem.isDir()) {
+                invalidateChildCount(static_cast<KDirModelDirNode *>(node), oldUrl);
             }
             // MIME type changed -> forget cached icon (e.g. from "cut", #164185 comment #13)
             if (oldItem.determineMimeType().name() != newItem.determineMimeType().name()) {
@@ -723,20 +984,25 @@ void KDirModelPrivate::_k_slotRefreshItems(const QList<QPair<KFileItem, KFileIte
 // and when renaming a directory.
 void KDirModelPrivate::_k_slotRedirection(const QUrl &oldUrl, const QUrl &newUrl)
 {
+    flushPendingNewItems();
+
     KDirModelNode *node = nodeForUrl(oldUrl);
     if (!node) {
         return;
     }
-    m_nodeHash.remove(cleanupUrl(oldUrl));
-    m_nodeHash.insert(cleanupUrl(newUrl), node);
 
     // Ensure the node's URL is updated. In case of a listjob redirection
     // we won't get a refreshItem, and in case of renaming a directory
-    // we'll get it too late (so the hash won't find the old url anymore).
+    // we'll get it too late (so the lookup won't find the old url anymore).
     KFileItem item = node->item();
     if (!item.isNull()) { // null if root item, #180156
+        removeFromLookup(node, oldUrl);
         item.setUrl(newUrl);
         node->setItem(item);
+        if (KDirModelDirNode *dirNode = node->parent()) {
+            const QUrl dirUrl = urlForNode(dirNode);
+            insertIntoLookup(dirNode, node, dirUrl, dirUrl.path());
+        }
     }
 
     // The items inside the renamed directory have been handled before,
@@ -796,6 +1062,81 @@ void KDirModelPrivate::clearAllPreviews(KDirModelDirNode *dirNode)
     }
 }
 
+void KDirModelPrivate::requestChildCount(KDirModelDirNode *dirNode, const QString &path)
+{
+    const QUrl url = cleanupUrl(dirNode->item().url());
+    if (m_childCountSerials.contains(url)) { // queued, running, or unreadable
+        return;
+    }
+    const quint64 serial = ++m_lastChildCountSerial;
+    m_childCountSerials.insert(url, serial);
+    m_childCountQueue.push_back({url, path, serial, KDirModel::ChildCountUnknown});
+    if (m_childCountQueue.size() > s_maximumQueuedChildCounts) {
+        m_childCountSerials.remove(m_childCountQueue.front().url);
+        m_childCountQueue.erase(m_childCountQueue.begin());
+    }
+    if (!m_childCountRunning && !m_childCountTimer.isActive()) {
+        m_childCountTimer.start();
+    }
+}
+
+void KDirModelPrivate::startChildCounting()
+{
+    if (m_childCountRunning || m_childCountQueue.empty()) {
+        return;
+    }
+    // One batch at a time, most recent requests first: they are for the rows visible right now
+    const auto batchStart = m_childCountQueue.end() - std::min<std::ptrdiff_t>(m_childCountQueue.size(), s_childCountBatchSize);
+    std::vector<ChildCountRequest> batch(std::make_move_iterator(batchStart), std::make_move_iterator(m_childCountQueue.end()));
+    m_childCountQueue.erase(batchStart, m_childCountQueue.end());
+    m_childCountRunning = true;
+
+    QtConcurrent::run([batch = std::move(batch), canceled = m_childCountCanceled]() mutable {
+        for (ChildCountRequest &request : batch) {
+            request.count = countDirectoryEntries(request.path, *canceled);
+        }
+        return batch;
+    }).then(q, [this](const std::vector<ChildCountRequest> &batch) {
+        m_childCountRunning = false;
+        for (const ChildCountRequest &request : batch) {
+            auto it = m_childCountSerials.find(request.url);
+            if (it == m_childCountSerials.end() || it.value() != request.serial) {
+                continue; // invalidated meanwhile
+            }
+            if (request.count == KDirModel::ChildCountUnknown) {
+                // Don't retry on every repaint, until the directory changes
+                it.value() = 0;
+                continue;
+            }
+            m_childCountSerials.erase(it);
+            KDirModelNode *node = nodeForUrl(request.url);
+            if (!node || node == m_rootNode || !node->item().isDir()) {
+                continue;
+            }
+            static_cast<KDirModelDirNode *>(node)->setChildCount(request.count);
+            const QModelIndex index = indexForNode(node);
+            Q_EMIT q->dataChanged(index, index.sibling(index.row(), KDirModel::ColumnCount - 1));
+        }
+        startChildCounting();
+    });
+}
+
+void KDirModelPrivate::invalidateChildCount(KDirModelDirNode *dirNode, const QUrl &url)
+{
+    if (!m_childCountSerials.isEmpty()) {
+        m_childCountSerials.remove(cleanupUrl(url));
+    }
+    dirNode->setChildCount(KDirModel::ChildCountUnknown);
+}
+
+void KDirModelPrivate::cancelChildCounts()
+{
+    m_childCountCanceled->store(true);
+    m_childCountCanceled = std::make_shared<std::atomic_bool>(false);
+    m_childCountQueue.clear();
+    m_childCountSerials.clear();
+}
+
 void KDirModel::clearAllPreviews()
 {
     d->clearAllPreviews(d->m_rootNode);
@@ -892,49 +1233,12 @@ QVariant KDirModel::data(const QModelIndex &index, int role) const
                 return ChildCountUnknown;
             } else {
                 KDirModelDirNode *dirNode = static_cast<KDirModelDirNode *>(node);
-                int count = dirNode->childCount();
+                const int count = dirNode->childCount();
                 if (count == ChildCountUnknown && item.isReadable() && !dirNode->isSlow()) {
                     const QString path = item.localPath();
                     if (!path.isEmpty()) {
-//                        slow
-//                        QDir dir(path);
-//                        count = dir.entryList(QDir::AllEntries|QDir::NoDotAndDotDot|QDir::System).count();
-#ifdef Q_OS_WIN
-                        QString s = path + QLatin1String("\\*.*");
-                        s.replace(QLatin1Char('/'), QLatin1Char('\\'));
-                        count = 0;
-                        WIN32_FIND_DATA findData;
-                        HANDLE hFile = FindFirstFile((LPWSTR)s.utf16(), &findData);
-                        if (hFile != INVALID_HANDLE_VALUE) {
-                            do {
-                                if (!(findData.cFileName[0] == '.' && findData.cFileName[1] == '\0')
-                                    && !(findData.cFileName[0] == '.' && findData.cFileName[1] == '.' && findData.cFileName[2] == '\0')) {
-                                    ++count;
-                                }
-                            } while (FindNextFile(hFile, &findData) != 0);
-                            FindClose(hFile);
-                        }
-#else
-                        DIR *dir = QT_OPENDIR(QFile::encodeName(path).constData());
-                        if (dir) {
-                            count = 0;
-                            QT_DIRENT *dirEntry = nullptr;
-                            while ((dirEntry = QT_READDIR(dir))) {
-                                if (dirEntry->d_name[0] == '.') {
-                                    if (dirEntry->d_name[1] == '\0') { // skip "."
-                                        continue;
-                                    }
-                                    if (dirEntry->d_name[1] == '.' && dirEntry->d_name[2] == '\0') { // skip ".."
-                                        continue;
-                                    }
-                                }
-                                ++count;
-                            }
-                            QT_CLOSEDIR(dir);
-                        }
-#endif
-                        // qDebug() << "child count for " << path << ":" << count;
-                        dirNode->setChildCount(count);
+                        // Counted in a thread, dataChanged() is emitted once it's known
+                        d->requestChildCount(dirNode, path);
                     }
                 }
                 return count;
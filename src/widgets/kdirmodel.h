@@ -152,11 +152,16 @@ public:
     /// or we haven't calculated its child count yet
     enum { ChildCountUnknown = -1 };
 
+    /// Upper bound of data(ChildCountRole) for the directories which weren't listed:
+    /// their entries are only counted up to this value, which means "this many or more".
+    /// @since 6.0
+    enum { ChildCountMany = 10000 };
+
     enum AdditionalRoles {
         // Note: use   printf "0x%08X\n" $(($RANDOM*$RANDOM))
         // to define additional roles.
         FileItemRole = 0x07A263FF, ///< returns the KFileItem for a given index. roleName is "fileItem".
-        ChildCountRole = 0x2C4D0A40, ///< returns the number of items in a directory, or ChildCountUnknown. roleName is "childCount".
+        ChildCountRole = 0x2C4D0A40, ///< returns the number of items in a directory, at most ChildCountMany if it wasn't listed, or ChildCountUnknown. roleName is "childCount".
         HasJobRole = 0x01E555A5, ///< returns whether or not there is a job on an item (file/directory). roleName is "hasJob".
     };
 
@@ -206,6 +206,10 @@ QString KFileItemDelegate::Private::itemSize(const QModelIndex &index, const KFi
         return QString();
     }
 
+    if (count >= KDirModel::ChildCountMany) {
+        return i18nc("Items in a folder, which has too many of them to count them all", "%1+ items", QLocale().toString(int(KDirModel::ChildCountMany)));
+    }
+
     return i18ncp("Items in a folder", "1 item", "%1 items", count);
 }
 